@@ -12,6 +12,11 @@
 .PARAMETER Clean
     Perform a clean build by deleting all build artifacts first
 
+.PARAMETER FleetManifest
+    Compile a site's fleet (known NIOX PRO serials, one per line) into the
+    DLL as a perfect hash table. Generates niox_fleet_manifest.h with
+    niox_fleet_gen and builds with NIOX_COMPILED_FLEET defined.
+
 .EXAMPLE
     .\build-winrt-native-dll.ps1
     Normal build (uses cache)
@@ -19,11 +24,18 @@
 .EXAMPLE
     .\build-winrt-native-dll.ps1 -Clean
     Clean build (deletes all build artifacts first)
+
+.EXAMPLE
+    .\build-winrt-native-dll.ps1 -FleetManifest .\site-fleet.txt
+    Build with the site's fleet compiled in
 #>
 
 param(
     [Parameter(Mandatory=$false)]
-    [switch]$Clean
+    [switch]$Clean,
+
+    [Parameter(Mandatory=$false)]
+    [string]$FleetManifest
 )
 
 $ErrorActionPreference = "Stop"
@@ -117,13 +129,29 @@ Write-Host "  Compiler: MSVC (Visual Studio)" -ForegroundColor Gray
 Write-Host ""
 Write-Host "  Compiling with C++/WinRT support..." -ForegroundColor Gray
 
+# Optional compiled-in fleet table
+$FleetDefine = ""
+$FleetSteps = ""
+if ($FleetManifest) {
+    $FleetManifestPath = (Resolve-Path $FleetManifest -ErrorAction Stop).Path
+    Write-Host "  Fleet manifest: $FleetManifestPath" -ForegroundColor Gray
+    $FleetDefine = "/DNIOX_COMPILED_FLEET"
+    $FleetSteps = @"
+cl.exe /EHsc /std:c++17 /MD /W3 /nologo niox_fleet_gen.cpp /Fe:niox_fleet_gen.exe /Fo:niox_fleet_gen.obj
+if errorlevel 1 exit /b %ERRORLEVEL%
+niox_fleet_gen.exe "$FleetManifestPath" niox_fleet_manifest.h
+if errorlevel 1 exit /b %ERRORLEVEL%
+"@
+}
+
 # Create a temporary batch file to set up VS environment and compile
 $TempBatchFile = [System.IO.Path]::GetTempFileName() + ".bat"
 $BatchContent = @"
 @echo off
 call "$VcVarsAll" x64
 cd /d "$CppSourceDir"
-cl.exe /EHsc /std:c++17 /MD /await /W3 /c winrt_ble_wrapper.cpp /Fo:winrt_ble_wrapper.obj
+$FleetSteps
+cl.exe /EHsc /std:c++17 /MD /await /W3 $FleetDefine /c winrt_ble_wrapper.cpp /Fo:winrt_ble_wrapper.obj
 exit /b %ERRORLEVEL%
 "@
 
@@ -89,7 +89,8 @@ kotlin {
                     "-lwindowsapp",
                     "-lole32",
                     "-loleaut32",
-                    "-lruntimeobject"
+                    "-lruntimeobject",
+                    "-lws2_32"
                 )
             }
         }
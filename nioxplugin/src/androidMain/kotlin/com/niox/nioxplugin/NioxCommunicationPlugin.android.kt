@@ -115,7 +115,7 @@ class AndroidNioxCommunicationPlugin(private val context: Context) : NioxCommuni
                     try {
                         val scanFilters = listOf(
                             android.bluetooth.le.ScanFilter.Builder()
-                                .setServiceUuid(android.os.ParcelUuid.fromString(serviceUuidFilter))
+                                .setServiceUuid(android.os.ParcelUuid.fromString(BluetoothUuid.parse(serviceUuidFilter).toString()))
                                 .build()
                         )
                         val scanSettings = android.bluetooth.le.ScanSettings.Builder()
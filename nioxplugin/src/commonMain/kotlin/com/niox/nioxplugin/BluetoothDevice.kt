@@ -21,34 +21,35 @@ data class BluetoothDevice(
 ) {
     /**
      * Check if this device is a NIOX PRO device based on:
-     * - Service UUID: 000fc00b-8a4-4078-874c-14efbd4b510a
+     * - Service UUID: 000fc00b-08a4-4078-874c-14efbd4b510a
      * - Device name starting with "NIOX PRO"
      */
     fun isNioxDevice(): Boolean {
         // Check if device name matches NIOX pattern
         val hasNioxName = name?.startsWith(NioxConstants.NIOX_DEVICE_NAME_PREFIX, ignoreCase = true) == true
 
-        // Normalize UUID strings (remove hyphens and lowercase) for comparison across platforms
-        fun normalizeUuid(u: String) = u.replace("-", "").lowercase()
-
-        val target = normalizeUuid(NioxConstants.NIOX_SERVICE_UUID)
-
         // Check if device advertises the NIOX FDC service UUID
-        val hasNioxService = serviceUuids?.any { uuid ->
-            normalizeUuid(uuid) == target
-        } == true
+        val hasNioxService = parsedServiceUuids.any { it == NioxConstants.NIOX_SERVICE }
 
         return hasNioxName || hasNioxService
     }
 
+    /** Advertised service UUIDs parsed once per instance; malformed entries are dropped */
+    val parsedServiceUuids: List<BluetoothUuid> by lazy {
+        serviceUuids?.mapNotNull { BluetoothUuid.parseOrNull(it) } ?: emptyList()
+    }
+
     /**
      * Extract NIOX device serial number from device name
      * Format: "NIOX PRO [serial_number]" (e.g., "NIOX PRO 070401992")
      */
-    fun getNioxSerialNumber(): String? {
-        return name?.let { deviceName ->
-            if (deviceName.startsWith("NIOX PRO", ignoreCase = true)) {
-                deviceName.substring(8).trim().takeIf { it.isNotEmpty() }
+    fun getNioxSerialNumber(): String? = nioxSerialNumber
+
+    /** Serial parsed once per instance; the name is immutable */
+    private val nioxSerialNumber: String? by lazy {
+        name?.let { deviceName ->
+            if (deviceName.startsWith(NioxConstants.NIOX_DEVICE_NAME_PREFIX, ignoreCase = true)) {
+                deviceName.substring(NioxConstants.NIOX_DEVICE_NAME_PREFIX.length).trim().takeIf { it.isNotEmpty() }
             } else {
                 null
             }
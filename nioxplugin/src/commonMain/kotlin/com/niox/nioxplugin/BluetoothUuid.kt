@@ -0,0 +1,91 @@
+package com.niox.nioxplugin
+
+/**
+ * Parsed 128-bit Bluetooth UUID, stored as two 64-bit halves.
+ * Same layout as the native niox::Uuid, so comparisons are two Long compares.
+ */
+data class BluetoothUuid(
+    /** Bytes 0..7 of the UUID in canonical text order */
+    val mostSignificantBits: Long,
+
+    /** Bytes 8..15 of the UUID in canonical text order */
+    val leastSignificantBits: Long
+) {
+    /** True if this UUID is a 16/32-bit assigned number expanded against the Base UUID */
+    val isBaseDerived: Boolean
+        get() = (mostSignificantBits and 0xFFFFFFFFL) == BASE_MSB && leastSignificantBits == BASE_LSB
+
+    /** Canonical lowercase form: xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx */
+    override fun toString(): String {
+        val hex = hex64(mostSignificantBits) + hex64(leastSignificantBits)
+        return "${hex.substring(0, 8)}-${hex.substring(8, 12)}-${hex.substring(12, 16)}-" +
+            "${hex.substring(16, 20)}-${hex.substring(20)}"
+    }
+
+    companion object {
+        // Bluetooth Base UUID: 00000000-0000-1000-8000-00805F9B34FB
+        private const val BASE_MSB = 0x0000000000001000L
+        private const val BASE_LSB = -0x7fffff7fa064cb05L // 0x800000805F9B34FB
+
+        /** Expand a 16-bit or 32-bit assigned number against the Base UUID */
+        fun fromShort(value: Long): BluetoothUuid =
+            BluetoothUuid(((value and 0xFFFFFFFFL) shl 32) or BASE_MSB, BASE_LSB)
+
+        /**
+         * Parse "xxxx", "xxxxxxxx" or "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx" (case-insensitive).
+         * NioxConstants.LEGACY_NIOX_SERVICE_UUID is also accepted, as the FDC service UUID.
+         * @throws IllegalArgumentException if the text is malformed
+         */
+        fun parse(text: String): BluetoothUuid =
+            parseOrNull(text) ?: throw IllegalArgumentException("Invalid Bluetooth UUID: $text")
+
+        /**
+         * Parse a UUID string (same forms as parse), returning null if it is malformed
+         */
+        fun parseOrNull(text: String): BluetoothUuid? {
+            // The only malformed form accepted: the FDC literal published before it was corrected
+            if (text.equals(NioxConstants.LEGACY_NIOX_SERVICE_UUID, ignoreCase = true)) {
+                return parseOrNull(NioxConstants.NIOX_SERVICE_UUID)
+            }
+            if (text.length == 4 || text.length == 8) {
+                var value = 0L
+                for (c in text) {
+                    val digit = hexDigit(c)
+                    if (digit < 0) return null
+                    value = (value shl 4) or digit.toLong()
+                }
+                return fromShort(value)
+            }
+            if (text.length != 36) return null
+
+            var msb = 0L
+            var lsb = 0L
+            var nibble = 0
+            for ((i, c) in text.withIndex()) {
+                if (i == 8 || i == 13 || i == 18 || i == 23) {
+                    if (c != '-') return null
+                    continue
+                }
+                val digit = hexDigit(c)
+                if (digit < 0) return null
+                if (nibble < 16) {
+                    msb = (msb shl 4) or digit.toLong()
+                } else {
+                    lsb = (lsb shl 4) or digit.toLong()
+                }
+                nibble++
+            }
+            return BluetoothUuid(msb, lsb)
+        }
+
+        private fun hexDigit(c: Char): Int = when (c) {
+            in '0'..'9' -> c - '0'
+            in 'a'..'f' -> c - 'a' + 10
+            in 'A'..'F' -> c - 'A' + 10
+            else -> -1
+        }
+
+        private fun hex64(value: Long): String =
+            value.toULong().toString(16).padStart(16, '0')
+    }
+}
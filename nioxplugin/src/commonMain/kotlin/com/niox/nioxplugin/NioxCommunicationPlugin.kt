@@ -14,8 +14,9 @@ interface NioxCommunicationPlugin {
     /**
      * Scan for nearby NIOX Bluetooth devices and return all discovered devices
      * @param scanDurationMs Duration of the scan in milliseconds (default: 10000ms)
-     * @param serviceUuidFilter Service UUID to filter devices (default: NIOX_SERVICE_UUID = "000fc00b-8a4-4078-874c-14efbd4b510a", set to null to scan all devices)
+     * @param serviceUuidFilter Service UUID to filter devices (default: NIOX_SERVICE_UUID = "000fc00b-08a4-4078-874c-14efbd4b510a", set to null to scan all devices)
      * @return List of discovered BluetoothDevice objects
+     * @throws IllegalArgumentException if serviceUuidFilter is not a valid UUID (Windows, iOS)
      */
     suspend fun scanForDevices(
         scanDurationMs: Long = 10000,
@@ -4,12 +4,28 @@ package com.niox.nioxplugin
  * NIOX device identification constants
  */
 object NioxConstants {
-    /** NIOX FDC Service UUID (128-bit) */
-    const val NIOX_SERVICE_UUID = "000fc00b-8a4-4078-874c-14efbd4b510a"
+    /**
+     * NIOX FDC Service UUID (128-bit)
+     * Earlier releases used "000fc00b-8a4-..." (three-digit second group), which strict
+     * parsers reject; lenient parsers read it as the value below.
+     */
+    const val NIOX_SERVICE_UUID = "000fc00b-08a4-4078-874c-14efbd4b510a"
+
+    /**
+     * The FDC Service UUID as published by earlier releases. Callers may still pass it;
+     * BluetoothUuid.parse accepts it as NIOX_SERVICE.
+     */
+    const val LEGACY_NIOX_SERVICE_UUID = "000fc00b-8a4-4078-874c-14efbd4b510a"
 
     /** Tx Power Service UUID (16-bit) */
     const val TX_POWER_SERVICE_UUID = "1804"
 
+    /** Pre-parsed NIOX FDC Service UUID for integer comparison */
+    val NIOX_SERVICE = BluetoothUuid.parse(NIOX_SERVICE_UUID)
+
+    /** Pre-parsed Tx Power Service UUID */
+    val TX_POWER_SERVICE = BluetoothUuid.parse(TX_POWER_SERVICE_UUID)
+
     /** NIOX device name prefix */
     const val NIOX_DEVICE_NAME_PREFIX = "NIOX PRO"
 }
@@ -48,6 +48,8 @@ class IosNioxCommunicationPlugin : NioxCommunicationPlugin {
         scanDurationMs: Long,
         serviceUuidFilter: String?
     ): List<BluetoothDevice> {
+        // Canonical form: CBUUID rejects the legacy FDC literal
+        val filterUuid = serviceUuidFilter?.let { BluetoothUuid.parse(it).toString() }
         val discoveredDevices = mutableMapOf<String, BluetoothDevice>()
 
         return suspendCoroutine { continuation ->
@@ -66,7 +68,7 @@ class IosNioxCommunicationPlugin : NioxCommunicationPlugin {
                 }
 
                 // Start scanning with optional service UUID filter
-                val serviceUUIDs = serviceUuidFilter?.let {
+                val serviceUUIDs = filterUuid?.let {
                     listOf(platform.CoreBluetooth.CBUUID.UUIDWithString(it))
                 }
 
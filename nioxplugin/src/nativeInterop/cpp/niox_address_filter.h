@@ -0,0 +1,331 @@
+// NIOX address filter - drop known-irrelevant adverts before any decoding
+// A fixed deployment hears the same beacons, monitors and phones all day.
+// Their addresses go on a denylist (configured, or learned from devices
+// that keep advertising a non-NIOX name); an optional allowlist restricts
+// the scan to known units. Both lists are sorted uint64 arrays behind a
+// Bloom filter, so most lookups end after three bit tests. Bloom hits are
+// confirmed in a small open-addressed index built from the same array; a
+// binary search over random addresses mispredicts on almost every step and
+// costs several times more.
+//
+// Membership changes publish a new immutable snapshot. Readers keep a
+// per-thread reference and only re-fetch it when the version moves, so
+// admit() takes no lock and the scan keeps running through changes. Its
+// counters are per thread too (one writer each), summed by stats().
+// Learning only takes the writer lock while it is on and has room.
+
+#ifndef NIOX_ADDRESS_FILTER_H
+#define NIOX_ADDRESS_FILTER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace niox {
+
+enum AddressList {
+    ADDRESS_DENY = 0,
+    ADDRESS_ALLOW = 1
+};
+
+// Sorted address set with a Bloom pre-check
+class AddressSet {
+public:
+    AddressSet() : mask_(0), index_mask_(0) {}
+
+    explicit AddressSet(std::vector<uint64_t> addresses) : addresses_(std::move(addresses)), mask_(0), index_mask_(0) {
+        std::sort(addresses_.begin(), addresses_.end());
+        addresses_.erase(std::unique(addresses_.begin(), addresses_.end()), addresses_.end());
+        if (addresses_.empty()) return;
+
+        // About 16 bits per address (~0.5% false positives with 3 probes)
+        size_t bits = 1024;
+        while (bits < addresses_.size() * 16) bits <<= 1;
+        bloom_.assign(bits / 64, 0);
+        mask_ = bits - 1;
+        for (uint64_t address : addresses_) {
+            const uint64_t h = mix(address);
+            for (int probe = 0; probe < PROBES; probe++) {
+                const uint64_t bit = (h >> (probe * 21)) & mask_;
+                bloom_[bit >> 6] |= uint64_t(1) << (bit & 63);
+            }
+        }
+
+        // Index at most half full, linear probing
+        size_t slots = 16;
+        while (slots < addresses_.size() * 2) slots <<= 1;
+        index_.assign(slots, EMPTY_SLOT);
+        index_mask_ = slots - 1;
+        for (uint64_t address : addresses_) {
+            size_t slot = index_slot(address);
+            while (index_[slot] != EMPTY_SLOT) slot = (slot + 1) & index_mask_;
+            index_[slot] = address;
+        }
+    }
+
+    // false: definitely absent. true: present, or a Bloom false positive
+    bool maybe_contains(uint64_t address) const {
+        if (mask_ == 0) return false;
+        const uint64_t h = mix(address);
+        for (int probe = 0; probe < PROBES; probe++) {
+            const uint64_t bit = (h >> (probe * 21)) & mask_;
+            if ((bloom_[bit >> 6] & (uint64_t(1) << (bit & 63))) == 0) return false;
+        }
+        return true;
+    }
+
+    bool contains(uint64_t address) const {
+        if (index_mask_ == 0 || address == EMPTY_SLOT) return false;
+        for (size_t slot = index_slot(address);; slot = (slot + 1) & index_mask_) {
+            if (index_[slot] == address) return true;
+            if (index_[slot] == EMPTY_SLOT) return false;
+        }
+    }
+
+    bool empty() const { return addresses_.empty(); }
+    size_t size() const { return addresses_.size(); }
+    const std::vector<uint64_t>& addresses() const { return addresses_; }
+
+private:
+    static const int PROBES = 3;
+    static constexpr uint64_t EMPTY_SLOT = ~uint64_t(0);  // Not a 48-bit address
+
+    // splitmix64 finalizer: 3 x 21-bit probe positions from one multiply chain
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebull;
+        x ^= x >> 31;
+        return x;
+    }
+
+    // Top bits of the hash, independent of the Bloom probe bits
+    size_t index_slot(uint64_t address) const {
+        return static_cast<size_t>(mix(address) >> 40) & index_mask_;
+    }
+
+    std::vector<uint64_t> addresses_;   // Sorted; the list contents
+    std::vector<uint64_t> bloom_;
+    uint64_t mask_;
+    std::vector<uint64_t> index_;       // Open-addressed copy of addresses_
+    size_t index_mask_;
+};
+
+struct AddressFilterStats {
+    uint64_t checked;
+    uint64_t denied;            // Dropped by the denylist
+    uint64_t notAllowed;        // Dropped because an allowlist is set
+    uint64_t bloomFalsePositives;
+    uint64_t learned;           // Addresses added to the denylist by learning
+    uint32_t sightings;         // Addresses being counted towards learning
+    uint32_t denySize;
+    uint32_t allowSize;
+    uint64_t version;           // Membership changes published
+};
+
+class AddressFilter {
+public:
+    // Sightings tracked for learning at most; when full, every count drops
+    // by one and addresses seen only once are forgotten
+    static const size_t MAX_SIGHTINGS = 16384;
+
+    AddressFilter() : version_(next_version()), current_(std::make_shared<Snapshot>()),
+                      learn_threshold_(0), learn_full_(false), learn_capacity_(4096), learned_count_(0), stats_() {}
+
+    AddressFilter(const AddressFilter&) = delete;
+    AddressFilter& operator=(const AddressFilter&) = delete;
+
+    // Hot path: true if adverts from this address should be processed
+    bool admit(uint64_t address) {
+        Local& local = local_state();
+        const Snapshot& snapshot = *local.snapshot;
+        Counters& counters = *local.counters;
+        bump(counters.checked);
+        if (snapshot.deny.maybe_contains(address)) {
+            if (snapshot.deny.contains(address)) {
+                bump(counters.denied);
+                return false;
+            }
+            bump(counters.falsePositives);
+        }
+        if (!snapshot.allow.empty()) {
+            if (!snapshot.allow.maybe_contains(address) || !snapshot.allow.contains(address)) {
+                bump(counters.notAllowed);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Membership changes (any thread; publish a new snapshot)
+    void add(AddressList list, uint64_t address) {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        std::vector<uint64_t> addresses = list_of(list).addresses();
+        addresses.push_back(address);
+        publish(list, std::move(addresses));
+    }
+
+    bool remove(AddressList list, uint64_t address) {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        std::vector<uint64_t> addresses = list_of(list).addresses();
+        auto it = std::lower_bound(addresses.begin(), addresses.end(), address);
+        if (it == addresses.end() || *it != address) return false;
+        addresses.erase(it);
+        publish(list, std::move(addresses));
+        return true;
+    }
+
+    void set(AddressList list, std::vector<uint64_t> addresses) {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        publish(list, std::move(addresses));
+    }
+
+    // Learn denylist entries: an address reported irrelevant threshold
+    // times is denied (0 disables learning). At most capacity learned
+    // addresses are kept.
+    void set_learning(uint32_t threshold, size_t capacity = 4096) {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        learn_threshold_.store(threshold, std::memory_order_relaxed);
+        learn_capacity_ = capacity;
+        learn_full_.store(learned_count_ >= learn_capacity_, std::memory_order_relaxed);
+        sightings_.clear();
+    }
+
+    // Report an advert from a device known not to be a NIOX unit. Returns
+    // true if this sighting put the address on the denylist. Only report
+    // stable addresses: a rotating private address would be denied long
+    // after the device stopped using it.
+    bool observe_irrelevant(uint64_t address) {
+        if (learn_threshold_.load(std::memory_order_relaxed) == 0 || learn_full_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        const uint32_t threshold = learn_threshold_.load(std::memory_order_relaxed);
+        if (threshold == 0 || learned_count_ >= learn_capacity_) return false;
+        if (sightings_.size() >= MAX_SIGHTINGS && sightings_.find(address) == sightings_.end()) age_sightings();
+        if (++sightings_[address] < threshold) return false;
+        sightings_.erase(address);
+        std::vector<uint64_t> addresses = list_of(ADDRESS_DENY).addresses();
+        addresses.push_back(address);
+        publish(ADDRESS_DENY, std::move(addresses));
+        learned_count_++;
+        learn_full_.store(learned_count_ >= learn_capacity_, std::memory_order_relaxed);
+        stats_.learned++;
+        return true;
+    }
+
+    AddressFilterStats stats() const {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        AddressFilterStats stats = stats_;
+        for (const auto& counters : counters_) {
+            stats.checked += counters->checked.load(std::memory_order_relaxed);
+            stats.denied += counters->denied.load(std::memory_order_relaxed);
+            stats.notAllowed += counters->notAllowed.load(std::memory_order_relaxed);
+            stats.bloomFalsePositives += counters->falsePositives.load(std::memory_order_relaxed);
+        }
+        stats.denySize = static_cast<uint32_t>(current_->deny.size());
+        stats.allowSize = static_cast<uint32_t>(current_->allow.size());
+        stats.sightings = static_cast<uint32_t>(sightings_.size());
+        return stats;
+    }
+
+private:
+    struct Snapshot {
+        AddressSet deny;
+        AddressSet allow;
+    };
+
+    // Written by one thread only, so a plain load/store replaces the locked
+    // increment; the filter keeps each block so counts survive the thread
+    struct Counters {
+        std::atomic<uint64_t> checked{ 0 };
+        std::atomic<uint64_t> denied{ 0 };
+        std::atomic<uint64_t> notAllowed{ 0 };
+        std::atomic<uint64_t> falsePositives{ 0 };
+    };
+
+    struct Local {
+        const AddressFilter* owner = nullptr;
+        uint64_t version = 0;
+        std::shared_ptr<const Snapshot> snapshot;
+        std::shared_ptr<Counters> counters;
+    };
+
+    static void bump(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Per-thread snapshot reference, refreshed when the version changes (or
+    // the thread last used another filter)
+    Local& local_state() {
+        thread_local Local local;
+        const uint64_t version = version_.load(std::memory_order_acquire);
+        if (local.owner != this || local.version != version) {
+            std::lock_guard<std::mutex> lock(writer_mutex_);
+            if (local.owner != this) {
+                local.counters = std::make_shared<Counters>();
+                counters_.push_back(local.counters);
+            }
+            local.owner = this;
+            local.version = version_.load(std::memory_order_relaxed);
+            local.snapshot = current_;
+        }
+        return local;
+    }
+
+    // Caller holds writer_mutex_
+    const AddressSet& list_of(AddressList list) const {
+        return list == ADDRESS_ALLOW ? current_->allow : current_->deny;
+    }
+
+    // Caller holds writer_mutex_
+    void age_sightings() {
+        for (auto it = sightings_.begin(); it != sightings_.end();) {
+            if (--it->second == 0) it = sightings_.erase(it);
+            else ++it;
+        }
+    }
+
+    // Caller holds writer_mutex_
+    void publish(AddressList list, std::vector<uint64_t> addresses) {
+        auto next = std::make_shared<Snapshot>();
+        next->deny = list == ADDRESS_DENY ? AddressSet(std::move(addresses)) : current_->deny;
+        next->allow = list == ADDRESS_ALLOW ? AddressSet(std::move(addresses)) : current_->allow;
+        // Removing or clearing denylist entries frees learning capacity
+        if (list == ADDRESS_DENY && learned_count_ > next->deny.size()) {
+            learned_count_ = next->deny.size();
+            learn_full_.store(learned_count_ >= learn_capacity_, std::memory_order_relaxed);
+        }
+        current_ = std::move(next);
+        version_.store(next_version(), std::memory_order_release);
+        stats_.version++;
+    }
+
+    // Versions are unique across filters, so a thread's cached snapshot can
+    // never be mistaken for one of a filter created at the same address
+    static uint64_t next_version() {
+        static std::atomic<uint64_t> counter{ 0 };
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    std::atomic<uint64_t> version_;
+    std::shared_ptr<const Snapshot> current_;   // Guarded by writer_mutex_
+    mutable std::mutex writer_mutex_;
+    std::atomic<uint32_t> learn_threshold_;     // Read before taking the lock
+    std::atomic<bool> learn_full_;              // learned_count_ reached learn_capacity_
+    size_t learn_capacity_;
+    size_t learned_count_;
+    std::unordered_map<uint64_t, uint32_t> sightings_;
+    AddressFilterStats stats_;
+    std::vector<std::shared_ptr<Counters>> counters_;   // One per reader thread
+};
+
+} // namespace niox
+
+#endif // NIOX_ADDRESS_FILTER_H
@@ -0,0 +1,115 @@
+// NIOX advertisement - platform-neutral advertisement event and cache
+// Every advertisement source (WinRT watcher, injected test adverts) is
+// reduced to an AdvertisementEvent before entering the scan pipeline, and
+// the last one per address is cached so a connect needs no rescan.
+
+#ifndef NIOX_ADVERTISEMENT_H
+#define NIOX_ADVERTISEMENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+namespace niox {
+
+enum AddressType : uint8_t {
+    ADDRESS_PUBLIC = 0,
+    ADDRESS_RANDOM = 1,
+    ADDRESS_UNSPECIFIED = 2
+};
+
+// One received advertisement. Pointers are only valid for the duration of
+// the ingest call.
+struct AdvertisementEvent {
+    uint64_t address;
+    uint8_t addressType;      // AddressType
+    bool connectable;
+    bool scannable;           // A scan response may follow (see niox_scan_merge.h)
+    bool scanResponse;        // PDU was a scan response
+    int rssi;
+    int64_t timestampMs;
+    const char* name;         // UTF-8 local name, nullptr if absent
+    const uint8_t* data;      // Raw AD structures ([len][type][data]...)
+    size_t length;
+};
+
+static const size_t MAX_CACHED_ADVERTISEMENT = 255;
+
+// Last advertisement per device, with the metadata a direct connect needs
+struct CachedAdvertisement {
+    uint64_t address;
+    uint8_t addressType;
+    bool connectable;
+    int rssi;
+    int64_t seenMs;
+    uint16_t length;
+    uint8_t data[MAX_CACHED_ADVERTISEMENT];
+};
+
+// Not thread-safe: callers serialize access (the wrapper uses g_device_mutex)
+class AdvertisementCache {
+public:
+    void store(const AdvertisementEvent& event) {
+        auto inserted = entries_.try_emplace(event.address);
+        CachedAdvertisement& entry = inserted.first->second;
+        const bool fresh = inserted.second;
+        entry.address = event.address;
+        entry.addressType = event.addressType;
+        entry.rssi = event.rssi;
+        entry.seenMs = event.timestampMs;
+        // A scan response carries only its own AD structures and says nothing
+        // about connectability; keep the primary advertisement for both.
+        if (!event.scanResponse || fresh) entry.connectable = event.connectable;
+        if (!event.scanResponse || entry.length == 0) {
+            size_t length = event.length > MAX_CACHED_ADVERTISEMENT ? MAX_CACHED_ADVERTISEMENT : event.length;
+            if (length > 0) memcpy(entry.data, event.data, length);
+            entry.length = static_cast<uint16_t>(length);
+        }
+    }
+
+    const CachedAdvertisement* find(uint64_t address) const {
+        auto it = entries_.find(address);
+        return it == entries_.end() ? nullptr : &it->second;
+    }
+
+    // Drop private addresses (random, not static) last heard before
+    // cutoffMs; once rotated away they are never heard or connected again.
+    // Public and static addresses stay for direct connects. Returns the
+    // number removed.
+    size_t evict_private(int64_t cutoffMs) {
+        size_t removed = 0;
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            const bool rotating = it->second.addressType == ADDRESS_RANDOM && ((it->first >> 46) & 0x3) != 0x3;
+            if (rotating && it->second.seenMs < cutoffMs) {
+                it = entries_.erase(it);
+                removed++;
+            }
+            else {
+                ++it;
+            }
+        }
+        return removed;
+    }
+
+    size_t size() const { return entries_.size(); }
+    void clear() { entries_.clear(); }
+
+private:
+    std::unordered_map<uint64_t, CachedAdvertisement> entries_;
+};
+
+// Helper: Append one AD structure to a raw payload buffer. Returns the new
+// length, or the old one if the structure does not fit.
+inline size_t append_ad_structure(uint8_t* buffer, size_t length, size_t capacity,
+                                  uint8_t type, const uint8_t* data, size_t dataLength) {
+    if (dataLength > 254 || length + 2 + dataLength > capacity) return length;
+    buffer[length] = static_cast<uint8_t>(dataLength + 1);
+    buffer[length + 1] = type;
+    if (dataLength > 0) memcpy(buffer + length + 2, data, dataLength);
+    return length + 2 + dataLength;
+}
+
+} // namespace niox
+
+#endif // NIOX_ADVERTISEMENT_H
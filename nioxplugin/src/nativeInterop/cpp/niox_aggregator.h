@@ -0,0 +1,398 @@
+// NIOX aggregator - clinic-wide device view across several plugin hosts
+// Each node periodically sends compact device deltas to a collector, which
+// merges them into one table keyed by NIOX serial (or address when the
+// serial is unknown), keeping the best RSSI and the node that heard it.
+// Devices no node has reported for a while are expired on both sides.
+
+#ifndef NIOX_AGGREGATOR_H
+#define NIOX_AGGREGATOR_H
+
+#include "niox_transport.h"
+#include "niox_wire.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace niox {
+
+// Datagram layout (little-endian):
+//   header  magic u32 "NXAG" | version u8 | kind u8 | node u16 | sequence u32 | count u16 | reserved u16
+//   delta   address 6 bytes | serial u64 | rssi i8 | flags u8 | ageMs u16   (x count)
+static const uint32_t AGG_MAGIC = 0x4741584E;
+static const uint8_t AGG_VERSION = 1;
+static const uint8_t AGG_KIND_DELTAS = 0;
+static const uint8_t AGG_KIND_HEARTBEAT = 1;
+static const size_t AGG_HEADER_SIZE = 16;
+static const size_t AGG_DELTA_SIZE = 18;
+static const size_t AGG_MAX_DATAGRAM = 1200;   // Fits any path MTU without fragmentation
+static const size_t AGG_MAX_DELTAS = (AGG_MAX_DATAGRAM - AGG_HEADER_SIZE) / AGG_DELTA_SIZE;
+
+struct DeviceDelta {
+    uint64_t address;
+    uint64_t serial;    // Packed NIOX serial, 0 if none
+    int8_t rssi;
+    uint8_t flags;      // DEVICE_FLAG_* bits
+    uint16_t ageMs;     // How long ago the node heard it (saturating)
+};
+
+struct AggregateHeader {
+    uint8_t kind;
+    uint16_t nodeId;
+    uint32_t sequence;
+    uint16_t count;
+};
+
+// Encode a datagram; count must be <= AGG_MAX_DELTAS. Returns its length.
+inline size_t encode_aggregate(const AggregateHeader& header, const DeviceDelta* deltas, uint8_t* out) {
+    put_le(out, AGG_MAGIC, 4);
+    out[4] = AGG_VERSION;
+    out[5] = header.kind;
+    put_le(out + 6, header.nodeId, 2);
+    put_le(out + 8, header.sequence, 4);
+    put_le(out + 12, header.count, 2);
+    put_le(out + 14, 0, 2);
+    uint8_t* p = out + AGG_HEADER_SIZE;
+    for (uint16_t i = 0; i < header.count; i++, p += AGG_DELTA_SIZE) {
+        put_le(p, deltas[i].address, 6);
+        put_le(p + 6, deltas[i].serial, 8);
+        p[14] = static_cast<uint8_t>(deltas[i].rssi);
+        p[15] = deltas[i].flags;
+        put_le(p + 16, deltas[i].ageMs, 2);
+    }
+    return AGG_HEADER_SIZE + header.count * AGG_DELTA_SIZE;
+}
+
+// Validate a datagram and read its header. Returns false if malformed.
+inline bool decode_aggregate_header(const uint8_t* data, size_t length, AggregateHeader* header) {
+    if (length < AGG_HEADER_SIZE) return false;
+    if (get_le(data, 4) != AGG_MAGIC || data[4] != AGG_VERSION) return false;
+    header->kind = data[5];
+    header->nodeId = static_cast<uint16_t>(get_le(data + 6, 2));
+    header->sequence = static_cast<uint32_t>(get_le(data + 8, 4));
+    header->count = static_cast<uint16_t>(get_le(data + 12, 2));
+    return length >= AGG_HEADER_SIZE + header->count * AGG_DELTA_SIZE;
+}
+
+inline DeviceDelta decode_aggregate_delta(const uint8_t* data, size_t index) {
+    const uint8_t* p = data + AGG_HEADER_SIZE + index * AGG_DELTA_SIZE;
+    DeviceDelta delta;
+    delta.address = get_le(p, 6);
+    delta.serial = get_le(p + 6, 8);
+    delta.rssi = static_cast<int8_t>(p[14]);
+    delta.flags = p[15];
+    delta.ageMs = static_cast<uint16_t>(get_le(p + 16, 2));
+    return delta;
+}
+
+// Node side: decides which devices changed enough to be worth sending.
+// A device is sent when it is new, its RSSI moved by at least rssiStep dB,
+// its flags changed, or it has not been refreshed for refreshMs.
+class DeltaTracker {
+public:
+    DeltaTracker(int rssiStep = 2, int64_t refreshMs = 5000)
+        : rssi_step_(rssiStep), refresh_ms_(refreshMs) {}
+
+    // Forget devices last sent before nowMs - maxAgeMs (no longer in the
+    // node's snapshot); they count as new if heard again
+    void expire(int64_t nowMs, int64_t maxAgeMs) {
+        for (auto it = sent_.begin(); it != sent_.end();) {
+            if (nowMs - it->second.sentMs > maxAgeMs) it = sent_.erase(it);
+            else ++it;
+        }
+    }
+
+    size_t size() const { return sent_.size(); }
+
+    bool should_send(const DeviceDelta& delta, int64_t nowMs) {
+        auto it = sent_.find(delta.address);
+        if (it != sent_.end()) {
+            const Sent& sent = it->second;
+            int drift = delta.rssi - sent.rssi;
+            if (drift < 0) drift = -drift;
+            if (drift < rssi_step_ && delta.flags == sent.flags &&
+                delta.serial == sent.serial && nowMs - sent.sentMs < refresh_ms_) {
+                return false;
+            }
+        }
+        sent_[delta.address] = Sent{ delta.serial, nowMs, delta.rssi, delta.flags };
+        return true;
+    }
+
+    void clear() { sent_.clear(); }
+
+private:
+    struct Sent {
+        uint64_t serial;
+        int64_t sentMs;
+        int8_t rssi;
+        uint8_t flags;
+    };
+
+    int rssi_step_;
+    int64_t refresh_ms_;
+    std::unordered_map<uint64_t, Sent> sent_;
+};
+
+// One merged device in the collector
+struct AggregatedDevice {
+    uint64_t address;
+    uint64_t serial;
+    int bestRssi;
+    uint16_t bestNode;      // Node that reported bestRssi
+    int64_t bestSeenMs;     // When bestNode last heard it (collector clock)
+    int64_t lastSeenMs;     // When any node last heard it
+};
+
+// Per-node freshness and delivery counters
+struct NodeStatus {
+    uint16_t nodeId;
+    int64_t lastHeardMs;
+    uint32_t lastSequence;
+    uint64_t datagrams;
+    uint64_t lost;          // Sequence gaps
+    uint64_t deltas;
+};
+
+// Collector side: merges deltas from every node. Thread-safe.
+class Collector {
+public:
+    // A best-RSSI report older than staleMs yields to any fresher report;
+    // a device no node has heard for expireMs is dropped
+    explicit Collector(int64_t staleMs = 10000, int64_t expireMs = 120000)
+        : stale_ms_(staleMs), expire_ms_(expireMs), last_sweep_ms_(0) {}
+
+    // Merge one datagram. Returns false if it was malformed.
+    bool ingest(const uint8_t* data, size_t length, int64_t nowMs) {
+        AggregateHeader header;
+        if (!decode_aggregate_header(data, length, &header)) return false;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        NodeStatus& node = node_status(header.nodeId);
+        if (node.datagrams > 0 && header.sequence > node.lastSequence + 1) {
+            node.lost += header.sequence - node.lastSequence - 1;
+        }
+        node.lastSequence = header.sequence;
+        node.lastHeardMs = nowMs;
+        node.datagrams++;
+        node.deltas += header.count;
+
+        for (uint16_t i = 0; i < header.count; i++) {
+            merge(header.nodeId, decode_aggregate_delta(data, i), nowMs);
+        }
+        if (nowMs - last_sweep_ms_ >= SWEEP_INTERVAL_MS) {
+            last_sweep_ms_ = nowMs;
+            expire_locked(nowMs);
+        }
+        return true;
+    }
+
+    // Drop devices not heard since nowMs - expireMs (ingest does this too,
+    // at most once a second)
+    void expire(int64_t nowMs) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        expire_locked(nowMs);
+    }
+
+    void snapshot_devices(std::vector<AggregatedDevice>& out) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out.clear();
+        out.reserve(devices_.size());
+        for (const auto& entry : devices_) out.push_back(entry.second);
+    }
+
+    void snapshot_nodes(std::vector<NodeStatus>& out) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out.clear();
+        out.reserve(nodes_.size());
+        for (const auto& entry : nodes_) out.push_back(entry.second);
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return devices_.size();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        devices_.clear();
+        serial_by_address_.clear();
+        nodes_.clear();
+    }
+
+private:
+    static const int64_t SWEEP_INTERVAL_MS = 1000;
+
+    // Serial-keyed entries use the packed serial (bit 63 always clear);
+    // address-keyed entries set bit 63 so the two spaces cannot collide.
+    static uint64_t address_key(uint64_t address) { return address | (1ull << 63); }
+
+    NodeStatus& node_status(uint16_t nodeId) {
+        auto it = nodes_.find(nodeId);
+        if (it == nodes_.end()) {
+            it = nodes_.emplace(nodeId, NodeStatus{ nodeId, 0, 0, 0, 0, 0 }).first;
+        }
+        return it->second;
+    }
+
+    void merge(uint16_t nodeId, const DeviceDelta& delta, int64_t nowMs) {
+        const int64_t seenMs = nowMs - delta.ageMs;
+        uint64_t key = address_key(delta.address);
+        uint64_t serial = delta.serial;
+        if (delta.serial != 0) {
+            // The name (and serial) may reach us after the device was first
+            // reported by address alone; fold that entry into the serial key.
+            devices_.erase(key);
+            key = delta.serial;
+            serial_by_address_[delta.address] = delta.serial;
+        }
+        else {
+            // A node that has not decoded the name yet still reports a
+            // device another node already knows by serial
+            auto known = serial_by_address_.find(delta.address);
+            if (known != serial_by_address_.end()) key = serial = known->second;
+        }
+
+        auto it = devices_.find(key);
+        if (it == devices_.end()) {
+            devices_.emplace(key, AggregatedDevice{ delta.address, serial, delta.rssi, nodeId, seenMs, seenMs });
+            return;
+        }
+
+        AggregatedDevice& device = it->second;
+        device.address = delta.address;
+        if (seenMs > device.lastSeenMs) device.lastSeenMs = seenMs;
+        const bool best_is_stale = seenMs - device.bestSeenMs > stale_ms_;
+        if (nodeId == device.bestNode || delta.rssi > device.bestRssi || best_is_stale) {
+            device.bestRssi = delta.rssi;
+            device.bestNode = nodeId;
+            device.bestSeenMs = seenMs;
+        }
+    }
+
+    void expire_locked(int64_t nowMs) {
+        for (auto it = devices_.begin(); it != devices_.end();) {
+            if (nowMs - it->second.lastSeenMs > expire_ms_) it = devices_.erase(it);
+            else ++it;
+        }
+        for (auto it = serial_by_address_.begin(); it != serial_by_address_.end();) {
+            if (devices_.find(it->second) == devices_.end()) it = serial_by_address_.erase(it);
+            else ++it;
+        }
+    }
+
+    int64_t stale_ms_;
+    int64_t expire_ms_;
+    int64_t last_sweep_ms_;
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, AggregatedDevice> devices_;
+    std::unordered_map<uint64_t, uint64_t> serial_by_address_;     // Addresses reported with a serial
+    std::unordered_map<uint16_t, NodeStatus> nodes_;
+};
+
+// Runs a collector receive loop and/or a node send loop on background threads
+class AggregationService {
+public:
+    // Fills the node's current device state; called once per send interval
+    typedef std::function<void(std::vector<DeviceDelta>& out, int64_t nowMs)> SnapshotFn;
+
+    AggregationService() : running_(false) {}
+    ~AggregationService() { stop(); }
+
+    bool start_collector(const Endpoint& endpoint) {
+        if (collector_thread_.joinable()) return false;
+        if (!collector_socket_.bind(endpoint, RECEIVE_TIMEOUT_MS)) return false;
+        running_ = true;
+        collector_thread_ = std::thread([this]() {
+            uint8_t buffer[AGG_MAX_DATAGRAM];
+            while (running_) {
+                int n = collector_socket_.receive(buffer, sizeof(buffer));
+                if (n > 0) collector_.ingest(buffer, static_cast<size_t>(n), clock_ms());
+            }
+        });
+        return true;
+    }
+
+    bool start_node(uint16_t nodeId, const Endpoint& collector, int intervalMs, SnapshotFn snapshot) {
+        if (node_thread_.joinable() || !snapshot) return false;
+        if (!node_socket_.connect(collector)) return false;
+        running_ = true;
+        node_thread_ = std::thread([this, nodeId, intervalMs, snapshot]() {
+            DeltaTracker tracker;
+            const int64_t forgetMs = 4 * static_cast<int64_t>(intervalMs) > TRACKER_EXPIRY_MS
+                ? 4 * static_cast<int64_t>(intervalMs) : TRACKER_EXPIRY_MS;
+            std::vector<DeviceDelta> current;
+            std::vector<DeviceDelta> pending;
+            uint8_t buffer[AGG_MAX_DATAGRAM];
+            uint32_t sequence = 0;
+            while (running_) {
+                const int64_t now = clock_ms();
+                current.clear();
+                pending.clear();
+                snapshot(current, now);
+                for (const DeviceDelta& delta : current) {
+                    if (tracker.should_send(delta, now)) pending.push_back(delta);
+                }
+                tracker.expire(now, forgetMs);
+
+                // Always send at least a heartbeat so the collector can track freshness
+                size_t offset = 0;
+                do {
+                    size_t count = pending.size() - offset;
+                    if (count > AGG_MAX_DELTAS) count = AGG_MAX_DELTAS;
+                    AggregateHeader header;
+                    header.kind = count > 0 ? AGG_KIND_DELTAS : AGG_KIND_HEARTBEAT;
+                    header.nodeId = nodeId;
+                    header.sequence = ++sequence;
+                    header.count = static_cast<uint16_t>(count);
+                    size_t length = encode_aggregate(header, pending.data() + offset, buffer);
+                    node_socket_.send(buffer, length);
+                    offset += count;
+                } while (offset < pending.size());
+
+                sleep_interruptible(intervalMs);
+            }
+        });
+        return true;
+    }
+
+    void stop() {
+        running_ = false;
+        if (collector_thread_.joinable()) collector_thread_.join();
+        if (node_thread_.joinable()) node_thread_.join();
+        collector_socket_.close();
+        node_socket_.close();
+    }
+
+    Collector& collector() { return collector_; }
+
+    static int64_t clock_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    static const int RECEIVE_TIMEOUT_MS = 100;
+    static const int64_t TRACKER_EXPIRY_MS = 60000;    // Past the snapshot's 65 s age limit, plus refreshes
+
+    void sleep_interruptible(int ms) {
+        for (int slept = 0; running_ && slept < ms; slept += 10) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    std::atomic<bool> running_;
+    Collector collector_;
+    DatagramSocket collector_socket_;
+    DatagramSocket node_socket_;
+    std::thread collector_thread_;
+    std::thread node_thread_;
+};
+
+} // namespace niox
+
+#endif // NIOX_AGGREGATOR_H
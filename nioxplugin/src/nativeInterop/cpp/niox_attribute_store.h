@@ -0,0 +1,366 @@
+// NIOX attribute store - persistent GATT attribute maps, memory-mapped
+// The attribute layout of a unit only changes with its firmware, so the
+// discovered characteristic table is kept on disk per device and reused on
+// later connects (and later runs) instead of rediscovering.
+//
+// File layout (little-endian)
+//   header   magic "NXGA" | version u32 | entry count u32 | reserved u32
+//   index    entry count x { address u64 | serial u64 | firmware hash u64 | first u32 | count u32 }
+//            sorted by address
+//   records  { service 16 | characteristic 16 | handle u16 | properties u8 | pad u8 }
+// The file is only ever replaced whole (write temp file, rename), so a
+// reader never sees a partial update.
+
+#ifndef NIOX_ATTRIBUTE_STORE_H
+#define NIOX_ATTRIBUTE_STORE_H
+
+#include "niox_gatt.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace niox {
+
+// Read-only view of a whole file (others may keep writing to it, e.g. a live scan log)
+class MappedFile {
+public:
+    MappedFile() : data_(nullptr), size_(0) {}
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false if the file is missing or empty
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0) {
+            close();
+            return false;
+        }
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ == nullptr) {
+            close();
+            return false;
+        }
+        data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        if (data_ == nullptr) {
+            close();
+            return false;
+        }
+        size_ = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) return false;
+        data_ = static_cast<const uint8_t*>(data);
+        size_ = static_cast<size_t>(st.st_size);
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#endif
+};
+
+struct AttributeStoreStats {
+    uint64_t lookups;
+    uint64_t hits;          // Entry found and its firmware revision confirmed
+    uint64_t misses;        // No entry, or entry for another serial
+    uint64_t stale;         // Entry found but the firmware revision changed
+    uint64_t writes;        // File rewrites
+    uint64_t entries;
+};
+
+// Persistent map address -> (serial, firmware hash, characteristics).
+// Thread-safe. Lookups read the mapping; put/erase rewrite the file.
+class AttributeStore : public AttributePersistence {
+public:
+    static const uint32_t VERSION = 1;
+
+    AttributeStore() : stats_() {}
+
+    // Map an existing file or start empty; an unreadable or malformed file
+    // is treated as empty and replaced on the next put
+    bool open(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path_ = path;
+        remap();
+        return !path_.empty();
+    }
+
+    // A serial of 0 (unknown) on either side matches any
+    bool find(uint64_t address, uint64_t serial, std::vector<GattCharacteristic>& out, uint64_t* firmwareHash) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.lookups++;
+        const uint8_t* entry = find_entry(address);
+        if (entry == nullptr || (serial != 0 && read_u64(entry + 8) != 0 && read_u64(entry + 8) != serial)) {
+            stats_.misses++;
+            return false;
+        }
+        *firmwareHash = read_u64(entry + 16);
+        const uint32_t first = read_u32(entry + 24);
+        const uint32_t count = read_u32(entry + 28);
+        out.resize(count);
+        const uint8_t* record = records_ + static_cast<size_t>(first) * RECORD_SIZE;
+        for (uint32_t i = 0; i < count; i++, record += RECORD_SIZE) {
+            out[i].service = Uuid{ read_u64(record), read_u64(record + 8) };
+            out[i].characteristic = Uuid{ read_u64(record + 16), read_u64(record + 24) };
+            out[i].handle = static_cast<uint16_t>(record[32] | (record[33] << 8));
+            out[i].properties = record[34];
+        }
+        return true;
+    }
+
+    void accept(uint64_t /*address*/) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.hits++;
+    }
+
+    void reject(uint64_t address) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.stale++;
+        rewrite(address, nullptr);
+    }
+
+    void put(uint64_t address, uint64_t serial, uint64_t firmwareHash,
+             const std::vector<GattCharacteristic>& characteristics) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry entry;
+        entry.address = address;
+        entry.serial = serial;
+        entry.firmwareHash = firmwareHash;
+        entry.characteristics = characteristics;
+        rewrite(address, &entry);
+    }
+
+    void erase(uint64_t address) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (find_entry(address) != nullptr) rewrite(address, nullptr);
+    }
+
+    AttributeStoreStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        AttributeStoreStats stats = stats_;
+        stats.entries = entry_count_;
+        return stats;
+    }
+
+private:
+    static const size_t HEADER_SIZE = 16;
+    static const size_t ENTRY_SIZE = 32;
+    static const size_t RECORD_SIZE = 36;
+
+    struct Entry {
+        uint64_t address;
+        uint64_t serial;
+        uint64_t firmwareHash;
+        std::vector<GattCharacteristic> characteristics;
+    };
+
+    static uint32_t read_u32(const uint8_t* p) {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static uint64_t read_u64(const uint8_t* p) {
+        uint64_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static void put_u32(std::vector<uint8_t>& out, uint32_t value) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), p, p + sizeof(value));
+    }
+
+    static void put_u64(std::vector<uint8_t>& out, uint64_t value) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), p, p + sizeof(value));
+    }
+
+    // Caller holds mutex_. Validates the mapped image; on any inconsistency
+    // the store behaves as empty.
+    void remap() {
+        file_.close();
+        index_ = nullptr;
+        records_ = nullptr;
+        entry_count_ = 0;
+        if (path_.empty() || !file_.open(path_)) return;
+
+        const uint8_t* data = file_.data();
+        const size_t size = file_.size();
+        if (size < HEADER_SIZE || memcmp(data, "NXGA", 4) != 0 || read_u32(data + 4) != VERSION) return;
+        const uint32_t count = read_u32(data + 8);
+        if ((size - HEADER_SIZE) / ENTRY_SIZE < count) return;
+        const size_t recordBytes = size - HEADER_SIZE - count * ENTRY_SIZE;
+        const uint8_t* index = data + HEADER_SIZE;
+        for (uint32_t i = 0; i < count; i++) {
+            const uint8_t* entry = index + i * ENTRY_SIZE;
+            const uint64_t end = static_cast<uint64_t>(read_u32(entry + 24)) + read_u32(entry + 28);
+            if (end * RECORD_SIZE > recordBytes) return;
+            if (i > 0 && read_u64(entry) <= read_u64(entry - ENTRY_SIZE)) return;
+        }
+        index_ = index;
+        records_ = index + count * ENTRY_SIZE;
+        entry_count_ = count;
+    }
+
+    // Caller holds mutex_. Binary search of the sorted index.
+    const uint8_t* find_entry(uint64_t address) const {
+        size_t lo = 0;
+        size_t hi = entry_count_;
+        while (lo < hi) {
+            const size_t mid = (lo + hi) / 2;
+            const uint64_t key = read_u64(index_ + mid * ENTRY_SIZE);
+            if (key == address) return index_ + mid * ENTRY_SIZE;
+            if (key < address) lo = mid + 1;
+            else hi = mid;
+        }
+        return nullptr;
+    }
+
+    // Caller holds mutex_. Rebuild the image with `address` replaced by
+    // `replacement` (or removed when null), write it beside the old file,
+    // then swap it in and remap.
+    void rewrite(uint64_t address, const Entry* replacement) {
+        std::vector<uint8_t> index;
+        std::vector<uint8_t> records;
+        uint32_t count = 0;
+        uint32_t nextRecord = 0;
+        bool inserted = replacement == nullptr;
+
+        auto append = [&](uint64_t entryAddress, uint64_t serial, uint64_t firmwareHash,
+                          const uint8_t* rawRecords, const GattCharacteristic* characteristics, uint32_t recordCount) {
+            put_u64(index, entryAddress);
+            put_u64(index, serial);
+            put_u64(index, firmwareHash);
+            put_u32(index, nextRecord);
+            put_u32(index, recordCount);
+            if (rawRecords) {
+                records.insert(records.end(), rawRecords, rawRecords + recordCount * RECORD_SIZE);
+            }
+            else {
+                for (uint32_t i = 0; i < recordCount; i++) {
+                    const GattCharacteristic& c = characteristics[i];
+                    put_u64(records, c.service.hi);
+                    put_u64(records, c.service.lo);
+                    put_u64(records, c.characteristic.hi);
+                    put_u64(records, c.characteristic.lo);
+                    records.push_back(static_cast<uint8_t>(c.handle));
+                    records.push_back(static_cast<uint8_t>(c.handle >> 8));
+                    records.push_back(c.properties);
+                    records.push_back(0);
+                }
+            }
+            nextRecord += recordCount;
+            count++;
+        };
+        auto append_replacement = [&]() {
+            append(replacement->address, replacement->serial, replacement->firmwareHash, nullptr,
+                   replacement->characteristics.data(), static_cast<uint32_t>(replacement->characteristics.size()));
+            inserted = true;
+        };
+
+        for (size_t i = 0; i < entry_count_; i++) {
+            const uint8_t* entry = index_ + i * ENTRY_SIZE;
+            const uint64_t entryAddress = read_u64(entry);
+            if (!inserted && replacement->address < entryAddress) append_replacement();
+            if (entryAddress == address) continue;
+            append(entryAddress, read_u64(entry + 8), read_u64(entry + 16),
+                   records_ + static_cast<size_t>(read_u32(entry + 24)) * RECORD_SIZE, nullptr, read_u32(entry + 28));
+        }
+        if (!inserted) append_replacement();
+
+        std::vector<uint8_t> image;
+        image.reserve(HEADER_SIZE + index.size() + records.size());
+        image.insert(image.end(), { 'N', 'X', 'G', 'A' });
+        put_u32(image, VERSION);
+        put_u32(image, count);
+        put_u32(image, 0);
+        image.insert(image.end(), index.begin(), index.end());
+        image.insert(image.end(), records.begin(), records.end());
+
+        // The old mapping must be released before the file can be replaced (Windows)
+        file_.close();
+        index_ = nullptr;
+        records_ = nullptr;
+        entry_count_ = 0;
+        if (!path_.empty() && replace_file(image)) stats_.writes++;
+        remap();
+    }
+
+    bool replace_file(const std::vector<uint8_t>& image) {
+        const std::string temp = path_ + ".tmp";
+        FILE* file = fopen(temp.c_str(), "wb");
+        if (file == nullptr) return false;
+        const bool written = fwrite(image.data(), 1, image.size(), file) == image.size();
+        if (fclose(file) != 0 || !written) {
+            remove(temp.c_str());
+            return false;
+        }
+#ifdef _WIN32
+        return MoveFileExA(temp.c_str(), path_.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        return rename(temp.c_str(), path_.c_str()) == 0;
+#endif
+    }
+
+    mutable std::mutex mutex_;
+    std::string path_;
+    MappedFile file_;
+    const uint8_t* index_ = nullptr;
+    const uint8_t* records_ = nullptr;
+    size_t entry_count_ = 0;
+    AttributeStoreStats stats_;
+};
+
+} // namespace niox
+
+#endif // NIOX_ATTRIBUTE_STORE_H
@@ -0,0 +1,327 @@
+// NIOX btsnoop - advertisements from HCI captures, for replay without a radio
+// Reads btsnoop files (Linux btmon / hcidump, Android, and Windows HCI
+// traces converted with btvs) and turns LE Advertising Report and LE
+// Extended Advertising Report events into AdvertisementEvents for the same
+// pipeline the WinRT watcher feeds. Everything else in the capture
+// (commands, ACL data, other events) is skipped.
+//
+// btsnoop layout (big-endian)
+//   header   "btsnoop\0" | version u32 (1) | datalink u32
+//   record   original length u32 | included length u32 | flags u32
+//            | cumulative drops u32 | timestamp i64 (us since 0 AD) | packet
+// Datalinks: 1001 HCI (flags bit 1 marks events), 1002 HCI UART / H4 (the
+// first byte is the packet type), 2001 Linux monitor (flags low 16 bits are
+// the opcode).
+//
+// Extended reports may split one advertisement over several events (data
+// status "incomplete"); the fragments are joined per address and set ID.
+
+#ifndef NIOX_BTSNOOP_H
+#define NIOX_BTSNOOP_H
+
+#include "niox_advertisement.h"
+#include "niox_attribute_store.h"
+#include "niox_scan_merge.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace niox {
+
+static const uint32_t BTSNOOP_DATALINK_HCI = 1001;
+static const uint32_t BTSNOOP_DATALINK_H4 = 1002;
+static const uint32_t BTSNOOP_DATALINK_MONITOR = 2001;
+static const size_t BTSNOOP_HEADER_SIZE = 16;
+static const size_t BTSNOOP_RECORD_HEADER_SIZE = 24;
+static const int64_t BTSNOOP_UNIX_EPOCH_US = 0x00DCDDB30F2F8000ll;     // 1970-01-01 in btsnoop time
+
+static const uint8_t HCI_EVENT_LE_META = 0x3E;
+static const uint8_t HCI_LE_ADVERTISING_REPORT = 0x02;
+static const uint8_t HCI_LE_EXTENDED_ADVERTISING_REPORT = 0x0D;
+static const uint8_t AD_TYPE_SHORT_NAME = 0x08;
+static const uint8_t AD_TYPE_COMPLETE_NAME = 0x09;
+static const int8_t HCI_RSSI_UNAVAILABLE = 127;
+
+// Longest extended advertisement kept after joining fragments (Core spec maximum)
+static const size_t MAX_EXTENDED_ADVERTISEMENT = 1650;
+
+struct BtsnoopStats {
+    uint64_t records;           // btsnoop records read
+    uint64_t events;            // LE advertising report events among them
+    uint64_t reports;           // Advertisements produced
+    uint64_t extended;          // ... of which from extended reports
+    uint64_t fragments;         // Extended report fragments joined
+    uint64_t malformed;         // Events or records that did not parse
+};
+
+// Helper: Big-endian fields of the btsnoop framing
+inline uint32_t get_be32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+inline uint64_t get_be64(const uint8_t* p) {
+    return (static_cast<uint64_t>(get_be32(p)) << 32) | get_be32(p + 4);
+}
+
+// Helper: 48-bit address from HCI byte order (least significant first)
+inline uint64_t hci_address(const uint8_t* p) {
+    uint64_t address = 0;
+    for (int i = 5; i >= 0; i--) address = (address << 8) | p[i];
+    return address;
+}
+
+// Helper: Copy the local name (complete preferred over shortened) out of a
+// raw AD payload. Returns false if there is none.
+inline bool find_local_name(const uint8_t* payload, size_t length, char* name, size_t capacity) {
+    bool found = false;
+    size_t pos = 0;
+    while (pos < length) {
+        const size_t fieldLength = payload[pos];
+        if (fieldLength == 0 || pos + 1 + fieldLength > length) break;
+        const uint8_t type = payload[pos + 1];
+        if (type == AD_TYPE_COMPLETE_NAME || (type == AD_TYPE_SHORT_NAME && !found)) {
+            size_t nameLength = fieldLength - 1;
+            if (nameLength >= capacity) nameLength = capacity - 1;
+            memcpy(name, payload + pos + 2, nameLength);
+            name[nameLength] = '\0';
+            found = true;
+            if (type == AD_TYPE_COMPLETE_NAME) return true;
+        }
+        pos += 1 + fieldLength;
+    }
+    return found;
+}
+
+// One advertisement taken from a capture. event() points into this object.
+struct BtsnoopAdvertisement {
+    int64_t captureUs;          // btsnoop timestamp (see BTSNOOP_UNIX_EPOCH_US)
+    uint64_t address;
+    uint8_t addressType;
+    bool connectable;
+    bool scannable;
+    bool scanResponse;
+    int rssi;
+    bool hasName;
+    char name[MAX_MERGED_NAME + 1];
+    size_t length;
+    const uint8_t* data;        // Into the capture, or the joined fragments
+
+    AdvertisementEvent event(int64_t timestampMs) const {
+        AdvertisementEvent event;
+        event.address = address;
+        event.addressType = addressType;
+        event.connectable = connectable;
+        event.scannable = scannable;
+        event.scanResponse = scanResponse;
+        event.rssi = rssi;
+        event.timestampMs = timestampMs;
+        event.name = hasName ? name : nullptr;
+        event.data = data;
+        event.length = length;
+        return event;
+    }
+};
+
+// Sequential reader over a mapped capture. next() yields one advertisement
+// at a time; an event with several reports yields each in turn.
+class BtsnoopReader {
+public:
+    BtsnoopReader() : data_(nullptr), size_(0), datalink_(0) { rewind(); }
+
+    BtsnoopReader(const BtsnoopReader&) = delete;
+    BtsnoopReader& operator=(const BtsnoopReader&) = delete;
+
+    // Returns false if the file is missing, not btsnoop, or an unsupported datalink
+    bool open(const std::string& path) {
+        if (!file_.open(path)) return false;
+        if (!attach(file_.data(), file_.size())) {
+            file_.close();
+            return false;
+        }
+        return true;
+    }
+
+    // Read a capture already in memory (kept by the caller)
+    bool attach(const uint8_t* data, size_t size) {
+        data_ = nullptr;
+        size_ = 0;
+        if (size < BTSNOOP_HEADER_SIZE || memcmp(data, "btsnoop\0", 8) != 0 || get_be32(data + 8) != 1) return false;
+        const uint32_t datalink = get_be32(data + 12);
+        if (datalink != BTSNOOP_DATALINK_HCI && datalink != BTSNOOP_DATALINK_H4 &&
+            datalink != BTSNOOP_DATALINK_MONITOR) return false;
+        data_ = data;
+        size_ = size;
+        datalink_ = datalink;
+        rewind();
+        return true;
+    }
+
+    // Start over from the first record (stats are reset)
+    void rewind() {
+        offset_ = BTSNOOP_HEADER_SIZE;
+        capture_us_ = 0;
+        event_ = nullptr;
+        event_end_ = nullptr;
+        remaining_ = 0;
+        extended_ = false;
+        fragments_.clear();
+        stats_ = BtsnoopStats();
+    }
+
+    // Returns false at the end of the capture (or at a torn final record)
+    bool next(BtsnoopAdvertisement* out) {
+        for (;;) {
+            if (remaining_ > 0) {
+                remaining_--;
+                if (extended_ ? extended_report(out) : legacy_report(out)) return true;
+                continue;
+            }
+            if (!next_event()) return false;
+        }
+    }
+
+    const BtsnoopStats& stats() const { return stats_; }
+    uint32_t datalink() const { return datalink_; }
+
+private:
+    // Advance to the next LE advertising report event
+    bool next_event() {
+        while (data_ != nullptr && size_ - offset_ >= BTSNOOP_RECORD_HEADER_SIZE) {
+            const uint8_t* record = data_ + offset_;
+            const uint32_t included = get_be32(record + 4);
+            const uint32_t flags = get_be32(record + 8);
+            if (included > size_ - offset_ - BTSNOOP_RECORD_HEADER_SIZE) return false;
+            offset_ += BTSNOOP_RECORD_HEADER_SIZE + included;
+            stats_.records++;
+
+            const uint8_t* packet = record + BTSNOOP_RECORD_HEADER_SIZE;
+            size_t length = included;
+            if (datalink_ == BTSNOOP_DATALINK_H4) {
+                if (length == 0 || packet[0] != 0x04) continue;
+                packet++;
+                length--;
+            }
+            else if (datalink_ == BTSNOOP_DATALINK_HCI) {
+                if ((flags & 0x02) == 0) continue;      // Not a command / event packet
+                if ((flags & 0x01) == 0) continue;      // Sent to the controller: a command
+            }
+            else if ((flags & 0xFFFF) != 3) {           // Monitor opcode 3: event packet
+                continue;
+            }
+
+            if (length < 4 || packet[0] != HCI_EVENT_LE_META) continue;
+            if (packet[2] != HCI_LE_ADVERTISING_REPORT && packet[2] != HCI_LE_EXTENDED_ADVERTISING_REPORT) continue;
+            if (static_cast<size_t>(packet[1]) + 2 > length) {
+                stats_.malformed++;
+                continue;
+            }
+            stats_.events++;
+            capture_us_ = static_cast<int64_t>(get_be64(record + 16));
+            extended_ = packet[2] == HCI_LE_EXTENDED_ADVERTISING_REPORT;
+            remaining_ = packet[3];
+            event_ = packet + 4;
+            event_end_ = packet + 2 + packet[1];
+            return true;
+        }
+        return false;
+    }
+
+    // Helper: Stop decoding the rest of a malformed event
+    bool malformed() {
+        stats_.malformed++;
+        remaining_ = 0;
+        return false;
+    }
+
+    void fill(BtsnoopAdvertisement* out, uint64_t address, uint8_t addressType, int rssi) {
+        out->captureUs = capture_us_;
+        out->address = address;
+        // Identity address types (2, 3) as resolved by the controller
+        out->addressType = (addressType & 0x01) != 0 ? ADDRESS_RANDOM : ADDRESS_PUBLIC;
+        out->rssi = rssi;
+        out->hasName = find_local_name(out->data, out->length, out->name, sizeof(out->name));
+        stats_.reports++;
+    }
+
+    // Reports are read one after another (event type, address type,
+    // address, length, data, RSSI), as controllers and BlueZ lay them out
+    bool legacy_report(BtsnoopAdvertisement* out) {
+        if (event_end_ - event_ < 9) return malformed();
+        const uint8_t type = event_[0];
+        const uint8_t dataLength = event_[8];
+        if (event_end_ - event_ < 10 + dataLength) return malformed();
+        out->connectable = type == 0x00 || type == 0x01;     // ADV_IND, ADV_DIRECT_IND
+        out->scannable = type == 0x00 || type == 0x02;       // ADV_IND, ADV_SCAN_IND
+        out->scanResponse = type == 0x04;                     // SCAN_RSP
+        out->data = event_ + 9;
+        out->length = dataLength;
+        const uint64_t address = hci_address(event_ + 2);
+        const uint8_t addressType = event_[1];
+        const int rssi = static_cast<int8_t>(event_[9 + dataLength]);
+        event_ += 10 + dataLength;
+        fill(out, address, addressType, rssi);
+        return true;
+    }
+
+    bool extended_report(BtsnoopAdvertisement* out) {
+        if (event_end_ - event_ < 24) return malformed();
+        const uint16_t type = static_cast<uint16_t>(event_[0] | (event_[1] << 8));
+        const uint8_t addressType = event_[2];
+        const uint64_t address = hci_address(event_ + 3);
+        const uint8_t sid = event_[11];
+        const int8_t rssi = static_cast<int8_t>(event_[13]);
+        const uint8_t dataLength = event_[23];
+        if (event_end_ - event_ < 24 + dataLength) return malformed();
+        const uint8_t* data = event_ + 24;
+        event_ += 24 + dataLength;
+
+        // Data status: 0 complete, 1 incomplete (more to come), 2 truncated
+        const uint8_t status = (type >> 5) & 0x03;
+        const uint64_t key = address | (static_cast<uint64_t>(sid) << 48) | (static_cast<uint64_t>(addressType) << 56);
+        auto pending = fragments_.find(key);
+        if (status == 1 || pending != fragments_.end()) {
+            std::vector<uint8_t>& joined = fragments_[key];
+            const size_t room = MAX_EXTENDED_ADVERTISEMENT - joined.size();
+            joined.insert(joined.end(), data, data + (dataLength < room ? dataLength : room));
+            stats_.fragments++;
+            if (status == 1) return false;
+            joined_.swap(joined);
+            fragments_.erase(key);
+            out->data = joined_.data();
+            out->length = joined_.size();
+        }
+        else {
+            out->data = data;
+            out->length = dataLength;
+        }
+
+        out->connectable = (type & 0x01) != 0;
+        out->scannable = (type & 0x02) != 0;
+        out->scanResponse = (type & 0x08) != 0;
+        fill(out, address, addressType, rssi == HCI_RSSI_UNAVAILABLE ? -127 : rssi);
+        stats_.extended++;
+        return true;
+    }
+
+    MappedFile file_;
+    const uint8_t* data_;
+    size_t size_;
+    uint32_t datalink_;
+    size_t offset_;
+    int64_t capture_us_;
+    const uint8_t* event_;          // Next report in the current event
+    const uint8_t* event_end_;
+    uint32_t remaining_;            // Reports left in the current event
+    bool extended_;
+    std::unordered_map<uint64_t, std::vector<uint8_t>> fragments_;     // Incomplete extended adverts
+    std::vector<uint8_t> joined_;   // Last joined advert (backs BtsnoopAdvertisement::data)
+    BtsnoopStats stats_;
+};
+
+} // namespace niox
+
+#endif // NIOX_BTSNOOP_H
@@ -0,0 +1,346 @@
+// NIOX connection pool - reuse of live device sessions
+// Consumers connect to the same unit many times within minutes; the pool
+// keeps released sessions open for an idle period and hands them out again
+// instead of paying link setup each time.
+//  - acquire() returns a live session: pooled (hit), re-established if the
+//    link dropped while pooled, or newly connected (miss)
+//  - release() returns it; idle sessions close after idleMs
+//  - over capacity, the least recently used idle session is closed
+
+#ifndef NIOX_CONNECTION_POOL_H
+#define NIOX_CONNECTION_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace niox {
+
+struct PoolHooks {
+    std::function<int(uint64_t address)> connect;       // 0 on success, else an error code
+    std::function<void(uint64_t address)> disconnect;
+    std::function<bool(uint64_t address)> alive;        // Link still up
+};
+
+struct PoolStats {
+    uint64_t acquires;
+    uint64_t hits;              // Live pooled session handed out
+    uint64_t misses;            // New link needed
+    uint64_t reconnects;        // Pooled link had dropped and was re-established
+    uint64_t failures;          // Connect failed
+    uint64_t evictedIdle;
+    uint64_t evictedLru;
+    uint32_t open;              // Sessions currently open
+    uint32_t leased;            // Sessions currently in use
+    int64_t totalSetupMs;       // Time spent establishing links
+    uint64_t setups;
+    int64_t savedSetupMs;       // hits x average setup time
+};
+
+class ConnectionPool {
+public:
+    ConnectionPool() : capacity_(8), idle_ms_(60000), stats_(), running_(false), closing_(0) {}
+    ~ConnectionPool() { shutdown(); }
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Configure and start the idle sweeper. Reconfiguring keeps open sessions.
+    void start(size_t capacity, int64_t idleMs, PoolHooks hooks) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            capacity_ = capacity > 0 ? capacity : 1;
+            idle_ms_ = idleMs;
+            hooks_ = hooks;
+            if (running_) return;
+            running_ = true;
+        }
+        sweeper_ = std::thread([this]() { sweep_loop(); });
+    }
+
+    // Stop the sweeper and close every session
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) return;
+            running_ = false;
+        }
+        cv_.notify_all();
+        if (sweeper_.joinable()) sweeper_.join();
+        close_all();
+    }
+
+    bool running() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return running_;
+    }
+
+    // Lease a live session. reused receives true for a pool hit.
+    // Returns 0 on success, the connect hook's error code, or -1 if the
+    // pool was shut down meanwhile.
+    int acquire(uint64_t address, bool* reused = nullptr) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stats_.acquires++;
+        Entry* entry = find_entry(address);
+        while (entry != nullptr && entry->state == BUSY) {
+            cv_.wait(lock);     // Another caller is checking or connecting this device
+            entry = find_entry(address);
+        }
+
+        // The entry is marked BUSY (and off the idle list) while the lock is
+        // released, so concurrent acquirers wait and the sweeper skips it
+        PoolHooks hooks = hooks_;
+        uint64_t victim = 0;
+        bool evict = false;
+        bool pooled = entry != nullptr;
+        if (pooled) {
+            take_idle(*entry);
+            entry->state = BUSY;
+            lock.unlock();
+            const bool alive = !hooks.alive || hooks.alive(address);
+            lock.lock();
+            entry = find_entry(address);
+            if (entry == nullptr) return -1;
+            if (alive) {
+                finish(*entry, true);
+                stats_.hits++;
+                if (reused) *reused = true;
+                return 0;
+            }
+            stats_.reconnects++;
+        }
+        else {
+            entry = &entries_[address];
+            entry->state = BUSY;
+            stats_.misses++;
+            evict = take_lru_victim(&victim);
+        }
+        if (reused) *reused = false;
+        lock.unlock();
+
+        if (evict) {
+            if (hooks.disconnect) hooks.disconnect(victim);
+            lock.lock();
+            end_close(victim);
+            lock.unlock();
+        }
+        const int64_t start = now_ms();
+        const int result = hooks.connect ? hooks.connect(address) : 0;
+        const int64_t setup = now_ms() - start;
+
+        lock.lock();
+        entry = find_entry(address);
+        if (entry == nullptr) {
+            lock.unlock();
+            if (result == 0 && hooks.disconnect) hooks.disconnect(address);
+            return -1;
+        }
+        if (result != 0) {
+            stats_.failures++;
+            if (entry->leases == 0) {
+                entries_.erase(address);
+                cv_.notify_all();
+            }
+            else {
+                finish(*entry, false);
+            }
+            return result;
+        }
+        stats_.setups++;
+        stats_.totalSetupMs += setup;
+        finish(*entry, true);
+        return 0;
+    }
+
+    // Return a leased session; it stays open until idle or evicted
+    void release(uint64_t address) {
+        uint64_t victim = 0;
+        bool evict = false;
+        PoolHooks hooks;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Entry* entry = find_entry(address);
+            if (entry == nullptr || entry->leases == 0) return;
+            // A BUSY entry is being checked or reconnected by another
+            // acquirer, which leases it or drops it when done
+            if (--entry->leases == 0 && entry->state == OPEN) {
+                entry->idle = true;
+                entry->lastUsedMs = now_ms();
+                lru_.push_front(address);
+                entry->lruPosition = lru_.begin();
+            }
+            evict = take_lru_victim(&victim);
+            hooks = hooks_;
+        }
+        if (!evict) return;
+        if (hooks.disconnect) hooks.disconnect(victim);
+        std::lock_guard<std::mutex> lock(mutex_);
+        end_close(victim);
+    }
+
+    // Close idle sessions older than the idle period
+    void evict_idle() {
+        std::vector<uint64_t> expired;
+        PoolHooks hooks;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const int64_t cutoff = now_ms() - idle_ms_;
+            while (!lru_.empty()) {
+                const uint64_t address = lru_.back();
+                Entry& entry = entries_[address];
+                if (entry.lastUsedMs > cutoff) break;
+                begin_close(entry);
+                expired.push_back(address);
+                stats_.evictedIdle++;
+            }
+            hooks = hooks_;
+        }
+        if (expired.empty()) return;
+        for (uint64_t address : expired) {
+            if (hooks.disconnect) hooks.disconnect(address);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (uint64_t address : expired) end_close(address);
+    }
+
+    // Forget a session without disconnecting (the link was closed elsewhere)
+    void forget(uint64_t address) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry* entry = find_entry(address);
+        if (entry == nullptr || entry->state == BUSY) return;
+        if (entry->idle) lru_.erase(entry->lruPosition);
+        entries_.erase(address);
+    }
+
+    PoolStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        PoolStats stats = stats_;
+        stats.open = 0;
+        stats.leased = 0;
+        for (const auto& entry : entries_) {
+            if (entry.second.state == OPEN) stats.open++;
+            if (entry.second.leases > 0) stats.leased++;
+        }
+        stats.savedSetupMs = stats.setups ? static_cast<int64_t>(stats.hits) * stats.totalSetupMs / static_cast<int64_t>(stats.setups) : 0;
+        return stats;
+    }
+
+private:
+    enum State { BUSY, OPEN };
+
+    struct Entry {
+        State state = BUSY;
+        uint32_t leases = 0;
+        bool idle = false;
+        bool closing = false;       // Evicted, disconnect still running
+        int64_t lastUsedMs = 0;
+        std::list<uint64_t>::iterator lruPosition;
+    };
+
+    static int64_t now_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    Entry* find_entry(uint64_t address) {
+        auto it = entries_.find(address);
+        return it == entries_.end() ? nullptr : &it->second;
+    }
+
+    // Caller holds mutex_. Take a session off the idle list.
+    void take_idle(Entry& entry) {
+        if (entry.idle) {
+            lru_.erase(entry.lruPosition);
+            entry.idle = false;
+        }
+    }
+
+    // Caller holds mutex_. End a BUSY phase, optionally leasing the session.
+    void finish(Entry& entry, bool lease) {
+        entry.state = OPEN;
+        if (lease) entry.leases++;
+        cv_.notify_all();
+    }
+
+    // Caller holds mutex_. Mark an idle session as closing: it stays BUSY
+    // until its disconnect has run, so an acquire of the same address waits
+    // instead of connecting a link the pending disconnect would close.
+    void begin_close(Entry& entry) {
+        take_idle(entry);
+        entry.state = BUSY;
+        entry.closing = true;
+        closing_++;
+    }
+
+    // Caller holds mutex_. Drop a closed session and wake its waiters.
+    void end_close(uint64_t address) {
+        auto it = entries_.find(address);
+        if (it == entries_.end() || !it->second.closing) return;
+        entries_.erase(it);
+        closing_--;
+        cv_.notify_all();
+    }
+
+    // Caller holds mutex_. Pick the least recently used idle session for
+    // closing while more than capacity sessions are open.
+    bool take_lru_victim(uint64_t* victim) {
+        if (entries_.size() - closing_ <= capacity_ || lru_.empty()) return false;
+        *victim = lru_.back();
+        begin_close(entries_[*victim]);
+        stats_.evictedLru++;
+        return true;
+    }
+
+    void close_all() {
+        std::vector<uint64_t> open;
+        PoolHooks hooks;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& entry : entries_) {
+                if (entry.second.state == OPEN) open.push_back(entry.first);
+            }
+            entries_.clear();
+            lru_.clear();
+            closing_ = 0;
+            hooks = hooks_;
+        }
+        cv_.notify_all();
+        for (uint64_t address : open) {
+            if (hooks.disconnect) hooks.disconnect(address);
+        }
+    }
+
+    void sweep_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (running_) {
+            const int64_t interval = idle_ms_ / 4 > 100 ? idle_ms_ / 4 : 100;
+            cv_.wait_for(lock, std::chrono::milliseconds(interval));
+            if (!running_) break;
+            lock.unlock();
+            evict_idle();
+            lock.lock();
+        }
+    }
+
+    size_t capacity_;
+    int64_t idle_ms_;
+    PoolHooks hooks_;
+    PoolStats stats_;
+    bool running_;
+    std::unordered_map<uint64_t, Entry> entries_;
+    std::list<uint64_t> lru_;       // Idle sessions, most recently used first
+    size_t closing_;                // Entries waiting for their disconnect
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread sweeper_;
+};
+
+} // namespace niox
+
+#endif // NIOX_CONNECTION_POOL_H
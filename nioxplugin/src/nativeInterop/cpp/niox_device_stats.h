@@ -0,0 +1,131 @@
+// NIOX device statistics - per-device advert diagnostics in one cache line
+// Every advert updates a fixed 64-byte block with O(1) math: counts, first
+// and last seen, RSSI min/max and Welford mean/variance, and an estimate of
+// the device's advertising interval. The estimate has to survive lost
+// adverts: a gap of k intervals is divided by k before it is averaged in,
+// and a gap much shorter than the estimate resets it (the estimate had
+// absorbed losses). From the interval and the observed mean gap follows the
+// share of adverts actually received, and from that how long a scan must
+// run to hear a device with a given confidence.
+
+#ifndef NIOX_DEVICE_STATS_H
+#define NIOX_DEVICE_STATS_H
+
+#include <cmath>
+#include <cstdint>
+
+namespace niox {
+
+// Gaps outside this range are not advertising intervals: shorter ones are a
+// scan response or a duplicate report, longer ones span scans that were
+// stopped (the Core spec caps legacy intervals at 10.24 s)
+static const int64_t MIN_ADVERT_GAP_MS = 15;
+static const int64_t MAX_ADVERT_GAP_MS = 10240;
+
+struct alignas(64) DeviceStats {
+    int64_t firstSeenMs;
+    int64_t lastSeenMs;
+    double rssiMean;
+    double rssiM2;              // Sum of squared deviations (Welford)
+    uint32_t adverts;
+    uint32_t gaps;              // Gaps used for the interval estimate
+    float intervalMs;           // Estimated advertising interval, 0 if unknown
+    float gapMeanMs;            // Mean of the gaps used (includes losses)
+    int8_t rssiMin;
+    int8_t rssiMax;
+    uint8_t reserved[14];
+
+    double rssi_variance() const { return adverts > 1 ? rssiM2 / (adverts - 1) : 0.0; }
+
+    // Share of the device's adverts that were received (0 if unknown)
+    double receive_ratio() const {
+        if (intervalMs <= 0.0f || gapMeanMs <= 0.0f) return 0.0;
+        const double ratio = static_cast<double>(intervalMs) / gapMeanMs;
+        return ratio > 1.0 ? 1.0 : ratio;
+    }
+};
+
+static_assert(sizeof(DeviceStats) == 64, "DeviceStats must fill exactly one cache line");
+
+inline int8_t clamp_rssi8(int rssi) {
+    return static_cast<int8_t>(rssi < -128 ? -128 : (rssi > 127 ? 127 : rssi));
+}
+
+// Fold one advert into the block
+inline void update_device_stats(DeviceStats& stats, int rssi, int64_t nowMs) {
+    const int8_t r = clamp_rssi8(rssi);
+    if (stats.adverts == 0) {
+        stats.firstSeenMs = nowMs;
+        stats.rssiMin = r;
+        stats.rssiMax = r;
+    }
+    else {
+        const int64_t gap = nowMs - stats.lastSeenMs;
+        if (gap >= MIN_ADVERT_GAP_MS && gap <= MAX_ADVERT_GAP_MS) {
+            const float g = static_cast<float>(gap);
+            stats.gaps++;
+            stats.gapMeanMs += (g - stats.gapMeanMs) / static_cast<float>(stats.gaps);
+
+            // Divide out lost adverts, then average with a 1/8 weight
+            const float missed = stats.intervalMs > 0.0f ? std::floor(g / stats.intervalMs + 0.5f) : 0.0f;
+            if (missed < 1.0f) {
+                stats.intervalMs = g;
+            }
+            else {
+                stats.intervalMs += (g / missed - stats.intervalMs) * 0.125f;
+            }
+        }
+        if (r < stats.rssiMin) stats.rssiMin = r;
+        if (r > stats.rssiMax) stats.rssiMax = r;
+    }
+    stats.lastSeenMs = nowMs;
+    stats.adverts++;
+    const double delta = r - stats.rssiMean;
+    stats.rssiMean += delta / stats.adverts;
+    stats.rssiM2 += delta * (r - stats.rssiMean);
+}
+
+// Fold the block of another record of the same device into stats, e.g. a
+// private address resolved to its identity: counts add up, first and last
+// seen widen, RSSI moments combine (Chan et al.) and the interval and gap
+// estimates are averaged by the gaps behind them
+inline void merge_device_stats(DeviceStats& stats, const DeviceStats& other) {
+    if (other.adverts == 0) return;
+    if (stats.adverts == 0) {
+        stats = other;
+        return;
+    }
+    const double n = static_cast<double>(stats.adverts) + other.adverts;
+    const double delta = other.rssiMean - stats.rssiMean;
+    stats.rssiM2 += other.rssiM2 + delta * delta * stats.adverts * other.adverts / n;
+    stats.rssiMean += delta * other.adverts / n;
+    stats.adverts += other.adverts;
+    if (other.firstSeenMs < stats.firstSeenMs) stats.firstSeenMs = other.firstSeenMs;
+    if (other.lastSeenMs > stats.lastSeenMs) stats.lastSeenMs = other.lastSeenMs;
+    if (other.rssiMin < stats.rssiMin) stats.rssiMin = other.rssiMin;
+    if (other.rssiMax > stats.rssiMax) stats.rssiMax = other.rssiMax;
+
+    const uint32_t gaps = stats.gaps + other.gaps;
+    if (other.gaps > 0) {
+        const float share = static_cast<float>(other.gaps) / static_cast<float>(gaps);
+        stats.gapMeanMs += (other.gapMeanMs - stats.gapMeanMs) * share;
+        stats.intervalMs += (other.intervalMs - stats.intervalMs) * share;
+    }
+    stats.gaps = gaps;
+}
+
+// Scan time needed to hear the device at least once with the given
+// confidence (0..1), from its interval and receive ratio. -1 if the device
+// has not been heard often enough to tell.
+inline int64_t scan_window_ms(const DeviceStats& stats, double confidence) {
+    const double ratio = stats.receive_ratio();
+    if (ratio <= 0.0 || stats.gaps < 2) return -1;
+    if (confidence <= 0.0) return 0;
+    if (confidence >= 1.0) confidence = 0.999;
+    const double adverts = ratio >= 1.0 ? 1.0 : std::ceil(std::log(1.0 - confidence) / std::log(1.0 - ratio));
+    return static_cast<int64_t>(std::ceil(adverts * stats.intervalMs));
+}
+
+} // namespace niox
+
+#endif // NIOX_DEVICE_STATS_H
@@ -0,0 +1,602 @@
+// NIOX device table - native column store for discovered BLE devices
+// Keeps one slot per Bluetooth address plus a serial-number index so
+// lookups by NIOX serial are O(1) regardless of how many devices are tracked.
+
+#ifndef NIOX_DEVICE_TABLE_H
+#define NIOX_DEVICE_TABLE_H
+
+#include "niox_device_stats.h"
+#include "niox_simd.h"
+#include "niox_status.h"
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace niox {
+
+static const char NIOX_NAME_PREFIX[] = "NIOX PRO";
+static const size_t NIOX_NAME_PREFIX_LEN = sizeof(NIOX_NAME_PREFIX) - 1;
+static const int MAX_SERIAL_DIGITS = 16;
+
+// Packed serial layout: bits 56..63 hold the digit count, bits 0..55 the
+// decimal value. Keeping the digit count preserves leading zeros
+// ("070401992" and "70401992" are different units). 0 means "no serial".
+inline uint64_t pack_serial(uint64_t value, int digits) {
+    return (static_cast<uint64_t>(digits) << 56) | value;
+}
+
+inline int serial_digits(uint64_t packed) {
+    return static_cast<int>(packed >> 56);
+}
+
+inline uint64_t serial_value(uint64_t packed) {
+    return packed & 0x00FFFFFFFFFFFFFFull;
+}
+
+// Helper: Parse a bare serial string ("070401992") into its packed form.
+// Surrounding whitespace is ignored; any other non-digit character makes the
+// serial unrepresentable and 0 is returned.
+inline uint64_t parse_serial(const char* str, size_t len) {
+    size_t begin = 0;
+    size_t end = len;
+    while (begin < end && (str[begin] == ' ' || str[begin] == '\t')) begin++;
+    while (end > begin && (str[end - 1] == ' ' || str[end - 1] == '\t')) end--;
+
+    int digits = static_cast<int>(end - begin);
+    if (digits == 0 || digits > MAX_SERIAL_DIGITS) return 0;
+
+    uint64_t value = 0;
+    for (size_t i = begin; i < end; i++) {
+        char c = str[i];
+        if (c < '0' || c > '9') return 0;
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return pack_serial(value, digits);
+}
+
+// Helper: Check for the "NIOX PRO" name prefix, ignoring case like
+// BluetoothDevice.isNioxDevice() on the Kotlin side
+inline bool has_niox_prefix(const char* name) {
+    if (name == nullptr) return false;
+    for (size_t i = 0; i < NIOX_NAME_PREFIX_LEN; i++) {
+        char c = name[i];
+        if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+        if (c != NIOX_NAME_PREFIX[i]) return false;
+    }
+    return true;
+}
+
+// Helper: Extract the packed serial from a device name of the form
+// "NIOX PRO [serial_number]", mirroring BluetoothDevice.getNioxSerialNumber()
+inline uint64_t extract_niox_serial(const char* name) {
+    if (!has_niox_prefix(name)) return 0;
+    const char* rest = name + NIOX_NAME_PREFIX_LEN;
+    size_t len = 0;
+    while (rest[len] != '\0') len++;
+    return parse_serial(rest, len);
+}
+
+// Helper: Format a packed serial back to its zero-padded decimal string.
+// Returns the number of characters written (excluding the terminator), or 0
+// if the serial is empty or the buffer is too small.
+inline int format_serial(uint64_t packed, char* buffer, size_t bufferSize) {
+    int digits = serial_digits(packed);
+    if (packed == 0 || digits == 0 || bufferSize < static_cast<size_t>(digits) + 1) return 0;
+    uint64_t value = serial_value(packed);
+    for (int i = digits - 1; i >= 0; i--) {
+        buffer[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    buffer[digits] = '\0';
+    return digits;
+}
+
+// Device flag bits (flags column)
+static const uint32_t DEVICE_FLAG_HAS_NAME = 1u << 0;
+static const uint32_t DEVICE_FLAG_NIOX_NAME = 1u << 1;     // Name starts with "NIOX PRO"
+static const uint32_t DEVICE_FLAG_NIOX_SERVICE = 1u << 2;  // Advertised the FDC service UUID
+static const uint32_t DEVICE_FLAG_NIOX = DEVICE_FLAG_NIOX_NAME | DEVICE_FLAG_NIOX_SERVICE;
+static const uint32_t DEVICE_FLAG_HAS_STATUS = 1u << 3;   // Advertised NIOX status (see niox_status.h)
+static const uint32_t DEVICE_FLAG_RESOLVED = 1u << 4;     // Keyed by identity, heard from a private address (niox_rpa.h)
+static const uint32_t DEVICE_FLAG_FLEET = 1u << 5;        // Serial is in the site fleet (niox_fleet.h)
+static const uint32_t DEVICE_FLAG_PRIVATE = 1u << 6;      // Keyed by a resolvable private address no key resolves (yet)
+
+// Range filter evaluated by DeviceTable::filter
+struct DeviceFilter {
+    int32_t minRssi;         // Keep devices with rssi >= minRssi
+    int64_t seenSinceMs;     // Keep devices with lastSeenMs >= seenSinceMs
+    uint32_t requireFlags;   // All of these flag bits must be set
+    uint32_t anyFlags;       // At least one of these must be set (0 = no constraint)
+};
+
+// Result ordering for DeviceTable::query
+enum DeviceSortKey {
+    DEVICE_SORT_NONE = -1,       // Slot (first-seen) order
+    DEVICE_SORT_RSSI = 0,        // Strongest first
+    DEVICE_SORT_LAST_SEEN = 1,   // Most recently heard first
+    DEVICE_SORT_SERIAL = 2       // Ascending NIOX serial, non-NIOX last
+};
+
+// Device table stored as structure-of-arrays, keyed by Bluetooth address
+// with a secondary serial index. Each column is contiguous so range filters
+// run as SIMD kernels over 4 (SSE2) or 8 (AVX2) devices per step; names live
+// in a side pool and are only touched when a record is materialized.
+// Not thread-safe: callers serialize access (see g_device_mutex in the wrapper).
+class DeviceTable {
+public:
+    static const int32_t NO_SLOT = -1;
+
+    enum Path { PATH_AUTO, PATH_SCALAR, PATH_SSE2, PATH_AVX2 };
+
+    DeviceTable() : epoch_ms_(0), sequence_(0), path_(PATH_AUTO) {}
+
+    // Insert or update the record for an address and return its slot. The
+    // serial is parsed only when the record first gets a name, so repeated
+    // adverts cost one hash lookup and no string parsing. status, if given,
+    // replaces the last advertised status.
+    uint32_t upsert(uint64_t address, const char* name, int rssi, int64_t nowMs, uint32_t flags = 0,
+                    const DeviceStatus* status = nullptr) {
+        if (addresses_.empty()) epoch_ms_ = nowMs;
+        if (nowMs - epoch_ms_ > REBASE_THRESHOLD_MS) rebase(nowMs);
+
+        uint32_t slot;
+        auto it = by_address_.find(address);
+        if (it == by_address_.end()) {
+            slot = static_cast<uint32_t>(addresses_.size());
+            by_address_.emplace(address, slot);
+            addresses_.push_back(address);
+            radio_addresses_.push_back(address);
+            serials_.push_back(0);
+            rssi_.push_back(rssi);
+            last_seen_.push_back(0);
+            flags_.push_back(0);
+            name_offset_.push_back(0);
+            name_length_.push_back(0);
+            status_.push_back(DeviceStatus());
+            stats_.push_back(DeviceStats());
+            updated_.push_back(0);
+        }
+        else {
+            slot = it->second;
+        }
+
+        if ((flags_[slot] & DEVICE_FLAG_HAS_NAME) == 0 && name != nullptr && name[0] != '\0') {
+            set_name(slot, name);
+        }
+        rssi_[slot] = rssi;
+        last_seen_[slot] = static_cast<int32_t>(nowMs - epoch_ms_);
+        update_device_stats(stats_[slot], rssi, nowMs);
+        flags_[slot] |= flags;
+        if (status != nullptr) {
+            status_[slot] = *status;
+            flags_[slot] |= DEVICE_FLAG_HAS_STATUS;
+        }
+        updated_[slot] = ++sequence_;
+        return slot;
+    }
+
+    // Record the over-the-air address a device keyed by its identity was
+    // last heard from
+    void set_radio_address(uint32_t slot, uint64_t address) {
+        radio_addresses_[slot] = address;
+        if (address != addresses_[slot]) flags_[slot] |= DEVICE_FLAG_RESOLVED;
+    }
+
+    void set_flag(uint32_t slot, uint32_t flag, bool on) {
+        const uint32_t flags = on ? (flags_[slot] | flag) : (flags_[slot] & ~flag);
+        if (flags == flags_[slot]) return;
+        flags_[slot] = flags;
+        updated_[slot] = ++sequence_;
+    }
+
+    int32_t find_by_address(uint64_t address) const {
+        auto it = by_address_.find(address);
+        return it == by_address_.end() ? NO_SLOT : static_cast<int32_t>(it->second);
+    }
+
+    int32_t find_by_serial(uint64_t serial) const {
+        if (serial == 0) return NO_SLOT;
+        auto it = by_serial_.find(serial);
+        return it == by_serial_.end() ? NO_SLOT : static_cast<int32_t>(it->second);
+    }
+
+    size_t size() const { return addresses_.size(); }
+
+    // Drop every record with all of requireFlags set that was last heard
+    // before cutoffMs, e.g. rotated private addresses. Slots of the
+    // remaining records may change. Returns the number removed.
+    size_t evict(uint32_t requireFlags, int64_t cutoffMs) {
+        const int64_t cutoff = cutoffMs - epoch_ms_;
+        const int32_t cutoff32 = cutoff < INT32_MIN ? INT32_MIN : cutoff > INT32_MAX ? INT32_MAX : static_cast<int32_t>(cutoff);
+        return compact([&](size_t i) {
+            return (flags_[i] & requireFlags) != requireFlags || last_seen_[i] >= cutoff32;
+        });
+    }
+
+    // Move the record of a private address under the identity it resolves
+    // to: re-keyed if the identity has no record yet, otherwise merged into
+    // it (newest RSSI and radio address, missing name and status filled in,
+    // advert statistics combined).
+    // Slots may change. Returns the identity's slot, or NO_SLOT if the
+    // address has no record.
+    int32_t fold(uint64_t address, uint64_t identity) {
+        auto it = by_address_.find(address);
+        if (it == by_address_.end()) return NO_SLOT;
+        const uint32_t slot = it->second;
+        if (address == identity) return static_cast<int32_t>(slot);
+        const uint32_t private_flags = flags_[slot] & ~DEVICE_FLAG_PRIVATE;
+
+        auto target_it = by_address_.find(identity);
+        if (target_it == by_address_.end()) {
+            by_address_.erase(it);
+            by_address_.emplace(identity, slot);
+            addresses_[slot] = identity;
+            flags_[slot] = private_flags | DEVICE_FLAG_RESOLVED;
+            radio_addresses_[slot] = address;
+            updated_[slot] = ++sequence_;
+            return static_cast<int32_t>(slot);
+        }
+
+        const uint32_t target = target_it->second;
+        if (last_seen_[slot] > last_seen_[target]) {
+            rssi_[target] = rssi_[slot];
+            last_seen_[target] = last_seen_[slot];
+            radio_addresses_[target] = address;
+        }
+        if ((flags_[target] & DEVICE_FLAG_HAS_NAME) == 0 && (flags_[slot] & DEVICE_FLAG_HAS_NAME) != 0) {
+            const std::string name_copy(name(slot), name_length_[slot]);
+            set_name(target, name_copy.c_str());
+        }
+        if ((flags_[target] & DEVICE_FLAG_HAS_STATUS) == 0) status_[target] = status_[slot];
+        merge_device_stats(stats_[target], stats_[slot]);
+        updated_[target] = ++sequence_;
+        flags_[target] |= private_flags | DEVICE_FLAG_RESOLVED;
+        compact([slot](size_t i) { return i != slot; });
+        return find_by_address(identity);
+    }
+
+    // Column accessors
+    uint64_t address(uint32_t slot) const { return addresses_[slot]; }
+    uint64_t radio_address(uint32_t slot) const { return radio_addresses_[slot]; }
+    uint64_t serial(uint32_t slot) const { return serials_[slot]; }
+    int rssi(uint32_t slot) const { return rssi_[slot]; }
+    int64_t last_seen_ms(uint32_t slot) const { return epoch_ms_ + last_seen_[slot]; }
+    uint32_t flags(uint32_t slot) const { return flags_[slot]; }
+    const char* name(uint32_t slot) const {
+        return (flags_[slot] & DEVICE_FLAG_HAS_NAME) ? &name_pool_[name_offset_[slot]] : nullptr;
+    }
+    size_t name_length(uint32_t slot) const { return name_length_[slot]; }
+    const DeviceStatus& status(uint32_t slot) const { return status_[slot]; }
+    const DeviceStats& stats(uint32_t slot) const { return stats_[slot]; }
+
+    // Change sequence: every upsert, flag change or fold stamps the record
+    // with the next number. Unlike last-seen times it never repeats within a
+    // millisecond and is not fooled by adverts delivered late, so consumers
+    // of changes poll with it. Not reset by clear().
+    uint64_t sequence() const { return sequence_; }
+    uint64_t updated(uint32_t slot) const { return updated_[slot]; }
+
+    // Append the slots changed after sequence, in slot order
+    void updated_since(uint64_t sequence, std::vector<uint32_t>& out) const {
+        for (size_t i = 0; i < updated_.size(); i++) {
+            if (updated_[i] > sequence) out.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    // Force a filter kernel (tests and benchmarks compare paths on the same table)
+    void set_path(Path path) { path_ = path; }
+
+    // Append the slots matching the filter to out, in slot order
+    void filter(const DeviceFilter& filter, std::vector<uint32_t>& out) const {
+        const size_t count = addresses_.size();
+        DeviceFilter f = filter;
+        if (f.minRssi < RSSI_FLOOR) f.minRssi = RSSI_FLOOR;  // Keeps minRssi - 1 in range
+
+        // Timestamps are stored relative to the epoch; clamp the cutoff into range
+        int32_t since32 = INT32_MIN;
+        if (f.seenSinceMs > epoch_ms_ + INT32_MIN) {
+            if (f.seenSinceMs - epoch_ms_ > INT32_MAX) return;
+            since32 = static_cast<int32_t>(f.seenSinceMs - epoch_ms_);
+        }
+
+        // Kernels compact matching slots straight into the output buffer
+        const size_t base = out.size();
+        out.resize(base + count);
+        uint32_t* dst = out.data() + base;
+        size_t written = 0;
+
+        size_t i = 0;
+#if NIOX_HAVE_SSE2
+        Path path = path_;
+        if (path == PATH_AUTO) path = cpu_has_avx2() ? PATH_AVX2 : PATH_SSE2;
+        if (path == PATH_AVX2) {
+            i = filter_avx2(f, since32, dst, &written);
+        }
+        else if (path == PATH_SSE2) {
+            i = filter_sse2(f, since32, dst, &written);
+        }
+#endif
+        for (; i < count; i++) {
+            dst[written] = static_cast<uint32_t>(i);
+            written += matches(i, f, since32) ? 1 : 0;
+        }
+        out.resize(base + written);
+    }
+
+    // Stable sort of slots by RSSI, strongest first. RSSI is clamped to
+    // [-128, 127], so a single counting-sort (radix-256) pass orders the list.
+    void sort_by_rssi(std::vector<uint32_t>& slots) const {
+        if (slots.size() < 2) return;
+        uint32_t offsets[257] = { 0 };
+        for (uint32_t slot : slots) offsets[rssi_key(slot) + 1]++;
+        for (int b = 0; b < 256; b++) offsets[b + 1] += offsets[b];
+        scratch_.resize(slots.size());
+        for (uint32_t slot : slots) scratch_[offsets[rssi_key(slot)]++] = slot;
+        slots.swap(scratch_);
+    }
+
+    // Filter, order and page in one pass over the columns. Only the slots of
+    // the requested page are left in page; returns the total match count.
+    // RSSI uses the counting sort; the other keys order just the first
+    // offset + limit matches with a partial sort.
+    size_t query(const DeviceFilter& f, DeviceSortKey key, size_t offset, size_t limit,
+                 std::vector<uint32_t>& page) const {
+        page.clear();
+        filter(f, page);
+        const size_t total = page.size();
+        if (offset >= total) {
+            page.clear();
+            return total;
+        }
+        const size_t end = (limit == 0 || limit > total - offset) ? total : offset + limit;
+
+        switch (key) {
+            case DEVICE_SORT_RSSI:
+                sort_by_rssi(page);
+                break;
+            case DEVICE_SORT_LAST_SEEN:
+                std::partial_sort(page.begin(), page.begin() + end, page.end(),
+                    [this](uint32_t a, uint32_t b) {
+                        return last_seen_[a] != last_seen_[b] ? last_seen_[a] > last_seen_[b] : a < b;
+                    });
+                break;
+            case DEVICE_SORT_SERIAL:
+                // Devices without a serial (0) sort after every NIOX unit
+                std::partial_sort(page.begin(), page.begin() + end, page.end(),
+                    [this](uint32_t a, uint32_t b) {
+                        const uint64_t sa = serials_[a] - 1;
+                        const uint64_t sb = serials_[b] - 1;
+                        return sa != sb ? sa < sb : a < b;
+                    });
+                break;
+            default:
+                break;
+        }
+
+        page.erase(page.begin() + end, page.end());
+        page.erase(page.begin(), page.begin() + offset);
+        return total;
+    }
+
+    void clear() {
+        addresses_.clear();
+        radio_addresses_.clear();
+        serials_.clear();
+        rssi_.clear();
+        last_seen_.clear();
+        flags_.clear();
+        name_offset_.clear();
+        name_length_.clear();
+        name_pool_.clear();
+        status_.clear();
+        stats_.clear();
+        updated_.clear();
+        by_address_.clear();
+        by_serial_.clear();
+        epoch_ms_ = 0;
+    }
+
+private:
+    static const int32_t RSSI_FLOOR = -32768;
+
+    // Offsets are int32 milliseconds; rebase well before they could overflow (~12 days)
+    static const int64_t REBASE_THRESHOLD_MS = int64_t(1) << 30;
+
+    void set_name(uint32_t slot, const char* name) {
+        size_t len = strlen(name);
+        name_offset_[slot] = static_cast<uint32_t>(name_pool_.size());
+        name_length_[slot] = static_cast<uint16_t>(len > 0xFFFF ? 0xFFFF : len);
+        name_pool_.insert(name_pool_.end(), name, name + name_length_[slot]);
+        name_pool_.push_back('\0');
+        flags_[slot] |= DEVICE_FLAG_HAS_NAME;
+
+        if (has_niox_prefix(name)) {
+            flags_[slot] |= DEVICE_FLAG_NIOX_NAME;
+        }
+        uint64_t packed = extract_niox_serial(name);
+        serials_[slot] = packed;
+        if (packed != 0) by_serial_[packed] = slot;
+    }
+
+    // Keep the records keep(i) accepts, in order, and rebuild the indexes
+    // and the name pool around them. Returns the number removed.
+    template <typename Keep>
+    size_t compact(Keep keep) {
+        const size_t count = addresses_.size();
+        size_t first = 0;
+        while (first < count && keep(first)) first++;
+        if (first == count) return 0;
+
+        std::vector<char> pool;
+        size_t kept = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (!keep(i)) continue;
+            if (flags_[i] & DEVICE_FLAG_HAS_NAME) {
+                const uint32_t offset = static_cast<uint32_t>(pool.size());
+                pool.insert(pool.end(), name_pool_.begin() + name_offset_[i],
+                            name_pool_.begin() + name_offset_[i] + name_length_[i]);
+                pool.push_back('\0');
+                name_offset_[i] = offset;
+            }
+            if (kept != i) {
+                addresses_[kept] = addresses_[i];
+                radio_addresses_[kept] = radio_addresses_[i];
+                serials_[kept] = serials_[i];
+                rssi_[kept] = rssi_[i];
+                last_seen_[kept] = last_seen_[i];
+                flags_[kept] = flags_[i];
+                name_offset_[kept] = name_offset_[i];
+                name_length_[kept] = name_length_[i];
+                status_[kept] = status_[i];
+                stats_[kept] = stats_[i];
+                updated_[kept] = updated_[i];
+            }
+            kept++;
+        }
+        name_pool_.swap(pool);
+        const size_t removed = count - kept;
+
+        addresses_.resize(kept);
+        radio_addresses_.resize(kept);
+        serials_.resize(kept);
+        rssi_.resize(kept);
+        last_seen_.resize(kept);
+        flags_.resize(kept);
+        name_offset_.resize(kept);
+        name_length_.resize(kept);
+        status_.resize(kept);
+        stats_.resize(kept);
+        updated_.resize(kept);
+        by_address_.clear();
+        by_serial_.clear();
+        for (size_t i = 0; i < kept; i++) {
+            by_address_.emplace(addresses_[i], static_cast<uint32_t>(i));
+            if (serials_[i] != 0) by_serial_[serials_[i]] = static_cast<uint32_t>(i);
+        }
+        return removed;
+    }
+
+    // Move the epoch forward; devices older than the new epoch saturate
+    void rebase(int64_t nowMs) {
+        const int64_t shift = (nowMs - epoch_ms_) - (REBASE_THRESHOLD_MS / 2);
+        for (int32_t& t : last_seen_) {
+            int64_t shifted = static_cast<int64_t>(t) - shift;
+            t = shifted < INT32_MIN ? INT32_MIN : static_cast<int32_t>(shifted);
+        }
+        epoch_ms_ += shift;
+    }
+
+    bool matches(size_t i, const DeviceFilter& f, int32_t since32) const {
+        return rssi_[i] >= f.minRssi &&
+               last_seen_[i] >= since32 &&
+               (flags_[i] & f.requireFlags) == f.requireFlags &&
+               (f.anyFlags == 0 || (flags_[i] & f.anyFlags) != 0);
+    }
+
+    uint32_t rssi_key(uint32_t slot) const {
+        // Descending order: strongest (127) maps to bucket 0
+        int32_t r = rssi_[slot];
+        if (r < -128) r = -128;
+        if (r > 127) r = 127;
+        return static_cast<uint32_t>(127 - r);
+    }
+
+#if NIOX_HAVE_SSE2
+    // Kernels return the number of slots processed; the caller finishes the tail.
+    // Matches are compacted branch-free: every lane is stored, and the write
+    // cursor only advances for lanes whose mask bit is set.
+    size_t filter_sse2(const DeviceFilter& f, int32_t since32, uint32_t* dst, size_t* written) const {
+        const size_t count = addresses_.size();
+        const __m128i rssi_floor = _mm_set1_epi32(f.minRssi - 1);
+        const __m128i seen_floor = _mm_set1_epi32(since32 == INT32_MIN ? INT32_MIN : since32 - 1);
+        const __m128i require = _mm_set1_epi32(static_cast<int32_t>(f.requireFlags));
+        const __m128i any = _mm_set1_epi32(static_cast<int32_t>(f.anyFlags));
+        const __m128i zero = _mm_setzero_si128();
+        const bool check_any = f.anyFlags != 0;
+        const bool seen_unbounded = since32 == INT32_MIN;
+
+        size_t n = *written;
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&rssi_[i]));
+            const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&last_seen_[i]));
+            const __m128i fl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&flags_[i]));
+            __m128i m = _mm_cmpgt_epi32(r, rssi_floor);
+            if (!seen_unbounded) m = _mm_and_si128(m, _mm_cmpgt_epi32(t, seen_floor));
+            m = _mm_and_si128(m, _mm_cmpeq_epi32(_mm_and_si128(fl, require), require));
+            if (check_any) {
+                m = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(fl, any), zero), m);
+            }
+            const int bits = _mm_movemask_ps(_mm_castsi128_ps(m));
+            for (int lane = 0; lane < 4; lane++) {
+                dst[n] = static_cast<uint32_t>(i + lane);
+                n += (bits >> lane) & 1;
+            }
+        }
+        *written = n;
+        return i;
+    }
+
+    NIOX_TARGET_AVX2 size_t filter_avx2(const DeviceFilter& f, int32_t since32, uint32_t* dst, size_t* written) const {
+        const size_t count = addresses_.size();
+        const __m256i rssi_floor = _mm256_set1_epi32(f.minRssi - 1);
+        const __m256i seen_floor = _mm256_set1_epi32(since32 == INT32_MIN ? INT32_MIN : since32 - 1);
+        const __m256i require = _mm256_set1_epi32(static_cast<int32_t>(f.requireFlags));
+        const __m256i any = _mm256_set1_epi32(static_cast<int32_t>(f.anyFlags));
+        const __m256i zero = _mm256_setzero_si256();
+        const bool check_any = f.anyFlags != 0;
+        const bool seen_unbounded = since32 == INT32_MIN;
+
+        size_t n = *written;
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&rssi_[i]));
+            const __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&last_seen_[i]));
+            const __m256i fl = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&flags_[i]));
+            __m256i m = _mm256_cmpgt_epi32(r, rssi_floor);
+            if (!seen_unbounded) m = _mm256_and_si256(m, _mm256_cmpgt_epi32(t, seen_floor));
+            m = _mm256_and_si256(m, _mm256_cmpeq_epi32(_mm256_and_si256(fl, require), require));
+            if (check_any) {
+                m = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(fl, any), zero), m);
+            }
+            const int bits = _mm256_movemask_ps(_mm256_castsi256_ps(m));
+            for (int lane = 0; lane < 8; lane++) {
+                dst[n] = static_cast<uint32_t>(i + lane);
+                n += (bits >> lane) & 1;
+            }
+        }
+        *written = n;
+        return i;
+    }
+#endif
+
+    // Columns, indexed by slot
+    std::vector<uint64_t> addresses_;
+    std::vector<uint64_t> radio_addresses_;  // Last heard from (differs once resolved)
+    std::vector<uint64_t> serials_;      // Packed NIOX serial, 0 if none
+    std::vector<int32_t> rssi_;
+    std::vector<int32_t> last_seen_;     // Milliseconds since epoch_ms_
+    std::vector<uint32_t> flags_;
+    std::vector<uint32_t> name_offset_;  // Into name_pool_
+    std::vector<uint16_t> name_length_;
+    std::vector<char> name_pool_;        // NUL-terminated names, append-only
+    std::vector<DeviceStatus> status_;   // Last advertised status (DEVICE_FLAG_HAS_STATUS)
+    std::vector<DeviceStats> stats_;     // One cache line each, only read by diagnostics
+    std::vector<uint64_t> updated_;      // sequence_ at the last change
+
+    int64_t epoch_ms_;
+    uint64_t sequence_;
+    Path path_;
+    std::unordered_map<uint64_t, uint32_t> by_address_;
+    std::unordered_map<uint64_t, uint32_t> by_serial_;
+    mutable std::vector<uint32_t> scratch_;
+};
+
+} // namespace niox
+
+#endif // NIOX_DEVICE_TABLE_H
@@ -0,0 +1,261 @@
+// NIOX fleet - minimal perfect hash over a site's known serial numbers
+// A site owns a fixed list of NIOX PRO units. The list is turned into a
+// minimal perfect hash (n keys in n slots, one 16-bit pilot per bucket of
+// ~3 keys), so "is this one of our units" is one hash, one pilot load and
+// one key compare, with no probing and no allocation.
+//  - Built into the wrapper: niox_fleet_gen turns a manifest into
+//    niox_fleet_manifest.h, compiled in with NIOX_COMPILED_FLEET defined
+//    (build-winrt-native-dll.ps1 -FleetManifest). The table is constexpr
+//    and is checked by a static_assert at compile time.
+//  - Loaded at runtime: Fleet builds the same layout from a manifest
+//    string (winrt_load_fleet) and replaces the compiled table.
+//
+// Manifest: one serial per line (or separated by ',' / ';'), either bare
+// digits or a full "NIOX PRO <serial>" name; '#' starts a comment.
+
+#ifndef NIOX_FLEET_H
+#define NIOX_FLEET_H
+
+#include "niox_device_table.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace niox {
+
+// Helper: Hash a packed serial (splitmix64 finalizer over key ^ seed). The
+// low 32 bits choose the bucket, the high 32 bits the slot.
+constexpr uint64_t fleet_hash(uint64_t key, uint64_t seed) {
+    uint64_t x = key ^ seed;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// Helper: Map a 32-bit hash onto [0, range) without a division
+constexpr uint32_t fleet_reduce(uint64_t hash32, uint32_t range) {
+    return static_cast<uint32_t>(((hash32 & 0xFFFFFFFFull) * range) >> 32);
+}
+
+constexpr uint32_t fleet_bucket(uint64_t hash, uint32_t buckets) {
+    return fleet_reduce(hash, buckets);
+}
+
+constexpr uint32_t fleet_slot(uint64_t hash, uint16_t pilot, uint32_t size) {
+    return fleet_reduce((hash ^ ((pilot + 1ull) * 0x9E3779B97F4A7C15ull)) >> 32, size);
+}
+
+// Read-only view of a fleet table; the compiled and runtime tables share it
+struct FleetTable {
+    uint64_t seed;
+    uint32_t size;              // Keys (and slots)
+    uint32_t buckets;
+    const uint16_t* pilots;     // One per bucket
+    const uint64_t* keys;       // Packed serials by slot
+
+    // Slot of a packed serial, or -1 if it is not in the fleet
+    constexpr int32_t find(uint64_t serial) const {
+        if (size == 0 || serial == 0) return -1;
+        const uint64_t hash = fleet_hash(serial, seed);
+        const uint32_t slot = fleet_slot(hash, pilots[fleet_bucket(hash, buckets)], size);
+        return keys[slot] == serial ? static_cast<int32_t>(slot) : -1;
+    }
+
+    constexpr bool contains(uint64_t serial) const { return find(serial) >= 0; }
+};
+
+// Every key must hash to its own slot (used by the compiled table's static_assert)
+constexpr bool fleet_table_valid(const FleetTable& table) {
+    for (uint32_t i = 0; i < table.size; i++) {
+        if (table.find(table.keys[i]) != static_cast<int32_t>(i)) return false;
+    }
+    return true;
+}
+
+// Runtime-built fleet table (the fallback when no manifest is compiled in,
+// and the generator's builder)
+class Fleet {
+public:
+    Fleet() : seed_(0), buckets_(0) {}
+
+    // Build over packed serials; duplicates are ignored. Returns false if a
+    // serial is 0 or no table was found (which takes far more keys than a
+    // fleet has). The previous table is kept on failure.
+    bool build(std::vector<uint64_t> serials) {
+        std::sort(serials.begin(), serials.end());
+        serials.erase(std::unique(serials.begin(), serials.end()), serials.end());
+        if (!serials.empty() && serials.front() == 0) return false;
+        if (serials.empty()) {
+            seed_ = 0;
+            buckets_ = 0;
+            pilots_.clear();
+            keys_.clear();
+            return true;
+        }
+
+        const uint32_t size = static_cast<uint32_t>(serials.size());
+        const uint32_t buckets = (size + AVERAGE_BUCKET - 1) / AVERAGE_BUCKET;
+        uint64_t seed = 0x4E494F58464C5431ull;      // "NIOXFLT1"
+        for (int attempt = 0; attempt < MAX_SEEDS; attempt++, seed = fleet_hash(seed, attempt)) {
+            std::vector<uint16_t> pilots;
+            std::vector<uint64_t> keys;
+            if (place(serials, seed, buckets, pilots, keys)) {
+                seed_ = seed;
+                buckets_ = buckets;
+                pilots_.swap(pilots);
+                keys_.swap(keys);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    FleetTable table() const {
+        return FleetTable{ seed_, static_cast<uint32_t>(keys_.size()), buckets_,
+                           pilots_.empty() ? nullptr : pilots_.data(), keys_.empty() ? nullptr : keys_.data() };
+    }
+
+    size_t size() const { return keys_.size(); }
+
+private:
+    static const uint32_t AVERAGE_BUCKET = 3;
+    static const int MAX_SEEDS = 64;
+    static const uint32_t MAX_PILOT = 0xFFFF;
+
+    // Place buckets largest first, trying pilots until all of a bucket's
+    // keys land in distinct free slots
+    static bool place(const std::vector<uint64_t>& serials, uint64_t seed, uint32_t buckets,
+                      std::vector<uint16_t>& pilots, std::vector<uint64_t>& keys) {
+        const uint32_t size = static_cast<uint32_t>(serials.size());
+        std::vector<std::vector<uint64_t>> members(buckets);
+        for (uint64_t serial : serials) {
+            members[fleet_bucket(fleet_hash(serial, seed), buckets)].push_back(serial);
+        }
+        std::vector<uint32_t> order(buckets);
+        for (uint32_t i = 0; i < buckets; i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return members[a].size() > members[b].size();
+        });
+
+        pilots.assign(buckets, 0);
+        keys.assign(size, 0);
+        std::vector<uint32_t> slots;
+        for (uint32_t bucket : order) {
+            const std::vector<uint64_t>& bucketKeys = members[bucket];
+            if (bucketKeys.empty()) break;
+            bool placed = false;
+            for (uint32_t pilot = 0; pilot <= MAX_PILOT && !placed; pilot++) {
+                slots.clear();
+                placed = true;
+                for (uint64_t serial : bucketKeys) {
+                    const uint32_t slot = fleet_slot(fleet_hash(serial, seed), static_cast<uint16_t>(pilot), size);
+                    if (keys[slot] != 0 || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                        placed = false;
+                        break;
+                    }
+                    slots.push_back(slot);
+                }
+                if (placed) {
+                    pilots[bucket] = static_cast<uint16_t>(pilot);
+                    for (size_t i = 0; i < slots.size(); i++) keys[slots[i]] = bucketKeys[i];
+                }
+            }
+            if (!placed) return false;
+        }
+        return true;
+    }
+
+    uint64_t seed_;
+    uint32_t buckets_;
+    std::vector<uint16_t> pilots_;
+    std::vector<uint64_t> keys_;
+};
+
+// Parse a fleet manifest into packed serials. Returns the number of entries,
+// or -1 if an entry is not a serial (serials is left partly filled then).
+inline int parse_fleet_manifest(const char* text, std::vector<uint64_t>& serials) {
+    if (text == nullptr) return -1;
+    int count = 0;
+    const char* p = text;
+    while (*p != '\0') {
+        const char* end = p;
+        while (*end != '\0' && *end != '\n' && *end != ',' && *end != ';' && *end != '#') end++;
+        const char* next = end;
+        if (*next == '#') {
+            while (*next != '\0' && *next != '\n') next++;
+        }
+
+        // Trim, then accept bare digits or a full advertised name
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+        const char* last = end;
+        while (last > p && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) last--;
+        if (last > p) {
+            const std::string entry(p, last);
+            const uint64_t serial = has_niox_prefix(entry.c_str())
+                ? extract_niox_serial(entry.c_str())
+                : parse_serial(entry.data(), entry.size());
+            if (serial == 0) return -1;
+            serials.push_back(serial);
+            count++;
+        }
+        p = *next == '\0' ? next : next + 1;
+    }
+    return count;
+}
+
+// Render a fleet as the niox_fleet_manifest.h header (see niox_fleet_gen.cpp)
+inline std::string fleet_header(const Fleet& fleet, const char* source) {
+    const FleetTable table = fleet.table();
+    std::string out;
+    char line[96];
+    out += "// Generated by niox_fleet_gen";
+    if (source != nullptr) {
+        out += " from ";
+        out += source;
+    }
+    out += " - do not edit\n\n#ifndef NIOX_FLEET_MANIFEST_H\n#define NIOX_FLEET_MANIFEST_H\n\n";
+    out += "#include <cstdint>\n\nnamespace niox {\nnamespace fleet_manifest {\n\n";
+    snprintf(line, sizeof(line), "static constexpr uint64_t SEED = 0x%016llXull;\n",
+             static_cast<unsigned long long>(table.seed));
+    out += line;
+    snprintf(line, sizeof(line), "static constexpr uint32_t SIZE = %u;\n", table.size);
+    out += line;
+    snprintf(line, sizeof(line), "static constexpr uint32_t BUCKETS = %u;\n\n", table.buckets);
+    out += line;
+
+    out += "static constexpr uint16_t PILOTS[] = {";
+    for (uint32_t i = 0; i < table.buckets; i++) {
+        snprintf(line, sizeof(line), "%s%u,", i % 12 == 0 ? "\n    " : " ", table.pilots[i]);
+        out += line;
+    }
+    out += "\n};\n\n// Packed serials by slot (digit count << 56 | value)\n";
+    out += "static constexpr uint64_t KEYS[] = {";
+    for (uint32_t i = 0; i < table.size; i++) {
+        char serial[MAX_SERIAL_DIGITS + 1];
+        format_serial(table.keys[i], serial, sizeof(serial));
+        snprintf(line, sizeof(line), "\n    0x%016llXull,    // %s", static_cast<unsigned long long>(table.keys[i]), serial);
+        out += line;
+    }
+    out += "\n};\n\n} // namespace fleet_manifest\n} // namespace niox\n\n#endif // NIOX_FLEET_MANIFEST_H\n";
+    return out;
+}
+
+#ifdef NIOX_COMPILED_FLEET
+} // namespace niox
+#include "niox_fleet_manifest.h"
+namespace niox {
+
+static constexpr FleetTable COMPILED_FLEET = {
+    fleet_manifest::SEED, fleet_manifest::SIZE, fleet_manifest::BUCKETS, fleet_manifest::PILOTS, fleet_manifest::KEYS
+};
+static_assert(fleet_table_valid(COMPILED_FLEET), "niox_fleet_manifest.h is stale or edited; rerun niox_fleet_gen");
+#else
+static constexpr FleetTable COMPILED_FLEET = { 0, 0, 0, nullptr, nullptr };
+#endif
+
+} // namespace niox
+
+#endif // NIOX_FLEET_H
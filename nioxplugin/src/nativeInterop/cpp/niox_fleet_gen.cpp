@@ -0,0 +1,59 @@
+// niox_fleet_gen - build niox_fleet_manifest.h from a site's fleet manifest
+// Usage: niox_fleet_gen <manifest.txt> [output.h]
+// The output defaults to niox_fleet_manifest.h next to this file's headers;
+// compile winrt_ble_wrapper.cpp with NIOX_COMPILED_FLEET defined to use it.
+// Standalone: needs only the niox headers, no WinRT.
+
+#include "niox_fleet.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: niox_fleet_gen <manifest.txt> [niox_fleet_manifest.h]\n");
+        return 2;
+    }
+    const char* manifestPath = argv[1];
+    const char* outputPath = argc > 2 ? argv[2] : "niox_fleet_manifest.h";
+
+    FILE* in = fopen(manifestPath, "rb");
+    if (in == nullptr) {
+        fprintf(stderr, "niox_fleet_gen: cannot open %s\n", manifestPath);
+        return 1;
+    }
+    std::string text;
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), in)) > 0) text.append(buffer, read);
+    fclose(in);
+
+    std::vector<uint64_t> serials;
+    if (niox::parse_fleet_manifest(text.c_str(), serials) < 0) {
+        fprintf(stderr, "niox_fleet_gen: %s: entry %zu is not a NIOX serial\n", manifestPath, serials.size() + 1);
+        return 1;
+    }
+    if (serials.empty()) {
+        fprintf(stderr, "niox_fleet_gen: %s lists no serials\n", manifestPath);
+        return 1;
+    }
+
+    niox::Fleet fleet;
+    if (!fleet.build(serials)) {
+        fprintf(stderr, "niox_fleet_gen: no perfect hash found for %zu serials\n", serials.size());
+        return 1;
+    }
+
+    const std::string header = niox::fleet_header(fleet, manifestPath);
+    FILE* out = fopen(outputPath, "wb");
+    if (out == nullptr || fwrite(header.data(), 1, header.size(), out) != header.size()) {
+        fprintf(stderr, "niox_fleet_gen: cannot write %s\n", outputPath);
+        if (out != nullptr) fclose(out);
+        return 1;
+    }
+    fclose(out);
+
+    const niox::FleetTable table = fleet.table();
+    printf("niox_fleet_gen: %u serials, %u buckets -> %s\n", table.size, table.buckets, outputPath);
+    return 0;
+}
@@ -0,0 +1,826 @@
+// NIOX GATT - client with a per-device attribute and value cache
+// Service discovery runs once per device, not once per connection: handles
+// and the values of static (read-only) characteristics stay cached across
+// links until the device sends a Service Changed indication for their range.
+// GattBackend is the radio side (WinRT in the wrapper, SimulatedGattBackend
+// here for tests without Bluetooth hardware).
+
+#ifndef NIOX_GATT_H
+#define NIOX_GATT_H
+
+#include "niox_link.h"
+#include "niox_uuid.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace niox {
+
+// Characteristic properties (Core spec Vol 3 Part G 3.3.1.1)
+static const uint8_t GATT_PROP_READ = 0x02;
+static const uint8_t GATT_PROP_WRITE_NO_RESPONSE = 0x04;
+static const uint8_t GATT_PROP_WRITE = 0x08;
+static const uint8_t GATT_PROP_NOTIFY = 0x10;
+static const uint8_t GATT_PROP_INDICATE = 0x20;
+
+// GATT result codes, continuing the LINK_* range
+static const int GATT_NOT_CONNECTED = -5;
+static const int GATT_NOT_FOUND = -6;       // No such characteristic on the device
+static const int GATT_NOT_PERMITTED = -7;   // Characteristic lacks the needed property
+static const int GATT_NO_SPACE = -8;        // Caller buffer too small
+
+// ATT_MTU before any exchange, and the largest the spec allows
+static const uint16_t ATT_DEFAULT_MTU = 23;
+static const uint16_t ATT_MAX_MTU = 517;
+
+struct GattCharacteristic {
+    Uuid service;
+    Uuid characteristic;
+    uint16_t handle;        // Value handle
+    uint8_t properties;     // GATT_PROP_* bits
+};
+
+// Helper: FNV-1a, used to key stored layouts by firmware revision string
+inline uint64_t fnv1a64(const uint8_t* data, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Value of a subscribed characteristic (notification or indication)
+typedef std::function<void(uint64_t address, uint16_t handle, const uint8_t* data, size_t length)> GattValueHandler;
+
+// Events raised by a backend, on whatever thread the radio stack uses
+class GattEvents {
+public:
+    virtual ~GattEvents() {}
+    virtual void on_value(uint64_t address, uint16_t handle, const uint8_t* data, size_t length) = 0;
+    // Attributes in [startHandle, endHandle] may have changed
+    virtual void on_services_changed(uint64_t address, uint16_t startHandle, uint16_t endHandle) = 0;
+};
+
+// Radio-side GATT operations. No caching at this layer: every call is at
+// least one round trip to the device.
+class GattBackend : public LinkBackend {
+public:
+    GattBackend() : events_(nullptr) {}
+
+    // Enumerate all services and characteristics
+    virtual int discover(uint64_t address, std::vector<GattCharacteristic>& out) = 0;
+
+    virtual int read(uint64_t address, uint16_t handle, std::vector<uint8_t>& out) = 0;
+
+    virtual int write(uint64_t address, uint16_t handle, const uint8_t* data, size_t length, bool withResponse) = 0;
+
+    // Enable or disable notifications/indications; values arrive via on_value
+    virtual int subscribe(uint64_t address, uint16_t handle, bool enable) = 0;
+
+    // Write command (write without response) through the stack's transmit
+    // queue. Backends with flow control block here until the stack has room;
+    // the ATT bearer keeps the order of commands and later requests.
+    virtual int write_command(uint64_t address, uint16_t handle, const uint8_t* data, size_t length) {
+        return write(address, handle, data, length, false);
+    }
+
+    // Wait until every write command issued so far has left the stack.
+    // Returns LINK_ERROR if one failed since the last drain (and clears
+    // that); backends that send commands synchronously have nothing to wait for.
+    virtual int drain_commands(uint64_t address) {
+        (void)address;
+        return LINK_OK;
+    }
+
+    // Negotiate the ATT MTU, asking for up to `desired`. Backends without an
+    // exchange report the default.
+    virtual int exchange_mtu(uint64_t address, uint16_t desired, uint16_t* mtu) {
+        (void)address;
+        (void)desired;
+        *mtu = ATT_DEFAULT_MTU;
+        return LINK_OK;
+    }
+
+    void set_events(GattEvents* events) { events_.store(events); }
+
+protected:
+    void deliver_value(uint64_t address, uint16_t handle, const uint8_t* data, size_t length) {
+        GattEvents* events = events_.load();
+        if (events) events->on_value(address, handle, data, length);
+    }
+
+    void deliver_services_changed(uint64_t address, uint16_t startHandle, uint16_t endHandle) {
+        GattEvents* events = events_.load();
+        if (events) events->on_services_changed(address, startHandle, endHandle);
+    }
+
+private:
+    std::atomic<GattEvents*> events_;
+};
+
+// Attribute layouts kept beyond the process (see AttributeStore). The client
+// looks a device up before discovering and confirms the stored layout by
+// reading the Firmware Revision characteristic through its stored handle.
+class AttributePersistence {
+public:
+    virtual ~AttributePersistence() {}
+
+    // Stored layout and firmware revision hash for a device, if taken from the same unit
+    virtual bool find(uint64_t address, uint64_t serial, std::vector<GattCharacteristic>& out, uint64_t* firmwareHash) = 0;
+
+    // Outcome of the firmware check after a successful find
+    virtual void accept(uint64_t address) = 0;
+    virtual void reject(uint64_t address) = 0;
+
+    virtual void put(uint64_t address, uint64_t serial, uint64_t firmwareHash,
+                     const std::vector<GattCharacteristic>& characteristics) = 0;
+
+    virtual void erase(uint64_t address) = 0;
+};
+
+// Packed NIOX serial for an address, 0 if unknown
+typedef std::function<uint64_t(uint64_t address)> SerialLookup;
+
+struct GattStats {
+    uint64_t discoveries;           // Discoveries that went to the device
+    uint64_t cachedDiscoveries;     // Discoveries answered from the in-memory cache
+    uint64_t persistedDiscoveries;  // Discoveries answered from the persistent store
+    uint64_t radioReads;
+    uint64_t cachedReads;
+    uint64_t invalidations;         // Service Changed events applied
+};
+
+// GATT client over a backend. Thread-safe; backend calls are made without
+// holding the cache lock.
+class GattClient : public GattEvents {
+public:
+    explicit GattClient(std::shared_ptr<GattBackend> backend) : backend_(backend), stats_() {
+        backend_->set_events(this);
+    }
+
+    ~GattClient() override {
+        backend_->set_events(nullptr);
+    }
+
+    GattClient(const GattClient&) = delete;
+    GattClient& operator=(const GattClient&) = delete;
+
+    GattBackend& backend() { return *backend_; }
+
+    // Consult a persistent store before discovering; serialOf supplies the
+    // unit's serial so a layout is never reused for a different device
+    void set_persistence(std::shared_ptr<AttributePersistence> store, SerialLookup serialOf) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        store_ = store;
+        serial_of_ = serialOf;
+    }
+
+    // Re-arms Service Changed indications for devices discovered on an
+    // earlier link, so their cache stays trustworthy
+    int connect(const CachedAdvertisement& advertisement, int timeoutMs) {
+        int result = backend_->connect(advertisement, timeoutMs);
+        if (result != LINK_OK) return result;
+        uint16_t serviceChanged = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = devices_.find(advertisement.address);
+            if (it != devices_.end()) serviceChanged = it->second.serviceChangedHandle;
+        }
+        if (serviceChanged != 0) backend_->subscribe(advertisement.address, serviceChanged, true);
+        return result;
+    }
+
+    // The cache outlives the link; only Service Changed (or clear) drops it
+    void disconnect(uint64_t address) {
+        backend_->disconnect(address);
+        std::lock_guard<std::mutex> lock(mutex_);
+        drop_listeners(address, 0x0001, 0xFFFF);
+    }
+
+    bool is_connected(uint64_t address) { return backend_->is_connected(address); }
+
+    // Characteristics of a device, from the in-memory cache or the persistent
+    // store when discovered before
+    int discover(uint64_t address, std::vector<GattCharacteristic>& out, bool* fromCache = nullptr) {
+        uint64_t generation;
+        std::shared_ptr<AttributePersistence> store;
+        SerialLookup serialOf;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Device& device = devices_[address];
+            if (device.discovered) {
+                out = device.characteristics;
+                stats_.cachedDiscoveries++;
+                if (fromCache) *fromCache = true;
+                return LINK_OK;
+            }
+            generation = device.generation;
+            store = store_;
+            serialOf = serial_of_;
+        }
+
+        // Stored layout, trusted only if the unit still runs the same firmware
+        std::vector<GattCharacteristic> found;
+        const uint64_t serial = store && serialOf ? serialOf(address) : 0;
+        bool persisted = false;
+        if (store) {
+            uint64_t storedFirmware = 0;
+            if (store->find(address, serial, found, &storedFirmware)) {
+                uint64_t firmware = 0;
+                persisted = read_firmware_hash(address, found, &firmware) && firmware == storedFirmware;
+                if (persisted) store->accept(address);
+                else store->reject(address);
+            }
+        }
+        if (fromCache) *fromCache = persisted;
+
+        if (!persisted) {
+            found.clear();
+            int result = backend_->discover(address, found);
+            if (result != LINK_OK) return result;
+            uint64_t firmware = 0;
+            if (store && read_firmware_hash(address, found, &firmware)) store->put(address, serial, firmware, found);
+        }
+
+        // Watch for Service Changed so the cache can be trusted across links
+        uint16_t serviceChanged = 0;
+        for (const GattCharacteristic& c : found) {
+            if (c.characteristic == SERVICE_CHANGED_UUID && (c.properties & GATT_PROP_INDICATE)) {
+                serviceChanged = c.handle;
+            }
+        }
+        if (serviceChanged != 0) backend_->subscribe(address, serviceChanged, true);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (persisted) stats_.persistedDiscoveries++;
+        else stats_.discoveries++;
+        Device& device = devices_[address];
+        if (device.generation == generation) {
+            device.characteristics = found;
+            device.serviceChangedHandle = serviceChanged;
+            device.discovered = true;
+        }
+        out.swap(found);
+        return LINK_OK;
+    }
+
+    // Resolve a characteristic, discovering on first use
+    int find(uint64_t address, const Uuid& service, const Uuid& characteristic, GattCharacteristic* out) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = devices_.find(address);
+            if (it != devices_.end() && it->second.discovered) {
+                return lookup(it->second, service, characteristic, out);
+            }
+        }
+        std::vector<GattCharacteristic> characteristics;
+        int result = discover(address, characteristics);
+        if (result != LINK_OK) return result;
+        for (const GattCharacteristic& c : characteristics) {
+            if (c.service == service && c.characteristic == characteristic) {
+                *out = c;
+                return LINK_OK;
+            }
+        }
+        return GATT_NOT_FOUND;
+    }
+
+    // Read a characteristic value. Static characteristics (readable, not
+    // writable, no notify/indicate) are served from the cache after the first read.
+    int read(uint64_t address, const Uuid& service, const Uuid& characteristic,
+             std::vector<uint8_t>& out, bool* fromCache = nullptr) {
+        GattCharacteristic c;
+        int result = find(address, service, characteristic, &c);
+        if (result != LINK_OK) return result;
+        if ((c.properties & GATT_PROP_READ) == 0) return GATT_NOT_PERMITTED;
+
+        const bool cacheable = is_static(c);
+        uint64_t generation = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Device& device = devices_[address];
+            if (cacheable) {
+                auto it = device.values.find(c.handle);
+                if (it != device.values.end()) {
+                    out = it->second;
+                    stats_.cachedReads++;
+                    if (fromCache) *fromCache = true;
+                    return LINK_OK;
+                }
+            }
+            generation = device.generation;
+        }
+        if (fromCache) *fromCache = false;
+
+        result = backend_->read(address, c.handle, out);
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.radioReads++;
+        if (result == LINK_OK && cacheable) {
+            Device& device = devices_[address];
+            if (device.generation == generation) device.values[c.handle] = out;
+        }
+        return result;
+    }
+
+    int write(uint64_t address, const Uuid& service, const Uuid& characteristic,
+              const uint8_t* data, size_t length, bool withResponse) {
+        GattCharacteristic c;
+        int result = find(address, service, characteristic, &c);
+        if (result != LINK_OK) return result;
+        const uint8_t needed = withResponse ? GATT_PROP_WRITE : GATT_PROP_WRITE_NO_RESPONSE;
+        if ((c.properties & needed) == 0) return GATT_NOT_PERMITTED;
+        return backend_->write(address, c.handle, data, length, withResponse);
+    }
+
+    // Subscribe to notifications/indications; an empty handler unsubscribes
+    int subscribe(uint64_t address, const Uuid& service, const Uuid& characteristic, GattValueHandler handler) {
+        GattCharacteristic c;
+        int result = find(address, service, characteristic, &c);
+        if (result != LINK_OK) return result;
+        if ((c.properties & (GATT_PROP_NOTIFY | GATT_PROP_INDICATE)) == 0) return GATT_NOT_PERMITTED;
+
+        const bool enable = static_cast<bool>(handler);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (enable) listeners_[listener_key(address, c.handle)] = std::make_shared<GattValueHandler>(handler);
+            else listeners_.erase(listener_key(address, c.handle));
+        }
+        result = backend_->subscribe(address, c.handle, enable);
+        if (result != LINK_OK && enable) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            listeners_.erase(listener_key(address, c.handle));
+        }
+        return result;
+    }
+
+    // Drop cached attributes and values in [startHandle, endHandle]. Handles
+    // outside the range are unchanged by definition, so their values stay.
+    // The persisted layout is dropped too.
+    void invalidate(uint64_t address, uint16_t startHandle, uint16_t endHandle) {
+        std::shared_ptr<AttributePersistence> store;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            store = store_;
+            auto it = devices_.find(address);
+            if (it != devices_.end()) {
+                Device& device = it->second;
+                device.generation++;
+                device.discovered = false;
+                device.characteristics.clear();
+                for (auto value = device.values.begin(); value != device.values.end();) {
+                    if (value->first >= startHandle && value->first <= endHandle) value = device.values.erase(value);
+                    else ++value;
+                }
+                drop_listeners(address, startHandle, endHandle);
+            }
+            stats_.invalidations++;
+        }
+        if (store) store->erase(address);
+    }
+
+    GattStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        devices_.clear();
+        listeners_.clear();
+        stats_ = GattStats();
+    }
+
+    // GattEvents
+    void on_value(uint64_t address, uint16_t handle, const uint8_t* data, size_t length) override {
+        bool serviceChanged = false;
+        std::shared_ptr<GattValueHandler> handler;     // Shared, not copied: no allocation per value
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto device = devices_.find(address);
+            if (device != devices_.end() && handle != 0 && device->second.serviceChangedHandle == handle) {
+                serviceChanged = true;
+            }
+            else {
+                auto it = listeners_.find(listener_key(address, handle));
+                if (it != listeners_.end()) handler = it->second;
+            }
+        }
+
+        if (serviceChanged) {
+            // Service Changed value: affected start and end handle, little-endian
+            uint16_t start = 0x0001;
+            uint16_t end = 0xFFFF;
+            if (length >= 4) {
+                start = static_cast<uint16_t>(data[0] | (data[1] << 8));
+                end = static_cast<uint16_t>(data[2] | (data[3] << 8));
+            }
+            invalidate(address, start, end);
+            return;
+        }
+        if (handler) (*handler)(address, handle, data, length);
+    }
+
+    void on_services_changed(uint64_t address, uint16_t startHandle, uint16_t endHandle) override {
+        invalidate(address, startHandle, endHandle);
+    }
+
+private:
+    struct Device {
+        bool discovered = false;
+        uint16_t serviceChangedHandle = 0;
+        uint64_t generation = 0;    // Bumped on invalidation; stale fills are dropped
+        std::vector<GattCharacteristic> characteristics;
+        std::unordered_map<uint16_t, std::vector<uint8_t>> values;
+    };
+
+    // Helper: Hash of the Firmware Revision String read through the given layout
+    bool read_firmware_hash(uint64_t address, const std::vector<GattCharacteristic>& characteristics, uint64_t* hash) {
+        for (const GattCharacteristic& c : characteristics) {
+            if (c.service == DEVICE_INFORMATION_SERVICE_UUID && c.characteristic == FIRMWARE_REVISION_UUID &&
+                (c.properties & GATT_PROP_READ)) {
+                std::vector<uint8_t> value;
+                if (backend_->read(address, c.handle, value) != LINK_OK) return false;
+                *hash = fnv1a64(value.data(), value.size());
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool is_static(const GattCharacteristic& c) {
+        return (c.properties & (GATT_PROP_WRITE | GATT_PROP_WRITE_NO_RESPONSE |
+                                GATT_PROP_NOTIFY | GATT_PROP_INDICATE)) == 0;
+    }
+
+    static uint64_t listener_key(uint64_t address, uint16_t handle) {
+        return (address << 16) | handle;
+    }
+
+    static int lookup(const Device& device, const Uuid& service, const Uuid& characteristic, GattCharacteristic* out) {
+        for (const GattCharacteristic& c : device.characteristics) {
+            if (c.service == service && c.characteristic == characteristic) {
+                *out = c;
+                return LINK_OK;
+            }
+        }
+        return GATT_NOT_FOUND;
+    }
+
+    // Caller holds mutex_
+    void drop_listeners(uint64_t address, uint16_t startHandle, uint16_t endHandle) {
+        for (auto it = listeners_.begin(); it != listeners_.end();) {
+            const uint16_t handle = static_cast<uint16_t>(it->first);
+            if ((it->first >> 16) == address && handle >= startHandle && handle <= endHandle) it = listeners_.erase(it);
+            else ++it;
+        }
+    }
+
+    std::shared_ptr<GattBackend> backend_;
+    std::shared_ptr<AttributePersistence> store_;
+    SerialLookup serial_of_;
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, Device> devices_;
+    std::unordered_map<uint64_t, std::shared_ptr<GattValueHandler>> listeners_;
+    GattStats stats_;
+};
+
+// Simulated peripherals for tests without a radio. Links come from an
+// internal MockLinkBackend; every GATT operation costs one simulated round
+// trip (discovery: one for the service list plus one per service).
+// Each peripheral starts with the Generic Attribute service and its Service
+// Changed characteristic at handle 3; added characteristics follow.
+class SimulatedGattBackend : public GattBackend {
+public:
+    // Peripheral-side reaction to a client write (runs on the writer's thread)
+    typedef std::function<void(const uint8_t* data, size_t length)> WriteHandler;
+
+    explicit SimulatedGattBackend(int setupLatencyMs = 0, int roundTripMs = 0)
+        : link_(setupLatencyMs), round_trip_ms_(roundTripMs), max_mtu_(ATT_MAX_MTU), round_trips_(0),
+          command_slots_(0), packet_interval_us_(0), failing_commands_(0), command_failed_(false), commands_(0),
+          credit_waits_(0) {}
+
+    int connect(const CachedAdvertisement& advertisement, int timeoutMs) override {
+        return link_.connect(advertisement, timeoutMs);
+    }
+
+    // Subscriptions end with the link (no bonding)
+    void disconnect(uint64_t address) override {
+        link_.disconnect(address);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = peripherals_.find(address);
+        if (it == peripherals_.end()) return;
+        for (Attribute& attribute : it->second.attributes) attribute.subscribed = false;
+    }
+
+    bool is_connected(uint64_t address) override { return link_.is_connected(address); }
+
+    void disconnect_all() override {
+        link_.disconnect_all();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : peripherals_) {
+            for (Attribute& attribute : entry.second.attributes) attribute.subscribed = false;
+        }
+    }
+
+    int discover(uint64_t address, std::vector<GattCharacteristic>& out) override {
+        std::vector<GattCharacteristic> found;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!link_.is_connected(address)) return GATT_NOT_CONNECTED;
+            const Peripheral& peripheral = peripheral_locked(address);
+            for (const Attribute& attribute : peripheral.attributes) found.push_back(attribute.characteristic);
+        }
+        size_t services = 0;
+        for (size_t i = 0; i < found.size(); i++) {
+            if (i == 0 || found[i].service != found[i - 1].service) services++;
+        }
+        round_trip(1 + services);
+        out.swap(found);
+        return LINK_OK;
+    }
+
+    int read(uint64_t address, uint16_t handle, std::vector<uint8_t>& out) override {
+        round_trip(1);
+        std::lock_guard<std::mutex> lock(mutex_);
+        Attribute* attribute = connected_attribute(address, handle);
+        if (attribute == nullptr) return link_.is_connected(address) ? GATT_NOT_FOUND : GATT_NOT_CONNECTED;
+        out = attribute->value;
+        return LINK_OK;
+    }
+
+    // A request queues behind buffered commands, then costs a round trip
+    int write(uint64_t address, uint16_t handle, const uint8_t* data, size_t length, bool withResponse) override {
+        if (withResponse) {
+            std::this_thread::sleep_until(transmit_done());
+            round_trip(1);
+        }
+        return apply_write(address, handle, data, length);
+    }
+
+    // Commands take one packet interval each on air; the stack buffers at
+    // most `slots` of them (see set_command_buffer)
+    int write_command(uint64_t address, uint16_t handle, const uint8_t* data, size_t length) override {
+        std::unique_lock<std::mutex> lock(transmit_mutex_);
+        const std::chrono::microseconds interval(packet_interval_us_);
+        Clock::time_point now = Clock::now();
+        if (command_slots_ > 0 && busy_until_ > now + interval * (command_slots_ - 1)) {
+            credit_waits_++;
+            const Clock::time_point room = busy_until_ - interval * (command_slots_ - 1);
+            lock.unlock();
+            std::this_thread::sleep_until(room);
+            lock.lock();
+            now = Clock::now();
+        }
+        // Like a real stack, a command that failed fails the rest until drained
+        if (command_failed_) return LINK_ERROR;
+        busy_until_ = (busy_until_ > now ? busy_until_ : now) + interval;
+        if (failing_commands_ > 0) {
+            failing_commands_--;
+            command_failed_ = true;
+            return LINK_OK;         // Accepted, then lost in the stack
+        }
+        lock.unlock();
+        commands_++;
+        return apply_write(address, handle, data, length);
+    }
+
+    int drain_commands(uint64_t address) override {
+        (void)address;
+        std::this_thread::sleep_until(transmit_done());
+        std::lock_guard<std::mutex> lock(transmit_mutex_);
+        const bool failed = command_failed_;
+        command_failed_ = false;
+        return failed ? LINK_ERROR : LINK_OK;
+    }
+
+    int subscribe(uint64_t address, uint16_t handle, bool enable) override {
+        round_trip(1);
+        std::lock_guard<std::mutex> lock(mutex_);
+        Attribute* attribute = connected_attribute(address, handle);
+        if (attribute == nullptr) return link_.is_connected(address) ? GATT_NOT_FOUND : GATT_NOT_CONNECTED;
+        attribute->subscribed = enable;
+        return LINK_OK;
+    }
+
+    int exchange_mtu(uint64_t address, uint16_t desired, uint16_t* mtu) override {
+        if (!link_.is_connected(address)) return GATT_NOT_CONNECTED;
+        round_trip(1);
+        const uint16_t supported = max_mtu_.load();
+        *mtu = desired < ATT_DEFAULT_MTU ? ATT_DEFAULT_MTU : (desired < supported ? desired : supported);
+        return LINK_OK;
+    }
+
+    // Model the stack's transmit buffer for write commands: `slots` packets,
+    // each on air for packetIntervalUs (0 slots: unlimited)
+    void set_command_buffer(size_t slots, int packetIntervalUs) {
+        std::lock_guard<std::mutex> lock(transmit_mutex_);
+        command_slots_ = slots;
+        packet_interval_us_ = packetIntervalUs > 0 ? packetIntervalUs : 0;
+    }
+
+    // Lose the next `count` write commands in the stack; each failure is
+    // reported by later commands and by drain_commands
+    void fail_commands(size_t count) {
+        std::lock_guard<std::mutex> lock(transmit_mutex_);
+        failing_commands_ = count;
+    }
+
+    void set_round_trip(int roundTripMs) { round_trip_ms_.store(roundTripMs > 0 ? roundTripMs : 0); }
+
+    // Largest ATT MTU the simulated peripherals accept
+    void set_max_mtu(uint16_t mtu) { max_mtu_.store(mtu < ATT_DEFAULT_MTU ? ATT_DEFAULT_MTU : mtu); }
+
+    // Attach device behaviour to writes of a characteristic; the handler
+    // replaces storing the written value
+    bool set_write_handler(uint64_t address, uint16_t handle, WriteHandler handler) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = peripherals_.find(address);
+        if (it == peripherals_.end()) return false;
+        Attribute* attribute = find_attribute(it->second, handle);
+        if (attribute == nullptr) return false;
+        attribute->on_write = handler;
+        return true;
+    }
+
+    // Send a notification without changing the stored value (streamed data).
+    // Returns false if the client is not connected and subscribed.
+    bool notify(uint64_t address, uint16_t handle, const uint8_t* data, size_t length) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Attribute* attribute = connected_attribute(address, handle);
+            if (attribute == nullptr || !attribute->subscribed) return false;
+        }
+        deliver_value(address, handle, data, length);
+        return true;
+    }
+
+    // Add a characteristic to a peripheral. Returns its value handle.
+    uint16_t add_characteristic(uint64_t address, const Uuid& service, const Uuid& characteristic,
+                                uint8_t properties, const uint8_t* value, size_t length) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Peripheral& peripheral = peripheral_locked(address);
+        Attribute attribute;
+        attribute.characteristic = GattCharacteristic{ service, characteristic, 0, properties };
+        attribute.value.assign(value, value + length);
+        attribute.subscribed = false;
+        peripheral.attributes.push_back(attribute);
+        layout(peripheral);
+        return peripheral.attributes.back().characteristic.handle;
+    }
+
+    // Update a value as the device would, notifying a subscribed client
+    bool set_value(uint64_t address, uint16_t handle, const uint8_t* value, size_t length) {
+        bool notify = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = peripherals_.find(address);
+            if (it == peripherals_.end()) return false;
+            Attribute* attribute = find_attribute(it->second, handle);
+            if (attribute == nullptr) return false;
+            attribute->value.assign(value, value + length);
+            notify = attribute->subscribed && link_.is_connected(address);
+        }
+        if (notify) deliver_value(address, handle, value, length);
+        return true;
+    }
+
+    // Simulate a firmware update that moves every non-GATT attribute to new
+    // handles, indicating Service Changed for the affected range if subscribed
+    void change_services(uint64_t address) {
+        uint8_t range[4];
+        bool indicate = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = peripherals_.find(address);
+            if (it == peripherals_.end()) return;
+            Peripheral& peripheral = it->second;
+            peripheral.base_handle += 0x10;
+            layout(peripheral);
+            const uint16_t start = FIRST_USER_HANDLE;
+            const uint16_t end = 0xFFFF;
+            range[0] = static_cast<uint8_t>(start);
+            range[1] = static_cast<uint8_t>(start >> 8);
+            range[2] = static_cast<uint8_t>(end);
+            range[3] = static_cast<uint8_t>(end >> 8);
+            indicate = peripheral.attributes[0].subscribed && link_.is_connected(address);
+        }
+        if (indicate) deliver_value(address, SERVICE_CHANGED_HANDLE, range, sizeof(range));
+    }
+
+    // Total simulated round trips (radio cost)
+    uint64_t round_trips() const { return round_trips_.load(); }
+
+    // Write commands sent, and how often one waited for buffer room
+    uint64_t commands() const { return commands_.load(); }
+    uint64_t credit_waits() const { return credit_waits_.load(); }
+
+    MockLinkBackend& link() { return link_; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static const uint16_t SERVICE_CHANGED_HANDLE = 3;
+    static const uint16_t FIRST_USER_HANDLE = 5;
+
+    struct Attribute {
+        GattCharacteristic characteristic;
+        std::vector<uint8_t> value;
+        bool subscribed;
+        WriteHandler on_write;
+    };
+
+    struct Peripheral {
+        uint16_t base_handle = FIRST_USER_HANDLE;
+        std::vector<Attribute> attributes;  // [0] is Service Changed
+    };
+
+    // Assign handles: one declaration and one value handle per characteristic,
+    // plus a CCCD when it can notify or indicate; a new service adds a declaration
+    static void layout(Peripheral& peripheral) {
+        uint16_t handle = peripheral.base_handle;
+        for (size_t i = 1; i < peripheral.attributes.size(); i++) {
+            GattCharacteristic& c = peripheral.attributes[i].characteristic;
+            if (i == 1 || c.service != peripheral.attributes[i - 1].characteristic.service) handle++;
+            c.handle = static_cast<uint16_t>(handle + 1);
+            handle = static_cast<uint16_t>(handle + ((c.properties & (GATT_PROP_NOTIFY | GATT_PROP_INDICATE)) ? 3 : 2));
+        }
+    }
+
+    Peripheral& peripheral_locked(uint64_t address) {
+        auto it = peripherals_.find(address);
+        if (it != peripherals_.end()) return it->second;
+        Peripheral& peripheral = peripherals_[address];
+        Attribute serviceChanged;
+        serviceChanged.characteristic = GattCharacteristic{
+            GATT_SERVICE_UUID, SERVICE_CHANGED_UUID, SERVICE_CHANGED_HANDLE, GATT_PROP_INDICATE };
+        serviceChanged.subscribed = false;
+        peripheral.attributes.push_back(serviceChanged);
+        return peripheral;
+    }
+
+    static Attribute* find_attribute(Peripheral& peripheral, uint16_t handle) {
+        for (Attribute& attribute : peripheral.attributes) {
+            if (attribute.characteristic.handle == handle) return &attribute;
+        }
+        return nullptr;
+    }
+
+    Attribute* connected_attribute(uint64_t address, uint16_t handle) {
+        if (!link_.is_connected(address)) return nullptr;
+        auto it = peripherals_.find(address);
+        return it == peripherals_.end() ? nullptr : find_attribute(it->second, handle);
+    }
+
+    void round_trip(size_t count) {
+        round_trips_ += count;
+        const int roundTripMs = round_trip_ms_.load();
+        if (roundTripMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(roundTripMs * static_cast<int64_t>(count)));
+        }
+    }
+
+    // When the buffered write commands will have left
+    Clock::time_point transmit_done() {
+        std::lock_guard<std::mutex> lock(transmit_mutex_);
+        return busy_until_;
+    }
+
+    int apply_write(uint64_t address, uint16_t handle, const uint8_t* data, size_t length) {
+        WriteHandler handler;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Attribute* attribute = connected_attribute(address, handle);
+            if (attribute == nullptr) return link_.is_connected(address) ? GATT_NOT_FOUND : GATT_NOT_CONNECTED;
+            handler = attribute->on_write;
+            if (!handler) attribute->value.assign(data, data + length);
+        }
+        if (handler) handler(data, length);
+        return LINK_OK;
+    }
+
+    MockLinkBackend link_;
+    std::atomic<int> round_trip_ms_;
+    std::atomic<uint16_t> max_mtu_;
+    std::atomic<uint64_t> round_trips_;
+    std::mutex transmit_mutex_;
+    size_t command_slots_;
+    int packet_interval_us_;
+    Clock::time_point busy_until_;  // Last buffered command leaves the radio
+    size_t failing_commands_;
+    bool command_failed_;
+    std::atomic<uint64_t> commands_;
+    std::atomic<uint64_t> credit_waits_;
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, Peripheral> peripherals_;
+};
+
+} // namespace niox
+
+#endif // NIOX_GATT_H
@@ -0,0 +1,100 @@
+// NIOX link - connection backends
+// A LinkBackend opens a link straight from cached advertisement metadata
+// (address and address type), so connecting never waits for a new scan.
+// The WinRT backend lives in the wrapper; MockLinkBackend runs anywhere.
+
+#ifndef NIOX_LINK_H
+#define NIOX_LINK_H
+
+#include "niox_advertisement.h"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+namespace niox {
+
+// Link result codes (also returned through the C API)
+static const int LINK_OK = 0;
+static const int LINK_ERROR = -1;
+static const int LINK_NOT_CACHED = -2;     // Device never advertised since init
+static const int LINK_NOT_CONNECTABLE = -3;
+static const int LINK_TIMEOUT = -4;
+
+class LinkBackend {
+public:
+    virtual ~LinkBackend() {}
+
+    // Open (or confirm) a link to the advertised device. Returns a LINK_* code.
+    virtual int connect(const CachedAdvertisement& advertisement, int timeoutMs) = 0;
+
+    virtual void disconnect(uint64_t address) = 0;
+
+    virtual bool is_connected(uint64_t address) = 0;
+
+    // Drop every link (cleanup, backend switch)
+    virtual void disconnect_all() = 0;
+};
+
+// In-memory backend: every connect succeeds after a fixed link-setup delay
+// unless the address was marked unreachable. Thread-safe.
+class MockLinkBackend : public LinkBackend {
+public:
+    explicit MockLinkBackend(int setupLatencyMs = 0) : setup_latency_ms_(setupLatencyMs), connects_(0) {}
+
+    int connect(const CachedAdvertisement& advertisement, int timeoutMs) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (connected_.count(advertisement.address)) return LINK_OK;
+            if (!advertisement.connectable) return LINK_NOT_CONNECTABLE;
+            if (unreachable_.count(advertisement.address)) return LINK_ERROR;
+        }
+        if (setup_latency_ms_ > timeoutMs) return LINK_TIMEOUT;
+        if (setup_latency_ms_ > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(setup_latency_ms_));
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        connected_.insert(advertisement.address);
+        connects_++;
+        return LINK_OK;
+    }
+
+    void disconnect(uint64_t address) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connected_.erase(address);
+    }
+
+    bool is_connected(uint64_t address) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connected_.count(address) != 0;
+    }
+
+    void disconnect_all() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connected_.clear();
+    }
+
+    // Simulate a device that advertises but never accepts a link
+    void set_unreachable(uint64_t address, bool unreachable) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (unreachable) unreachable_.insert(address);
+        else unreachable_.erase(address);
+    }
+
+    uint64_t connect_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connects_;
+    }
+
+private:
+    int setup_latency_ms_;
+    uint64_t connects_;
+    mutable std::mutex mutex_;
+    std::unordered_set<uint64_t> connected_;
+    std::unordered_set<uint64_t> unreachable_;
+};
+
+} // namespace niox
+
+#endif // NIOX_LINK_H
@@ -0,0 +1,183 @@
+// NIOX notification ring - allocation-free streaming of GATT notifications
+// Live measurement data arrives as a burst of small notifications. Each
+// payload is copied once, from the radio stack's buffer into a preallocated
+// byte ring, and the consumer reads it in place in batches.
+//  - Producers: any number of radio threads (serialized by a short lock)
+//  - Consumer: one at a time; peek() returns views into the ring, release()
+//    frees them
+//  - A full ring drops the newest notification and counts it
+
+#ifndef NIOX_NOTIFICATION_RING_H
+#define NIOX_NOTIFICATION_RING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+namespace niox {
+
+// One notification, pointing into the ring; valid until release()
+struct NotificationView {
+    uint64_t address;
+    uint16_t handle;
+    uint16_t length;
+    int64_t timestampUs;        // Arrival time (steady clock)
+    const uint8_t* data;
+};
+
+struct NotificationRingStats {
+    uint64_t notifications;     // Accepted into the ring
+    uint64_t bytes;             // Payload bytes accepted
+    uint64_t dropped;           // Rejected because the ring was full
+    uint64_t droppedBytes;
+    uint64_t delivered;         // Released by the consumer
+    uint64_t batches;           // Non-empty peeks
+    uint64_t pendingBytes;      // Ring bytes in use, including headers
+    uint64_t peakBytes;         // Most ring bytes ever in use
+    uint64_t capacity;
+};
+
+class NotificationRing {
+public:
+    // capacity is rounded up to a multiple of 8 bytes
+    explicit NotificationRing(size_t capacity)
+        : capacity_((capacity < MIN_CAPACITY ? MIN_CAPACITY : capacity + 7) & ~static_cast<size_t>(7)),
+          buffer_(new uint8_t[capacity_]), head_(0), tail_(0), peeked_(0), peeked_count_(0),
+          delivered_(0), batches_(0), stats_() {
+        stats_.capacity = capacity_;
+    }
+
+    NotificationRing(const NotificationRing&) = delete;
+    NotificationRing& operator=(const NotificationRing&) = delete;
+
+    // Copy a notification into the ring. Returns false (and counts a drop)
+    // if it does not fit.
+    bool push(uint64_t address, uint16_t handle, const uint8_t* data, size_t length) {
+        const size_t size = record_size(length);
+        std::lock_guard<std::mutex> lock(producer_mutex_);
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        const uint64_t tail = tail_.load(std::memory_order_acquire);
+        const size_t position = static_cast<size_t>(head % capacity_);
+        // A record never wraps: the tail end of the ring is skipped instead
+        const size_t skip = capacity_ - position < size ? capacity_ - position : 0;
+        if (length > UINT16_MAX || size + skip > capacity_ - static_cast<size_t>(head - tail)) {
+            stats_.dropped++;
+            stats_.droppedBytes += length;
+            return false;
+        }
+
+        if (skip >= sizeof(Header)) {
+            Header padding{ 0, 0, 0, 0, FLAG_PADDING };
+            memcpy(buffer_.get() + position, &padding, sizeof(padding));
+        }
+        uint8_t* record = buffer_.get() + (position + skip) % capacity_;
+        Header header{ address, now_us(), handle, static_cast<uint16_t>(length), 0 };
+        memcpy(record, &header, sizeof(header));
+        if (length > 0) memcpy(record + sizeof(header), data, length);
+        head_.store(head + skip + size, std::memory_order_release);
+
+        stats_.notifications++;
+        stats_.bytes += length;
+        const uint64_t used = head + skip + size - tail;
+        if (used > stats_.peakBytes) stats_.peakBytes = used;
+        return true;
+    }
+
+    // Views of up to max buffered notifications, oldest first. Successive
+    // peeks continue where the previous one stopped; the views stay valid
+    // until release().
+    size_t peek(NotificationView* out, size_t max) {
+        std::lock_guard<std::mutex> lock(consumer_mutex_);
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t position = peeked_ > tail ? peeked_ : tail;
+        size_t count = 0;
+        while (count < max && position < head) {
+            const size_t offset = static_cast<size_t>(position % capacity_);
+            if (capacity_ - offset < sizeof(Header)) {
+                position += capacity_ - offset;
+                continue;
+            }
+            Header header;
+            memcpy(&header, buffer_.get() + offset, sizeof(header));
+            if (header.flags & FLAG_PADDING) {
+                position += capacity_ - offset;
+                continue;
+            }
+            out[count].address = header.address;
+            out[count].handle = header.handle;
+            out[count].length = header.length;
+            out[count].timestampUs = header.timestampUs;
+            out[count].data = buffer_.get() + offset + sizeof(Header);
+            count++;
+            position += record_size(header.length);
+        }
+        peeked_ = position;
+        peeked_count_ += count;
+        if (count > 0) batches_.fetch_add(1, std::memory_order_relaxed);
+        return count;
+    }
+
+    // Free every notification returned by peek() so far
+    void release() {
+        std::lock_guard<std::mutex> lock(consumer_mutex_);
+        if (peeked_ > tail_.load(std::memory_order_relaxed)) tail_.store(peeked_, std::memory_order_release);
+        delivered_.fetch_add(peeked_count_, std::memory_order_relaxed);
+        peeked_count_ = 0;
+    }
+
+    NotificationRingStats stats() const {
+        NotificationRingStats stats;
+        {
+            std::lock_guard<std::mutex> lock(producer_mutex_);
+            stats = stats_;
+            stats.pendingBytes = head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_acquire);
+        }
+        stats.delivered = delivered_.load(std::memory_order_relaxed);
+        stats.batches = batches_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    static const size_t MIN_CAPACITY = 256;
+    static const uint32_t FLAG_PADDING = 1;     // Marks the skipped end of the ring
+
+    struct Header {
+        uint64_t address;
+        int64_t timestampUs;
+        uint16_t handle;
+        uint16_t length;
+        uint32_t flags;
+    };
+
+    // Header plus payload, 8-byte aligned so headers can be read in place
+    static size_t record_size(size_t length) {
+        return (sizeof(Header) + length + 7) & ~static_cast<size_t>(7);
+    }
+
+    static int64_t now_us() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    const size_t capacity_;
+    std::unique_ptr<uint8_t[]> buffer_;
+    std::atomic<uint64_t> head_;    // Bytes ever written (producer)
+    std::atomic<uint64_t> tail_;    // Bytes ever freed (consumer)
+    uint64_t peeked_;               // End of the last peek; guarded by consumer_mutex_
+    size_t peeked_count_;           // Peeked, not yet released
+    std::atomic<uint64_t> delivered_;
+    std::atomic<uint64_t> batches_;
+    NotificationRingStats stats_;   // Producer counters; guarded by producer_mutex_
+    mutable std::mutex producer_mutex_;
+    std::mutex consumer_mutex_;
+};
+
+} // namespace niox
+
+#endif // NIOX_NOTIFICATION_RING_H
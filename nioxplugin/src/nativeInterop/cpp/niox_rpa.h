@@ -0,0 +1,320 @@
+// NIOX RPA - resolvable private address to identity resolution
+// Phones and some peripherals advertise from a resolvable private address
+// (RPA) that rotates every few minutes. Given the identity resolving key
+// (IRK) of a bonded device, an RPA resolves to that device's identity
+// address, so a rotating device stays one entry in the device table.
+//
+// An RPA is prand (top 24 bits, 0b01 in bits 47..46) followed by
+// hash = ah(IRK, prand), where ah is the low 24 bits of
+// AES-128(IRK, 0^104 || prand) (Core spec Vol 3 Part H 2.2.2). Resolution
+// tries each known IRK; results are cached per address, and cache misses
+// are resolved in batches so each IRK's key schedule is used for many
+// blocks at once (8 interleaved AES-NI pipelines, portable AES otherwise).
+
+#ifndef NIOX_RPA_H
+#define NIOX_RPA_H
+
+#include "niox_simd.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace niox {
+
+static const size_t IRK_SIZE = 16;
+
+// Helper: Address is a resolvable private address (random, bits 47..46 = 01)
+inline bool is_resolvable_private(uint64_t address) {
+    return ((address >> 46) & 0x3) == 1;
+}
+
+// Helper: Address is a random static address (bits 47..46 = 11), fixed
+// at least until the device power-cycles
+inline bool is_static_random(uint64_t address) {
+    return ((address >> 46) & 0x3) == 3;
+}
+
+// AES-128 encryption only, FIPS-197 byte order
+class Aes128 {
+public:
+    static const int ROUNDS = 10;
+
+    explicit Aes128(const uint8_t key[16]) {
+        memcpy(round_keys_[0], key, 16);
+        uint8_t rcon = 1;
+        for (int r = 1; r <= ROUNDS; r++) {
+            const uint8_t* prev = round_keys_[r - 1];
+            uint8_t* next = round_keys_[r];
+            next[0] = static_cast<uint8_t>(prev[0] ^ sbox(prev[13]) ^ rcon);
+            next[1] = static_cast<uint8_t>(prev[1] ^ sbox(prev[14]));
+            next[2] = static_cast<uint8_t>(prev[2] ^ sbox(prev[15]));
+            next[3] = static_cast<uint8_t>(prev[3] ^ sbox(prev[12]));
+            for (int i = 4; i < 16; i++) next[i] = static_cast<uint8_t>(prev[i] ^ next[i - 4]);
+            rcon = xtime(rcon);
+        }
+    }
+
+    // Encrypt count 16-byte blocks (in and out may alias)
+    void encrypt(const uint8_t* in, uint8_t* out, size_t count, bool hardware = true) const {
+#if NIOX_HAVE_SSE2
+        if (hardware && cpu_has_aesni()) {
+            encrypt_aesni(in, out, count);
+            return;
+        }
+#endif
+        (void)hardware;
+        for (size_t i = 0; i < count; i++) encrypt_block(in + i * 16, out + i * 16);
+    }
+
+private:
+    static uint8_t sbox(uint8_t value) {
+        static const uint8_t SBOX[256] = {
+            0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+            0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+            0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+            0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+            0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+            0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+            0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+            0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+            0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+            0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+            0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+            0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+            0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+            0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+            0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+            0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+        };
+        return SBOX[value];
+    }
+
+    static uint8_t xtime(uint8_t value) {
+        return static_cast<uint8_t>((value << 1) ^ ((value & 0x80) ? 0x1b : 0));
+    }
+
+    void encrypt_block(const uint8_t* in, uint8_t* out) const {
+        uint8_t s[16];
+        for (int i = 0; i < 16; i++) s[i] = static_cast<uint8_t>(in[i] ^ round_keys_[0][i]);
+        for (int r = 1; r <= ROUNDS; r++) {
+            // SubBytes + ShiftRows (column-major state: byte i is row i % 4)
+            uint8_t t[16];
+            for (int c = 0; c < 4; c++) {
+                for (int row = 0; row < 4; row++) t[c * 4 + row] = sbox(s[((c + row) % 4) * 4 + row]);
+            }
+            if (r < ROUNDS) {
+                // MixColumns
+                for (int c = 0; c < 4; c++) {
+                    uint8_t* col = t + c * 4;
+                    const uint8_t a0 = col[0], a1 = col[1], a2 = col[2], a3 = col[3];
+                    const uint8_t all = static_cast<uint8_t>(a0 ^ a1 ^ a2 ^ a3);
+                    col[0] = static_cast<uint8_t>(a0 ^ all ^ xtime(static_cast<uint8_t>(a0 ^ a1)));
+                    col[1] = static_cast<uint8_t>(a1 ^ all ^ xtime(static_cast<uint8_t>(a1 ^ a2)));
+                    col[2] = static_cast<uint8_t>(a2 ^ all ^ xtime(static_cast<uint8_t>(a2 ^ a3)));
+                    col[3] = static_cast<uint8_t>(a3 ^ all ^ xtime(static_cast<uint8_t>(a3 ^ a0)));
+                }
+            }
+            for (int i = 0; i < 16; i++) s[i] = static_cast<uint8_t>(t[i] ^ round_keys_[r][i]);
+        }
+        memcpy(out, s, 16);
+    }
+
+#if NIOX_HAVE_SSE2
+    // Eight independent blocks per step keep the AESENC pipeline full
+    NIOX_TARGET_AESNI void encrypt_aesni(const uint8_t* in, uint8_t* out, size_t count) const {
+        __m128i k[ROUNDS + 1];
+        for (int r = 0; r <= ROUNDS; r++) k[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(round_keys_[r]));
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i b[8];
+            for (int j = 0; j < 8; j++) {
+                b[j] = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + (i + j) * 16)), k[0]);
+            }
+            for (int r = 1; r < ROUNDS; r++) {
+                for (int j = 0; j < 8; j++) b[j] = _mm_aesenc_si128(b[j], k[r]);
+            }
+            for (int j = 0; j < 8; j++) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (i + j) * 16), _mm_aesenclast_si128(b[j], k[ROUNDS]));
+            }
+        }
+        for (; i < count; i++) {
+            __m128i b = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 16)), k[0]);
+            for (int r = 1; r < ROUNDS; r++) b = _mm_aesenc_si128(b, k[r]);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 16), _mm_aesenclast_si128(b, k[ROUNDS]));
+        }
+    }
+#endif
+
+    uint8_t round_keys_[ROUNDS + 1][16];
+};
+
+// Helper: ah(IRK, prand) for one address. irk is most significant byte first.
+inline uint32_t rpa_hash(const uint8_t irk[IRK_SIZE], uint32_t prand) {
+    uint8_t block[16] = { 0 };
+    block[13] = static_cast<uint8_t>(prand >> 16);
+    block[14] = static_cast<uint8_t>(prand >> 8);
+    block[15] = static_cast<uint8_t>(prand);
+    Aes128(irk).encrypt(block, block, 1);
+    return (static_cast<uint32_t>(block[13]) << 16) | (static_cast<uint32_t>(block[14]) << 8) | block[15];
+}
+
+struct IdentityResolverStats {
+    uint64_t lookups;           // RPAs looked up
+    uint64_t cacheHits;
+    uint64_t resolved;          // Misses resolved to an identity
+    uint64_t unresolved;        // Misses no known IRK matches
+    uint64_t aesBlocks;         // AES encryptions performed
+    uint32_t keys;
+    uint32_t cached;            // Addresses in the cache
+    bool hardware;              // AES-NI in use
+};
+
+// Not thread-safe: callers serialize access (the wrapper uses g_identity_mutex)
+class IdentityResolver {
+public:
+    explicit IdentityResolver(size_t cacheCapacity = 4096)
+        : cache_capacity_(cacheCapacity), hardware_(true), stats_() {}
+
+    // Add or replace the IRK of an identity address (irk most significant
+    // byte first). Cached failures are dropped so they are retried.
+    void add_key(uint64_t identity, const uint8_t irk[IRK_SIZE]) {
+        remove_key(identity);
+        keys_.push_back(Key{ identity, Aes128(irk) });
+        for (auto it = cache_.begin(); it != cache_.end();) {
+            it = it->second == 0 ? cache_.erase(it) : std::next(it);
+        }
+    }
+
+    // Returns false if the identity had no key
+    bool remove_key(uint64_t identity) {
+        for (size_t i = 0; i < keys_.size(); i++) {
+            if (keys_[i].identity != identity) continue;
+            keys_.erase(keys_.begin() + i);
+            for (auto it = cache_.begin(); it != cache_.end();) {
+                it = it->second == identity ? cache_.erase(it) : std::next(it);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // Replace each RPA in addresses that a known IRK resolves with its
+    // identity address; other addresses are left as they are. Returns the
+    // number replaced.
+    size_t resolve(uint64_t* addresses, size_t count) {
+        size_t replaced = 0;
+        misses_.clear();
+        for (size_t i = 0; i < count; i++) {
+            if (!is_resolvable_private(addresses[i]) || keys_.empty()) continue;
+            stats_.lookups++;
+            auto it = cache_.find(addresses[i]);
+            if (it == cache_.end()) {
+                misses_.push_back(i);
+                continue;
+            }
+            stats_.cacheHits++;
+            if (it->second != 0) {
+                addresses[i] = it->second;
+                replaced++;
+            }
+        }
+        if (misses_.empty()) return replaced;
+
+        // One plaintext block per miss; each key encrypts every block still
+        // unresolved in one batch
+        blocks_.assign(misses_.size() * 16, 0);
+        results_.resize(blocks_.size());
+        found_.assign(count, 0);
+        for (size_t m = 0; m < misses_.size(); m++) {
+            const uint64_t prand = addresses[misses_[m]] >> 24;
+            blocks_[m * 16 + 13] = static_cast<uint8_t>(prand >> 16);
+            blocks_[m * 16 + 14] = static_cast<uint8_t>(prand >> 8);
+            blocks_[m * 16 + 15] = static_cast<uint8_t>(prand);
+        }
+        size_t pending = misses_.size();
+        for (const Key& key : keys_) {
+            key.cipher.encrypt(blocks_.data(), results_.data(), pending, hardware_);
+            stats_.aesBlocks += pending;
+            // Unresolved misses move to the front for the next key
+            size_t kept = 0;
+            for (size_t m = 0; m < pending; m++) {
+                const uint8_t* out = &results_[m * 16];
+                const uint32_t hash = (static_cast<uint32_t>(out[13]) << 16) | (static_cast<uint32_t>(out[14]) << 8) | out[15];
+                if (hash == (addresses[misses_[m]] & 0xFFFFFF)) {
+                    found_[misses_[m]] = key.identity;
+                    continue;
+                }
+                if (kept != m) {
+                    memcpy(&blocks_[kept * 16], &blocks_[m * 16], 16);
+                    std::swap(misses_[kept], misses_[m]);
+                }
+                kept++;
+            }
+            pending = kept;
+            if (pending == 0) break;
+        }
+
+        if (cache_.size() + misses_.size() > cache_capacity_) cache_.clear();
+        for (size_t index : misses_) {
+            const uint64_t identity = found_[index];
+            cache_[addresses[index]] = identity;
+            if (identity == 0) {
+                stats_.unresolved++;
+                continue;
+            }
+            stats_.resolved++;
+            addresses[index] = identity;
+            replaced++;
+        }
+        return replaced;
+    }
+
+    uint64_t resolve(uint64_t address) {
+        resolve(&address, 1);
+        return address;
+    }
+
+    // Use AES-NI when the CPU has it (default), or always the portable AES
+    void set_hardware(bool enabled) { hardware_ = enabled; }
+
+    void clear_cache() { cache_.clear(); }
+
+    size_t key_count() const { return keys_.size(); }
+
+    IdentityResolverStats stats() const {
+        IdentityResolverStats stats = stats_;
+        stats.keys = static_cast<uint32_t>(keys_.size());
+        stats.cached = static_cast<uint32_t>(cache_.size());
+#if NIOX_HAVE_SSE2
+        stats.hardware = hardware_ && cpu_has_aesni();
+#else
+        stats.hardware = false;
+#endif
+        return stats;
+    }
+
+private:
+    struct Key {
+        uint64_t identity;
+        Aes128 cipher;
+    };
+
+    size_t cache_capacity_;
+    bool hardware_;
+    IdentityResolverStats stats_;
+    std::vector<Key> keys_;
+    std::unordered_map<uint64_t, uint64_t> cache_;  // RPA -> identity, 0 if unresolvable
+    std::vector<size_t> misses_;                    // Scratch, reused across calls
+    std::vector<uint8_t> blocks_;
+    std::vector<uint8_t> results_;
+    std::vector<uint64_t> found_;
+};
+
+} // namespace niox
+
+#endif // NIOX_RPA_H
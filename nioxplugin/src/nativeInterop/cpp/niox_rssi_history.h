@@ -0,0 +1,274 @@
+// NIOX RSSI history - recent RSSI per device for range troubleshooting
+// Each tracked device owns a fixed block of one shared slab, so memory is
+// set once at configuration (devices x entries x 8 bytes) and never grows.
+// A block holds one ring per resolution tier:
+//   tier 0  raw samples (the last rawSamples adverts)
+//   tier 1  1 s buckets (min / max / mean / count)
+//   tier 2  10 s buckets
+// Every sample goes into the raw ring and into the open bucket of each
+// coarser tier; a bucket is written to its ring when time moves past it.
+// Old data therefore survives at decreasing resolution, and an export
+// stitches the tiers together: coarse buckets up to where the next finer
+// ring begins, then the finer entries.
+// When all blocks are in use the device heard least recently gives up its
+// block.
+
+#ifndef NIOX_RSSI_HISTORY_H
+#define NIOX_RSSI_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace niox {
+
+static const int RSSI_TIERS = 3;
+static const int64_t RSSI_TIER_WIDTH_MS[RSSI_TIERS] = { 0, 1000, 10000 };   // 0 = raw
+
+struct RssiHistoryConfig {
+    uint32_t maxDevices;
+    uint32_t capacity[RSSI_TIERS];  // Entries per ring
+};
+
+static const RssiHistoryConfig DEFAULT_RSSI_HISTORY = { 64, { 256, 120, 90 } };  // 2 min at 1 s, 15 min at 10 s
+
+// One exported point, oldest first
+struct RssiPoint {
+    int64_t timeMs;             // Sample time, or bucket start
+    int32_t widthMs;            // 0 for a raw sample
+    int8_t min;
+    int8_t max;
+    int8_t mean;
+    uint16_t count;             // Samples folded into the point (saturates at 255)
+};
+
+class RssiHistory {
+public:
+    explicit RssiHistory(const RssiHistoryConfig& config = DEFAULT_RSSI_HISTORY) { configure(config); }
+
+    // Reallocate the slab; all history is dropped
+    void configure(const RssiHistoryConfig& config) {
+        config_ = config;
+        block_size_ = 0;
+        for (int tier = 0; tier < RSSI_TIERS; tier++) {
+            tier_offset_[tier] = block_size_;
+            block_size_ += config.capacity[tier];
+        }
+        slab_.assign(static_cast<size_t>(block_size_) * config.maxDevices, Entry());
+        blocks_.assign(config.maxDevices, Block());
+        by_address_.clear();
+        used_ = 0;
+        epoch_ms_ = INT64_MIN;
+        evictions_ = 0;
+    }
+
+    void add(uint64_t address, int rssi, int64_t nowMs) {
+        if (config_.maxDevices == 0) return;
+        if (epoch_ms_ == INT64_MIN) epoch_ms_ = nowMs;
+        if (nowMs - epoch_ms_ > REBASE_THRESHOLD_MS) rebase(nowMs);
+
+        Block& block = blocks_[block_for(address, nowMs)];
+        const uint32_t t = static_cast<uint32_t>(nowMs < epoch_ms_ ? 0 : nowMs - epoch_ms_);
+        const int8_t r = static_cast<int8_t>(rssi < -128 ? -128 : (rssi > 127 ? 127 : rssi));
+        block.lastMs = nowMs;
+
+        push(block, 0, Entry{ t, r, r, r, 1 });
+        for (int tier = 1; tier < RSSI_TIERS; tier++) {
+            const uint32_t width = static_cast<uint32_t>(RSSI_TIER_WIDTH_MS[tier]);
+            const uint32_t start = t - t % width;
+            Bucket& open = block.open[tier];
+            if (open.count > 0 && open.start != start) close(block, tier);
+            if (open.count == 0) {
+                open.start = start;
+                open.min = r;
+                open.max = r;
+                open.sum = 0;
+            }
+            if (r < open.min) open.min = r;
+            if (r > open.max) open.max = r;
+            open.sum += r;
+            open.count++;
+        }
+    }
+
+    // Export one device's series from sinceMs on, oldest first, stitching
+    // coarse buckets to finer ones. Returns the number of points available;
+    // at most capacity are written.
+    size_t export_series(uint64_t address, int64_t sinceMs, RssiPoint* out, size_t capacity) const {
+        auto it = by_address_.find(address);
+        if (it == by_address_.end()) return 0;
+        const Block& block = blocks_[it->second];
+        const size_t base = static_cast<size_t>(it->second) * block_size_;
+
+        size_t count = 0;
+        int64_t cursor = sinceMs;
+        for (int tier = RSSI_TIERS - 1; tier >= 0; tier--) {
+            const int64_t width = RSSI_TIER_WIDTH_MS[tier];
+            const int64_t finer = tier > 0 ? oldest_ms(block, base, tier - 1) : INT64_MAX;
+            bool stop = false;
+            auto emit = [&](const Entry& entry) {
+                const int64_t start = epoch_ms_ + entry.t;
+                if (start < cursor) return;
+                if (start >= finer) {
+                    stop = true;
+                    return;
+                }
+                if (count < capacity) {
+                    RssiPoint& p = out[count];
+                    p.timeMs = start;
+                    p.widthMs = static_cast<int32_t>(width);
+                    p.min = entry.min;
+                    p.max = entry.max;
+                    p.mean = entry.mean;
+                    p.count = entry.count;
+                }
+                count++;
+                cursor = start + (width > 0 ? width : 1);
+            };
+            const Ring& ring = block.rings[tier];
+            const uint32_t cap = config_.capacity[tier];
+            for (uint32_t i = 0; i < ring.size && !stop; i++) {
+                emit(slab_[base + tier_offset_[tier] + (ring.head + cap - ring.size + i) % cap]);
+            }
+            // The open bucket holds the newest samples of a coarse tier
+            if (tier > 0 && block.open[tier].count > 0 && !stop) emit(bucket_entry(block.open[tier]));
+        }
+        return count;
+    }
+
+    // Append every address with history (unordered)
+    void addresses(std::vector<uint64_t>& out) const {
+        for (const auto& entry : by_address_) out.push_back(entry.first);
+    }
+
+    size_t devices() const { return by_address_.size(); }
+    size_t bytes() const { return slab_.size() * sizeof(Entry) + blocks_.size() * sizeof(Block); }
+    uint64_t evictions() const { return evictions_; }
+    const RssiHistoryConfig& config() const { return config_; }
+
+    void clear() { configure(config_); }
+
+private:
+    // Timestamps are uint32 ms from epoch_ms_; rebase well before they wrap (~49 days)
+    static const int64_t REBASE_THRESHOLD_MS = int64_t(1) << 31;
+
+    // 8 bytes per sample or bucket
+    struct Entry {
+        uint32_t t;             // Ms since epoch_ms_ (bucket start for coarse tiers)
+        int8_t min;
+        int8_t max;
+        int8_t mean;
+        uint8_t count;          // Saturates at 255
+        Entry() : t(0), min(0), max(0), mean(0), count(0) {}
+        Entry(uint32_t t, int8_t min, int8_t max, int8_t mean, uint8_t count)
+            : t(t), min(min), max(max), mean(mean), count(count) {}
+    };
+    static_assert(sizeof(Entry) == 8, "RSSI entries are 8 bytes");
+
+    struct Ring {
+        uint32_t head = 0;      // Next write position
+        uint32_t size = 0;
+    };
+
+    struct Bucket {
+        uint32_t start = 0;
+        int8_t min = 0;
+        int8_t max = 0;
+        int32_t sum = 0;
+        uint32_t count = 0;
+    };
+
+    struct Block {
+        uint64_t address = 0;
+        int64_t lastMs = INT64_MIN;
+        Ring rings[RSSI_TIERS];
+        Bucket open[RSSI_TIERS];    // Index 0 unused
+    };
+
+    uint32_t block_for(uint64_t address, int64_t nowMs) {
+        auto it = by_address_.find(address);
+        if (it != by_address_.end()) return it->second;
+
+        uint32_t index;
+        if (used_ < config_.maxDevices) {
+            index = used_++;
+        }
+        else {
+            index = 0;
+            for (uint32_t i = 1; i < config_.maxDevices; i++) {
+                if (blocks_[i].lastMs < blocks_[index].lastMs) index = i;
+            }
+            by_address_.erase(blocks_[index].address);
+            evictions_++;
+        }
+        blocks_[index] = Block();
+        blocks_[index].address = address;
+        blocks_[index].lastMs = nowMs;
+        by_address_.emplace(address, index);
+        return index;
+    }
+
+    size_t block_index(const Block& block) const { return static_cast<size_t>(&block - blocks_.data()); }
+
+    void push(Block& block, int tier, const Entry& entry) {
+        const uint32_t cap = config_.capacity[tier];
+        if (cap == 0) return;
+        Ring& ring = block.rings[tier];
+        slab_[block_index(block) * block_size_ + tier_offset_[tier] + ring.head] = entry;
+        ring.head = (ring.head + 1) % cap;
+        if (ring.size < cap) ring.size++;
+    }
+
+    static Entry bucket_entry(const Bucket& bucket) {
+        const int32_t count = static_cast<int32_t>(bucket.count);
+        const int32_t mean = (bucket.sum >= 0 ? bucket.sum + count / 2 : bucket.sum - count / 2) / count;
+        return Entry(bucket.start, bucket.min, bucket.max, static_cast<int8_t>(mean),
+                     static_cast<uint8_t>(bucket.count > 0xFF ? 0xFF : bucket.count));
+    }
+
+    void close(Block& block, int tier) {
+        push(block, tier, bucket_entry(block.open[tier]));
+        block.open[tier].count = 0;
+    }
+
+    // Start of the oldest entry still in a tier (INT64_MAX if it holds none)
+    int64_t oldest_ms(const Block& block, size_t base, int tier) const {
+        const Ring& ring = block.rings[tier];
+        if (ring.size == 0) {
+            return (tier > 0 && block.open[tier].count > 0) ? epoch_ms_ + block.open[tier].start : INT64_MAX;
+        }
+        const uint32_t cap = config_.capacity[tier];
+        return epoch_ms_ + slab_[base + tier_offset_[tier] + (ring.head + cap - ring.size) % cap].t;
+    }
+
+    // Move the epoch forward by whole coarse buckets so bucket boundaries
+    // stay aligned; entries older than the new epoch are clamped to it
+    void rebase(int64_t nowMs) {
+        const int64_t coarsest = RSSI_TIER_WIDTH_MS[RSSI_TIERS - 1];
+        int64_t shift = (nowMs - epoch_ms_) - REBASE_THRESHOLD_MS / 2;
+        shift -= shift % coarsest;
+        const uint32_t s = static_cast<uint32_t>(shift);
+        for (Entry& entry : slab_) entry.t = entry.t < s ? 0 : entry.t - s;
+        for (Block& block : blocks_) {
+            for (int tier = 1; tier < RSSI_TIERS; tier++) {
+                block.open[tier].start = block.open[tier].start < s ? 0 : block.open[tier].start - s;
+            }
+        }
+        epoch_ms_ += shift;
+    }
+
+    RssiHistoryConfig config_;
+    uint32_t block_size_;                   // Entries per device
+    uint32_t tier_offset_[RSSI_TIERS];      // Ring start within a block
+    std::vector<Entry> slab_;
+    std::vector<Block> blocks_;
+    std::unordered_map<uint64_t, uint32_t> by_address_;
+    uint32_t used_;
+    int64_t epoch_ms_;
+    uint64_t evictions_;
+};
+
+} // namespace niox
+
+#endif // NIOX_RSSI_HISTORY_H
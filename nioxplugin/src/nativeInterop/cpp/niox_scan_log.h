@@ -0,0 +1,414 @@
+// NIOX scan log - append-only columnar history of every advert, on disk
+// Weeks of scan history per site for capacity planning. Records are
+// buffered in memory (bounded; a full buffer drops and counts) and a
+// background thread encodes them into self-contained blocks:
+//  - addresses dictionary-encoded per block, one varint index per record
+//  - timestamps as zigzag varint deltas from the previous record
+//  - RSSI as zigzag varint deltas from the same device's previous value
+//  - flags (DEVICE_FLAG_* low byte) one byte per record
+// A record costs 4-5 bytes against ~100 for a JSON line. Each block header
+// carries its time range and column offsets, so a reader maps the file and
+// skips blocks outside the requested range without touching their payload.
+//
+// File layout (little-endian)
+//   header   magic "NXSL" | version u32 | created unix ms i64
+//   block    magic "NXLB" | payload bytes u32 | records u32 | dictionary u32
+//            | first ms i64 | last ms i64 | column offsets u32 x 4
+//            (times, rssi, flags, end) | crc32 u32 of header bytes 0-47 and payload
+//            | payload: dictionary (6-byte addresses) | address indexes
+//            | times | rssi | flags
+// A block is only valid if its payload is complete and the checksum
+// matches; a torn block at the end (crash mid-write) is cut off when the
+// log is reopened for writing.
+
+#ifndef NIOX_SCAN_LOG_H
+#define NIOX_SCAN_LOG_H
+
+#include "niox_attribute_store.h"
+#include "niox_wire.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace niox {
+
+static const uint32_t SCAN_LOG_MAGIC = 0x4C53584E;        // "NXSL"
+static const uint32_t SCAN_LOG_BLOCK_MAGIC = 0x424C584E;  // "NXLB"
+static const uint32_t SCAN_LOG_VERSION = 2;                // 2: CRC-32 block checksum
+static const size_t SCAN_LOG_HEADER_SIZE = 16;
+static const size_t SCAN_LOG_BLOCK_HEADER_SIZE = 52;
+
+struct ScanLogRecord {
+    uint64_t address;
+    int64_t timeMs;             // Unix milliseconds
+    int8_t rssi;
+    uint8_t flags;
+};
+
+struct ScanLogStats {
+    uint64_t records;           // Written to disk
+    uint64_t blocks;
+    uint64_t bytes;             // File bytes written, headers included
+    uint64_t dropped;           // Buffer full or write failed
+    uint32_t pending;           // Buffered, not yet written
+    uint32_t capacity;          // Buffer limit
+};
+
+// Encode records (in arrival order) as one block appended to out
+inline void encode_scan_log_block(const ScanLogRecord* records, size_t count, std::vector<uint8_t>& out) {
+    std::unordered_map<uint64_t, uint32_t> ids;
+    std::vector<uint64_t> dictionary;
+    std::vector<uint32_t> index(count);
+    int64_t first = INT64_MAX;
+    int64_t last = INT64_MIN;
+    for (size_t i = 0; i < count; i++) {
+        auto inserted = ids.emplace(records[i].address, static_cast<uint32_t>(dictionary.size()));
+        if (inserted.second) dictionary.push_back(records[i].address);
+        index[i] = inserted.first->second;
+        if (records[i].timeMs < first) first = records[i].timeMs;
+        if (records[i].timeMs > last) last = records[i].timeMs;
+    }
+
+    std::vector<uint8_t> payload;
+    payload.reserve(dictionary.size() * 6 + count * 5);
+    for (uint64_t address : dictionary) put_le(payload, address, 6);
+    for (size_t i = 0; i < count; i++) put_varint(payload, index[i]);
+    const uint32_t timesOffset = static_cast<uint32_t>(payload.size());
+    int64_t previousTime = first;
+    for (size_t i = 0; i < count; i++) {
+        put_varint(payload, zigzag(records[i].timeMs - previousTime));
+        previousTime = records[i].timeMs;
+    }
+    const uint32_t rssiOffset = static_cast<uint32_t>(payload.size());
+    std::vector<int8_t> previousRssi(dictionary.size(), 0);
+    for (size_t i = 0; i < count; i++) {
+        put_varint(payload, zigzag(records[i].rssi - previousRssi[index[i]]));
+        previousRssi[index[i]] = records[i].rssi;
+    }
+    const uint32_t flagsOffset = static_cast<uint32_t>(payload.size());
+    for (size_t i = 0; i < count; i++) payload.push_back(records[i].flags);
+
+    put_le(out, SCAN_LOG_BLOCK_MAGIC, 4);
+    put_le(out, payload.size(), 4);
+    put_le(out, count, 4);
+    put_le(out, dictionary.size(), 4);
+    put_le(out, static_cast<uint64_t>(first), 8);
+    put_le(out, static_cast<uint64_t>(last), 8);
+    put_le(out, timesOffset, 4);
+    put_le(out, rssiOffset, 4);
+    put_le(out, flagsOffset, 4);
+    put_le(out, payload.size(), 4);
+    const size_t header = out.size() - (SCAN_LOG_BLOCK_HEADER_SIZE - 4);
+    put_le(out, crc32(payload.data(), payload.size(), crc32(out.data() + header, SCAN_LOG_BLOCK_HEADER_SIZE - 4)), 4);
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+// Location and range of one block within a mapped log
+struct ScanLogBlock {
+    size_t offset;
+    int64_t firstMs;
+    int64_t lastMs;
+    uint32_t records;
+};
+
+// Helper: Validate the block at offset. Returns its total size, or 0 if the
+// block is torn or corrupt.
+inline size_t check_scan_log_block(const uint8_t* data, size_t size, size_t offset, ScanLogBlock* block) {
+    if (size - offset < SCAN_LOG_BLOCK_HEADER_SIZE) return 0;
+    const uint8_t* h = data + offset;
+    if (get_le(h, 4) != SCAN_LOG_BLOCK_MAGIC) return 0;
+    const uint64_t payloadSize = get_le(h + 4, 4);
+    if (payloadSize > size - offset - SCAN_LOG_BLOCK_HEADER_SIZE) return 0;
+    const uint8_t* payload = h + SCAN_LOG_BLOCK_HEADER_SIZE;
+    if (crc32(payload, static_cast<size_t>(payloadSize), crc32(h, SCAN_LOG_BLOCK_HEADER_SIZE - 4)) != get_le(h + 48, 4)) return 0;
+    block->offset = offset;
+    block->records = static_cast<uint32_t>(get_le(h + 8, 4));
+    block->firstMs = static_cast<int64_t>(get_le(h + 16, 8));
+    block->lastMs = static_cast<int64_t>(get_le(h + 24, 8));
+    return SCAN_LOG_BLOCK_HEADER_SIZE + static_cast<size_t>(payloadSize);
+}
+
+// Memory-mapped reader. The mapping is a snapshot of the file when opened;
+// reopen to see blocks written since.
+class ScanLogReader {
+public:
+    // Returns false if the file is missing or not a scan log
+    bool open(const std::string& path) {
+        blocks_.clear();
+        records_ = 0;
+        if (!file_.open(path)) return false;
+        const uint8_t* data = file_.data();
+        const size_t size = file_.size();
+        if (size < SCAN_LOG_HEADER_SIZE || get_le(data, 4) != SCAN_LOG_MAGIC || get_le(data + 4, 4) != SCAN_LOG_VERSION) {
+            file_.close();
+            return false;
+        }
+        size_t offset = SCAN_LOG_HEADER_SIZE;
+        ScanLogBlock block;
+        while (size_t blockSize = check_scan_log_block(data, size, offset, &block)) {
+            blocks_.push_back(block);
+            records_ += block.records;
+            offset += blockSize;
+        }
+        return true;
+    }
+
+    size_t blocks() const { return blocks_.size(); }
+    uint64_t records() const { return records_; }
+
+    // Call fn(const ScanLogRecord&) for every record with fromMs <= time < toMs,
+    // in file order. Blocks outside the range are skipped by their header;
+    // inside a block only the time column is decoded for records outside it.
+    // Returns the number of records passed to fn.
+    template <typename Fn>
+    uint64_t scan(int64_t fromMs, int64_t toMs, Fn&& fn) const {
+        uint64_t matched = 0;
+        std::vector<int64_t> times;
+        std::vector<uint32_t> index;
+        std::vector<int8_t> previousRssi;
+        for (const ScanLogBlock& block : blocks_) {
+            if (block.lastMs < fromMs || block.firstMs >= toMs) continue;
+            const uint8_t* h = file_.data() + block.offset;
+            const uint8_t* payload = h + SCAN_LOG_BLOCK_HEADER_SIZE;
+            const uint32_t dictionarySize = static_cast<uint32_t>(get_le(h + 12, 4));
+            const uint8_t* times_p = payload + get_le(h + 32, 4);
+            const uint8_t* rssi_p = payload + get_le(h + 36, 4);
+            const uint8_t* flags_p = payload + get_le(h + 40, 4);
+            const uint8_t* end = payload + get_le(h + 44, 4);
+
+            // Time column first: a block only partly in range skips the rest
+            times.resize(block.records);
+            const uint8_t* p = times_p;
+            int64_t time = block.firstMs;
+            size_t inRange = 0;
+            uint64_t value;
+            for (uint32_t i = 0; i < block.records; i++) {
+                if (!get_varint(p, rssi_p, &value)) return matched;
+                time += unzigzag(value);
+                times[i] = time;
+                inRange += (time >= fromMs && time < toMs) ? 1 : 0;
+            }
+            if (inRange == 0) continue;
+
+            index.resize(block.records);
+            p = payload + static_cast<size_t>(dictionarySize) * 6;
+            for (uint32_t i = 0; i < block.records; i++) {
+                if (!get_varint(p, times_p, &value) || value >= dictionarySize) return matched;
+                index[i] = static_cast<uint32_t>(value);
+            }
+            previousRssi.assign(dictionarySize, 0);
+            p = rssi_p;
+            for (uint32_t i = 0; i < block.records; i++) {
+                if (!get_varint(p, flags_p, &value)) return matched;
+                const int8_t rssi = static_cast<int8_t>(previousRssi[index[i]] + unzigzag(value));
+                previousRssi[index[i]] = rssi;
+                if (times[i] < fromMs || times[i] >= toMs) continue;
+                if (flags_p + i >= end) return matched;
+                ScanLogRecord record;
+                record.address = get_le(payload + static_cast<size_t>(index[i]) * 6, 6);
+                record.timeMs = times[i];
+                record.rssi = rssi;
+                record.flags = flags_p[i];
+                fn(record);
+                matched++;
+            }
+        }
+        return matched;
+    }
+
+private:
+    MappedFile file_;
+    std::vector<ScanLogBlock> blocks_;
+    uint64_t records_ = 0;
+};
+
+// Background writer. append() only takes a short lock and copies 24 bytes;
+// encoding and file I/O happen on the writer thread.
+class ScanLogWriter {
+public:
+    ScanLogWriter() : running_(false), stop_(false), file_(nullptr), capacity_(0), block_records_(0),
+                      flush_ms_(0), stats_() {}
+    ~ScanLogWriter() { stop(); }
+
+    ScanLogWriter(const ScanLogWriter&) = delete;
+    ScanLogWriter& operator=(const ScanLogWriter&) = delete;
+
+    // Open (or create) the log and start the writer thread. A torn block at
+    // the end of an existing log is cut off first. Returns false on error.
+    bool start(const std::string& path, int64_t flushIntervalMs = 1000, size_t capacity = 65536,
+               size_t blockRecords = 4096) {
+        stop();
+        if (!prepare(path)) return false;
+        file_ = fopen(path.c_str(), "ab");
+        if (file_ == nullptr) return false;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity;
+        block_records_ = blockRecords == 0 ? 1 : blockRecords;
+        flush_ms_ = flushIntervalMs;
+        pending_.clear();
+        pending_.reserve(capacity);
+        draining_.reserve(capacity);
+        stats_ = ScanLogStats();
+        stats_.bytes = header_bytes_;
+        stop_ = false;
+        running_ = true;
+        thread_ = std::thread([this]() { run(); });
+        return true;
+    }
+
+    // Write everything buffered and stop the thread
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) return;
+            stop_ = true;
+        }
+        wake_.notify_one();
+        if (thread_.joinable()) thread_.join();
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        if (file_ != nullptr) fclose(file_);
+        file_ = nullptr;
+    }
+
+    // Hot path (any thread). Returns false if not running or the buffer is full.
+    bool append(const ScanLogRecord& record) {
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_ || stop_) return false;
+            if (pending_.size() >= capacity_) {
+                stats_.dropped++;
+                return false;
+            }
+            pending_.push_back(record);
+            wake = pending_.size() == block_records_;
+        }
+        if (wake) wake_.notify_one();
+        return true;
+    }
+
+    bool running() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return running_;
+    }
+
+    ScanLogStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ScanLogStats stats = stats_;
+        stats.pending = static_cast<uint32_t>(pending_.size() + draining_.size());
+        stats.capacity = static_cast<uint32_t>(capacity_);
+        return stats;
+    }
+
+private:
+    // Write the file header, or cut an existing log back to its last valid block
+    bool prepare(const std::string& path) {
+        header_bytes_ = 0;
+        // A file whose size cannot be read may still hold a log; never
+        // truncate it with "wb"
+        std::error_code error;
+        const bool exists = std::filesystem::exists(path, error);
+        if (error) return false;
+        const uintmax_t existingSize = exists ? std::filesystem::file_size(path, error) : 0;
+        if (error) return false;
+        if (existingSize > 0) {
+            size_t valid = 0;
+            {
+                MappedFile existing;
+                if (!existing.open(path)) return false;
+                const uint8_t* data = existing.data();
+                const size_t size = existing.size();
+                if (size < SCAN_LOG_HEADER_SIZE || get_le(data, 4) != SCAN_LOG_MAGIC ||
+                    get_le(data + 4, 4) != SCAN_LOG_VERSION) return false;     // Not ours; leave it alone
+                valid = SCAN_LOG_HEADER_SIZE;
+                ScanLogBlock block;
+                while (size_t blockSize = check_scan_log_block(data, size, valid, &block)) valid += blockSize;
+                if (valid == size) return true;
+            }
+            std::filesystem::resize_file(path, valid, error);
+            return !error;
+        }
+
+        FILE* file = fopen(path.c_str(), "wb");
+        if (file == nullptr) return false;
+        std::vector<uint8_t> header;
+        put_le(header, SCAN_LOG_MAGIC, 4);
+        put_le(header, SCAN_LOG_VERSION, 4);
+        put_le(header, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count()), 8);
+        const bool written = fwrite(header.data(), 1, header.size(), file) == header.size();
+        if (fclose(file) != 0 || !written) return false;
+        header_bytes_ = header.size();
+        return true;
+    }
+
+    void run() {
+        std::vector<uint8_t> encoded;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait_for(lock, std::chrono::milliseconds(flush_ms_), [this]() {
+                return stop_ || pending_.size() >= block_records_;
+            });
+            const bool stopping = stop_;
+            draining_.swap(pending_);
+            lock.unlock();
+
+            // Encode and write outside the lock; producers fill the other buffer
+            size_t written = 0;
+            size_t blocks = 0;
+            size_t bytes = 0;
+            size_t failed = 0;
+            for (size_t first = 0; first < draining_.size(); first += block_records_) {
+                const size_t count = std::min(block_records_, draining_.size() - first);
+                encoded.clear();
+                encode_scan_log_block(draining_.data() + first, count, encoded);
+                if (fwrite(encoded.data(), 1, encoded.size(), file_) == encoded.size()) {
+                    written += count;
+                    blocks++;
+                    bytes += encoded.size();
+                }
+                else {
+                    failed += count;
+                }
+            }
+            if (!draining_.empty()) fflush(file_);
+
+            lock.lock();
+            draining_.clear();
+            stats_.records += written;
+            stats_.blocks += blocks;
+            stats_.bytes += bytes;
+            stats_.dropped += failed;
+            if (stopping && pending_.empty()) return;
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::thread thread_;
+    bool running_;
+    bool stop_;
+    FILE* file_;                        // Only touched by the writer thread while running
+    size_t capacity_;
+    size_t block_records_;
+    int64_t flush_ms_;
+    size_t header_bytes_ = 0;
+    std::vector<ScanLogRecord> pending_;    // Filled by append()
+    std::vector<ScanLogRecord> draining_;   // Being written
+    ScanLogStats stats_;
+};
+
+} // namespace niox
+
+#endif // NIOX_SCAN_LOG_H
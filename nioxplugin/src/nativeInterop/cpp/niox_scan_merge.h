@@ -0,0 +1,288 @@
+// NIOX scan merge - one update per advertisement / scan response pair
+// Active scanning reports a scannable advertisement and its scan response
+// as separate events, and the name is often only in the response. The
+// merger holds the first PDU of a pair per address and delivers a single
+// event carrying both payloads once the pair is complete, or on its own
+// after a timeout (the response was lost, or never comes).
+//  - Non-scannable advertisements pass straight through, without a slot
+//  - A repeated PDU of the same kind delivers the held one first
+//  - Payloads are copied into fixed per-address buffers that are reused, so
+//    an address costs one allocation when first heard, not one per event;
+//    take_expired() frees the buffers of addresses unheard for SLOT_IDLE_MS
+
+#ifndef NIOX_SCAN_MERGE_H
+#define NIOX_SCAN_MERGE_H
+
+#include "niox_advertisement.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+
+namespace niox {
+
+static const size_t MAX_MERGED_NAME = 248;      // Longest AD local name
+static const int64_t SLOT_IDLE_MS = 10000;      // Unheard this long: the slot is freed
+
+// A delivered event with its own storage; event() points into it, so it
+// is valid while this object is unchanged
+struct MergedAdvertisement {
+    uint64_t address;
+    uint8_t addressType;
+    bool connectable;
+    bool scanResponse;          // Only the scan response was received
+    int rssi;
+    int64_t timestampMs;
+    bool hasName;
+    char name[MAX_MERGED_NAME + 1];
+    uint16_t length;
+    uint8_t data[2 * MAX_CACHED_ADVERTISEMENT];
+
+    AdvertisementEvent event() const {
+        AdvertisementEvent event;
+        event.address = address;
+        event.addressType = addressType;
+        event.connectable = connectable;
+        event.scannable = false;
+        event.scanResponse = scanResponse;
+        event.rssi = rssi;
+        event.timestampMs = timestampMs;
+        event.name = hasName ? name : nullptr;
+        event.data = data;
+        event.length = length;
+        return event;
+    }
+};
+
+struct ScanMergeStats {
+    uint64_t received;          // PDUs in
+    uint64_t delivered;         // Events out
+    uint64_t merged;            // Advertisement + scan response pairs
+    uint64_t passedThrough;     // Non-scannable advertisements
+    uint64_t timedOut;          // Delivered alone after the timeout
+    uint64_t superseded;        // Delivered alone because the same PDU kind repeated
+    uint32_t pending;           // Held, waiting for the other half
+    uint32_t slots;             // Addresses holding pairing buffers
+    uint64_t slotsFreed;        // Slots dropped after SLOT_IDLE_MS unheard
+};
+
+// Not thread-safe: callers serialize access (the wrapper uses g_merge_mutex)
+class ScanMerger {
+public:
+    explicit ScanMerger(int64_t timeoutMs = 100) : timeout_ms_(timeoutMs), last_sweep_ms_(INT64_MIN), stats_() {}
+
+    void set_timeout(int64_t timeoutMs) { timeout_ms_ = timeoutMs; }
+    int64_t timeout() const { return timeout_ms_; }
+
+    // Feed one PDU. Up to two events are written to out (a superseded held
+    // PDU, then the current one if it completed a pair or needs no partner);
+    // returns how many.
+    size_t add(const AdvertisementEvent& event, MergedAdvertisement out[2]) {
+        stats_.received++;
+        size_t count = 0;
+        if (!event.scanResponse && !event.scannable) {
+            stats_.passedThrough++;
+            auto it = slots_.find(event.address);
+            if (it != slots_.end() && it->second.pending) {
+                // A held half is stale once the device stops being scannable
+                emit(it->second, &out[count++]);
+                stats_.superseded++;
+            }
+            emit(event, &out[count++]);
+            return count;
+        }
+
+        Slot& slot = slots_[event.address];
+        if (slot.pending && (event.scanResponse ? slot.hasResponse : slot.hasAdvertisement)) {
+            emit(slot, &out[count++]);
+            stats_.superseded++;
+        }
+        if (!slot.pending) {
+            begin(slot, event);
+            expiry_.push_back(Expiry{ event.address, slot.firstMs });
+        }
+        store(slot, event);
+        if (slot.hasAdvertisement && slot.hasResponse) {
+            emit(slot, &out[count++]);
+            stats_.merged++;
+        }
+        return count;
+    }
+
+    // Deliver one held PDU whose partner is overdue. Returns false if none.
+    // Also frees slots of addresses unheard for SLOT_IDLE_MS (at most one
+    // sweep per SLOT_IDLE_MS).
+    bool take_expired(int64_t nowMs, MergedAdvertisement* out) {
+        if (last_sweep_ms_ == INT64_MIN || nowMs - last_sweep_ms_ >= SLOT_IDLE_MS) {
+            last_sweep_ms_ = nowMs;
+            sweep_idle(nowMs);
+        }
+        return take(nowMs, out);
+    }
+
+    // Deliver one held PDU regardless of age (scan stopped). Returns false if none.
+    bool take_any(MergedAdvertisement* out) {
+        return take(INT64_MAX, out);
+    }
+
+    ScanMergeStats stats() const {
+        ScanMergeStats stats = stats_;
+        stats.pending = 0;
+        for (const auto& slot : slots_) {
+            if (slot.second.pending) stats.pending++;
+        }
+        stats.slots = static_cast<uint32_t>(slots_.size());
+        return stats;
+    }
+
+    void clear() {
+        slots_.clear();
+        expiry_.clear();
+        last_sweep_ms_ = INT64_MIN;
+        stats_ = ScanMergeStats();
+    }
+
+private:
+    bool take(int64_t nowMs, MergedAdvertisement* out) {
+        while (!expiry_.empty()) {
+            const Expiry next = expiry_.front();
+            auto it = slots_.find(next.address);
+            if (it == slots_.end() || !it->second.pending || it->second.firstMs != next.firstMs) {
+                expiry_.pop_front();        // Delivered or restarted since
+                continue;
+            }
+            if (nowMs - next.firstMs < timeout_ms_) return false;
+            expiry_.pop_front();
+            emit(it->second, out);
+            stats_.timedOut++;
+            return true;
+        }
+        return false;
+    }
+
+    // Held slots stay until delivered; their expiry entry refers to them
+    void sweep_idle(int64_t nowMs) {
+        for (auto it = slots_.begin(); it != slots_.end();) {
+            if (!it->second.pending && nowMs - it->second.lastMs >= SLOT_IDLE_MS) {
+                it = slots_.erase(it);
+                stats_.slotsFreed++;
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    struct Slot {
+        uint64_t address = 0;
+        bool pending = false;
+        bool hasAdvertisement = false;
+        bool hasResponse = false;
+        bool hasName = false;
+        uint8_t addressType = ADDRESS_PUBLIC;
+        bool connectable = false;
+        int rssi = 0;
+        int64_t firstMs = 0;
+        int64_t lastMs = 0;
+        uint16_t advertisementLength = 0;
+        uint16_t responseLength = 0;
+        char name[MAX_MERGED_NAME + 1];
+        uint8_t advertisement[MAX_CACHED_ADVERTISEMENT];
+        uint8_t response[MAX_CACHED_ADVERTISEMENT];
+    };
+
+    struct Expiry {
+        uint64_t address;
+        int64_t firstMs;
+    };
+
+    static void begin(Slot& slot, const AdvertisementEvent& event) {
+        slot.address = event.address;
+        slot.pending = true;
+        slot.hasAdvertisement = false;
+        slot.hasResponse = false;
+        slot.hasName = false;
+        slot.firstMs = event.timestampMs;
+    }
+
+    static void store(Slot& slot, const AdvertisementEvent& event) {
+        const size_t length = event.length > MAX_CACHED_ADVERTISEMENT ? MAX_CACHED_ADVERTISEMENT : event.length;
+        if (event.scanResponse) {
+            if (length > 0) memcpy(slot.response, event.data, length);
+            slot.responseLength = static_cast<uint16_t>(length);
+            slot.hasResponse = true;
+        }
+        else {
+            if (length > 0) memcpy(slot.advertisement, event.data, length);
+            slot.advertisementLength = static_cast<uint16_t>(length);
+            slot.connectable = event.connectable;
+            slot.hasAdvertisement = true;
+        }
+        if (event.name != nullptr && event.name[0] != '\0') {
+            size_t nameLength = strlen(event.name);
+            if (nameLength > MAX_MERGED_NAME) nameLength = MAX_MERGED_NAME;
+            memcpy(slot.name, event.name, nameLength);
+            slot.name[nameLength] = '\0';
+            slot.hasName = true;
+        }
+        slot.addressType = event.addressType;
+        slot.rssi = event.rssi;
+        slot.lastMs = event.timestampMs;
+    }
+
+    // Advertisement AD structures first, then the scan response's
+    void emit(Slot& slot, MergedAdvertisement* out) {
+        out->address = slot.address;
+        out->addressType = slot.addressType;
+        out->connectable = slot.hasAdvertisement && slot.connectable;
+        out->scanResponse = !slot.hasAdvertisement;
+        out->rssi = slot.rssi;
+        out->timestampMs = slot.lastMs;
+        out->hasName = slot.hasName;
+        if (slot.hasName) memcpy(out->name, slot.name, strlen(slot.name) + 1);
+        size_t length = 0;
+        if (slot.hasAdvertisement) {
+            memcpy(out->data, slot.advertisement, slot.advertisementLength);
+            length = slot.advertisementLength;
+        }
+        if (slot.hasResponse) {
+            memcpy(out->data + length, slot.response, slot.responseLength);
+            length += slot.responseLength;
+        }
+        out->length = static_cast<uint16_t>(length);
+        slot.pending = false;
+        stats_.delivered++;
+    }
+
+    // A PDU that needs no partner, copied straight out
+    void emit(const AdvertisementEvent& event, MergedAdvertisement* out) {
+        const size_t length = event.length > MAX_CACHED_ADVERTISEMENT ? MAX_CACHED_ADVERTISEMENT : event.length;
+        out->address = event.address;
+        out->addressType = event.addressType;
+        out->connectable = event.connectable;
+        out->scanResponse = false;
+        out->rssi = event.rssi;
+        out->timestampMs = event.timestampMs;
+        out->hasName = event.name != nullptr && event.name[0] != '\0';
+        if (out->hasName) {
+            size_t nameLength = strlen(event.name);
+            if (nameLength > MAX_MERGED_NAME) nameLength = MAX_MERGED_NAME;
+            memcpy(out->name, event.name, nameLength);
+            out->name[nameLength] = '\0';
+        }
+        if (length > 0) memcpy(out->data, event.data, length);
+        out->length = static_cast<uint16_t>(length);
+        stats_.delivered++;
+    }
+
+    int64_t timeout_ms_;
+    int64_t last_sweep_ms_;
+    ScanMergeStats stats_;
+    std::unordered_map<uint64_t, Slot> slots_;
+    std::deque<Expiry> expiry_;     // Pending pairs, oldest first (one timeout, so also deadline order)
+};
+
+} // namespace niox
+
+#endif // NIOX_SCAN_MERGE_H
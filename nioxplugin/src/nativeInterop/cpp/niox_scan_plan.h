@@ -0,0 +1,103 @@
+// NIOX scan plan - passive sweep first, active burst only when needed
+// Active scanning sends a scan request to every scannable device and
+// doubles the event volume, but scan responses are only needed for devices
+// whose name is still unknown. A two-phase scan listens passively first
+// (addresses, RSSI, names carried in the advert itself) and switches to
+// active scanning only if nameless candidates above the RSSI floor remain,
+// ending the burst as soon as they are resolved.
+
+#ifndef NIOX_SCAN_PLAN_H
+#define NIOX_SCAN_PLAN_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+namespace niox {
+
+enum ScanStrategy {
+    SCAN_ACTIVE = 0,            // Active for the whole duration
+    SCAN_TWO_PHASE = 1
+};
+
+struct ScanPlan {
+    int strategy;               // ScanStrategy
+    int64_t passiveMs;          // Passive sweep length
+    int64_t activeMs;           // Longest active burst
+    int minRssi;                // Nameless devices weaker than this are ignored
+};
+
+struct ScanPhaseHooks {
+    std::function<bool(bool active)> set_mode;      // Switch the watcher; false on failure
+    std::function<size_t(int minRssi)> unresolved;  // Nameless devices heard this scan
+    std::function<void()> tick;                     // Periodic work while scanning
+    std::function<bool()> stopped;                  // Scan ended elsewhere
+};
+
+// Outcome of the last scan
+struct ScanPhaseStats {
+    int strategy;
+    int64_t passiveMs;          // Time spent in each phase
+    int64_t activeMs;
+    uint32_t candidates;        // Unresolved when the passive sweep ended
+    uint32_t unresolved;        // Still unresolved at the end
+    int64_t resolvedMs;         // Scan start until no candidate was left, -1 if never
+};
+
+// Run the phases of one scan on the calling thread, blocking for at most
+// durationMs. The watcher is expected to be running in the initial mode
+// (passive for SCAN_TWO_PHASE).
+inline ScanPhaseStats run_scan_phases(const ScanPlan& plan, int64_t durationMs, const ScanPhaseHooks& hooks,
+                                      int64_t tickMs = 25) {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    auto elapsed = [start]() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+    };
+    // Sleep in ticks until the deadline (from start) or until done() holds
+    auto wait_until = [&](int64_t deadline, const std::function<bool()>& done) {
+        for (int64_t remaining = deadline - elapsed(); remaining > 0; remaining = deadline - elapsed()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(remaining < tickMs ? remaining : tickMs));
+            if (hooks.tick) hooks.tick();
+            if (hooks.stopped && hooks.stopped()) return;
+            if (done && done()) return;
+        }
+    };
+
+    ScanPhaseStats stats = ScanPhaseStats();
+    stats.strategy = plan.strategy;
+    stats.resolvedMs = -1;
+    if (plan.strategy != SCAN_TWO_PHASE) {
+        wait_until(durationMs, nullptr);
+        stats.activeMs = elapsed();
+        stats.unresolved = static_cast<uint32_t>(hooks.unresolved(plan.minRssi));
+        return stats;
+    }
+
+    wait_until(plan.passiveMs < durationMs ? plan.passiveMs : durationMs, nullptr);
+    stats.passiveMs = elapsed();
+    stats.candidates = static_cast<uint32_t>(hooks.unresolved(plan.minRssi));
+    stats.unresolved = stats.candidates;
+    if (stats.candidates == 0) {
+        stats.resolvedMs = stats.passiveMs;
+        return stats;
+    }
+    if (stats.passiveMs >= durationMs || (hooks.stopped && hooks.stopped()) || !hooks.set_mode(true)) {
+        return stats;
+    }
+
+    const int64_t burstEnd = stats.passiveMs + plan.activeMs;
+    wait_until(burstEnd < durationMs ? burstEnd : durationMs, [&]() {
+        stats.unresolved = static_cast<uint32_t>(hooks.unresolved(plan.minRssi));
+        return stats.unresolved == 0;
+    });
+    stats.activeMs = elapsed() - stats.passiveMs;
+    if (stats.unresolved == 0) stats.resolvedMs = elapsed();
+    return stats;
+}
+
+} // namespace niox
+
+#endif // NIOX_SCAN_PLAN_H
@@ -0,0 +1,266 @@
+// NIOX scheduler - bounded, fair scheduling of per-device GATT work
+// Opening links to many units at once overloads the Bluetooth stack, so
+// operations are queued per device and served by a fixed number of
+// workers, each holding at most one device session (link) at a time.
+//  - Concurrency: at most maxSessions devices are in service at once
+//  - Serialization: operations on one device never overlap
+//  - Priority: the device whose next operation has the highest priority is
+//    served first; within a device, higher priority first, then FIFO
+//  - Fairness: a session runs at most `quantum` operations, then the device
+//    goes behind other ready devices of the same priority
+
+#ifndef NIOX_SCHEDULER_H
+#define NIOX_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace niox {
+
+// Result of an operation cancelled by stop()
+static const int SCHEDULE_CANCELLED = -9;
+
+struct OperationResult {
+    uint64_t id;
+    uint64_t address;
+    int result;             // LINK_* / GATT_* code from the session or the operation
+    int64_t queueMs;        // Enqueue to start of execution
+    int64_t serviceMs;      // Execution time (excluding session setup)
+};
+
+struct DeviceScheduleStats {
+    uint64_t address;
+    uint64_t completed;
+    uint64_t failed;
+    uint32_t pending;
+    int64_t totalQueueMs;
+    int64_t maxQueueMs;
+    int64_t totalServiceMs;
+    int64_t maxServiceMs;
+    uint64_t sessions;      // Links opened for this device
+};
+
+// Link management around a batch of operations on one device
+struct SessionHooks {
+    std::function<int(uint64_t address)> open;      // LINK_OK or an error code
+    std::function<void(uint64_t address)> close;
+};
+
+class ConnectionScheduler {
+public:
+    typedef std::function<int(uint64_t address)> Operation;
+    typedef std::function<void(const OperationResult& result)> Completion;
+
+    ConnectionScheduler() : running_(false), quantum_(1), next_id_(1), serve_seq_(0), active_(0), peak_active_(0) {}
+    ~ConnectionScheduler() { stop(); }
+
+    ConnectionScheduler(const ConnectionScheduler&) = delete;
+    ConnectionScheduler& operator=(const ConnectionScheduler&) = delete;
+
+    bool start(int maxSessions, int quantum, SessionHooks hooks) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_ || maxSessions <= 0) return false;
+        running_ = true;
+        quantum_ = quantum > 0 ? quantum : 1;
+        hooks_ = hooks;
+        peak_active_ = 0;
+        for (int i = 0; i < maxSessions; i++) {
+            workers_.emplace_back([this]() { worker(); });
+        }
+        return true;
+    }
+
+    // Cancel pending operations (their completions run with
+    // SCHEDULE_CANCELLED), let running sessions finish, join workers
+    void stop() {
+        std::vector<std::pair<Completion, OperationResult>> cancelled;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) return;
+            running_ = false;
+            for (auto& entry : devices_) {
+                for (auto& queued : entry.second.queue) {
+                    OperationResult result{ queued.second.id, entry.first, SCHEDULE_CANCELLED,
+                                            now_ms() - queued.second.enqueuedMs, 0 };
+                    cancelled.emplace_back(queued.second.done, result);
+                }
+                entry.second.queue.clear();
+            }
+            ready_.clear();
+        }
+        cv_.notify_all();
+        for (std::thread& worker : workers_) worker.join();
+        workers_.clear();
+        for (auto& entry : cancelled) {
+            if (entry.first) entry.first(entry.second);
+        }
+    }
+
+    // Queue an operation. Returns its id, or 0 if the scheduler is stopped.
+    uint64_t submit(uint64_t address, int priority, Operation run, Completion done) {
+        uint64_t id;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) return 0;
+            id = next_id_++;
+            Device& device = devices_[address];
+            if (!device.busy && !device.queue.empty()) ready_.erase(ready_key(address, device));
+            device.queue.emplace(QueueKey(-priority, id), Queued{ id, now_ms(), run, done });
+            if (!device.busy) ready_.insert(ready_key(address, device));
+        }
+        cv_.notify_one();
+        return id;
+    }
+
+    std::vector<DeviceScheduleStats> stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<DeviceScheduleStats> out;
+        out.reserve(devices_.size());
+        for (const auto& entry : devices_) {
+            DeviceScheduleStats stats = entry.second.stats;
+            stats.address = entry.first;
+            stats.pending = static_cast<uint32_t>(entry.second.queue.size());
+            out.push_back(stats);
+        }
+        return out;
+    }
+
+    // Most sessions that were open at the same time since start()
+    int peak_sessions() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return peak_active_;
+    }
+
+    bool running() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return running_;
+    }
+
+    static int64_t now_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    typedef std::pair<int, uint64_t> QueueKey;   // (-priority, id)
+
+    struct Queued {
+        uint64_t id;
+        int64_t enqueuedMs;
+        Operation run;
+        Completion done;
+    };
+
+    struct Device {
+        std::multimap<QueueKey, Queued> queue;
+        bool busy = false;
+        uint64_t lastServed = 0;
+        DeviceScheduleStats stats = DeviceScheduleStats();
+    };
+
+    // Ready devices: highest head priority first, then least recently served
+    struct ReadyKey {
+        int negPriority;
+        uint64_t lastServed;
+        uint64_t address;
+        bool operator<(const ReadyKey& other) const {
+            if (negPriority != other.negPriority) return negPriority < other.negPriority;
+            if (lastServed != other.lastServed) return lastServed < other.lastServed;
+            return address < other.address;
+        }
+    };
+
+    static ReadyKey ready_key(uint64_t address, const Device& device) {
+        return ReadyKey{ device.queue.begin()->first.first, device.lastServed, address };
+    }
+
+    void worker() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this]() { return !running_ || !ready_.empty(); });
+            if (!running_) return;
+
+            const uint64_t address = ready_.begin()->address;
+            ready_.erase(ready_.begin());
+            Device& device = devices_[address];
+            device.busy = true;
+            active_++;
+            if (active_ > peak_active_) peak_active_ = active_;
+            device.stats.sessions++;
+            lock.unlock();
+
+            serve(address);
+
+            lock.lock();
+            active_--;
+            device.busy = false;
+            device.lastServed = ++serve_seq_;
+            if (running_ && !device.queue.empty()) {
+                ready_.insert(ready_key(address, device));
+                cv_.notify_one();
+            }
+        }
+    }
+
+    // One session: open the link, run up to quantum_ operations, close it
+    void serve(uint64_t address) {
+        const int opened = hooks_.open ? hooks_.open(address) : 0;
+        for (int served = 0; served < quantum_; served++) {
+            Queued op;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                Device& device = devices_[address];
+                if (!running_ || device.queue.empty()) break;
+                op = device.queue.begin()->second;
+                device.queue.erase(device.queue.begin());
+            }
+
+            const int64_t start = now_ms();
+            // A failed link fails the head operation only; the rest wait for another session
+            const int result = opened != 0 ? opened : (op.run ? op.run(address) : 0);
+            const int64_t end = now_ms();
+            OperationResult outcome{ op.id, address, result, start - op.enqueuedMs, end - start };
+            record(address, outcome);
+            if (op.done) op.done(outcome);
+            if (opened != 0) break;
+        }
+        if (opened == 0 && hooks_.close) hooks_.close(address);
+    }
+
+    void record(uint64_t address, const OperationResult& outcome) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        DeviceScheduleStats& stats = devices_[address].stats;
+        if (outcome.result >= 0) stats.completed++;
+        else stats.failed++;
+        stats.totalQueueMs += outcome.queueMs;
+        stats.totalServiceMs += outcome.serviceMs;
+        if (outcome.queueMs > stats.maxQueueMs) stats.maxQueueMs = outcome.queueMs;
+        if (outcome.serviceMs > stats.maxServiceMs) stats.maxServiceMs = outcome.serviceMs;
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::thread> workers_;
+    bool running_;
+    int quantum_;
+    SessionHooks hooks_;
+    uint64_t next_id_;
+    uint64_t serve_seq_;
+    int active_;
+    int peak_active_;
+    std::unordered_map<uint64_t, Device> devices_;
+    std::set<ReadyKey> ready_;
+};
+
+} // namespace niox
+
+#endif // NIOX_SCHEDULER_H
@@ -0,0 +1,72 @@
+// NIOX SIMD support - shared intrinsics setup and CPU feature detection
+// SSE2 is baseline on every x64 build; AVX2 and AES-NI kernels are compiled
+// with a per-function target attribute (GCC/Clang) and selected at runtime.
+
+#ifndef NIOX_SIMD_H
+#define NIOX_SIMD_H
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define NIOX_HAVE_SSE2 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define NIOX_TARGET_AVX2
+#define NIOX_TARGET_AESNI
+#else
+#include <cpuid.h>
+#define NIOX_TARGET_AVX2 __attribute__((target("avx2")))
+#define NIOX_TARGET_AESNI __attribute__((target("aes")))
+#endif
+#endif
+
+namespace niox {
+
+#if NIOX_HAVE_SSE2
+// Helper: Detect AVX2 once (CPUID leaf 7 EBX bit 5, plus OS YMM state via XGETBV)
+inline bool cpu_has_avx2() {
+    static const bool has_avx2 = []() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+        bool osxsave = (ecx & (1u << 27)) != 0;
+        bool avx = (ecx & (1u << 28)) != 0;
+        if (!osxsave || !avx) return false;
+        unsigned int xcr0_lo, xcr0_hi;
+        __asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+        if ((xcr0_lo & 0x6) != 0x6) return false;
+        if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+        return (ebx & (1u << 5)) != 0;
+#endif
+    }();
+    return has_avx2;
+}
+
+// Helper: Detect AES-NI once (CPUID leaf 1 ECX bit 25)
+inline bool cpu_has_aesni() {
+    static const bool has_aesni = []() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 25)) != 0;
+#else
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+        return (ecx & (1u << 25)) != 0;
+#endif
+    }();
+    return has_aesni;
+}
+#endif
+
+} // namespace niox
+
+#endif // NIOX_SIMD_H
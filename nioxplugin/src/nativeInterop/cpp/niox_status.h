@@ -0,0 +1,125 @@
+// NIOX status - device status carried in manufacturer-specific advert data
+// Battery and readiness are broadcast so a dashboard can show them without
+// connecting. The payload format is versioned; each version is a row range
+// in a static field table, so supporting a new firmware layout is a table
+// edit, not new parsing code. Decoding works in place on the raw AD payload
+// and never allocates.
+//
+// Manufacturer data (AD type 0xFF):
+//   company id u16 LE | format version u8 | fields (per version)
+//   v1: battery % u8 | state u8 (bit0 ready, bit1 charging, bit2 busy,
+//       bit3 error) | tests remaining u16 LE | error code u8
+
+#ifndef NIOX_STATUS_H
+#define NIOX_STATUS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace niox {
+
+static const uint8_t AD_TYPE_MANUFACTURER_DATA = 0xFF;
+
+// Company identifier the NIOX firmware advertises under. 0xFFFF is the
+// Bluetooth SIG value reserved for testing; replace it with the assigned
+// identifier when the firmware ships one.
+static const uint16_t NIOX_COMPANY_ID = 0xFFFF;
+
+// Status fields (bit positions in DeviceStatus::present)
+enum StatusField : uint8_t {
+    STATUS_BATTERY = 0,
+    STATUS_READY = 1,
+    STATUS_CHARGING = 2,
+    STATUS_BUSY = 3,
+    STATUS_ERROR = 4,
+    STATUS_TESTS_REMAINING = 5,
+    STATUS_ERROR_CODE = 6,
+    STATUS_FIELD_COUNT = 7
+};
+
+// Decoded status; a field is only meaningful if its present bit is set
+struct DeviceStatus {
+    uint8_t version;            // Format version, 0 if no status was found
+    uint8_t present;            // 1 << StatusField for each decoded field
+    uint16_t values[STATUS_FIELD_COUNT];
+
+    bool has(StatusField field) const { return (present >> field) & 1; }
+    uint16_t get(StatusField field) const { return values[field]; }
+};
+
+// One field of a format version: width bytes (1 or 2, little-endian) at
+// offset after the version byte, then (raw >> shift) & mask
+struct StatusFieldSpec {
+    uint8_t field;              // StatusField
+    uint8_t offset;
+    uint8_t width;
+    uint8_t shift;
+    uint16_t mask;
+};
+
+// Format versions and their rows in STATUS_FIELDS
+struct StatusLayout {
+    uint8_t version;
+    uint8_t minLength;          // Field bytes required after the version byte
+    uint8_t first;
+    uint8_t count;
+};
+
+static const StatusFieldSpec STATUS_FIELDS[] = {
+    // v1
+    { STATUS_BATTERY,         0, 1, 0, 0xFF },
+    { STATUS_READY,           1, 1, 0, 0x01 },
+    { STATUS_CHARGING,        1, 1, 1, 0x01 },
+    { STATUS_BUSY,            1, 1, 2, 0x01 },
+    { STATUS_ERROR,           1, 1, 3, 0x01 },
+    { STATUS_TESTS_REMAINING, 2, 2, 0, 0xFFFF },
+    { STATUS_ERROR_CODE,      4, 1, 0, 0xFF },
+};
+
+static const StatusLayout STATUS_LAYOUTS[] = {
+    { 1, 5, 0, 7 },
+};
+
+// Helper: Decode the field bytes of one format version. Returns false for an
+// unknown version or a payload too short for it.
+inline bool decode_status_fields(uint8_t version, const uint8_t* data, size_t length, DeviceStatus* status) {
+    for (const StatusLayout& layout : STATUS_LAYOUTS) {
+        if (layout.version != version) continue;
+        if (length < layout.minLength) return false;
+        status->version = version;
+        status->present = 0;
+        for (size_t i = layout.first; i < static_cast<size_t>(layout.first) + layout.count; i++) {
+            const StatusFieldSpec& spec = STATUS_FIELDS[i];
+            uint32_t raw = data[spec.offset];
+            if (spec.width == 2) raw |= static_cast<uint32_t>(data[spec.offset + 1]) << 8;
+            status->values[spec.field] = static_cast<uint16_t>((raw >> spec.shift) & spec.mask);
+            status->present |= static_cast<uint8_t>(1u << spec.field);
+        }
+        return true;
+    }
+    return false;
+}
+
+// Find and decode NIOX manufacturer data in a raw AD payload
+// ([len][type][data]...). Returns false if there is none or it is not a
+// known format; status is left untouched then.
+inline bool decode_status(const uint8_t* payload, size_t length, DeviceStatus* status) {
+    size_t pos = 0;
+    while (pos < length) {
+        const size_t fieldLength = payload[pos];
+        if (fieldLength == 0) break;                    // Early terminator / padding
+        if (pos + 1 + fieldLength > length) break;      // Truncated structure
+        const uint8_t* body = payload + pos + 2;
+        const size_t bodyLength = fieldLength - 1;
+        if (payload[pos + 1] == AD_TYPE_MANUFACTURER_DATA && bodyLength >= 3 &&
+            (body[0] | (body[1] << 8)) == NIOX_COMPANY_ID) {
+            return decode_status_fields(body[2], body + 3, bodyLength - 3, status);
+        }
+        pos += 1 + fieldLength;
+    }
+    return false;
+}
+
+} // namespace niox
+
+#endif // NIOX_STATUS_H
@@ -0,0 +1,498 @@
+// NIOX transfer - pipelined bulk download of a device's measurement log
+// Reading the log one chunk at a time costs a full round trip per chunk, so
+// most of the link sits idle. LogTransfer negotiates the largest MTU, keeps
+// several range requests outstanding while the device streams the data as
+// notifications, and reassembles them into one preallocated buffer.
+//
+// Log protocol (NIOX service):
+//  - Log Control: read -> [total size LE32]
+//                 write -> [0x01][offset LE32][length LE32][chunk LE16]
+//  - Log Data:    notify <- [offset LE32][up to `chunk` bytes], in request order
+// A transfer interrupted by a disconnect is resumed by calling run() again:
+// it continues from the last acknowledged (contiguously received) offset.
+
+#ifndef NIOX_TRANSFER_H
+#define NIOX_TRANSFER_H
+
+#include "niox_gatt.h"
+#include "niox_uuid.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace niox {
+
+constexpr Uuid NIOX_LOG_CONTROL_UUID = "000fc00b-08a4-4078-874c-14efbd4b5201"_uuid;
+constexpr Uuid NIOX_LOG_DATA_UUID = "000fc00b-08a4-4078-874c-14efbd4b5202"_uuid;
+
+static const uint8_t LOG_OP_READ_RANGE = 0x01;
+static const size_t LOG_REQUEST_SIZE = 11;
+static const size_t LOG_DATA_HEADER = 4;
+static const size_t ATT_NOTIFY_HEADER = 3;     // Opcode + attribute handle
+
+struct TransferOptions {
+    uint16_t mtu = ATT_MAX_MTU;         // Requested ATT MTU; the device may grant less
+    int depth = 4;                      // Range requests kept outstanding
+    uint32_t requestChunks = 16;        // Notifications asked for per request
+    int requestTimeoutMs = 500;         // Re-request a range with nothing new for this long
+    int stallTimeoutMs = 5000;          // Give up (resumable) after this long without progress
+};
+
+struct TransferStats {
+    uint32_t size;                  // Log size reported by the device
+    uint32_t received;              // Bytes held
+    uint32_t acknowledged;          // Contiguous bytes from offset 0; resume point
+    uint16_t mtu;                   // Negotiated ATT MTU of the last run
+    uint16_t chunk;                 // Payload bytes per notification
+    uint64_t requests;              // Range requests sent
+    uint64_t rerequests;            // Requests repeating lost chunks
+    uint64_t notifications;
+    uint64_t duplicates;            // Chunks received twice
+    uint32_t resumes;               // Runs after the first
+    int64_t elapsedMs;              // Time spent in run(), all runs
+    double bytesPerSecond;          // Bytes received / elapsed time
+};
+
+// Little-endian helpers for the log protocol
+inline void put_le16(uint8_t* out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+inline void put_le32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+inline uint32_t get_le32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+        (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+inline uint16_t get_le16(const uint8_t* in) {
+    return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+// Download of one device's log. Not thread-safe across run() calls: one
+// caller drives a transfer at a time (run() fails while another is active).
+class LogTransfer {
+public:
+    explicit LogTransfer(uint64_t address, TransferOptions options = TransferOptions())
+        : address_(address), options_(options), state_(std::make_shared<State>()), runs_(0), elapsed_ms_(0) {
+        if (options_.depth < 1) options_.depth = 1;
+        if (options_.requestChunks < 1) options_.requestChunks = 1;
+    }
+
+    LogTransfer(const LogTransfer&) = delete;
+    LogTransfer& operator=(const LogTransfer&) = delete;
+
+    // Download the rest of the log over the client's link to the device.
+    // Returns LINK_OK when complete, else the link/GATT error; progress is
+    // kept and the next call resumes from the acknowledged offset.
+    int run(GattClient& client) {
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (state_->running) return LINK_ERROR;
+            if (state_->complete()) return LINK_OK;
+            state_->running = true;
+        }
+        const int64_t start = now_ms();
+        int result = download(client);
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->running = false;
+        elapsed_ms_ += now_ms() - start;
+        runs_++;
+        return result;
+    }
+
+    bool complete() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->complete();
+    }
+
+    // The log; valid once complete()
+    const std::vector<uint8_t>& data() const { return state_->data; }
+
+    TransferStats stats() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        TransferStats stats = state_->stats;
+        stats.size = static_cast<uint32_t>(state_->data.size());
+        stats.acknowledged = state_->acknowledged;
+        stats.resumes = runs_ > 1 ? runs_ - 1 : 0;
+        stats.elapsedMs = elapsed_ms_;
+        stats.bytesPerSecond = elapsed_ms_ > 0 ? stats.received * 1000.0 / static_cast<double>(elapsed_ms_) : 0.0;
+        return stats;
+    }
+
+    uint64_t address() const { return address_; }
+
+private:
+    // Shared with the notification handler, which may outlive a run
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool running = false;
+        bool sized = false;
+        std::vector<uint8_t> data;      // Preallocated to the log size
+        uint32_t base = 0;              // Offset of chunk 0 for the current grid
+        uint32_t chunk = 0;             // Payload bytes per chunk
+        std::vector<uint8_t> have;      // Per chunk: received
+        std::vector<uint32_t> sequence; // Per chunk: request that last asked for it
+        uint32_t firstMissing = 0;      // Chunk index below which everything is held
+        uint32_t acknowledged = 0;
+        uint32_t latestSequence = 0;    // Newest request with a chunk delivered
+        int64_t lastProgressMs = 0;
+        TransferStats stats = TransferStats();
+
+        bool complete() const { return sized && acknowledged == data.size(); }
+        uint32_t chunks() const {
+            return chunk == 0 ? 0 : static_cast<uint32_t>((data.size() - base + chunk - 1) / chunk);
+        }
+        uint32_t chunk_length(uint32_t index) const {
+            const uint32_t offset = base + index * chunk;
+            const uint32_t left = static_cast<uint32_t>(data.size()) - offset;
+            return left < chunk ? left : chunk;
+        }
+    };
+
+    // One outstanding range request: chunks [first, first + count)
+    struct Request {
+        uint32_t sequence;
+        uint32_t first;
+        uint32_t count;
+        int64_t sentMs;
+    };
+
+    static int64_t now_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int download(GattClient& client) {
+        GattCharacteristic control;
+        GattCharacteristic data;
+        int result = client.find(address_, NIOX_SERVICE_UUID, NIOX_LOG_CONTROL_UUID, &control);
+        if (result != LINK_OK) return result;
+        result = client.find(address_, NIOX_SERVICE_UUID, NIOX_LOG_DATA_UUID, &data);
+        if (result != LINK_OK) return result;
+        if ((control.properties & GATT_PROP_WRITE_NO_RESPONSE) == 0 || (data.properties & GATT_PROP_NOTIFY) == 0) {
+            return GATT_NOT_PERMITTED;
+        }
+
+        uint16_t mtu = ATT_DEFAULT_MTU;
+        result = client.backend().exchange_mtu(address_, options_.mtu, &mtu);
+        if (result != LINK_OK) return result;
+        if (mtu <= ATT_NOTIFY_HEADER + LOG_DATA_HEADER) return GATT_NOT_PERMITTED;
+
+        std::vector<uint8_t> info;
+        result = client.read(address_, NIOX_SERVICE_UUID, NIOX_LOG_CONTROL_UUID, info);
+        if (result != LINK_OK) return result;
+        if (info.size() < 4) return LINK_ERROR;
+        const uint32_t size = get_le32(info.data());
+
+        prepare(size, mtu);
+        std::shared_ptr<State> state = state_;
+        result = client.subscribe(address_, NIOX_SERVICE_UUID, NIOX_LOG_DATA_UUID,
+            [state](uint64_t, uint16_t, const uint8_t* value, size_t length) { on_chunk(*state, value, length); });
+        if (result != LINK_OK) return result;
+
+        result = pump(client, control.handle);
+        client.subscribe(address_, NIOX_SERVICE_UUID, NIOX_LOG_DATA_UUID, GattValueHandler());
+        return result;
+    }
+
+    // Size the buffer once, then lay the chunk grid from the acknowledged offset
+    void prepare(uint32_t size, uint16_t mtu) {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        State& state = *state_;
+        if (!state.sized || state.data.size() != size) {
+            state.data.assign(size, 0);
+            state.acknowledged = 0;
+            state.stats.received = 0;
+            state.sized = true;
+        }
+        state.base = state.acknowledged;
+        state.chunk = static_cast<uint32_t>(mtu - ATT_NOTIFY_HEADER - LOG_DATA_HEADER);
+        state.have.assign(state.chunks(), 0);
+        state.sequence.assign(state.chunks(), 0);
+        state.firstMissing = 0;
+        state.latestSequence = 0;
+        state.stats.received = state.acknowledged;
+        state.stats.mtu = mtu;
+        state.stats.chunk = static_cast<uint16_t>(state.chunk);
+        state.lastProgressMs = now_ms();
+    }
+
+    static void on_chunk(State& state, const uint8_t* value, size_t length) {
+        if (length < LOG_DATA_HEADER) return;
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.stats.notifications++;
+        const uint32_t offset = get_le32(value);
+        if (state.chunk == 0 || offset < state.base || (offset - state.base) % state.chunk != 0) return;
+        const uint32_t index = (offset - state.base) / state.chunk;
+        if (index >= state.have.size() || length - LOG_DATA_HEADER != state.chunk_length(index)) return;
+        if (state.have[index]) {
+            state.stats.duplicates++;
+            return;
+        }
+
+        memcpy(state.data.data() + offset, value + LOG_DATA_HEADER, length - LOG_DATA_HEADER);
+        state.have[index] = 1;
+        state.stats.received += static_cast<uint32_t>(length - LOG_DATA_HEADER);
+        if (state.sequence[index] > state.latestSequence) state.latestSequence = state.sequence[index];
+        while (state.firstMissing < state.have.size() && state.have[state.firstMissing]) state.firstMissing++;
+        const uint32_t held = state.base + state.firstMissing * state.chunk;
+        state.acknowledged = held < state.data.size() ? held : static_cast<uint32_t>(state.data.size());
+        state.lastProgressMs = now_ms();
+        state.cv.notify_all();
+    }
+
+    // Keep `depth` requests in flight until every chunk is held. The device
+    // serves requests in order, so missing chunks of a request older than
+    // one that has delivered were lost and are asked for again at once;
+    // the request timeout covers losses at the tail.
+    int pump(GattClient& client, uint16_t controlHandle) {
+        State& state = *state_;
+        std::deque<Request> outstanding;
+        uint32_t nextChunk = 0;
+        uint32_t nextSequence = 1;
+        std::vector<Request> toSend;
+
+        std::unique_lock<std::mutex> lock(state.mutex);
+        nextChunk = state.firstMissing;
+        for (;;) {
+            if (state.firstMissing >= state.have.size()) return LINK_OK;
+            const int64_t now = now_ms();
+            if (now - state.lastProgressMs > options_.stallTimeoutMs) return LINK_TIMEOUT;
+
+            // Retire finished requests; re-request what earlier ones lost
+            toSend.clear();
+            for (auto it = outstanding.begin(); it != outstanding.end();) {
+                uint32_t missing = 0;
+                for (uint32_t i = it->first; i < it->first + it->count; i++) {
+                    if (!state.have[i]) missing++;
+                }
+                if (missing == 0) {
+                    it = outstanding.erase(it);
+                    continue;
+                }
+                // Only the oldest request can time out; later ones queue behind it
+                const int64_t waited = now - (it->sentMs > state.lastProgressMs ? it->sentMs : state.lastProgressMs);
+                const bool overtaken = it->sequence < state.latestSequence;
+                const bool expired = it == outstanding.begin() && waited > options_.requestTimeoutMs;
+                if (overtaken || expired) {
+                    const size_t before = toSend.size();
+                    append_missing(state, it->first, it->count, &toSend);
+                    state.stats.rerequests += toSend.size() - before;
+                    it = outstanding.erase(it);
+                    continue;
+                }
+                ++it;
+            }
+
+            // Fill the pipeline with new ranges
+            while (outstanding.size() + toSend.size() < static_cast<size_t>(options_.depth) &&
+                   nextChunk < state.have.size()) {
+                while (nextChunk < state.have.size() && state.have[nextChunk]) nextChunk++;
+                if (nextChunk >= state.have.size()) break;
+                uint32_t count = static_cast<uint32_t>(state.have.size()) - nextChunk;
+                if (count > options_.requestChunks) count = options_.requestChunks;
+                toSend.push_back(Request{ 0, nextChunk, count, 0 });
+                nextChunk += count;
+            }
+
+            if (!toSend.empty()) {
+                for (Request& request : toSend) {
+                    request.sequence = nextSequence++;
+                    request.sentMs = now;
+                    for (uint32_t i = request.first; i < request.first + request.count; i++) {
+                        state.sequence[i] = request.sequence;
+                    }
+                    state.stats.requests++;
+                }
+                const uint32_t base = state.base;
+                const uint32_t chunk = state.chunk;
+                const uint32_t size = static_cast<uint32_t>(state.data.size());
+                lock.unlock();
+                for (const Request& request : toSend) {
+                    int result = send(client, controlHandle, base, chunk, size, request);
+                    if (result != LINK_OK) return result;
+                }
+                lock.lock();
+                outstanding.insert(outstanding.end(), toSend.begin(), toSend.end());
+                continue;
+            }
+
+            if (!client.is_connected(address_)) return GATT_NOT_CONNECTED;
+            const int wait = options_.requestTimeoutMs / 4 > 1 ? options_.requestTimeoutMs / 4 : 1;
+            state.cv.wait_for(lock, std::chrono::milliseconds(wait));
+        }
+    }
+
+    // Split the missing chunks of [first, first + count) into contiguous runs
+    static void append_missing(const State& state, uint32_t first, uint32_t count, std::vector<Request>* out) {
+        uint32_t i = first;
+        while (i < first + count) {
+            if (state.have[i]) {
+                i++;
+                continue;
+            }
+            uint32_t end = i;
+            while (end < first + count && !state.have[end]) end++;
+            out->push_back(Request{ 0, i, end - i, 0 });
+            i = end;
+        }
+    }
+
+    int send(GattClient& client, uint16_t controlHandle, uint32_t base, uint32_t chunk, uint32_t size,
+             const Request& request) {
+        const uint32_t offset = base + request.first * chunk;
+        uint32_t length = request.count * chunk;
+        if (offset + length > size) length = size - offset;
+        uint8_t command[LOG_REQUEST_SIZE];
+        command[0] = LOG_OP_READ_RANGE;
+        put_le32(command + 1, offset);
+        put_le32(command + 5, length);
+        put_le16(command + 9, static_cast<uint16_t>(chunk));
+        int result = client.backend().write_command(address_, controlHandle, command, sizeof(command));
+        // An earlier command that failed in the stack fails every later one
+        // until drained; a lost range request is re-requested anyway, so
+        // clear the failure and send this one again
+        if (result == LINK_ERROR && client.backend().drain_commands(address_) == LINK_ERROR) {
+            result = client.backend().write_command(address_, controlHandle, command, sizeof(command));
+        }
+        return result;
+    }
+
+    uint64_t address_;
+    TransferOptions options_;
+    std::shared_ptr<State> state_;
+    uint32_t runs_;
+    int64_t elapsed_ms_;
+};
+
+// Device side of the log protocol on a SimulatedGattBackend peripheral.
+// Requests are served in order from one thread: the first chunk of a request
+// arrives one round trip after it was sent, and chunks leave at most one per
+// packet interval (link throughput). Each chunk is lost with lossRate.
+class SimulatedLogPeripheral {
+public:
+    SimulatedLogPeripheral(std::shared_ptr<SimulatedGattBackend> backend, uint64_t address,
+                           std::vector<uint8_t> log, int roundTripMs, int packetIntervalUs,
+                           double lossRate, uint32_t seed = 1)
+        : backend_(backend), address_(address), log_(std::move(log)), round_trip_ms_(roundTripMs),
+          packet_interval_us_(packetIntervalUs), loss_rate_(lossRate), random_(seed ? seed : 1),
+          running_(true), sent_(0), dropped_(0) {
+        uint8_t size[4];
+        put_le32(size, static_cast<uint32_t>(log_.size()));
+        control_handle_ = backend_->add_characteristic(address, NIOX_SERVICE_UUID, NIOX_LOG_CONTROL_UUID,
+            GATT_PROP_READ | GATT_PROP_WRITE | GATT_PROP_WRITE_NO_RESPONSE, size, sizeof(size));
+        data_handle_ = backend_->add_characteristic(address, NIOX_SERVICE_UUID, NIOX_LOG_DATA_UUID,
+            GATT_PROP_NOTIFY, nullptr, 0);
+        backend_->set_write_handler(address, control_handle_,
+            [this](const uint8_t* data, size_t length) { on_request(data, length); });
+        thread_ = std::thread([this]() { serve(); });
+    }
+
+    ~SimulatedLogPeripheral() {
+        backend_->set_write_handler(address_, control_handle_, SimulatedGattBackend::WriteHandler());
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    SimulatedLogPeripheral(const SimulatedLogPeripheral&) = delete;
+    SimulatedLogPeripheral& operator=(const SimulatedLogPeripheral&) = delete;
+
+    uint64_t chunks_sent() const { return sent_.load(); }
+    uint64_t chunks_dropped() const { return dropped_.load(); }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Pending {
+        uint32_t offset;
+        uint32_t length;
+        uint16_t chunk;
+        Clock::time_point ready;    // First chunk may not arrive before this
+    };
+
+    void on_request(const uint8_t* data, size_t length) {
+        if (length < LOG_REQUEST_SIZE || data[0] != LOG_OP_READ_RANGE) return;
+        Pending request{ get_le32(data + 1), get_le32(data + 5), get_le16(data + 9),
+                         Clock::now() + std::chrono::milliseconds(round_trip_ms_) };
+        if (request.chunk == 0 || request.offset >= log_.size()) return;
+        if (request.length > log_.size() - request.offset) request.length = static_cast<uint32_t>(log_.size()) - request.offset;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(request);
+        }
+        cv_.notify_all();
+    }
+
+    void serve() {
+        std::vector<uint8_t> packet;
+        Clock::time_point next = Clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this]() { return !running_ || !queue_.empty(); });
+            if (!running_) return;
+            Pending request = queue_.front();
+            queue_.pop_front();
+            lock.unlock();
+
+            if (next < request.ready) next = request.ready;
+            for (uint32_t sent = 0; sent < request.length;) {
+                const uint32_t length = request.length - sent < request.chunk ? request.length - sent : request.chunk;
+                packet.resize(LOG_DATA_HEADER + length);
+                put_le32(packet.data(), request.offset + sent);
+                memcpy(packet.data() + LOG_DATA_HEADER, log_.data() + request.offset + sent, length);
+                std::this_thread::sleep_until(next);
+                next += std::chrono::microseconds(packet_interval_us_);
+                if (lost()) dropped_++;
+                else if (backend_->notify(address_, data_handle_, packet.data(), packet.size())) sent_++;
+                sent += length;
+            }
+            lock.lock();
+        }
+    }
+
+    // xorshift32; deterministic per seed
+    bool lost() {
+        if (loss_rate_ <= 0.0) return false;
+        random_ ^= random_ << 13;
+        random_ ^= random_ >> 17;
+        random_ ^= random_ << 5;
+        return random_ < loss_rate_ * 4294967296.0;
+    }
+
+    std::shared_ptr<SimulatedGattBackend> backend_;
+    uint64_t address_;
+    std::vector<uint8_t> log_;
+    int round_trip_ms_;
+    int packet_interval_us_;
+    double loss_rate_;
+    uint32_t random_;
+    uint16_t control_handle_;
+    uint16_t data_handle_;
+    bool running_;
+    std::atomic<uint64_t> sent_;
+    std::atomic<uint64_t> dropped_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Pending> queue_;
+    std::thread thread_;
+};
+
+} // namespace niox
+
+#endif // NIOX_TRANSFER_H
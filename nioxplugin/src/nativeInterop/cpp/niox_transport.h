@@ -0,0 +1,233 @@
+// NIOX transport - minimal datagram sockets for plugin-to-plugin traffic
+// UDP works on every platform (loopback for local load tests, LAN between
+// clinic PCs); Unix datagram sockets are available on POSIX hosts.
+
+#ifndef NIOX_TRANSPORT_H
+#define NIOX_TRANSPORT_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET niox_socket_t;
+#define NIOX_INVALID_SOCKET INVALID_SOCKET
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+typedef int niox_socket_t;
+#define NIOX_INVALID_SOCKET (-1)
+#endif
+
+namespace niox {
+
+// Helper: One-time Winsock setup (no-op elsewhere)
+inline bool transport_startup() {
+#ifdef _WIN32
+    static const bool ok = []() {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return ok;
+#else
+    return true;
+#endif
+}
+
+// Helper: Resolve an IPv4 literal or host name to an address in network
+// byte order. An empty host is the loopback address.
+inline bool resolve_ipv4(const std::string& host, in_addr* out) {
+    if (host.empty()) {
+        out->s_addr = htonl(INADDR_LOOPBACK);
+        return true;
+    }
+    if (inet_pton(AF_INET, host.c_str(), out) == 1) return true;
+    if (!transport_startup()) return false;
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &found) != 0 || found == nullptr) return false;
+    *out = reinterpret_cast<const sockaddr_in*>(found->ai_addr)->sin_addr;
+    freeaddrinfo(found);
+    return true;
+}
+
+// Endpoint: "udp://host:port" or "unix:///path/to/socket"
+struct Endpoint {
+    enum Kind { UDP, UNIX_DGRAM };
+    Kind kind;
+    std::string host;   // UDP host (IPv4 literal or name) or Unix socket path
+    uint16_t port;
+    in_addr ipv4;       // UDP host, resolved by parse()
+
+    // Returns false if the endpoint string is malformed, unsupported here,
+    // or names a host that does not resolve to an IPv4 address
+    static bool parse(const char* text, Endpoint* out) {
+        if (text == nullptr) return false;
+        std::string s(text);
+        if (s.compare(0, 6, "udp://") == 0) {
+            size_t colon = s.rfind(':');
+            if (colon == std::string::npos || colon < 6) return false;
+            const std::string digits = s.substr(colon + 1);
+            if (digits.empty() || digits.size() > 5 || digits.find_first_not_of("0123456789") != std::string::npos) return false;
+            const int port = std::stoi(digits);
+            if (port <= 0 || port > 65535) return false;
+            out->kind = UDP;
+            out->host = s.substr(6, colon - 6);
+            out->port = static_cast<uint16_t>(port);
+            return resolve_ipv4(out->host, &out->ipv4);
+        }
+#ifndef _WIN32
+        if (s.compare(0, 7, "unix://") == 0 && s.size() > 7 && s.size() - 7 < sizeof(sockaddr_un().sun_path)) {
+            out->kind = UNIX_DGRAM;
+            out->host = s.substr(7);
+            out->port = 0;
+            return true;
+        }
+#endif
+        return false;
+    }
+};
+
+// Connectionless datagram socket. Bound sockets receive, connected sockets
+// send; a single instance may do both.
+class DatagramSocket {
+public:
+    DatagramSocket() : fd_(NIOX_INVALID_SOCKET) {}
+    ~DatagramSocket() { close(); }
+
+    DatagramSocket(const DatagramSocket&) = delete;
+    DatagramSocket& operator=(const DatagramSocket&) = delete;
+
+    static bool startup() { return transport_startup(); }
+
+    // Bind to the endpoint to receive. recvTimeoutMs bounds each receive()
+    // so the owning thread can notice a stop request.
+    bool bind(const Endpoint& endpoint, int recvTimeoutMs) {
+        if (!open(endpoint.kind)) return false;
+        set_recv_timeout(recvTimeoutMs);
+        if (endpoint.kind == Endpoint::UDP) {
+            sockaddr_in addr = make_inet(endpoint);
+            return ::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        }
+#ifndef _WIN32
+        sockaddr_un addr = make_unix(endpoint);
+        unlink(endpoint.host.c_str());
+        bound_path_ = endpoint.host;
+        return ::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+#else
+        return false;
+#endif
+    }
+
+    // Set the default destination for send()
+    bool connect(const Endpoint& endpoint) {
+        if (fd_ == NIOX_INVALID_SOCKET && !open(endpoint.kind)) return false;
+        if (endpoint.kind == Endpoint::UDP) {
+            sockaddr_in addr = make_inet(endpoint);
+            return ::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        }
+#ifndef _WIN32
+        sockaddr_un addr = make_unix(endpoint);
+        return ::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+#else
+        return false;
+#endif
+    }
+
+    // Returns bytes sent, or -1 on error
+    int send(const uint8_t* data, size_t length) {
+        return static_cast<int>(::send(fd_, reinterpret_cast<const char*>(data), static_cast<int>(length), 0));
+    }
+
+    // Returns bytes received, 0 on timeout, -1 on error
+    int receive(uint8_t* buffer, size_t capacity) {
+        int n = static_cast<int>(::recv(fd_, reinterpret_cast<char*>(buffer), static_cast<int>(capacity), 0));
+        if (n < 0 && would_block()) return 0;
+        return n;
+    }
+
+    void close() {
+        if (fd_ == NIOX_INVALID_SOCKET) return;
+#ifdef _WIN32
+        closesocket(fd_);
+#else
+        ::close(fd_);
+        if (!bound_path_.empty()) unlink(bound_path_.c_str());
+        bound_path_.clear();
+#endif
+        fd_ = NIOX_INVALID_SOCKET;
+    }
+
+    bool is_open() const { return fd_ != NIOX_INVALID_SOCKET; }
+
+private:
+    bool open(Endpoint::Kind kind) {
+        close();
+        if (!startup()) return false;
+#ifndef _WIN32
+        int family = kind == Endpoint::UNIX_DGRAM ? AF_UNIX : AF_INET;
+#else
+        int family = AF_INET;
+#endif
+        fd_ = socket(family, SOCK_DGRAM, 0);
+        return fd_ != NIOX_INVALID_SOCKET;
+    }
+
+    void set_recv_timeout(int timeoutMs) {
+#ifdef _WIN32
+        DWORD tv = static_cast<DWORD>(timeoutMs);
+#else
+        timeval tv;
+        tv.tv_sec = timeoutMs / 1000;
+        tv.tv_usec = (timeoutMs % 1000) * 1000;
+#endif
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&tv), sizeof(tv));
+    }
+
+    static bool would_block() {
+#ifdef _WIN32
+        return WSAGetLastError() == WSAETIMEDOUT || WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+    }
+
+    static sockaddr_in make_inet(const Endpoint& endpoint) {
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(endpoint.port);
+        addr.sin_addr = endpoint.ipv4;
+        return addr;
+    }
+
+#ifndef _WIN32
+    static sockaddr_un make_unix(const Endpoint& endpoint) {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, endpoint.host.c_str(), sizeof(addr.sun_path) - 1);
+        return addr;
+    }
+
+    std::string bound_path_;
+#endif
+
+    niox_socket_t fd_;
+};
+
+} // namespace niox
+
+#endif // NIOX_TRANSPORT_H
@@ -0,0 +1,133 @@
+// NIOX UUID - 128-bit Bluetooth UUID value type
+// Parsed once (at compile time for literals) so service matching on the
+// advertisement path is two integer compares instead of string normalization.
+
+#ifndef NIOX_UUID_H
+#define NIOX_UUID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace niox {
+
+struct Uuid {
+    uint64_t hi; // Bytes 0..7 in canonical (big-endian) text order
+    uint64_t lo; // Bytes 8..15
+
+    constexpr bool operator==(const Uuid& other) const { return hi == other.hi && lo == other.lo; }
+    constexpr bool operator!=(const Uuid& other) const { return !(*this == other); }
+
+    // Bluetooth Base UUID: 00000000-0000-1000-8000-00805F9B34FB
+    static constexpr uint64_t BASE_HI = 0x0000000000001000ull;
+    static constexpr uint64_t BASE_LO = 0x800000805F9B34FBull;
+
+    // Expand an assigned 16-bit or 32-bit UUID against the Base UUID
+    static constexpr Uuid from16(uint16_t value) { return from32(value); }
+    static constexpr Uuid from32(uint32_t value) {
+        return Uuid{ (static_cast<uint64_t>(value) << 32) | BASE_HI, BASE_LO };
+    }
+
+    // True if this UUID can be shortened to a 16/32-bit assigned number
+    constexpr bool is_base_derived() const {
+        return (hi & 0xFFFFFFFFull) == BASE_HI && lo == BASE_LO;
+    }
+
+    // Build from 16 bytes as they appear on air (little-endian, LSB first),
+    // e.g. an entry of a "Complete List of 128-bit Service UUIDs" AD structure.
+    static Uuid from_le_bytes(const uint8_t* bytes) {
+        uint64_t hi = 0;
+        uint64_t lo = 0;
+        for (int i = 0; i < 8; i++) {
+            lo |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+            hi |= static_cast<uint64_t>(bytes[8 + i]) << (8 * i);
+        }
+        return Uuid{ hi, lo };
+    }
+
+    // Parse "xxxx", "xxxxxxxx" or "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx".
+    // Throws std::invalid_argument on malformed input; in a constant
+    // expression that becomes a compile error, which is how literals are
+    // validated (see operator""_uuid).
+    static constexpr Uuid parse(const char* text, size_t len) {
+        if (len == 4 || len == 8) {
+            uint64_t value = 0;
+            for (size_t i = 0; i < len; i++) value = (value << 4) | hex_digit(text[i]);
+            return from32(static_cast<uint32_t>(value));
+        }
+        if (len != 36) throw std::invalid_argument("UUID must be 4, 8 or 36 characters");
+
+        uint64_t words[2] = { 0, 0 };
+        int nibble = 0;
+        for (size_t i = 0; i < len; i++) {
+            if (i == 8 || i == 13 || i == 18 || i == 23) {
+                if (text[i] != '-') throw std::invalid_argument("UUID groups must be 8-4-4-4-12");
+                continue;
+            }
+            words[nibble / 16] = (words[nibble / 16] << 4) | hex_digit(text[i]);
+            nibble++;
+        }
+        return Uuid{ words[0], words[1] };
+    }
+
+    // Non-throwing parse for runtime input. Returns false if malformed.
+    static bool try_parse(const char* text, size_t len, Uuid* out) {
+        try {
+            *out = parse(text, len);
+            return true;
+        }
+        catch (...) {
+            return false;
+        }
+    }
+
+private:
+    static constexpr uint64_t hex_digit(char c) {
+        return (c >= '0' && c <= '9') ? static_cast<uint64_t>(c - '0')
+             : (c >= 'a' && c <= 'f') ? static_cast<uint64_t>(c - 'a' + 10)
+             : (c >= 'A' && c <= 'F') ? static_cast<uint64_t>(c - 'A' + 10)
+             : throw std::invalid_argument("UUID contains a non-hex character");
+    }
+};
+
+// Validated UUID literal: constexpr Uuid id = "0000180a-0000-1000-8000-00805f9b34fb"_uuid;
+constexpr Uuid operator""_uuid(const char* text, size_t len) {
+    return Uuid::parse(text, len);
+}
+
+// NIOX FDC service. The historical string constant had a three-digit second
+// group ("8a4"); lenient parsers read it as 0x08a4, which is the value kept here.
+constexpr Uuid NIOX_SERVICE_UUID = "000fc00b-08a4-4078-874c-14efbd4b510a"_uuid;
+
+// Tx Power service (16-bit assigned number)
+constexpr Uuid TX_POWER_SERVICE_UUID = Uuid::from16(0x1804);
+
+// Generic Attribute service and its Service Changed characteristic
+constexpr Uuid GATT_SERVICE_UUID = Uuid::from16(0x1801);
+constexpr Uuid SERVICE_CHANGED_UUID = Uuid::from16(0x2A05);
+
+// Device Information service and its Firmware Revision String characteristic
+constexpr Uuid DEVICE_INFORMATION_SERVICE_UUID = Uuid::from16(0x180A);
+constexpr Uuid FIRMWARE_REVISION_UUID = Uuid::from16(0x2A26);
+
+// Helper: Format as canonical lowercase text (buffer of at least 37 bytes)
+inline void format_uuid(const Uuid& uuid, char* buffer, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    if (size < 37) {
+        if (size > 0) buffer[0] = '\0';
+        return;
+    }
+    size_t pos = 0;
+    for (int i = 0; i < 16; i++) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) buffer[pos++] = '-';
+        const uint64_t word = i < 8 ? uuid.hi : uuid.lo;
+        const uint8_t byte = static_cast<uint8_t>(word >> (56 - 8 * (i % 8)));
+        buffer[pos++] = digits[byte >> 4];
+        buffer[pos++] = digits[byte & 0x0F];
+    }
+    buffer[pos] = '\0';
+}
+
+} // namespace niox
+
+#endif // NIOX_UUID_H
@@ -0,0 +1,183 @@
+// NIOX UUID matching - vectorized service-UUID list matching
+// Tests packed 128-bit UUID lists taken straight from the advertisement
+// payload against a small set of target UUIDs. Uses AVX2 (four targets per
+// compare) when the CPU supports it, SSE2 (two per compare) on any x64
+// build, and a scalar path everywhere else.
+
+#ifndef NIOX_UUID_MATCH_H
+#define NIOX_UUID_MATCH_H
+
+#include "niox_simd.h"
+#include "niox_uuid.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace niox {
+
+// AD structure types carrying 128-bit service UUIDs (Core Spec Supplement, Part A)
+static const uint8_t AD_TYPE_UUID128_INCOMPLETE = 0x06;
+static const uint8_t AD_TYPE_UUID128_COMPLETE = 0x07;
+static const uint8_t AD_TYPE_SERVICE_DATA_UUID128 = 0x21;
+
+static const size_t UUID_MATCH_MAX_TARGETS = 8;
+
+// Matches packed little-endian 128-bit UUIDs against up to
+// UUID_MATCH_MAX_TARGETS targets. Targets are converted to on-air byte order
+// once, so matching is a straight 16-byte equality per (entry, target).
+class UuidMatcher {
+public:
+    enum Path { PATH_AUTO, PATH_SCALAR, PATH_SSE2, PATH_AVX2 };
+
+    UuidMatcher() : count_(0), path_(PATH_AUTO) {
+        for (size_t t = 0; t < UUID_MATCH_MAX_TARGETS; t++) {
+            lo_[t] = 0;
+            hi_[t] = 0;
+        }
+    }
+
+    // Add a target. Returns its index, or -1 if the matcher is full.
+    int add(const Uuid& uuid) {
+        if (count_ >= UUID_MATCH_MAX_TARGETS) return -1;
+        uint8_t* bytes = targets_[count_];
+        for (int i = 0; i < 8; i++) {
+            bytes[i] = static_cast<uint8_t>(uuid.lo >> (8 * i));
+            bytes[8 + i] = static_cast<uint8_t>(uuid.hi >> (8 * i));
+        }
+        memcpy(&lo_[count_], bytes, 8);
+        memcpy(&hi_[count_], bytes + 8, 8);
+        return static_cast<int>(count_++);
+    }
+
+    size_t size() const { return count_; }
+
+    // Force a code path (benchmarks compare paths on the same input)
+    void set_path(Path path) { path_ = path; }
+
+    // Returns the index of the first target found in the list, or -1.
+    // list points at count * 16 bytes; no alignment is required.
+    int match(const uint8_t* list, size_t count) const {
+        if (count_ == 0 || count == 0) return -1;
+#if NIOX_HAVE_SSE2
+        Path path = path_;
+        if (path == PATH_AUTO) path = cpu_has_avx2() ? PATH_AVX2 : PATH_SSE2;
+        if (path == PATH_AVX2) return match_avx2(list, count);
+        if (path == PATH_SSE2) return match_sse2(list, count);
+#endif
+        return match_scalar(list, count);
+    }
+
+    // Walk a raw advertisement payload (sequence of [len][type][data] AD
+    // structures) and match every 128-bit UUID list and 128-bit service data
+    // block. Returns the first matching target index, or -1.
+    int match_payload(const uint8_t* payload, size_t length) const {
+        size_t pos = 0;
+        while (pos < length) {
+            size_t field_len = payload[pos];
+            if (field_len == 0) break;                  // Early terminator / padding
+            if (pos + 1 + field_len > length) break;    // Truncated structure
+            const uint8_t type = payload[pos + 1];
+            const int hit = match_section(type, payload + pos + 2, field_len - 1);
+            if (hit >= 0) return hit;
+            pos += 1 + field_len;
+        }
+        return -1;
+    }
+
+    // Match one AD structure body (without length and type bytes)
+    int match_section(uint8_t type, const uint8_t* data, size_t length) const {
+        if (type == AD_TYPE_UUID128_INCOMPLETE || type == AD_TYPE_UUID128_COMPLETE) {
+            return match(data, length / 16);
+        }
+        if (type == AD_TYPE_SERVICE_DATA_UUID128 && length >= 16) {
+            return match(data, 1);
+        }
+        return -1;
+    }
+
+    int match_scalar(const uint8_t* list, size_t count) const {
+        for (size_t e = 0; e < count; e++) {
+            uint64_t lo, hi;
+            memcpy(&lo, list + e * 16, 8);
+            memcpy(&hi, list + e * 16 + 8, 8);
+            for (size_t t = 0; t < count_; t++) {
+                uint64_t tlo, thi;
+                memcpy(&tlo, targets_[t], 8);
+                memcpy(&thi, targets_[t] + 8, 8);
+                if (lo == tlo && hi == thi) return static_cast<int>(t);
+            }
+        }
+        return -1;
+    }
+
+#if NIOX_HAVE_SSE2
+    // Targets are kept transposed (lo halves together, hi halves together),
+    // so each list entry is broadcast once and compared against two (SSE2)
+    // or four (AVX2) targets per instruction.
+    int match_sse2(const uint8_t* list, size_t count) const {
+        const size_t groups = (count_ + 1) / 2;
+        __m128i target_lo[UUID_MATCH_MAX_TARGETS / 2];
+        __m128i target_hi[UUID_MATCH_MAX_TARGETS / 2];
+        for (size_t g = 0; g < groups; g++) {
+            target_lo[g] = _mm_load_si128(reinterpret_cast<const __m128i*>(lo_ + 2 * g));
+            target_hi[g] = _mm_load_si128(reinterpret_cast<const __m128i*>(hi_ + 2 * g));
+        }
+        for (size_t e = 0; e < count; e++) {
+            const __m128i entry = _mm_loadu_si128(reinterpret_cast<const __m128i*>(list + e * 16));
+            const __m128i lo = _mm_unpacklo_epi64(entry, entry);
+            const __m128i hi = _mm_unpackhi_epi64(entry, entry);
+            for (size_t g = 0; g < groups; g++) {
+                // SSE2 has no 64-bit compare: a target matches when all four
+                // 32-bit words of its (lo, hi) pair compare equal.
+                const __m128i eq = _mm_and_si128(_mm_cmpeq_epi32(lo, target_lo[g]),
+                                                 _mm_cmpeq_epi32(hi, target_hi[g]));
+                const int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+                if ((mask & 0x3) == 0x3) return static_cast<int>(2 * g);
+                if ((mask & 0xC) == 0xC && 2 * g + 1 < count_) return static_cast<int>(2 * g + 1);
+            }
+        }
+        return -1;
+    }
+
+    NIOX_TARGET_AVX2 int match_avx2(const uint8_t* list, size_t count) const {
+        const size_t groups = (count_ + 3) / 4;
+        __m256i target_lo[UUID_MATCH_MAX_TARGETS / 4];
+        __m256i target_hi[UUID_MATCH_MAX_TARGETS / 4];
+        for (size_t g = 0; g < groups; g++) {
+            target_lo[g] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lo_ + 4 * g));
+            target_hi[g] = _mm256_load_si256(reinterpret_cast<const __m256i*>(hi_ + 4 * g));
+        }
+        for (size_t e = 0; e < count; e++) {
+            uint64_t lo_word, hi_word;
+            memcpy(&lo_word, list + e * 16, 8);
+            memcpy(&hi_word, list + e * 16 + 8, 8);
+            const __m256i lo = _mm256_set1_epi64x(static_cast<long long>(lo_word));
+            const __m256i hi = _mm256_set1_epi64x(static_cast<long long>(hi_word));
+            for (size_t g = 0; g < groups; g++) {
+                const __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi64(lo, target_lo[g]),
+                                                    _mm256_cmpeq_epi64(hi, target_hi[g]));
+                int mask = _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+                if (4 * g + 4 > count_) mask &= (1 << (count_ - 4 * g)) - 1;
+                if (mask != 0) {
+                    int lane = 0;
+                    while ((mask & (1 << lane)) == 0) lane++;
+                    return static_cast<int>(4 * g + lane);
+                }
+            }
+        }
+        return -1;
+    }
+#endif
+
+private:
+    alignas(16) uint8_t targets_[UUID_MATCH_MAX_TARGETS][16];
+    // Transposed copies for the SIMD paths; lanes past count_ are masked off
+    alignas(32) uint64_t lo_[UUID_MATCH_MAX_TARGETS];
+    alignas(32) uint64_t hi_[UUID_MATCH_MAX_TARGETS];
+    size_t count_;
+    Path path_;
+};
+
+} // namespace niox
+
+#endif // NIOX_UUID_MATCH_H
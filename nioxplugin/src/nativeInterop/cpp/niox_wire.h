@@ -0,0 +1,386 @@
+// NIOX wire - delta-compressed stream encoding for device updates
+// Addresses and serials are sent once into a dictionary; later updates
+// refer to a device by its dictionary id and carry only the fields that
+// changed, as zigzag varint deltas behind a per-record presence bitmap.
+//
+// Stream layout: a sequence of frames
+//   frame   sync u8 (0xA5) | type u8 | sequence u16 | payload length varint | payload | crc32 u32
+//   RESET   (empty payload) - both sides drop their dictionaries
+//   UPDATES base time delta varint | record count varint | records...
+//   record  presence u8 | [id varint unless NEW] | NEW: address 6 bytes
+//           | SERIAL: serial varint | RSSI: zigzag delta | TIME: zigzag offset from base
+//           | FLAGS: u8
+// The dictionary is stateful, so frames must arrive in order (pipes, TCP,
+// files). Every frame carries the next sequence number; a corrupt frame or
+// a sequence gap makes the decoder drop sync and ignore updates until the
+// producer calls WireEncoder::reset() to send a new key frame.
+// Timestamps are carried as given; the wrapper sends Unix epoch ms so they
+// mean the same on the receiving host.
+
+#ifndef NIOX_WIRE_H
+#define NIOX_WIRE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace niox {
+
+static const uint8_t WIRE_SYNC = 0xA5;
+static const uint8_t WIRE_FRAME_RESET = 0x01;
+static const uint8_t WIRE_FRAME_UPDATES = 0x02;
+
+// Presence bitmap bits
+static const uint8_t WIRE_FIELD_NEW = 0x01;
+static const uint8_t WIRE_FIELD_SERIAL = 0x02;
+static const uint8_t WIRE_FIELD_RSSI = 0x04;
+static const uint8_t WIRE_FIELD_TIME = 0x08;
+static const uint8_t WIRE_FIELD_FLAGS = 0x10;
+
+// One device update, as given to the encoder and produced by the decoder
+struct WireUpdate {
+    uint64_t address;
+    uint64_t serial;        // Packed NIOX serial, 0 if none
+    int32_t rssi;
+    int64_t timestampMs;
+    uint8_t flags;
+    uint8_t present;        // WIRE_FIELD_* bits carried by this record (decoder output)
+};
+
+// Helper: LEB128 varints and zigzag mapping
+inline void put_varint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline bool get_varint(const uint8_t*& p, const uint8_t* end, uint64_t* value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p >= end) return false;
+        uint8_t byte = *p++;
+        result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Helper: Little-endian fixed-width fields (shared by the aggregator
+// datagrams and the scan log blocks)
+inline void put_le(uint8_t* p, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) p[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+inline void put_le(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+inline uint64_t get_le(const uint8_t* p, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) value |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return value;
+}
+
+// Helper: CRC-32 (IEEE 802.3, reflected) over the frame type, sequence,
+// length and payload. Unlike a Fletcher sum it tells 0x00 from 0xFF and
+// catches every burst of up to 32 bits.
+inline uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// Framing layer: wraps payloads and splits a byte stream back into frames
+class WireFramer {
+public:
+    // Append one complete frame to out
+    static void write_frame(std::vector<uint8_t>& out, uint8_t type, uint16_t sequence,
+                            const uint8_t* payload, size_t length) {
+        const size_t start = out.size();
+        out.push_back(WIRE_SYNC);
+        out.push_back(type);
+        out.push_back(static_cast<uint8_t>(sequence));
+        out.push_back(static_cast<uint8_t>(sequence >> 8));
+        put_varint(out, length);
+        out.insert(out.end(), payload, payload + length);
+        const uint32_t sum = crc32(out.data() + start + 1, out.size() - start - 1);
+        for (int b = 0; b < 4; b++) out.push_back(static_cast<uint8_t>(sum >> (8 * b)));
+    }
+
+    // Feed received bytes; arbitrary chunking is fine
+    void feed(const uint8_t* data, size_t length) {
+        buffer_.insert(buffer_.end(), data, data + length);
+    }
+
+    // Extract the next complete frame. Returns false if more bytes are needed.
+    // Corrupt frames are skipped by resynchronizing on the next sync byte
+    // (counted in corrupt_frames()); the decoder sees the sequence gap.
+    bool next_frame(uint8_t* type, uint16_t* sequence, std::vector<uint8_t>& payload) {
+        for (;;) {
+            size_t pos = read_pos_;
+            while (pos < buffer_.size() && buffer_[pos] != WIRE_SYNC) pos++;
+            read_pos_ = pos;
+            if (buffer_.size() - pos < 9) break;
+
+            const uint8_t* p = buffer_.data() + pos + 4;
+            const uint8_t* end = buffer_.data() + buffer_.size();
+            uint64_t length = 0;
+            if (!get_varint(p, end, &length)) break;
+            if (length > MAX_FRAME_PAYLOAD) {
+                corrupt_++;
+                read_pos_ = pos + 1;
+                continue;
+            }
+            if (static_cast<uint64_t>(end - p) < length + 4) break;
+
+            const uint8_t* body = p;
+            const size_t checked = static_cast<size_t>(body + length - (buffer_.data() + pos + 1));
+            uint32_t expected = 0;
+            for (int b = 0; b < 4; b++) expected |= static_cast<uint32_t>(body[length + b]) << (8 * b);
+            if (crc32(buffer_.data() + pos + 1, checked) != expected) {
+                corrupt_++;
+                read_pos_ = pos + 1;
+                continue;
+            }
+
+            *type = buffer_[pos + 1];
+            *sequence = static_cast<uint16_t>(buffer_[pos + 2] | (buffer_[pos + 3] << 8));
+            payload.assign(body, body + length);
+            read_pos_ = static_cast<size_t>(body + length + 4 - buffer_.data());
+            compact();
+            return true;
+        }
+        compact();
+        return false;
+    }
+
+    uint64_t corrupt_frames() const { return corrupt_; }
+
+private:
+    static const uint64_t MAX_FRAME_PAYLOAD = 1 << 20;
+
+    void compact() {
+        if (read_pos_ > 4096 && read_pos_ * 2 > buffer_.size()) {
+            buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(read_pos_));
+            read_pos_ = 0;
+        }
+    }
+
+    std::vector<uint8_t> buffer_;
+    size_t read_pos_ = 0;
+    uint64_t corrupt_ = 0;
+};
+
+// Encoder: turns batches of device updates into UPDATES frames
+class WireEncoder {
+public:
+    WireEncoder() : base_ms_(0), sequence_(0), needs_reset_(true) {}
+
+    // Forget the dictionary; the next batch starts with a RESET frame
+    void reset() {
+        ids_.clear();
+        states_.clear();
+        base_ms_ = 0;
+        needs_reset_ = true;
+    }
+
+    // Encode one batch and append its frame(s) to out
+    void encode(const WireUpdate* updates, size_t count, std::vector<uint8_t>& out) {
+        if (needs_reset_) {
+            WireFramer::write_frame(out, WIRE_FRAME_RESET, sequence_++, nullptr, 0);
+            needs_reset_ = false;
+        }
+        if (count == 0) return;
+
+        // The batch base time is the newest timestamp; per-record offsets are small negatives
+        int64_t base = updates[0].timestampMs;
+        for (size_t i = 1; i < count; i++) {
+            if (updates[i].timestampMs > base) base = updates[i].timestampMs;
+        }
+
+        payload_.clear();
+        put_varint(payload_, zigzag(base - base_ms_));
+        put_varint(payload_, count);
+        base_ms_ = base;
+
+        for (size_t i = 0; i < count; i++) {
+            encode_record(updates[i], base);
+        }
+        WireFramer::write_frame(out, WIRE_FRAME_UPDATES, sequence_++, payload_.data(), payload_.size());
+    }
+
+    size_t dictionary_size() const { return ids_.size(); }
+
+private:
+    struct State {
+        uint64_t serial;
+        int32_t rssi;
+        uint8_t flags;
+    };
+
+    void encode_record(const WireUpdate& update, int64_t base) {
+        uint8_t present = WIRE_FIELD_TIME;
+        auto it = ids_.find(update.address);
+        uint32_t id;
+        if (it == ids_.end()) {
+            id = static_cast<uint32_t>(states_.size());
+            ids_.emplace(update.address, id);
+            states_.push_back(State{ 0, 0, 0 });
+            present |= WIRE_FIELD_NEW | WIRE_FIELD_RSSI | WIRE_FIELD_FLAGS;
+        }
+        else {
+            id = it->second;
+        }
+
+        State& state = states_[id];
+        if (update.serial != state.serial) present |= WIRE_FIELD_SERIAL;
+        if (update.rssi != state.rssi) present |= WIRE_FIELD_RSSI;
+        if (update.flags != state.flags) present |= WIRE_FIELD_FLAGS;
+
+        payload_.push_back(present);
+        if (present & WIRE_FIELD_NEW) {
+            for (int b = 0; b < 6; b++) payload_.push_back(static_cast<uint8_t>(update.address >> (8 * b)));
+        }
+        else {
+            put_varint(payload_, id);
+        }
+        if (present & WIRE_FIELD_SERIAL) put_varint(payload_, update.serial);
+        if (present & WIRE_FIELD_RSSI) put_varint(payload_, zigzag(update.rssi - state.rssi));
+        put_varint(payload_, zigzag(update.timestampMs - base));
+        if (present & WIRE_FIELD_FLAGS) payload_.push_back(update.flags);
+
+        state.serial = update.serial;
+        state.rssi = update.rssi;
+        state.flags = update.flags;
+    }
+
+    std::unordered_map<uint64_t, uint32_t> ids_;
+    std::vector<State> states_;
+    std::vector<uint8_t> payload_;
+    int64_t base_ms_;
+    uint16_t sequence_;
+    bool needs_reset_;
+};
+
+// Decoder: mirrors the encoder's dictionary and expands records
+class WireDecoder {
+public:
+    WireDecoder() : base_ms_(0), next_sequence_(0), synced_(false), gaps_(0), rejected_(0) {}
+
+    // Decode one frame (from WireFramer::next_frame), appending updates to out.
+    // Returns false on a malformed frame, a sequence gap, or an UPDATES frame
+    // while out of sync; the decoder then ignores frames until the next RESET.
+    bool decode(uint8_t type, uint16_t sequence, const std::vector<uint8_t>& payload, std::vector<WireUpdate>& out) {
+        if (type == WIRE_FRAME_RESET) {
+            states_.clear();
+            base_ms_ = 0;
+            next_sequence_ = static_cast<uint16_t>(sequence + 1);
+            synced_ = true;
+            return true;
+        }
+        if (type != WIRE_FRAME_UPDATES || !synced_) {
+            rejected_++;
+            return false;
+        }
+        if (sequence != next_sequence_) {
+            gaps_++;
+            return fail();
+        }
+        next_sequence_ = static_cast<uint16_t>(sequence + 1);
+
+        const uint8_t* p = payload.data();
+        const uint8_t* end = p + payload.size();
+        uint64_t value;
+        if (!get_varint(p, end, &value)) return fail();
+        base_ms_ += unzigzag(value);
+        uint64_t count;
+        if (!get_varint(p, end, &count)) return fail();
+
+        for (uint64_t i = 0; i < count; i++) {
+            if (p >= end) return fail();
+            const uint8_t present = *p++;
+            size_t id;
+            if (present & WIRE_FIELD_NEW) {
+                if (end - p < 6) return fail();
+                uint64_t address = 0;
+                for (int b = 0; b < 6; b++) address |= static_cast<uint64_t>(*p++) << (8 * b);
+                id = states_.size();
+                states_.push_back(WireUpdate{ address, 0, 0, 0, 0, 0 });
+            }
+            else {
+                if (!get_varint(p, end, &value) || value >= states_.size()) return fail();
+                id = static_cast<size_t>(value);
+            }
+
+            WireUpdate& state = states_[id];
+            if (present & WIRE_FIELD_SERIAL) {
+                if (!get_varint(p, end, &value)) return fail();
+                state.serial = value;
+            }
+            if (present & WIRE_FIELD_RSSI) {
+                if (!get_varint(p, end, &value)) return fail();
+                state.rssi += static_cast<int32_t>(unzigzag(value));
+            }
+            if (present & WIRE_FIELD_TIME) {
+                if (!get_varint(p, end, &value)) return fail();
+                state.timestampMs = base_ms_ + unzigzag(value);
+            }
+            if (present & WIRE_FIELD_FLAGS) {
+                if (p >= end) return fail();
+                state.flags = *p++;
+            }
+            state.present = present;
+            out.push_back(state);
+        }
+        return true;
+    }
+
+    // Drop sync, e.g. when the framer reports a corrupt frame
+    void lose_sync() { synced_ = false; }
+
+    bool synced() const { return synced_; }
+    uint64_t sequence_gaps() const { return gaps_; }
+    uint64_t rejected_frames() const { return rejected_; }
+
+private:
+    bool fail() {
+        synced_ = false;
+        rejected_++;
+        return false;
+    }
+
+    std::vector<WireUpdate> states_;
+    int64_t base_ms_;
+    uint16_t next_sequence_;
+    bool synced_;
+    uint64_t gaps_;
+    uint64_t rejected_;
+};
+
+} // namespace niox
+
+#endif // NIOX_WIRE_H
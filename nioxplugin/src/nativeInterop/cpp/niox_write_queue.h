@@ -0,0 +1,202 @@
+// NIOX write queue - batched characteristic writes for configuration pushes
+// A profile is dozens of small writes; sending each as a write request costs
+// a round trip apiece. The queue sends independent writes as write commands
+// (without response) in bursts paced by the stack's transmit buffer, and
+// uses a write request only where the device protocol needs an
+// acknowledgement (a barrier). ATT keeps the order, so a barrier's response
+// also confirms every command sent before it.
+
+#ifndef NIOX_WRITE_QUEUE_H
+#define NIOX_WRITE_QUEUE_H
+
+#include "niox_gatt.h"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
+namespace niox {
+
+struct WriteQueueStats {
+    uint64_t commands;              // Writes completed
+    uint64_t unacknowledged;        // Sent as write commands
+    uint64_t acknowledged;          // Sent as write requests (barriers, or too long for a command)
+    uint64_t bursts;                // Runs of write commands
+    uint64_t failed;
+    int64_t elapsedMs;              // Time spent in flush()
+    int64_t totalCompletionMs;      // Sum of enqueue-to-completion times
+    int64_t maxCompletionMs;
+};
+
+// Writes queued for one device, sent in order by flush(). A write completes
+// when acknowledged: by its own response, or by a later barrier's. Commands
+// after the last barrier complete once the stack has sent them (drained);
+// if one of those failed, they are all queued again.
+class WriteQueue {
+public:
+    explicit WriteQueue(uint64_t address) : address_(address), stats_() {}
+
+    WriteQueue(const WriteQueue&) = delete;
+    WriteQueue& operator=(const WriteQueue&) = delete;
+
+    // barrier: the device must acknowledge this write (and so everything
+    // before it) before later writes are sent
+    void enqueue(const Uuid& service, const Uuid& characteristic, const uint8_t* data, size_t length, bool barrier) {
+        Pending pending{ service, characteristic, std::vector<uint8_t>(data, data + length), barrier, now_ms() };
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(pending));
+    }
+
+    // Send the writes queued so far. Returns LINK_OK, or the first error;
+    // the failed write and those after it stay queued for the next flush.
+    int flush(GattClient& client, WriteQueueStats* flushStats = nullptr) {
+        std::lock_guard<std::mutex> flushing(flush_mutex_);
+        std::deque<Pending> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            batch.swap(queue_);
+        }
+        WriteQueueStats run = WriteQueueStats();
+        const int64_t start = now_ms();
+        int result = send(client, batch, &run);
+        run.elapsedMs = now_ms() - start;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Unsent writes go back ahead of anything queued meanwhile
+        queue_.insert(queue_.begin(), batch.begin(), batch.end());
+        stats_.commands += run.commands;
+        stats_.unacknowledged += run.unacknowledged;
+        stats_.acknowledged += run.acknowledged;
+        stats_.bursts += run.bursts;
+        stats_.failed += run.failed;
+        stats_.elapsedMs += run.elapsedMs;
+        stats_.totalCompletionMs += run.totalCompletionMs;
+        if (run.maxCompletionMs > stats_.maxCompletionMs) stats_.maxCompletionMs = run.maxCompletionMs;
+        if (flushStats) *flushStats = run;
+        return result;
+    }
+
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.clear();
+    }
+
+    // Totals over all flushes
+    WriteQueueStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+    uint64_t address() const { return address_; }
+
+private:
+    struct Pending {
+        Uuid service;
+        Uuid characteristic;
+        std::vector<uint8_t> data;
+        bool barrier;
+        int64_t enqueuedMs;
+    };
+
+    static int64_t now_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static void complete(const Pending& pending, int64_t when, WriteQueueStats* stats) {
+        const int64_t latency = when - pending.enqueuedMs;
+        stats->commands++;
+        stats->totalCompletionMs += latency;
+        if (latency > stats->maxCompletionMs) stats->maxCompletionMs = latency;
+    }
+
+    // Sends from the front of batch, removing what was sent
+    int send(GattClient& client, std::deque<Pending>& batch, WriteQueueStats* stats) {
+        if (batch.empty()) return LINK_OK;
+        // A command failure left behind (reported by the last flush, or by
+        // another user of the link) must not fail this retry
+        client.backend().drain_commands(address_);
+        uint16_t mtu = ATT_DEFAULT_MTU;
+        int result = client.backend().exchange_mtu(address_, ATT_MAX_MTU, &mtu);
+        if (result != LINK_OK) return result;
+        const size_t commandLimit = mtu - 3u;      // ATT opcode + handle
+
+        std::vector<Pending> unconfirmed;          // Commands awaiting a barrier's response
+        bool commandsFailed = false;               // One of them failed in the stack
+        bool inBurst = false;
+        while (!batch.empty()) {
+            const Pending& pending = batch.front();
+            GattCharacteristic c;
+            result = client.find(address_, pending.service, pending.characteristic, &c);
+            if (result != LINK_OK) break;
+
+            const bool command = !pending.barrier && (c.properties & GATT_PROP_WRITE_NO_RESPONSE) &&
+                pending.data.size() <= commandLimit;
+            if (!command && (c.properties & GATT_PROP_WRITE) == 0) {
+                result = GATT_NOT_PERMITTED;
+                break;
+            }
+
+            if (command) {
+                result = client.backend().write_command(address_, c.handle, pending.data.data(), pending.data.size());
+                if (result != LINK_OK) break;
+                if (!inBurst) stats->bursts++;
+                inBurst = true;
+                stats->unacknowledged++;
+                unconfirmed.push_back(std::move(batch.front()));
+            }
+            else {
+                // The request acknowledges the commands before it, so they must have left
+                if (!unconfirmed.empty()) {
+                    result = client.backend().drain_commands(address_);
+                    if (result != LINK_OK) {
+                        commandsFailed = true;
+                        break;
+                    }
+                }
+                result = client.backend().write(address_, c.handle, pending.data.data(), pending.data.size(), true);
+                if (result != LINK_OK) break;
+                inBurst = false;
+                stats->acknowledged++;
+                const int64_t acknowledged = now_ms();
+                for (const Pending& earlier : unconfirmed) complete(earlier, acknowledged, stats);
+                unconfirmed.clear();
+                complete(pending, acknowledged, stats);
+            }
+            batch.pop_front();
+        }
+
+        // Trailing commands are done only once they have left the stack; a
+        // failure among them is reported (and cleared) here
+        const int drained = commandsFailed ? result
+            : unconfirmed.empty() ? LINK_OK : client.backend().drain_commands(address_);
+        if (drained == LINK_OK) {
+            const int64_t sent = now_ms();
+            for (const Pending& earlier : unconfirmed) complete(earlier, sent, stats);
+        }
+        else {
+            // Which one failed is unknown: send them all again, in order
+            batch.insert(batch.begin(), std::make_move_iterator(unconfirmed.begin()), std::make_move_iterator(unconfirmed.end()));
+        }
+        if (result == LINK_OK) result = drained;
+        if (result != LINK_OK) stats->failed++;
+        return result;
+    }
+
+    uint64_t address_;
+    mutable std::mutex mutex_;
+    std::mutex flush_mutex_;        // One flush at a time keeps the order
+    std::deque<Pending> queue_;
+    WriteQueueStats stats_;
+};
+
+} // namespace niox
+
+#endif // NIOX_WRITE_QUEUE_H
@@ -0,0 +1,60 @@
+// AddressFilter::admit cost per advert against a 500-entry denylist: a
+// trace dominated by denied beacons, and one of addresses on no list
+
+#include "niox_test.h"
+#include "niox_address_filter.h"
+#include <cstdio>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+const size_t DENIED = 500;
+const size_t TRACE = 64 * 1024;
+const int PASSES = 64;
+
+uint64_t next(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state & 0xFFFFFFFFFFFFull;
+}
+
+double run(AddressFilter& filter, const std::vector<uint64_t>& trace, size_t* admitted) {
+    size_t count = 0;
+    const double ns = niox_test::ns_per_op(static_cast<uint64_t>(PASSES) * trace.size(), [&](uint64_t i) {
+        if (filter.admit(trace[i % trace.size()])) count++;
+    });
+    niox_test::keep(count);
+    *admitted = count / PASSES;
+    return ns;
+}
+
+} // namespace
+
+int main() {
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    std::vector<uint64_t> denied(DENIED);
+    for (uint64_t& address : denied) address = next(state);
+    AddressFilter filter;
+    filter.set(ADDRESS_DENY, denied);
+
+    // 90% of adverts from denied beacons, the rest from passers-by
+    std::vector<uint64_t> busy(TRACE);
+    for (size_t i = 0; i < TRACE; i++) busy[i] = next(state) % 10 < 9 ? denied[next(state) % DENIED] : next(state);
+    std::vector<uint64_t> unlisted(TRACE);
+    for (uint64_t& address : unlisted) address = next(state);
+
+    size_t admitted = 0;
+    const double busyNs = run(filter, busy, &admitted);
+    printf("90%% denied traffic   %6.1f ns/advert  (%zu of %zu admitted)\n", busyNs, admitted, TRACE);
+    const AddressFilterStats before = filter.stats();
+    const double unlistedNs = run(filter, unlisted, &admitted);
+    const AddressFilterStats after = filter.stats();
+    printf("unlisted addresses   %6.1f ns/advert  (%zu of %zu admitted)\n", unlistedNs, admitted, TRACE);
+    printf("bloom false positives %.2f%% of unlisted lookups\n",
+           100.0 * static_cast<double>(after.bloomFalsePositives - before.bloomFalsePositives) /
+           static_cast<double>(after.checked - before.checked));
+    return 0;
+}
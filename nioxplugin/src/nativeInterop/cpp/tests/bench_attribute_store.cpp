@@ -0,0 +1,88 @@
+// Reconnect cost with and without the persistent attribute map, against a
+// simulated NIOX PRO with realistic link setup and ATT round-trip latency
+
+#include "niox_attribute_store.h"
+#include "niox_test.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+using namespace niox;
+
+namespace {
+
+const uint64_t DEVICE = 0xC0FFEE000003ull;
+const char* STORE_PATH = "bench_attribute_store.nxga";
+const int SETUP_MS = 30;
+const int ROUND_TRIP_MS = 15;
+
+std::shared_ptr<SimulatedGattBackend> make_peripheral() {
+    auto backend = std::make_shared<SimulatedGattBackend>(SETUP_MS, ROUND_TRIP_MS);
+    const char revision[] = "1.4.2";
+    backend->add_characteristic(DEVICE, DEVICE_INFORMATION_SERVICE_UUID, FIRMWARE_REVISION_UUID, GATT_PROP_READ,
+        reinterpret_cast<const uint8_t*>(revision), sizeof(revision) - 1);
+    const uint8_t zero[] = { 0 };
+    for (uint16_t i = 0; i < 12; i++) {
+        backend->add_characteristic(DEVICE, Uuid::from16(static_cast<uint16_t>(0x1800 + i / 4)),
+            Uuid::from16(static_cast<uint16_t>(0x2A00 + i)), GATT_PROP_READ | GATT_PROP_NOTIFY, zero, 1);
+    }
+    return backend;
+}
+
+// Mean milliseconds from connect to a usable layout, each run a fresh client
+double reconnect_ms(std::shared_ptr<SimulatedGattBackend> backend, std::shared_ptr<AttributeStore> store, int runs) {
+    CachedAdvertisement advert = {};
+    advert.address = DEVICE;
+    advert.connectable = true;
+    double total = 0;
+    for (int i = 0; i < runs; i++) {
+        GattClient client(backend);
+        if (store) client.set_persistence(store, [](uint64_t) { return 7001234ull; });
+        const auto start = std::chrono::steady_clock::now();
+        client.connect(advert, 1000);
+        std::vector<GattCharacteristic> characteristics;
+        client.discover(DEVICE, characteristics);
+        total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        client.disconnect(DEVICE);
+    }
+    return total / runs;
+}
+
+} // namespace
+
+int main() {
+    const int runs = 10;
+    std::remove(STORE_PATH);
+
+    auto uncachedBackend = make_peripheral();
+    const uint64_t uncachedTrips = uncachedBackend->round_trips();
+    const double uncached = reconnect_ms(uncachedBackend, nullptr, runs);
+    const double uncachedRoundTrips = static_cast<double>(uncachedBackend->round_trips() - uncachedTrips) / runs;
+
+    auto store = std::make_shared<AttributeStore>();
+    store->open(STORE_PATH);
+    auto cachedBackend = make_peripheral();
+    reconnect_ms(cachedBackend, store, 1);     // First contact populates the store
+    const uint64_t cachedTrips = cachedBackend->round_trips();
+    const double cached = reconnect_ms(cachedBackend, store, runs);
+    const double cachedRoundTrips = static_cast<double>(cachedBackend->round_trips() - cachedTrips) / runs;
+
+    // Store lookup alone, without the radio
+    std::vector<GattCharacteristic> characteristics;
+    uint64_t firmwareHash = 0;
+    const double lookupNs = niox_test::ns_per_op(200000, [&](uint64_t) {
+        store->find(DEVICE, 7001234, characteristics, &firmwareHash);
+        niox_test::keep(firmwareHash);
+    });
+
+    const AttributeStoreStats stats = store->stats();
+    printf("uncached reconnect  %.1f ms (%.1f round trips)\n", uncached, uncachedRoundTrips);
+    printf("cached reconnect    %.1f ms (%.1f round trips)\n", cached, cachedRoundTrips);
+    printf("store lookup        %.0f ns\n", lookupNs);
+    printf("hit rate            %.1f%% (%llu hits, %llu misses, %llu stale)\n",
+        100.0 * static_cast<double>(stats.hits) / static_cast<double>(stats.hits + stats.misses + stats.stale),
+        static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses),
+        static_cast<unsigned long long>(stats.stale));
+    std::remove(STORE_PATH);
+    return 0;
+}
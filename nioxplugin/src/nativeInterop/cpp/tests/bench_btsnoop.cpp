@@ -0,0 +1,118 @@
+// btsnoop replay throughput: parsing alone, and parsing plus the WinRT-free
+// half of the scan pipeline the replay feeds (scan response pairing, status
+// decode, device table), against the capture's own real-time rate
+
+#include "niox_btsnoop.h"
+#include "niox_device_table.h"
+#include "niox_scan_merge.h"
+#include "niox_status.h"
+#include "niox_test.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+void put_be32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+// H4 capture of a busy clinic: 500 devices, one report per event, every
+// scannable advert followed by its scan response, a NIOX unit in ten
+std::vector<uint8_t> make_capture(size_t reports, double* captureSeconds) {
+    std::mt19937 rng(75);
+    std::vector<uint8_t> capture = { 'b', 't', 's', 'n', 'o', 'o', 'p', 0 };
+    put_be32(capture, 1);
+    put_be32(capture, BTSNOOP_DATALINK_H4);
+    uint64_t us = BTSNOOP_UNIX_EPOCH_US + 1700000000000000ull;
+    const uint64_t startUs = us;
+    for (size_t i = 0; i < reports; i++) {
+        const size_t device = (i / 2) % 500;
+        const bool response = i % 2 == 1;
+        std::vector<uint8_t> data;
+        if (response) {
+            const std::string name = device % 10 == 0 ? "NIOX PRO 0704" + std::to_string(10000 + device) : "Other device";
+            data.push_back(static_cast<uint8_t>(name.size() + 1));
+            data.push_back(AD_TYPE_COMPLETE_NAME);
+            data.insert(data.end(), name.begin(), name.end());
+        } else {
+            const uint8_t flags[] = { 0x02, 0x01, 0x06, 0x09, 0xFF, 0xFF, 0xFF, 0x01, 80, 0x01, 0x20, 0x01, 0x00 };
+            data.assign(flags, flags + (device % 10 == 0 ? sizeof(flags) : 3));
+        }
+        std::vector<uint8_t> packet = { 0x04, HCI_EVENT_LE_META, 0, HCI_LE_ADVERTISING_REPORT, 1,
+                                        static_cast<uint8_t>(response ? 0x04 : 0x00), 0x01 };
+        for (int b = 0; b < 6; b++) packet.push_back(static_cast<uint8_t>((0xC00000000000ull + device) >> (8 * b)));
+        packet.push_back(static_cast<uint8_t>(data.size()));
+        packet.insert(packet.end(), data.begin(), data.end());
+        packet.push_back(static_cast<uint8_t>(-40 - static_cast<int>(rng() % 50)));
+        packet[2] = static_cast<uint8_t>(packet.size() - 3);
+
+        us += response ? 200 : 1000 + rng() % 1000;
+        put_be32(capture, static_cast<uint32_t>(packet.size()));
+        put_be32(capture, static_cast<uint32_t>(packet.size()));
+        put_be32(capture, 0x03);
+        put_be32(capture, 0);
+        put_be32(capture, static_cast<uint32_t>(us >> 32));
+        put_be32(capture, static_cast<uint32_t>(us));
+        capture.insert(capture.end(), packet.begin(), packet.end());
+    }
+    *captureSeconds = static_cast<double>(us - startUs) / 1e6;
+    return capture;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    const size_t reports = 2000000;
+    double captureSeconds = 0;
+    const std::vector<uint8_t> capture = make_capture(reports, &captureSeconds);
+    BtsnoopReader reader;
+    reader.attach(capture.data(), capture.size());
+    BtsnoopAdvertisement advertisement;
+
+    // Parsing alone
+    size_t parsed = 0;
+    const auto parseStart = std::chrono::steady_clock::now();
+    while (reader.next(&advertisement)) {
+        parsed++;
+        niox_test::keep(advertisement.length);
+    }
+    const double parseSeconds = seconds_since(parseStart);
+
+    // Parsing and the pipeline, timestamps taken from the capture as at rate 0
+    ScanMerger merger;
+    DeviceTable table;
+    MergedAdvertisement merged[2];
+    size_t ingested = 0;
+    reader.rewind();
+    const auto pipelineStart = std::chrono::steady_clock::now();
+    while (reader.next(&advertisement)) {
+        const int64_t timestampMs = (advertisement.captureUs - BTSNOOP_UNIX_EPOCH_US) / 1000;
+        const size_t count = merger.add(advertisement.event(timestampMs), merged);
+        for (size_t i = 0; i < count; i++) {
+            const AdvertisementEvent event = merged[i].event();
+            DeviceStatus status;
+            const bool hasStatus = decode_status(event.data, event.length, &status);
+            table.upsert(event.address, event.name, event.rssi, event.timestampMs, 0, hasStatus ? &status : nullptr);
+            ingested++;
+        }
+    }
+    const double pipelineSeconds = seconds_since(pipelineStart);
+
+    printf("capture             %zu reports, %.1f MB, %.1f s of radio time\n", parsed,
+        static_cast<double>(capture.size()) / 1e6, captureSeconds);
+    printf("parse               %.1f M reports/s, %.0f MB/s\n", parsed / parseSeconds / 1e6,
+        static_cast<double>(capture.size()) / parseSeconds / 1e6);
+    printf("parse + pipeline    %.1f M reports/s (%zu merged adverts, %zu devices)\n",
+        parsed / pipelineSeconds / 1e6, ingested, table.size());
+    printf("replay speed        %.0fx real time\n", captureSeconds / pipelineSeconds);
+    return 0;
+}
@@ -0,0 +1,63 @@
+// DeviceTable queries on a 10k-device table: filter per kernel, and a full
+// filter + sort + page as winrt_query_devices runs it
+
+#include "niox_test.h"
+#include "niox_device_table.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+const size_t DEVICES = 10000;
+const int64_t NOW = 10000000;
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(10);
+    DeviceTable table;
+    char name[32];
+    for (size_t i = 0; i < DEVICES; i++) {
+        const bool niox = rng() % 10 == 0;
+        if (niox) snprintf(name, sizeof(name), "NIOX PRO %09zu", i);
+        table.upsert(0xC00000000000ull + i, niox ? name : nullptr, -100 + static_cast<int>(rng() % 70),
+                     NOW - static_cast<int64_t>(rng() % 120000), niox ? DEVICE_FLAG_NIOX_SERVICE : 0);
+    }
+
+    // RSSI >= -80, heard in the last minute, NIOX name or service
+    const DeviceFilter f = { -80, NOW - 60000, 0, DEVICE_FLAG_NIOX };
+    std::vector<uint32_t> out;
+    out.reserve(DEVICES);
+    const struct { DeviceTable::Path path; const char* name; } paths[] = {
+        { DeviceTable::PATH_SCALAR, "scalar" }, { DeviceTable::PATH_SSE2, "sse2" }, { DeviceTable::PATH_AVX2, "avx2" } };
+    for (const auto& p : paths) {
+#if NIOX_HAVE_SSE2
+        if (p.path == DeviceTable::PATH_AVX2 && !cpu_has_avx2()) continue;
+#endif
+        table.set_path(p.path);
+        const double ns = niox_test::ns_per_op(2000, [&](uint64_t) {
+            out.clear();
+            table.filter(f, out);
+            niox_test::keep(out.size());
+        });
+        printf("filter %-6s  %7.2f us  (%zu matches)\n", p.name, ns / 1000.0, out.size());
+    }
+    table.set_path(DeviceTable::PATH_AUTO);
+
+    const DeviceFilter all = { INT32_MIN, INT64_MIN, 0, 0 };
+    const struct { DeviceSortKey key; const char* name; } keys[] = {
+        { DEVICE_SORT_RSSI, "rssi" }, { DEVICE_SORT_LAST_SEEN, "last seen" }, { DEVICE_SORT_SERIAL, "serial" } };
+    for (const auto& k : keys) {
+        const double full = niox_test::ns_per_op(500, [&](uint64_t) {
+            niox_test::keep(table.query(all, k.key, 0, 0, out));
+        });
+        const double paged = niox_test::ns_per_op(500, [&](uint64_t) {
+            niox_test::keep(table.query(all, k.key, 0, 50, out));
+        });
+        printf("query all, sort by %-9s  %7.2f us full, %7.2f us first 50\n", k.name, full / 1000.0, paged / 1000.0);
+    }
+    return 0;
+}
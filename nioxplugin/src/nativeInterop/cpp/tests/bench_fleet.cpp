@@ -0,0 +1,49 @@
+// Fleet membership: minimal perfect hash against std::unordered_set, for
+// site-sized and large fleets, on hits and on the (common) misses
+
+#include "niox_fleet.h"
+#include "niox_test.h"
+#include <cstdio>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+using namespace niox;
+
+int main() {
+    std::mt19937_64 rng(71);
+    const uint64_t iterations = 20000000;
+    printf("%8s %10s %10s %10s %10s %12s %12s\n", "fleet", "mph hit", "set hit", "mph miss", "set miss", "mph bytes", "set bytes");
+    for (size_t count : { 20, 500, 20000 }) {
+        std::vector<uint64_t> serials;
+        for (size_t i = 0; i < count; i++) serials.push_back(pack_serial(rng() % 100000000, 8));
+        Fleet fleet;
+        fleet.build(serials);
+        const FleetTable table = fleet.table();
+        const std::unordered_set<uint64_t> set(serials.begin(), serials.end());
+
+        // Probe sequences, masked to a power of two to keep indexing cheap
+        const size_t probes = 4096;
+        std::vector<uint64_t> hits(probes);
+        std::vector<uint64_t> misses(probes);
+        for (size_t i = 0; i < probes; i++) {
+            hits[i] = serials[rng() % count];
+            uint64_t miss;
+            do miss = pack_serial(rng() % 100000000, 8); while (set.count(miss));
+            misses[i] = miss;
+        }
+
+        size_t found = 0;
+        const double mphHit = niox_test::ns_per_op(iterations, [&](uint64_t i) { found += table.contains(hits[i & (probes - 1)]); });
+        const double setHit = niox_test::ns_per_op(iterations, [&](uint64_t i) { found += set.count(hits[i & (probes - 1)]); });
+        const double mphMiss = niox_test::ns_per_op(iterations, [&](uint64_t i) { found += table.contains(misses[i & (probes - 1)]); });
+        const double setMiss = niox_test::ns_per_op(iterations, [&](uint64_t i) { found += set.count(misses[i & (probes - 1)]); });
+        niox_test::keep(found);
+
+        // Table arrays against nodes (key + next pointer + cached hash) plus buckets
+        const size_t mphBytes = table.size * sizeof(uint64_t) + table.buckets * sizeof(uint16_t);
+        const size_t setBytes = set.size() * (sizeof(uint64_t) + 2 * sizeof(void*)) + set.bucket_count() * sizeof(void*);
+        printf("%8zu %8.2fns %8.2fns %8.2fns %8.2fns %12zu %12zu\n", count, mphHit, setHit, mphMiss, setMiss, mphBytes, setBytes);
+    }
+    return 0;
+}
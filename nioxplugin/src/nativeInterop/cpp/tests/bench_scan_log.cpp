@@ -0,0 +1,76 @@
+// Scan log: 1M adverts from 200 devices over 2.5 s. Bytes per advert,
+// append latency, full and narrow range scans, and the round trip
+
+#include "niox_scan_log.h"
+#include "niox_test.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+const char* LOG_PATH = "bench_scan_log.nxsl";
+const size_t ADVERTS = 1000000;
+const int DEVICES = 200;
+const int64_t SPAN_MS = 2500;
+
+} // namespace
+
+int main() {
+    std::remove(LOG_PATH);
+    std::vector<ScanLogRecord> records(ADVERTS);
+    uint32_t x = 1;
+    const int64_t start = 1700000000000;
+    for (size_t i = 0; i < ADVERTS; i++) {
+        x = x * 1664525u + 1013904223u;
+        const int device = static_cast<int>((x >> 8) % DEVICES);
+        records[i].address = 0xC0FFEE000000ull + static_cast<uint64_t>(device);
+        records[i].timeMs = start + static_cast<int64_t>(i) * SPAN_MS / static_cast<int64_t>(ADVERTS);
+        records[i].rssi = static_cast<int8_t>(-50 - device / 5 - static_cast<int>((x >> 20) % 5));
+        records[i].flags = device % 10 == 0 ? 0x07 : 0x01;
+    }
+
+    ScanLogWriter writer;
+    if (!writer.start(LOG_PATH, 100, ADVERTS, 4096)) return 1;
+    std::vector<int64_t> latency(ADVERTS);
+    for (size_t i = 0; i < ADVERTS; i++) {
+        const auto before = std::chrono::steady_clock::now();
+        writer.append(records[i]);
+        latency[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - before).count();
+    }
+    writer.stop();
+    const ScanLogStats stats = writer.stats();
+    std::sort(latency.begin(), latency.end());
+    printf("log size      %.2f bytes/advert (%llu blocks, %llu dropped)\n",
+           static_cast<double>(stats.bytes) / static_cast<double>(ADVERTS),
+           static_cast<unsigned long long>(stats.blocks), static_cast<unsigned long long>(stats.dropped));
+    printf("append        p50 %lld ns, p99 %lld ns (two clock reads included)\n",
+           static_cast<long long>(latency[ADVERTS / 2]), static_cast<long long>(latency[ADVERTS * 99 / 100]));
+
+    ScanLogReader reader;
+    if (!reader.open(LOG_PATH)) return 1;
+    size_t index = 0;
+    bool exact = true;
+    const auto scanStart = std::chrono::steady_clock::now();
+    reader.scan(INT64_MIN, INT64_MAX, [&](const ScanLogRecord& r) {
+        const ScanLogRecord& e = records[index++];
+        exact = exact && r.address == e.address && r.timeMs == e.timeMs && r.rssi == e.rssi && r.flags == e.flags;
+    });
+    const double scanNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - scanStart).count());
+    printf("full scan     %.1f ns/record\n", scanNs / static_cast<double>(ADVERTS));
+    printf("round trip    %s (%zu records)\n", exact && index == ADVERTS ? "exact" : "MISMATCH", index);
+
+    const int64_t from = start + SPAN_MS / 2;
+    uint64_t matched = 0;
+    const double rangeNs = niox_test::ns_per_op(100, [&](uint64_t) {
+        matched = reader.scan(from, from + SPAN_MS / 100, [](const ScanLogRecord& r) { niox_test::keep(r.rssi); });
+    });
+    printf("1%% range scan %.3f ms (%llu records)\n", rangeNs / 1e6, static_cast<unsigned long long>(matched));
+    std::remove(LOG_PATH);
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Scan updates with and without pairing: 200 scannable devices at a 1 s
+// interval for 10 s, 5% of scan responses lost, plus the cost per PDU
+
+#include "niox_test.h"
+#include "niox_scan_merge.h"
+#include <cstdio>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+const int DEVICES = 200;
+const int SECONDS = 10;
+const double RESPONSE_LOSS = 0.05;
+
+const uint8_t ADV_DATA[] = { 0x02, 0x01, 0x06, 0x03, 0x03, 0x0F, 0x18 };
+const uint8_t RSP_DATA[] = { 0x09, 0x09, 'N', 'I', 'O', 'X', '-', '0', '0', '1' };
+
+// Advertisement then (usually) its scan response, devices spread over the second
+std::vector<AdvertisementEvent> trace() {
+    std::vector<AdvertisementEvent> events;
+    uint32_t random = 12345;
+    for (int second = 0; second < SECONDS; second++) {
+        for (int device = 0; device < DEVICES; device++) {
+            AdvertisementEvent event = {};
+            event.address = 0xC10000000000ull + static_cast<uint64_t>(device);
+            event.connectable = true;
+            event.scannable = true;
+            event.rssi = -60;
+            event.timestampMs = second * 1000 + device * 1000 / DEVICES;
+            event.data = ADV_DATA;
+            event.length = sizeof(ADV_DATA);
+            events.push_back(event);
+            random = random * 1664525u + 1013904223u;
+            if (random < RESPONSE_LOSS * 4294967296.0) continue;
+            event.scannable = false;
+            event.scanResponse = true;
+            event.timestampMs += 2;
+            event.name = "NIOX-001";
+            event.data = RSP_DATA;
+            event.length = sizeof(RSP_DATA);
+            events.push_back(event);
+        }
+    }
+    return events;
+}
+
+} // namespace
+
+int main() {
+    const std::vector<AdvertisementEvent> events = trace();
+    size_t nameless = 0;
+    for (const AdvertisementEvent& event : events) {
+        if (event.name == nullptr) nameless++;
+    }
+    printf("unpaired: %zu updates, %zu without a name\n", events.size(), nameless);
+
+    ScanMerger merger(100);
+    MergedAdvertisement out[2];
+    MergedAdvertisement held;
+    size_t updates = 0;
+    nameless = 0;
+    for (const AdvertisementEvent& event : events) {
+        while (merger.take_expired(event.timestampMs, &held)) {
+            updates++;
+            if (!held.hasName) nameless++;
+        }
+        const size_t count = merger.add(event, out);
+        for (size_t i = 0; i < count; i++) {
+            updates++;
+            if (!out[i].hasName) nameless++;
+        }
+    }
+    while (merger.take_any(&held)) {
+        updates++;
+        if (!held.hasName) nameless++;
+    }
+    printf("paired:   %zu updates, %zu without a name\n", updates, nameless);
+
+    const double ns = niox_test::ns_per_op(20 * events.size(), [&](uint64_t i) {
+        const AdvertisementEvent& event = events[i % events.size()];
+        niox_test::keep(merger.add(event, out));
+        if (merger.take_expired(event.timestampMs, &held)) niox_test::keep(held.length);
+    });
+    printf("add + take_expired: %.1f ns/PDU\n", ns);
+    return 0;
+}
@@ -0,0 +1,41 @@
+// Advertised status decoding cost per advertisement, for adverts carrying
+// NIOX status and for the (far more common) foreign adverts without it
+
+#include "niox_status.h"
+#include "niox_test.h"
+#include <cstdio>
+
+using namespace niox;
+
+int main() {
+    // Full 31-byte advert: flags, name, then the status at the end
+    const uint8_t nioxAdvert[] = {
+        0x02, 0x01, 0x06,
+        0x0D, 0x09, 'N', 'I', 'O', 'X', ' ', 'P', 'R', 'O', ' ', '0', '0', '1',
+        0x09, 0xFF, 0xFF, 0xFF, 0x01, 87, 0x03, 0x38, 0x01, 0x00,
+        0x02, 0x0A, 0x04,
+    };
+    const uint8_t foreignAdvert[] = {
+        0x02, 0x01, 0x1A,
+        0x0A, 0xFF, 0x4C, 0x00, 0x10, 0x05, 0x0B, 0x1C, 0x7E, 0x2F, 0x11,
+        0x03, 0x03, 0x0F, 0x18,
+        0x02, 0x0A, 0x08,
+    };
+    const uint64_t iterations = 20000000;
+    DeviceStatus status = {};
+    uint64_t decoded = 0;
+
+    const double nioxNs = niox_test::ns_per_op(iterations, [&](uint64_t) {
+        decoded += decode_status(nioxAdvert, sizeof(nioxAdvert), &status);
+        niox_test::keep(status);
+    });
+    const double foreignNs = niox_test::ns_per_op(iterations, [&](uint64_t) {
+        decoded += decode_status(foreignAdvert, sizeof(foreignAdvert), &status);
+        niox_test::keep(status);
+    });
+
+    printf("niox advert     %.1f ns/decode\n", nioxNs);
+    printf("foreign advert  %.1f ns/decode\n", foreignNs);
+    printf("decoded         %llu\n", static_cast<unsigned long long>(decoded));
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Log download throughput on a simulated link with a 30 ms round trip and
+// 1.25 ms per packet: one chunk per request against the pipelined transfer,
+// with and without loss, and a resume after the link drops
+
+#include "niox_test.h"
+#include "niox_transfer.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+const uint64_t DEVICE = 0xC0FFEE000063ull;
+const int ROUND_TRIP_MS = 30;
+const int PACKET_US = 1250;
+
+std::vector<uint8_t> make_log(size_t size) {
+    std::vector<uint8_t> log(size);
+    for (size_t i = 0; i < size; i++) log[i] = static_cast<uint8_t>(i * 131 + (i >> 8));
+    return log;
+}
+
+bool connect(GattClient& client) {
+    CachedAdvertisement advert = {};
+    advert.address = DEVICE;
+    advert.connectable = true;
+    return client.connect(advert, 1000) == LINK_OK;
+}
+
+void report(const char* name, const LogTransfer& transfer, const std::vector<uint8_t>& log,
+            const SimulatedLogPeripheral& device) {
+    const TransferStats stats = transfer.stats();
+    printf("%-34s %6u B  mtu %3u  %7.0f ms  %9.0f B/s  requests %4llu  rerequests %3llu  lost %3llu  dup %llu  resumes %u  %s\n",
+           name, stats.size, stats.mtu, static_cast<double>(stats.elapsedMs), stats.bytesPerSecond,
+           static_cast<unsigned long long>(stats.requests), static_cast<unsigned long long>(stats.rerequests),
+           static_cast<unsigned long long>(device.chunks_dropped()), static_cast<unsigned long long>(stats.duplicates),
+           stats.resumes, transfer.data() == log ? "match" : "MISMATCH");
+}
+
+void download(const char* name, size_t size, uint16_t mtu, int depth, uint32_t requestChunks, double loss) {
+    auto backend = std::make_shared<SimulatedGattBackend>(0, ROUND_TRIP_MS);
+    backend->set_max_mtu(mtu);
+    const std::vector<uint8_t> log = make_log(size);
+    SimulatedLogPeripheral device(backend, DEVICE, log, ROUND_TRIP_MS, PACKET_US, loss, 3);
+    GattClient client(backend);
+    if (!connect(client)) return;
+    TransferOptions options;
+    options.mtu = mtu;
+    options.depth = depth;
+    options.requestChunks = requestChunks;
+    options.requestTimeoutMs = 4 * ROUND_TRIP_MS;
+    LogTransfer transfer(DEVICE, options);
+    transfer.run(client);
+    report(name, transfer, log, device);
+}
+
+void resume() {
+    auto backend = std::make_shared<SimulatedGattBackend>(0, ROUND_TRIP_MS);
+    backend->set_max_mtu(247);
+    const std::vector<uint8_t> log = make_log(64 * 1024);
+    SimulatedLogPeripheral device(backend, DEVICE, log, ROUND_TRIP_MS, PACKET_US, 0.0);
+    GattClient client(backend);
+    if (!connect(client)) return;
+    LogTransfer transfer(DEVICE);
+    std::thread runner([&]() { transfer.run(client); });
+    while (transfer.stats().acknowledged < 17 * 1024) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    backend->disconnect(DEVICE);
+    runner.join();
+    backend->set_max_mtu(185);
+    if (!connect(client)) return;
+    transfer.run(client);
+    report("dropped at 17 KiB, resumed at 185", transfer, log, device);
+}
+
+} // namespace
+
+int main() {
+    download("sequential, mtu 23, 1 chunk/request", 2048, ATT_DEFAULT_MTU, 1, 1, 0.0);
+    download("pipelined, mtu 23", 16 * 1024, ATT_DEFAULT_MTU, 4, 16, 0.0);
+    download("pipelined, mtu 247", 64 * 1024, 247, 4, 16, 0.0);
+    download("pipelined, mtu 247, 5% loss", 64 * 1024, 247, 4, 16, 0.05);
+    resume();
+    return 0;
+}
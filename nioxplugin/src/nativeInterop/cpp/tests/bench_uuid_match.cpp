@@ -0,0 +1,39 @@
+// UuidMatcher: scalar vs SSE2 vs AVX2 on advertised 128-bit UUID lists
+
+#include "niox_test.h"
+#include "niox_uuid_match.h"
+#include <random>
+#include <vector>
+
+using niox::Uuid;
+using niox::UuidMatcher;
+
+int main() {
+    std::mt19937_64 rng(53);
+    UuidMatcher matcher;
+    for (int t = 0; t < 4; t++) matcher.add(Uuid{ rng(), rng() });
+
+    // Lists of 1..30 entries, no hit: the worst case, every entry is compared
+    const size_t sizes[] = { 1, 2, 4, 8, 16, 30 };
+    const uint64_t iterations = 2000000;
+    printf("%8s %12s %12s %12s\n", "entries", "scalar ns", "sse2 ns", "avx2 ns");
+    for (size_t count : sizes) {
+        std::vector<uint8_t> list(count * 16);
+        for (uint8_t& b : list) b = static_cast<uint8_t>(rng());
+
+        double ns[3] = { 0, 0, 0 };
+        const UuidMatcher::Path paths[3] = { UuidMatcher::PATH_SCALAR, UuidMatcher::PATH_SSE2, UuidMatcher::PATH_AVX2 };
+        for (int p = 0; p < 3; p++) {
+#if !NIOX_HAVE_SSE2
+            if (p > 0) continue;
+#endif
+            if (paths[p] == UuidMatcher::PATH_AVX2 && !niox::cpu_has_avx2()) continue;
+            matcher.set_path(paths[p]);
+            ns[p] = niox_test::ns_per_op(iterations, [&](uint64_t) {
+                niox_test::keep(matcher.match(list.data(), count));
+            });
+        }
+        printf("%8zu %12.2f %12.2f %12.2f\n", count, ns[0], ns[1], ns[2]);
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Wire protocol: bytes per update and throughput against the JSON records
+// niox_query_devices builds in CApi.kt
+
+#include "niox_test.h"
+#include "niox_wire.h"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+// Same fields and layout as the CApi.kt device JSON
+void append_json(std::string& out, const WireUpdate& update) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer),
+        "{\"name\":\"NIOX PRO %08llu\",\"address\":\"%02llX:%02llX:%02llX:%02llX:%02llX:%02llX\",\"rssi\":%d,"
+        "\"ageMs\":%lld,\"isNioxDevice\":%s,\"serialNumber\":\"%llu\"},",
+        static_cast<unsigned long long>(update.serial),
+        static_cast<unsigned long long>((update.address >> 40) & 0xFF), static_cast<unsigned long long>((update.address >> 32) & 0xFF),
+        static_cast<unsigned long long>((update.address >> 24) & 0xFF), static_cast<unsigned long long>((update.address >> 16) & 0xFF),
+        static_cast<unsigned long long>((update.address >> 8) & 0xFF), static_cast<unsigned long long>(update.address & 0xFF),
+        update.rssi, static_cast<long long>(update.timestampMs % 1000), update.flags ? "true" : "false",
+        static_cast<unsigned long long>(update.serial));
+    out += buffer;
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(57);
+    const size_t devices = 200;
+    const int batches = 2000;
+
+    // Pre-generate a drifting population: RSSI wanders a few dB per batch
+    std::vector<std::vector<WireUpdate>> stream(batches);
+    std::vector<int> rssi(devices, -60);
+    size_t updates = 0;
+    for (int b = 0; b < batches; b++) {
+        for (size_t d = 0; d < devices; d++) {
+            if (rng() % 4 == 0) continue;
+            rssi[d] += static_cast<int>(rng() % 5) - 2;
+            WireUpdate update = { 0xC00000000000ull + d, 7000000 + d, rssi[d],
+                1700000000000ll + b * 500 - static_cast<int64_t>(rng() % 400), 1, 0 };
+            stream[b].push_back(update);
+            updates++;
+        }
+    }
+
+    WireEncoder encoder;
+    std::vector<uint8_t> bytes;
+    const auto encode_start = std::chrono::steady_clock::now();
+    for (const auto& batch : stream) encoder.encode(batch.data(), batch.size(), bytes);
+    const double encode_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - encode_start).count();
+
+    WireFramer framer;
+    WireDecoder decoder;
+    std::vector<WireUpdate> decoded;
+    decoded.reserve(updates);
+    const auto decode_start = std::chrono::steady_clock::now();
+    framer.feed(bytes.data(), bytes.size());
+    uint8_t type;
+    uint16_t sequence;
+    std::vector<uint8_t> payload;
+    while (framer.next_frame(&type, &sequence, payload)) decoder.decode(type, sequence, payload, decoded);
+    const double decode_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - decode_start).count();
+
+    std::string json;
+    const auto json_start = std::chrono::steady_clock::now();
+    for (const auto& batch : stream) {
+        json += "[";
+        for (const WireUpdate& update : batch) append_json(json, update);
+        json += "]";
+    }
+    const double json_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - json_start).count();
+
+    printf("updates            %zu (decoded %zu)\n", updates, decoded.size());
+    printf("wire bytes/update  %.2f\n", static_cast<double>(bytes.size()) / static_cast<double>(updates));
+    printf("json bytes/update  %.2f\n", static_cast<double>(json.size()) / static_cast<double>(updates));
+    printf("encode             %.1f M updates/s\n", static_cast<double>(updates) / encode_s / 1e6);
+    printf("decode             %.1f M updates/s\n", static_cast<double>(updates) / decode_s / 1e6);
+    printf("json build         %.1f M updates/s\n", static_cast<double>(updates) / json_s / 1e6);
+    return decoded.size() == updates ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+// Configuration push: WriteQueue (write commands with a few barriers)
+// against one write request per value, on a simulated link with a 30 ms
+// round trip and an 8-packet transmit buffer at 1.25 ms per packet
+
+#include "niox_test.h"
+#include "niox_write_queue.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+const uint64_t DEVICE = 0xC0FFEE000065ull;
+const Uuid CONFIG_SERVICE = Uuid::from16(0x1850);
+const Uuid CONFIG = Uuid::from16(0x2B60);
+const int WRITES = 60;
+
+struct Run {
+    double ms;
+    double writesPerSecond;
+    double meanCompletionMs;
+    int64_t maxCompletionMs;
+    uint64_t roundTrips;
+    std::vector<std::vector<uint8_t>> seen;
+};
+
+Run push(bool queued) {
+    auto backend = std::make_shared<SimulatedGattBackend>(0, 30);
+    const uint8_t zero[] = { 0 };
+    const uint16_t handle = backend->add_characteristic(DEVICE, CONFIG_SERVICE, CONFIG,
+        GATT_PROP_WRITE | GATT_PROP_WRITE_NO_RESPONSE, zero, 1);
+    Run run = Run();
+    backend->set_write_handler(DEVICE, handle, [&run](const uint8_t* data, size_t length) {
+        run.seen.emplace_back(data, data + length);
+    });
+    backend->set_command_buffer(8, 1250);
+    GattClient client(backend);
+    CachedAdvertisement advert = {};
+    advert.address = DEVICE;
+    advert.connectable = true;
+    client.connect(advert, 1000);
+    GattCharacteristic c;
+    client.find(DEVICE, CONFIG_SERVICE, CONFIG, &c);
+    const uint64_t tripsBefore = backend->round_trips();
+
+    std::vector<std::vector<uint8_t>> values;
+    for (int i = 0; i < WRITES; i++) values.push_back({ static_cast<uint8_t>(i), 0x10, 0x20, static_cast<uint8_t>(i * 3) });
+
+    const auto start = std::chrono::steady_clock::now();
+    if (queued) {
+        WriteQueue queue(DEVICE);
+        for (int i = 0; i < WRITES; i++) {
+            // The protocol needs an acknowledgement after each 20-value section
+            queue.enqueue(CONFIG_SERVICE, CONFIG, values[i].data(), values[i].size(), i % 20 == 19);
+        }
+        WriteQueueStats stats;
+        queue.flush(client, &stats);
+        run.meanCompletionMs = static_cast<double>(stats.totalCompletionMs) / WRITES;
+        run.maxCompletionMs = stats.maxCompletionMs;
+    } else {
+        double total = 0;
+        for (int i = 0; i < WRITES; i++) {
+            client.write(DEVICE, CONFIG_SERVICE, CONFIG, values[i].data(), values[i].size(), true);
+            const int64_t done = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+            total += static_cast<double>(done);     // All enqueued at the start
+            run.maxCompletionMs = done;
+        }
+        run.meanCompletionMs = total / WRITES;
+    }
+    run.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    run.writesPerSecond = WRITES / (run.ms / 1000.0);
+    run.roundTrips = backend->round_trips() - tripsBefore;
+    return run;
+}
+
+} // namespace
+
+int main() {
+    const Run sequential = push(false);
+    const Run queued = push(true);
+    printf("write requests   %6.0f ms  %5.0f writes/s  completion mean %5.0f ms max %5lld ms  %3llu round trips\n",
+        sequential.ms, sequential.writesPerSecond, sequential.meanCompletionMs,
+        static_cast<long long>(sequential.maxCompletionMs), static_cast<unsigned long long>(sequential.roundTrips));
+    printf("write queue      %6.0f ms  %5.0f writes/s  completion mean %5.0f ms max %5lld ms  %3llu round trips\n",
+        queued.ms, queued.writesPerSecond, queued.meanCompletionMs,
+        static_cast<long long>(queued.maxCompletionMs), static_cast<unsigned long long>(queued.roundTrips));
+    const bool sameOrder = queued.seen == sequential.seen && queued.seen.size() == static_cast<size_t>(WRITES);
+    printf("device write order %s\n", sameOrder ? "identical" : "DIFFERS");
+    return sameOrder ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+// Minimal check helpers for the native header tests
+// A failed CHECK reports file and line and the test keeps going; main
+// returns niox_test::finish() so ctest sees the failure count.
+
+#ifndef NIOX_TEST_H
+#define NIOX_TEST_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace niox_test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void check(bool ok, const char* expr, const char* file, int line) {
+    if (ok) return;
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+    failures()++;
+}
+
+inline int finish(const char* suite) {
+    if (failures() != 0) {
+        fprintf(stderr, "%s: %d check(s) failed\n", suite, failures());
+        return 1;
+    }
+    printf("%s: ok\n", suite);
+    return 0;
+}
+
+// Nanoseconds per call of fn over iterations calls
+template <typename Fn>
+double ns_per_op(uint64_t iterations, Fn fn) {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) fn(i);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / static_cast<double>(iterations);
+}
+
+// Keep a value alive so the optimizer cannot drop the work producing it
+template <typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace niox_test
+
+#define CHECK(expr) niox_test::check(static_cast<bool>(expr), #expr, __FILE__, __LINE__)
+
+#endif // NIOX_TEST_H
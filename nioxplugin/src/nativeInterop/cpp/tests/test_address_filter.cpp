@@ -0,0 +1,163 @@
+// AddressFilter: deny/allow membership, learning with bounded sightings,
+// and lock-free readers while the lists are replaced
+
+#include "niox_test.h"
+#include "niox_address_filter.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+uint64_t address(uint64_t i) {
+    return 0xC00000000000ull | (i * 0x9E3779B1ull & 0xFFFFFFFFFFull);
+}
+
+void test_set_contents() {
+    std::vector<uint64_t> addresses;
+    for (uint64_t i = 0; i < 1000; i++) addresses.push_back(address(i));
+    addresses.push_back(address(5));
+    AddressSet set(addresses);
+    CHECK(set.size() == 1000);
+    for (uint64_t i = 0; i < 1000; i++) CHECK(set.maybe_contains(address(i)) && set.contains(address(i)));
+    size_t falsePositives = 0;
+    for (uint64_t i = 1000; i < 101000; i++) {
+        CHECK(!set.contains(address(i)));
+        if (set.maybe_contains(address(i))) falsePositives++;
+    }
+    CHECK(falsePositives < 2000);
+    CHECK(!AddressSet().maybe_contains(address(1)));
+    CHECK(!set.contains(~uint64_t(0)));
+}
+
+void test_deny_and_allow() {
+    AddressFilter filter;
+    CHECK(filter.admit(address(1)));
+    filter.add(ADDRESS_DENY, address(1));
+    filter.add(ADDRESS_DENY, address(2));
+    CHECK(!filter.admit(address(1)));
+    CHECK(!filter.admit(address(2)));
+    CHECK(filter.admit(address(3)));
+    CHECK(filter.remove(ADDRESS_DENY, address(1)));
+    CHECK(!filter.remove(ADDRESS_DENY, address(1)));
+    CHECK(filter.admit(address(1)));
+
+    // An allowlist admits only its members; the denylist still wins
+    filter.set(ADDRESS_ALLOW, { address(2), address(3) });
+    CHECK(filter.admit(address(3)));
+    CHECK(!filter.admit(address(2)));
+    CHECK(!filter.admit(address(4)));
+    filter.set(ADDRESS_ALLOW, {});
+    CHECK(filter.admit(address(4)));
+
+    const AddressFilterStats stats = filter.stats();
+    CHECK(stats.checked == 9);
+    CHECK(stats.denied == 3);
+    CHECK(stats.notAllowed == 1);
+    CHECK(stats.denySize == 1);
+    CHECK(stats.allowSize == 0);
+    CHECK(stats.version == 5);
+}
+
+void test_learning() {
+    AddressFilter filter;
+    CHECK(!filter.observe_irrelevant(address(1)));      // Off by default
+    filter.set_learning(3, 2);
+    CHECK(!filter.observe_irrelevant(address(1)));
+    CHECK(!filter.observe_irrelevant(address(1)));
+    CHECK(filter.observe_irrelevant(address(1)));
+    CHECK(!filter.admit(address(1)));
+    for (int i = 0; i < 2; i++) filter.observe_irrelevant(address(2));
+    CHECK(filter.observe_irrelevant(address(2)));
+
+    // At capacity nothing more is learned until an entry is removed
+    for (int i = 0; i < 5; i++) CHECK(!filter.observe_irrelevant(address(3)));
+    CHECK(filter.admit(address(3)));
+    CHECK(filter.remove(ADDRESS_DENY, address(2)));
+    for (int i = 0; i < 2; i++) filter.observe_irrelevant(address(3));
+    CHECK(filter.observe_irrelevant(address(3)));
+    CHECK(filter.stats().learned == 3);
+
+    filter.set_learning(0);
+    for (int i = 0; i < 5; i++) CHECK(!filter.observe_irrelevant(address(4)));
+    CHECK(filter.admit(address(4)));
+}
+
+// A stream of one-off addresses ages out of the sightings table instead of
+// growing it; an address heard steadily throughout is still learned
+void test_sightings_age_out() {
+    AddressFilter filter;
+    filter.set_learning(8);
+    const uint64_t steady = address(0);
+    bool learned = false;
+    size_t peak = 0;
+    for (uint64_t i = 1; i <= 4 * AddressFilter::MAX_SIGHTINGS; i++) {
+        filter.observe_irrelevant(address(i));
+        if (i % 4096 == 0 && filter.observe_irrelevant(steady)) learned = true;
+        if (i % 1024 == 0 && filter.stats().sightings > peak) peak = filter.stats().sightings;
+    }
+    CHECK(learned);
+    CHECK(peak <= AddressFilter::MAX_SIGHTINGS);
+    CHECK(!filter.admit(steady));
+    CHECK(filter.stats().learned == 1);
+    CHECK(filter.admit(address(7)));
+}
+
+// Readers keep admitting while the denylist is replaced: a permanent
+// entry is denied and an unlisted address admitted in every snapshot
+void test_concurrent_readers() {
+    AddressFilter filter;
+    std::vector<uint64_t> first;
+    std::vector<uint64_t> second;
+    for (uint64_t i = 0; i < 1000; i++) {
+        first.push_back(address(i));
+        second.push_back(address(i));
+    }
+    for (uint64_t i = 1000; i < 1500; i++) first.push_back(address(i));
+    for (uint64_t i = 1500; i < 2000; i++) second.push_back(address(i));
+    filter.set(ADDRESS_DENY, first);
+
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> wrong(0);
+    std::atomic<uint64_t> checked(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&, t]() {
+            uint64_t i = static_cast<uint64_t>(t) * 7919;
+            uint64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (filter.admit(address(i % 1000))) wrong++;
+                if (!filter.admit(address(5000 + i % 1000))) wrong++;
+                filter.admit(address(1000 + i % 1000));     // Either answer is right
+                count += 3;
+                i++;
+            }
+            checked += count;
+        });
+    }
+    for (int round = 0; round < 200; round++) {
+        filter.set(ADDRESS_DENY, round % 2 == 0 ? second : first);
+        filter.add(ADDRESS_DENY, address(9000 + round));
+        filter.remove(ADDRESS_DENY, address(9000 + round));
+    }
+    stop = true;
+    for (std::thread& reader : readers) reader.join();
+    CHECK(wrong.load() == 0);
+    const AddressFilterStats stats = filter.stats();
+    CHECK(stats.checked == checked.load());
+    CHECK(stats.version == 601);
+    CHECK(stats.denySize == 1500);
+}
+
+} // namespace
+
+int main() {
+    test_set_contents();
+    test_deny_and_allow();
+    test_learning();
+    test_sightings_age_out();
+    test_concurrent_readers();
+    return niox_test::finish("test_address_filter");
+}
@@ -0,0 +1,256 @@
+// Aggregator: datagram encoding, collector merging (serial folding, stale
+// best-RSSI handover, sequence gaps, expiry) and nodes over loopback
+
+#include "niox_test.h"
+#include "niox_aggregator.h"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+DeviceDelta delta(uint64_t address, uint64_t serial, int rssi, uint16_t ageMs = 0) {
+    return DeviceDelta{ address, serial, static_cast<int8_t>(rssi), 0, ageMs };
+}
+
+// One datagram from a node to the collector
+bool send(Collector& collector, uint16_t node, uint32_t sequence, const std::vector<DeviceDelta>& deltas, int64_t nowMs) {
+    uint8_t buffer[AGG_MAX_DATAGRAM];
+    AggregateHeader header = { deltas.empty() ? AGG_KIND_HEARTBEAT : AGG_KIND_DELTAS, node, sequence,
+                               static_cast<uint16_t>(deltas.size()) };
+    const size_t length = encode_aggregate(header, deltas.data(), buffer);
+    return collector.ingest(buffer, length, nowMs);
+}
+
+std::vector<AggregatedDevice> devices(const Collector& collector) {
+    std::vector<AggregatedDevice> out;
+    collector.snapshot_devices(out);
+    return out;
+}
+
+NodeStatus node(const Collector& collector, uint16_t nodeId) {
+    std::vector<NodeStatus> nodes;
+    collector.snapshot_nodes(nodes);
+    for (const NodeStatus& status : nodes) {
+        if (status.nodeId == nodeId) return status;
+    }
+    return NodeStatus();
+}
+
+void test_round_trip() {
+    std::vector<DeviceDelta> deltas;
+    for (size_t i = 0; i < AGG_MAX_DELTAS; i++) {
+        deltas.push_back(DeviceDelta{ 0xFEDCBA987654ull - i, i * 0x0102030405ull, static_cast<int8_t>(-100 + static_cast<int>(i)),
+                                      static_cast<uint8_t>(i), static_cast<uint16_t>(i * 997) });
+    }
+    uint8_t buffer[AGG_MAX_DATAGRAM];
+    AggregateHeader header = { AGG_KIND_DELTAS, 0xBEEF, 0xDEADBEEF, static_cast<uint16_t>(deltas.size()) };
+    const size_t length = encode_aggregate(header, deltas.data(), buffer);
+    CHECK(length == AGG_HEADER_SIZE + deltas.size() * AGG_DELTA_SIZE);
+    CHECK(length <= AGG_MAX_DATAGRAM);
+
+    AggregateHeader decoded;
+    CHECK(decode_aggregate_header(buffer, length, &decoded));
+    CHECK(decoded.kind == AGG_KIND_DELTAS && decoded.nodeId == 0xBEEF && decoded.sequence == 0xDEADBEEF);
+    CHECK(decoded.count == deltas.size());
+    for (size_t i = 0; i < deltas.size(); i++) {
+        const DeviceDelta d = decode_aggregate_delta(buffer, i);
+        CHECK(d.address == deltas[i].address && d.serial == deltas[i].serial && d.rssi == deltas[i].rssi);
+        CHECK(d.flags == deltas[i].flags && d.ageMs == deltas[i].ageMs);
+    }
+}
+
+void test_malformed() {
+    uint8_t buffer[AGG_MAX_DATAGRAM];
+    const DeviceDelta deltas[2] = { delta(1, 0, -50), delta(2, 0, -60) };
+    AggregateHeader header = { AGG_KIND_DELTAS, 1, 1, 2 };
+    const size_t length = encode_aggregate(header, deltas, buffer);
+    AggregateHeader decoded;
+    CHECK(!decode_aggregate_header(buffer, AGG_HEADER_SIZE - 1, &decoded));
+    CHECK(!decode_aggregate_header(buffer, length - 1, &decoded));     // Count past the end
+
+    Collector collector;
+    buffer[4] = AGG_VERSION + 1;
+    CHECK(!collector.ingest(buffer, length, 0));
+    buffer[4] = AGG_VERSION;
+    buffer[0] ^= 0xFF;
+    CHECK(!collector.ingest(buffer, length, 0));
+    buffer[0] ^= 0xFF;
+    CHECK(collector.ingest(buffer, length, 0));
+    CHECK(collector.size() == 2);
+    CHECK(!collector.ingest(buffer, 3, 0));
+}
+
+// A device first reported by address alone joins its serial entry once any
+// node decodes the name; later address-only reports land there too
+void test_serial_folding() {
+    Collector collector;
+    const uint64_t address = 0xC0FFEE000001ull;
+    const uint64_t serial = (9ull << 56) | 1234;
+    CHECK(send(collector, 1, 1, { delta(address, 0, -60) }, 1000));
+    CHECK(collector.size() == 1 && devices(collector)[0].serial == 0);
+    CHECK(send(collector, 2, 1, { delta(address, serial, -70) }, 1100));
+    CHECK(collector.size() == 1);
+    CHECK(devices(collector)[0].serial == serial);
+    CHECK(send(collector, 3, 1, { delta(address, 0, -55) }, 1200));
+    const std::vector<AggregatedDevice> all = devices(collector);
+    CHECK(all.size() == 1);
+    CHECK(all[0].serial == serial && all[0].bestRssi == -55 && all[0].bestNode == 3);
+
+    // Another device with a serial stays separate
+    CHECK(send(collector, 1, 2, { delta(0xC0FFEE000002ull, (9ull << 56) | 99, -80) }, 1300));
+    CHECK(collector.size() == 2);
+}
+
+void test_stale_best_handover() {
+    Collector collector(10000, 120000);
+    const uint64_t serial = (9ull << 56) | 7;
+    send(collector, 1, 1, { delta(1, serial, -40) }, 0);
+    send(collector, 2, 1, { delta(1, serial, -70) }, 5000);
+    AggregatedDevice device = devices(collector)[0];
+    CHECK(device.bestNode == 1 && device.bestRssi == -40);
+    CHECK(device.lastSeenMs == 5000);
+
+    // The best node's own report always updates, even when weaker
+    send(collector, 1, 2, { delta(1, serial, -45) }, 6000);
+    device = devices(collector)[0];
+    CHECK(device.bestNode == 1 && device.bestRssi == -45 && device.bestSeenMs == 6000);
+
+    // Once the best report is older than staleMs, a weaker fresh one takes over
+    send(collector, 2, 2, { delta(1, serial, -75) }, 16001);
+    device = devices(collector)[0];
+    CHECK(device.bestNode == 2 && device.bestRssi == -75);
+
+    // ageMs backdates the sighting
+    send(collector, 3, 1, { delta(1, serial, -90, 4000) }, 20000);
+    device = devices(collector)[0];
+    CHECK(device.bestNode == 2);
+    CHECK(device.lastSeenMs == 16001);
+}
+
+void test_sequence_gaps() {
+    Collector collector;
+    send(collector, 5, 10, {}, 0);
+    send(collector, 5, 11, { delta(1, 0, -50) }, 100);
+    send(collector, 5, 14, {}, 200);
+    send(collector, 5, 15, {}, 300);
+    const NodeStatus status = node(collector, 5);
+    CHECK(status.datagrams == 4);
+    CHECK(status.lost == 2);
+    CHECK(status.deltas == 1);
+    CHECK(status.lastSequence == 15 && status.lastHeardMs == 300);
+}
+
+void test_expiry() {
+    Collector collector(10000, 60000);
+    const uint64_t serial = (9ull << 56) | 5;
+    send(collector, 1, 1, { delta(1, serial, -50), delta(2, 0, -60) }, 0);
+    send(collector, 1, 2, { delta(2, 0, -60) }, 30000);
+    collector.expire(60001);
+    std::vector<AggregatedDevice> all = devices(collector);
+    CHECK(all.size() == 1 && all[0].address == 2);
+
+    // The expired serial no longer captures address-only reports
+    send(collector, 2, 1, { delta(1, 0, -65) }, 61000);
+    all = devices(collector);
+    CHECK(all.size() == 2);
+    for (const AggregatedDevice& device : all) CHECK(device.serial == 0);
+
+    // Ingest sweeps as well
+    send(collector, 2, 2, {}, 200000);
+    CHECK(collector.size() == 0);
+}
+
+void test_delta_tracker() {
+    DeltaTracker tracker(2, 5000);
+    CHECK(tracker.should_send(delta(1, 0, -60), 0));
+    CHECK(!tracker.should_send(delta(1, 0, -61), 100));
+    CHECK(tracker.should_send(delta(1, 0, -62), 200));
+    CHECK(tracker.should_send(delta(1, 7, -62), 300));       // Serial learned
+    CHECK(!tracker.should_send(delta(1, 7, -62), 5299));
+    CHECK(tracker.should_send(delta(1, 7, -62), 5300));      // Refresh
+    tracker.expire(20000, 10000);
+    CHECK(tracker.size() == 0);
+}
+
+// NODES services share one population: each hears every device, with its
+// own RSSI; the collector ends with one entry per device and the node
+// nearest each device as its best
+void run_nodes(const std::string& endpointText) {
+    const int NODES = 8;
+    const int DEVICES = 50;
+    Endpoint endpoint;
+    CHECK(Endpoint::parse(endpointText.c_str(), &endpoint));
+    AggregationService collector;
+    CHECK(collector.start_collector(endpoint));
+    std::vector<std::unique_ptr<AggregationService>> nodes;
+    for (int n = 1; n <= NODES; n++) {
+        nodes.emplace_back(new AggregationService());
+        CHECK(nodes.back()->start_node(static_cast<uint16_t>(n), endpoint, 20,
+            [n](std::vector<DeviceDelta>& out, int64_t) {
+                for (int d = 0; d < DEVICES; d++) {
+                    const int distance = (d % NODES + 1 == n) ? 0 : 1 + (d + n) % 5;
+                    out.push_back(delta(0xA00000000000ull + d, (9ull << 56) | static_cast<uint64_t>(d), -40 - 10 * distance));
+                }
+            }));
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    std::vector<NodeStatus> status;
+    while (std::chrono::steady_clock::now() < deadline) {
+        collector.collector().snapshot_nodes(status);
+        bool ready = status.size() == static_cast<size_t>(NODES);
+        for (const NodeStatus& s : status) ready = ready && s.datagrams >= 5;
+        if (ready) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (auto& service : nodes) service->stop();
+    collector.stop();
+
+    collector.collector().snapshot_nodes(status);
+    CHECK(status.size() == static_cast<size_t>(NODES));
+    uint64_t deltas = 0;
+    for (const NodeStatus& s : status) {
+        CHECK(s.datagrams >= 5);
+        CHECK(s.lost == 0);
+        deltas += s.deltas;
+    }
+    CHECK(deltas == static_cast<uint64_t>(NODES * DEVICES));     // Unchanged devices are not resent
+    const std::vector<AggregatedDevice> all = devices(collector.collector());
+    CHECK(all.size() == static_cast<size_t>(DEVICES));
+    for (const AggregatedDevice& device : all) {
+        const int d = static_cast<int>(device.address - 0xA00000000000ull);
+        CHECK(device.serial == ((9ull << 56) | static_cast<uint64_t>(d)));
+        CHECK(device.bestRssi == -40);
+        CHECK(device.bestNode == d % NODES + 1);
+    }
+}
+
+void test_nodes_over_udp() {
+    run_nodes("udp://127.0.0.1:" + std::to_string(20000 + getpid() % 20000));
+}
+
+void test_nodes_over_unix() {
+    const std::string path = "/tmp/niox_test_aggregator_" + std::to_string(getpid()) + ".sock";
+    run_nodes("unix://" + path);
+    CHECK(access(path.c_str(), F_OK) != 0);     // Removed on close
+}
+
+} // namespace
+
+int main() {
+    test_round_trip();
+    test_malformed();
+    test_serial_folding();
+    test_stale_best_handover();
+    test_sequence_gaps();
+    test_expiry();
+    test_delta_tracker();
+    test_nodes_over_udp();
+    test_nodes_over_unix();
+    return niox_test::finish("test_aggregator");
+}
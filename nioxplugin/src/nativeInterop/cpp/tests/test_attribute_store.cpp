@@ -0,0 +1,150 @@
+// AttributeStore: persisted GATT layouts reused across clients, rejected
+// after a firmware change or for a different unit
+
+#include "niox_attribute_store.h"
+#include "niox_test.h"
+#include <cstdio>
+#include <memory>
+#include <string>
+
+using namespace niox;
+
+namespace {
+
+const uint64_t DEVICE = 0xC0FFEE000002ull;
+const uint64_t SERIAL = 7001234;
+const char* STORE_PATH = "test_attribute_store.nxga";
+const Uuid NIOX_SERVICE = Uuid::parse("3e3d1158-5656-4a89-a3ea-ec58bff4d3c8", 36);
+const Uuid SETTINGS = Uuid::parse("3e3d0001-5656-4a89-a3ea-ec58bff4d3c8", 36);
+
+CachedAdvertisement advert(uint64_t address) {
+    CachedAdvertisement a = {};
+    a.address = address;
+    a.addressType = ADDRESS_PUBLIC;
+    a.connectable = true;
+    return a;
+}
+
+struct Peripheral {
+    std::shared_ptr<SimulatedGattBackend> backend = std::make_shared<SimulatedGattBackend>();
+    uint16_t firmware = 0;
+
+    Peripheral() {
+        set_firmware("1.4.2");
+        const uint8_t zero[] = { 0 };
+        backend->add_characteristic(DEVICE, NIOX_SERVICE, SETTINGS, GATT_PROP_READ | GATT_PROP_WRITE, zero, 1);
+    }
+
+    void set_firmware(const std::string& revision) {
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(revision.data());
+        if (firmware == 0) {
+            firmware = backend->add_characteristic(DEVICE, DEVICE_INFORMATION_SERVICE_UUID, FIRMWARE_REVISION_UUID,
+                GATT_PROP_READ, data, revision.size());
+        } else {
+            backend->set_value(DEVICE, firmware, data, revision.size());
+        }
+    }
+};
+
+// One connect and discovery by a fresh client, as on a new run of the plugin.
+// Returns whether the layout came from the store.
+bool reconnect(Peripheral& peripheral, std::shared_ptr<AttributeStore> store, uint64_t serial) {
+    GattClient client(peripheral.backend);
+    client.set_persistence(store, [serial](uint64_t) { return serial; });
+    CHECK(client.connect(advert(DEVICE), 1000) == LINK_OK);
+    std::vector<GattCharacteristic> characteristics;
+    bool cached = false;
+    CHECK(client.discover(DEVICE, characteristics, &cached) == LINK_OK);
+    CHECK(characteristics.size() == 3);
+    client.disconnect(DEVICE);
+    return cached;
+}
+
+void test_layout_reused_across_clients() {
+    std::remove(STORE_PATH);
+    Peripheral peripheral;
+    auto store = std::make_shared<AttributeStore>();
+    CHECK(store->open(STORE_PATH));
+
+    CHECK(!reconnect(peripheral, store, SERIAL));
+    CHECK(store->stats().entries == 1);
+    CHECK(reconnect(peripheral, store, SERIAL));
+    CHECK(reconnect(peripheral, store, SERIAL));
+
+    const AttributeStoreStats stats = store->stats();
+    CHECK(stats.lookups == 3);
+    CHECK(stats.misses == 1);
+    CHECK(stats.hits == 2);
+    CHECK(stats.writes == 1);
+}
+
+void test_layout_survives_reopen() {
+    Peripheral peripheral;
+    {
+        auto store = std::make_shared<AttributeStore>();
+        store->open(STORE_PATH);
+        reconnect(peripheral, store, SERIAL);
+    }
+    auto store = std::make_shared<AttributeStore>();
+    CHECK(store->open(STORE_PATH));
+    CHECK(store->stats().entries == 1);
+    CHECK(reconnect(peripheral, store, SERIAL));
+
+    std::vector<GattCharacteristic> characteristics;
+    uint64_t firmwareHash = 0;
+    CHECK(store->find(DEVICE, 0, characteristics, &firmwareHash));      // Unknown serial matches
+    CHECK(firmwareHash == fnv1a64(reinterpret_cast<const uint8_t*>("1.4.2"), 5));
+}
+
+void test_firmware_change_rejects_layout() {
+    std::remove(STORE_PATH);
+    Peripheral peripheral;
+    auto store = std::make_shared<AttributeStore>();
+    store->open(STORE_PATH);
+    reconnect(peripheral, store, SERIAL);
+
+    peripheral.set_firmware("1.5.0");
+    CHECK(!reconnect(peripheral, store, SERIAL));
+    CHECK(store->stats().stale == 1);
+    CHECK(store->stats().entries == 1);     // Replaced by the rediscovered layout
+    CHECK(reconnect(peripheral, store, SERIAL));
+}
+
+void test_other_serial_misses() {
+    std::remove(STORE_PATH);
+    Peripheral peripheral;
+    auto store = std::make_shared<AttributeStore>();
+    store->open(STORE_PATH);
+    reconnect(peripheral, store, SERIAL);
+
+    // Same address, different unit (e.g. a swapped radio module)
+    CHECK(!reconnect(peripheral, store, SERIAL + 1));
+    CHECK(store->stats().misses == 2);
+
+    store->erase(DEVICE);
+    CHECK(store->stats().entries == 0);
+}
+
+void test_malformed_file_is_empty() {
+    FILE* file = fopen(STORE_PATH, "wb");
+    fputs("not an attribute store", file);
+    fclose(file);
+    Peripheral peripheral;
+    auto store = std::make_shared<AttributeStore>();
+    CHECK(store->open(STORE_PATH));
+    CHECK(store->stats().entries == 0);
+    CHECK(!reconnect(peripheral, store, SERIAL));
+    CHECK(store->stats().entries == 1);
+    std::remove(STORE_PATH);
+}
+
+} // namespace
+
+int main() {
+    test_layout_reused_across_clients();
+    test_layout_survives_reopen();
+    test_firmware_change_rejects_layout();
+    test_other_serial_misses();
+    test_malformed_file_is_empty();
+    return niox_test::finish("test_attribute_store");
+}
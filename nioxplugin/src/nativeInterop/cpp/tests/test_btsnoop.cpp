@@ -0,0 +1,232 @@
+// btsnoop parsing: all three datalinks, legacy and extended reports,
+// fragment joining, malformed and torn records, and reading from a file
+
+#include "niox_btsnoop.h"
+#include "niox_test.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+const char* CAPTURE_PATH = "test_btsnoop.btsnoop";
+
+void put_be32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+std::vector<uint8_t> capture_header(uint32_t datalink) {
+    std::vector<uint8_t> out = { 'b', 't', 's', 'n', 'o', 'o', 'p', 0 };
+    put_be32(out, 1);
+    put_be32(out, datalink);
+    return out;
+}
+
+// One HCI packet, framed for the datalink; events go to the host, commands
+// to the controller
+void put_record(std::vector<uint8_t>& out, uint32_t datalink, const std::vector<uint8_t>& hci, int64_t us, bool command = false) {
+    std::vector<uint8_t> packet;
+    uint32_t flags = command ? 0x02 : 0x03;
+    if (datalink == BTSNOOP_DATALINK_H4) packet.push_back(command ? 0x01 : 0x04);
+    if (datalink == BTSNOOP_DATALINK_MONITOR) flags = command ? 2 : 3;     // Monitor opcodes
+    packet.insert(packet.end(), hci.begin(), hci.end());
+    put_be32(out, static_cast<uint32_t>(packet.size()));
+    put_be32(out, static_cast<uint32_t>(packet.size()));
+    put_be32(out, flags);
+    put_be32(out, 0);
+    put_be32(out, static_cast<uint32_t>(static_cast<uint64_t>(us) >> 32));
+    put_be32(out, static_cast<uint32_t>(us));
+    out.insert(out.end(), packet.begin(), packet.end());
+}
+
+std::vector<uint8_t> name_ad(const std::string& name) {
+    std::vector<uint8_t> ad(name.size() + 2);
+    ad[0] = static_cast<uint8_t>(name.size() + 1);
+    ad[1] = AD_TYPE_COMPLETE_NAME;
+    memcpy(ad.data() + 2, name.data(), name.size());
+    return ad;
+}
+
+void put_address(std::vector<uint8_t>& out, uint64_t address) {
+    for (int i = 0; i < 6; i++) out.push_back(static_cast<uint8_t>(address >> (8 * i)));
+}
+
+struct LegacyReport {
+    uint8_t type;
+    uint64_t address;
+    std::vector<uint8_t> data;
+    int8_t rssi;
+};
+
+std::vector<uint8_t> legacy_event(const std::vector<LegacyReport>& reports) {
+    std::vector<uint8_t> event = { HCI_EVENT_LE_META, 0, HCI_LE_ADVERTISING_REPORT, static_cast<uint8_t>(reports.size()) };
+    for (const LegacyReport& r : reports) {
+        event.push_back(r.type);
+        event.push_back(1);     // Random
+        put_address(event, r.address);
+        event.push_back(static_cast<uint8_t>(r.data.size()));
+        event.insert(event.end(), r.data.begin(), r.data.end());
+        event.push_back(static_cast<uint8_t>(r.rssi));
+    }
+    event[1] = static_cast<uint8_t>(event.size() - 2);
+    return event;
+}
+
+std::vector<uint8_t> extended_event(uint16_t type, uint64_t address, uint8_t sid, int8_t rssi, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> event = { HCI_EVENT_LE_META, 0, HCI_LE_EXTENDED_ADVERTISING_REPORT, 1,
+                                   static_cast<uint8_t>(type), static_cast<uint8_t>(type >> 8), 0 };
+    put_address(event, address);
+    const uint8_t rest[] = { 1, 0, sid, 127, static_cast<uint8_t>(rssi), 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    event.insert(event.end(), rest, rest + sizeof(rest));
+    event.push_back(static_cast<uint8_t>(data.size()));
+    event.insert(event.end(), data.begin(), data.end());
+    event[1] = static_cast<uint8_t>(event.size() - 2);
+    return event;
+}
+
+// A command, a two-report legacy event, a Command Complete, an extended
+// advert split over two fragments and one with no RSSI
+std::vector<uint8_t> sample_capture(uint32_t datalink, std::vector<uint8_t>* joined) {
+    std::vector<uint8_t> capture = capture_header(datalink);
+    put_record(capture, datalink, { 0x01, 0x0C, 0x03, 0, 0, 0 }, 1000, true);
+    put_record(capture, datalink, legacy_event({
+        { 0x00, 0xA1B2C3D4E5F6ull, name_ad("NIOX PRO 070401992"), -60 },
+        { 0x04, 0x112233445566ull, name_ad("X"), -70 },
+    }), 2000);
+    put_record(capture, datalink, { 0x0E, 4, 1, 0x03, 0x0C, 0 }, 2500);
+
+    *joined = name_ad("Extended device");
+    std::vector<uint8_t> manufacturer(200, 0x5A);
+    manufacturer[0] = 199;
+    manufacturer[1] = 0xFF;
+    joined->insert(joined->end(), manufacturer.begin(), manufacturer.end());
+    const std::vector<uint8_t> first(joined->begin(), joined->begin() + 100);
+    const std::vector<uint8_t> second(joined->begin() + 100, joined->end());
+    put_record(capture, datalink, extended_event(0x03 | (1 << 5), 0xDEADBEEF0001ull, 3, -55, first), 3000);
+    put_record(capture, datalink, extended_event(0x03, 0xDEADBEEF0001ull, 3, -55, second), 3100);
+    put_record(capture, datalink, extended_event(0x13, 0x0000000000AAull, 0, 127, name_ad("L")), 3200);
+    return capture;
+}
+
+void test_datalinks() {
+    for (uint32_t datalink : { BTSNOOP_DATALINK_HCI, BTSNOOP_DATALINK_H4, BTSNOOP_DATALINK_MONITOR }) {
+        std::vector<uint8_t> joined;
+        const std::vector<uint8_t> capture = sample_capture(datalink, &joined);
+        BtsnoopReader reader;
+        CHECK(reader.attach(capture.data(), capture.size()));
+        CHECK(reader.datalink() == datalink);
+
+        BtsnoopAdvertisement a;
+        CHECK(reader.next(&a));
+        CHECK(a.address == 0xA1B2C3D4E5F6ull);
+        CHECK(a.addressType == ADDRESS_RANDOM);
+        CHECK(a.connectable && a.scannable && !a.scanResponse);
+        CHECK(a.rssi == -60);
+        CHECK(a.hasName && std::string(a.name) == "NIOX PRO 070401992");
+        CHECK(a.captureUs == 2000);
+
+        CHECK(reader.next(&a));
+        CHECK(a.address == 0x112233445566ull && a.scanResponse && !a.connectable);
+        CHECK(std::string(a.name) == "X");
+
+        CHECK(reader.next(&a));
+        CHECK(a.address == 0xDEADBEEF0001ull);
+        CHECK(a.length == joined.size() && memcmp(a.data, joined.data(), joined.size()) == 0);
+        CHECK(std::string(a.name) == "Extended device");
+        CHECK(a.captureUs == 3100);
+
+        CHECK(reader.next(&a));
+        CHECK(a.address == 0xAA && a.rssi == -127);
+        CHECK(a.connectable && a.scannable && !a.scanResponse);    // Legacy ADV_IND in an extended report
+        CHECK(!reader.next(&a));
+
+        const BtsnoopStats& stats = reader.stats();
+        CHECK(stats.records == 6);
+        CHECK(stats.events == 4);
+        CHECK(stats.reports == 4);
+        CHECK(stats.extended == 2);
+        CHECK(stats.fragments == 2);
+        CHECK(stats.malformed == 0);
+
+        // rewind() starts over with fresh counters
+        reader.rewind();
+        int again = 0;
+        while (reader.next(&a)) again++;
+        CHECK(again == 4);
+        CHECK(reader.stats().records == 6);
+    }
+}
+
+void test_torn_and_malformed() {
+    std::vector<uint8_t> joined;
+    std::vector<uint8_t> capture = sample_capture(BTSNOOP_DATALINK_H4, &joined);
+    capture.resize(capture.size() - 3);     // Capture cut off mid-record
+    BtsnoopReader reader;
+    CHECK(reader.attach(capture.data(), capture.size()));
+    BtsnoopAdvertisement a;
+    int count = 0;
+    while (reader.next(&a)) count++;
+    CHECK(count == 3);
+
+    // A report claiming more data than its event holds
+    std::vector<uint8_t> bad = capture_header(BTSNOOP_DATALINK_H4);
+    std::vector<uint8_t> event = legacy_event({ { 0x00, 0x1, name_ad("A"), -40 }, { 0x00, 0x2, name_ad("B"), -40 } });
+    event[4 + 8 + 3 + 10] = 60;            // Second report's data length
+    put_record(bad, BTSNOOP_DATALINK_H4, event, 1000);
+    CHECK(reader.attach(bad.data(), bad.size()));
+    CHECK(reader.next(&a) && a.address == 0x1);
+    CHECK(!reader.next(&a));
+    CHECK(reader.stats().malformed == 1);
+}
+
+void test_rejected_files() {
+    std::vector<uint8_t> capture = capture_header(BTSNOOP_DATALINK_H4);
+    BtsnoopReader reader;
+    CHECK(reader.attach(capture.data(), capture.size()));      // Empty capture is fine
+    BtsnoopAdvertisement a;
+    CHECK(!reader.next(&a));
+
+    std::vector<uint8_t> unsupported = capture_header(2002);
+    CHECK(!reader.attach(unsupported.data(), unsupported.size()));
+    std::vector<uint8_t> version = capture_header(BTSNOOP_DATALINK_H4);
+    version[11] = 2;
+    CHECK(!reader.attach(version.data(), version.size()));
+    const uint8_t text[] = "not a capture at all";
+    CHECK(!reader.attach(text, sizeof(text)));
+    CHECK(!reader.open("no_such_capture.btsnoop"));
+}
+
+void test_open_file() {
+    std::vector<uint8_t> joined;
+    const std::vector<uint8_t> capture = sample_capture(BTSNOOP_DATALINK_MONITOR, &joined);
+    FILE* file = fopen(CAPTURE_PATH, "wb");
+    fwrite(capture.data(), 1, capture.size(), file);
+    fclose(file);
+
+    BtsnoopReader reader;
+    CHECK(reader.open(CAPTURE_PATH));
+    BtsnoopAdvertisement a;
+    int count = 0;
+    while (reader.next(&a)) {
+        const AdvertisementEvent event = a.event(1700000000000ll);
+        CHECK(event.address == a.address && event.length == a.length && event.data == a.data);
+        CHECK(event.timestampMs == 1700000000000ll);
+        CHECK((event.name != nullptr) == a.hasName);
+        count++;
+    }
+    CHECK(count == 4);
+    std::remove(CAPTURE_PATH);
+}
+
+} // namespace
+
+int main() {
+    test_datalinks();
+    test_torn_and_malformed();
+    test_rejected_files();
+    test_open_file();
+    return niox_test::finish("test_btsnoop");
+}
@@ -0,0 +1,250 @@
+// ConnectionPool: hits and misses, dead-link reconnect, LRU and idle
+// eviction, concurrent acquires and shutdown while a connect is running
+
+#include "niox_test.h"
+#include "niox_connection_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+// Stand-in for the radio: records every hook call and tracks which links are up
+struct FakeLinks {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<uint64_t> connects;
+    std::vector<uint64_t> disconnects;
+    std::set<uint64_t> up;
+    std::set<uint64_t> dead;            // Links that dropped while pooled
+    uint64_t failing = 0;
+    int delayMs = 0;
+    bool gated = false;                 // connect() blocks until the gate opens
+    int inConnect = 0;
+    int doubleConnects = 0;             // connect() on a link that is already up
+
+    PoolHooks hooks() {
+        PoolHooks h;
+        h.connect = [this](uint64_t address) {
+            std::unique_lock<std::mutex> lock(mutex);
+            connects.push_back(address);
+            inConnect++;
+            cv.notify_all();
+            cv.wait(lock, [this]() { return !gated; });
+            inConnect--;
+            if (delayMs > 0) {
+                lock.unlock();
+                std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+                lock.lock();
+            }
+            if (address == failing) return 133;
+            if (up.count(address) && !dead.count(address)) doubleConnects++;
+            up.insert(address);
+            dead.erase(address);
+            return 0;
+        };
+        h.disconnect = [this](uint64_t address) {
+            std::lock_guard<std::mutex> lock(mutex);
+            disconnects.push_back(address);
+            up.erase(address);
+        };
+        h.alive = [this](uint64_t address) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return up.count(address) > 0 && dead.count(address) == 0;
+        };
+        return h;
+    }
+
+    std::vector<uint64_t> disconnected() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return disconnects;
+    }
+
+    size_t connect_count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return connects.size();
+    }
+};
+
+void test_hit_miss_reconnect() {
+    FakeLinks links;
+    ConnectionPool pool;
+    pool.start(4, 60000, links.hooks());
+    bool reused = true;
+    CHECK(pool.acquire(0xA, &reused) == 0 && !reused);
+    pool.release(0xA);
+    CHECK(pool.acquire(0xA, &reused) == 0 && reused);
+    pool.release(0xA);
+
+    links.dead.insert(0xA);                         // Dropped while pooled
+    CHECK(pool.acquire(0xA, &reused) == 0 && !reused);
+    pool.release(0xA);
+
+    links.failing = 0xB;
+    CHECK(pool.acquire(0xB, &reused) == 133);
+    pool.release(0xB);                              // Not leased: ignored
+
+    PoolStats stats = pool.stats();
+    CHECK(stats.acquires == 4 && stats.hits == 1 && stats.misses == 2);
+    CHECK(stats.reconnects == 1 && stats.failures == 1 && stats.setups == 2);
+    CHECK(stats.open == 1 && stats.leased == 0);
+    CHECK((links.connects == std::vector<uint64_t>{ 0xA, 0xA, 0xB }));
+    CHECK(links.disconnects.empty());
+
+    pool.shutdown();
+    CHECK((links.disconnects == std::vector<uint64_t>{ 0xA }));
+    CHECK(!pool.running() && pool.stats().open == 0);
+}
+
+void test_lru_eviction() {
+    FakeLinks links;
+    ConnectionPool pool;
+    pool.start(2, 60000, links.hooks());
+    pool.acquire(0xA);
+    pool.acquire(0xB);
+    pool.release(0xA);
+    pool.release(0xB);
+    CHECK(pool.acquire(0xA) == 0);                  // A is now the most recent
+    pool.release(0xA);
+
+    CHECK(pool.acquire(0xC) == 0);                  // Third session: B goes
+    CHECK((links.disconnected() == std::vector<uint64_t>{ 0xB }));
+    CHECK(pool.stats().evictedLru == 1 && pool.stats().open == 2);
+
+    // Leased sessions are never evicted, only idle ones once released
+    pool.acquire(0xA);
+    CHECK(pool.acquire(0xD) == 0);
+    CHECK(pool.stats().open == 3 && links.disconnected().size() == 1);
+    pool.release(0xC);
+    CHECK((links.disconnected() == std::vector<uint64_t>{ 0xB, 0xC }));
+    pool.release(0xA);                              // Back within capacity
+    CHECK(links.disconnected().size() == 2);
+    CHECK(pool.stats().evictedLru == 2 && pool.stats().open == 2);
+}
+
+void test_idle_sweep() {
+    FakeLinks links;
+    ConnectionPool pool;
+    pool.start(4, 50, links.hooks());
+    pool.acquire(0xA);
+    pool.acquire(0xB);
+    pool.release(0xA);                              // B stays leased
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (links.disconnected().empty() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK((links.disconnected() == std::vector<uint64_t>{ 0xA }));
+    PoolStats stats = pool.stats();
+    CHECK(stats.evictedIdle == 1 && stats.open == 1 && stats.leased == 1);
+
+    pool.release(0xB);
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    pool.evict_idle();
+    CHECK((links.disconnected() == std::vector<uint64_t>{ 0xA, 0xB }));
+    CHECK(pool.stats().open == 0);
+}
+
+// Eight callers want the same device at once: one connects, the rest wait
+// for it and share the session
+void test_concurrent_acquire() {
+    FakeLinks links;
+    links.delayMs = 20;
+    ConnectionPool pool;
+    pool.start(4, 60000, links.hooks());
+    std::atomic<int> failed(0);
+    std::atomic<int> reusedCount(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++) {
+        threads.emplace_back([&]() {
+            bool reused = false;
+            if (pool.acquire(0xA, &reused) != 0) failed++;
+            if (reused) reusedCount++;
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    CHECK(failed == 0 && reusedCount == 7);
+    CHECK(links.connect_count() == 1);
+    PoolStats stats = pool.stats();
+    CHECK(stats.misses == 1 && stats.hits == 7 && stats.open == 1 && stats.leased == 1);
+    for (int i = 0; i < 8; i++) pool.release(0xA);
+    CHECK(pool.stats().leased == 0 && pool.stats().open == 1);
+}
+
+// Many callers over more devices than the pool holds: every link opened is
+// closed exactly once, and an eviction never closes a link reconnected
+// while its disconnect was pending
+void test_concurrent_churn() {
+    FakeLinks links;
+    links.delayMs = 1;
+    ConnectionPool pool;
+    pool.start(2, 60000, links.hooks());
+    std::atomic<int> failed(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 100; i++) {
+                const uint64_t address = 0x10 + static_cast<uint64_t>((t * 7 + i * 3) % 5);
+                if (pool.acquire(address) != 0) {
+                    failed++;
+                    continue;
+                }
+                pool.release(address);
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    CHECK(failed == 0);
+    PoolStats stats = pool.stats();
+    CHECK(stats.acquires == 400 && stats.hits + stats.misses == 400);
+    CHECK(stats.open <= 2 && stats.leased == 0);
+    pool.shutdown();
+    CHECK(links.connects.size() == links.disconnects.size());
+    CHECK(links.up.empty() && links.doubleConnects == 0);
+}
+
+// Shutdown while a connect is in flight: the acquire fails and the link it
+// opened is closed rather than leaked
+void test_shutdown_during_connect() {
+    FakeLinks links;
+    ConnectionPool pool;
+    pool.start(4, 60000, links.hooks());
+    pool.acquire(0xB);
+    links.gated = true;
+    int result = 0;
+    std::thread caller([&]() { result = pool.acquire(0xA); });
+    {
+        std::unique_lock<std::mutex> lock(links.mutex);
+        links.cv.wait(lock, [&]() { return links.inConnect == 1; });
+    }
+    pool.shutdown();
+    {
+        std::lock_guard<std::mutex> lock(links.mutex);
+        links.gated = false;
+    }
+    links.cv.notify_all();
+    caller.join();
+    CHECK(result == -1);
+    CHECK((links.disconnects == std::vector<uint64_t>{ 0xB, 0xA }));
+    CHECK(links.up.empty() && pool.stats().open == 0);
+}
+
+} // namespace
+
+int main() {
+    test_hit_miss_reconnect();
+    test_lru_eviction();
+    test_idle_sweep();
+    test_concurrent_acquire();
+    test_concurrent_churn();
+    test_shutdown_during_connect();
+    return niox_test::finish("test_connection_pool");
+}
@@ -0,0 +1,108 @@
+// DeviceStats: interval, receive ratio and scan window of a lossy
+// advertiser, and RSSI moments against a two-pass reference
+
+#include "niox_test.h"
+#include "niox_device_stats.h"
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+double variance(const std::vector<int>& values) {
+    double mean = 0.0;
+    for (int v : values) mean += v;
+    mean /= values.size();
+    double m2 = 0.0;
+    for (int v : values) m2 += (v - mean) * (v - mean);
+    return m2 / (values.size() - 1);
+}
+
+// A 100 ms advertiser with the spec's 0..10 ms advDelay, 30% of its adverts lost
+void test_lossy_advertiser() {
+    std::mt19937 rng(73);
+    DeviceStats stats = DeviceStats();
+    std::vector<int> received;
+    const int64_t start = 500000;
+    for (int i = 0; i < 2000; i++) {
+        const int64_t t = start + i * 100 + static_cast<int64_t>(rng() % 11);
+        const int rssi = -70 + static_cast<int>(rng() % 21);
+        if (rng() % 10 < 3) continue;
+        update_device_stats(stats, rssi, t);
+        received.push_back(rssi);
+    }
+
+    CHECK(stats.adverts == received.size());
+    CHECK(stats.gaps == stats.adverts - 1);
+    CHECK(std::fabs(stats.intervalMs - 100.0f) < 5.0f);
+    CHECK(std::fabs(stats.gapMeanMs - 100.0f / 0.7f) < 5.0f);
+    CHECK(std::fabs(stats.receive_ratio() - 0.7) < 0.03);
+
+    // 95%: 1 - 0.3^3 > 0.95 > 1 - 0.3^2, so three intervals
+    const int64_t window = scan_window_ms(stats, 0.95);
+    CHECK(window == static_cast<int64_t>(std::ceil(3 * stats.intervalMs)));
+    CHECK(scan_window_ms(stats, 0.0) == 0);
+    CHECK(scan_window_ms(stats, 0.999) > window);
+
+    CHECK(std::fabs(stats.rssi_variance() - variance(received)) < 1e-9);
+    CHECK(stats.rssiMin == -70 && stats.rssiMax == -50);
+}
+
+void test_gap_bounds() {
+    DeviceStats stats = DeviceStats();
+    update_device_stats(stats, -60, 1000);
+    CHECK(scan_window_ms(stats, 0.95) == -1);
+    update_device_stats(stats, -60, 1005);              // Scan response, not an interval
+    update_device_stats(stats, -60, 1005 + 20000);      // Scan was stopped
+    CHECK(stats.gaps == 0 && stats.intervalMs == 0.0f && stats.receive_ratio() == 0.0);
+    update_device_stats(stats, -60, 1005 + 20200);
+    update_device_stats(stats, -60, 1005 + 20400);
+    CHECK(stats.gaps == 2 && stats.intervalMs == 200.0f);
+    CHECK(stats.receive_ratio() == 1.0 && scan_window_ms(stats, 0.95) == 200);
+    CHECK(stats.adverts == 5 && stats.firstSeenMs == 1000 && stats.lastSeenMs == 1005 + 20400);
+
+    // A much shorter gap resets an estimate that had absorbed losses
+    update_device_stats(stats, -60, 1005 + 20450);
+    CHECK(stats.intervalMs == 50.0f);
+}
+
+void test_merge() {
+    std::mt19937 rng(72);
+    DeviceStats a = DeviceStats();
+    DeviceStats b = DeviceStats();
+    DeviceStats all = DeviceStats();
+    std::vector<int> values;
+    for (int i = 0; i < 300; i++) {
+        const int rssi = -90 + static_cast<int>(rng() % 50);
+        const int64_t t = 10000 + i * 100;
+        update_device_stats(i < 120 ? a : b, rssi, t);
+        update_device_stats(all, rssi, t);
+        values.push_back(rssi);
+    }
+    DeviceStats merged = b;
+    merge_device_stats(merged, a);
+    CHECK(merged.adverts == 300 && merged.gaps == 298);
+    CHECK(merged.firstSeenMs == 10000 && merged.lastSeenMs == 10000 + 299 * 100);
+    CHECK(merged.rssiMin == all.rssiMin && merged.rssiMax == all.rssiMax);
+    CHECK(std::fabs(merged.rssiMean - all.rssiMean) < 1e-9);
+    CHECK(std::fabs(merged.rssi_variance() - variance(values)) < 1e-9);
+    CHECK(std::fabs(merged.intervalMs - 100.0f) < 0.01f && merged.receive_ratio() == 1.0);
+
+    DeviceStats empty = DeviceStats();
+    merge_device_stats(empty, a);
+    CHECK(empty.adverts == a.adverts && empty.rssiM2 == a.rssiM2);
+    merge_device_stats(a, DeviceStats());
+    CHECK(a.adverts == 120);
+}
+
+} // namespace
+
+int main() {
+    test_lossy_advertiser();
+    test_gap_bounds();
+    test_merge();
+    return niox_test::finish("test_device_stats");
+}
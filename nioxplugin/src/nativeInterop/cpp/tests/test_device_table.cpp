@@ -0,0 +1,260 @@
+// DeviceTable: SIMD filter kernels against a scalar reference, stable RSSI
+// sort, query ordering and paging, epoch rebasing, stats folding and
+// change sequencing
+
+#include "niox_test.h"
+#include "niox_device_table.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+const DeviceTable::Path PATHS[] = { DeviceTable::PATH_AUTO, DeviceTable::PATH_SCALAR, DeviceTable::PATH_SSE2,
+                                    DeviceTable::PATH_AVX2 };
+
+bool path_available(DeviceTable::Path path) {
+#if NIOX_HAVE_SSE2
+    return path != DeviceTable::PATH_AVX2 || cpu_has_avx2();
+#else
+    return path == DeviceTable::PATH_AUTO || path == DeviceTable::PATH_SCALAR;
+#endif
+}
+
+void fill(DeviceTable& table, size_t count, std::mt19937& rng) {
+    table.clear();
+    const int64_t start = 1000000;
+    for (size_t i = 0; i < count; i++) {
+        const int rssi = -100 + static_cast<int>(rng() % 80);
+        const int64_t seen = start + static_cast<int64_t>(rng() % 60000);
+        table.upsert(0xC00000000000ull + i, nullptr, rssi, seen, rng() % 16 == 0 ? 0 : (rng() & 0x7C));
+    }
+}
+
+std::vector<uint32_t> reference(const DeviceTable& table, const DeviceFilter& f) {
+    std::vector<uint32_t> out;
+    for (uint32_t slot = 0; slot < table.size(); slot++) {
+        if (table.rssi(slot) >= f.minRssi && table.last_seen_ms(slot) >= f.seenSinceMs &&
+            (table.flags(slot) & f.requireFlags) == f.requireFlags &&
+            (f.anyFlags == 0 || (table.flags(slot) & f.anyFlags) != 0)) {
+            out.push_back(slot);
+        }
+    }
+    return out;
+}
+
+// Every size up to 40 covers each tail length of the 4- and 8-lane kernels
+void test_filter_kernels() {
+    std::mt19937 rng(54);
+    DeviceTable table;
+    std::vector<size_t> sizes;
+    for (size_t n = 0; n <= 40; n++) sizes.push_back(n);
+    sizes.push_back(1001);
+    sizes.push_back(1003);
+    sizes.push_back(1007);
+    for (size_t size : sizes) {
+        fill(table, size, rng);
+        for (int round = 0; round < 8; round++) {
+            DeviceFilter f;
+            f.minRssi = round == 0 ? INT32_MIN : -100 + static_cast<int>(rng() % 90);
+            f.seenSinceMs = round == 1 ? INT64_MIN : 1000000 + static_cast<int64_t>(rng() % 70000) - 5000;
+            f.requireFlags = round % 3 == 0 ? 0 : (rng() & 0x0C);
+            f.anyFlags = round % 2 == 0 ? 0 : (rng() & 0x70);
+            const std::vector<uint32_t> expected = reference(table, f);
+            for (DeviceTable::Path path : PATHS) {
+                if (!path_available(path)) continue;
+                table.set_path(path);
+                std::vector<uint32_t> out = { 12345 };     // Results are appended
+                table.filter(f, out);
+                CHECK(out.size() == expected.size() + 1);
+                CHECK(out[0] == 12345);
+                CHECK(std::equal(expected.begin(), expected.end(), out.begin() + 1));
+            }
+        }
+    }
+
+    // A cutoff past what the epoch offsets can hold matches nothing
+    fill(table, 9, rng);
+    DeviceFilter future = { INT32_MIN, INT64_MAX, 0, 0 };
+    std::vector<uint32_t> out;
+    table.filter(future, out);
+    CHECK(out.empty());
+}
+
+void test_sort_by_rssi_is_stable() {
+    std::mt19937 rng(7);
+    DeviceTable table;
+    for (uint32_t i = 0; i < 500; i++) table.upsert(i + 1, nullptr, -90 + static_cast<int>(rng() % 12) * 5, 1000);
+    table.upsert(9001, nullptr, 300, 1000);             // Clamped to 127
+    table.upsert(9002, nullptr, -400, 1000);            // Clamped to -128
+    table.upsert(9003, nullptr, 127, 1000);
+
+    std::vector<uint32_t> slots;
+    for (uint32_t slot = 0; slot < table.size(); slot++) slots.push_back(slot);
+    std::shuffle(slots.begin(), slots.end(), rng);
+    std::vector<uint32_t> expected = slots;
+    std::stable_sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) {
+        const int ra = std::max(-128, std::min(127, table.rssi(a)));
+        const int rb = std::max(-128, std::min(127, table.rssi(b)));
+        return ra > rb;
+    });
+    table.sort_by_rssi(slots);
+    CHECK(slots == expected);
+    CHECK(table.address(slots.back()) == 9002);
+}
+
+void test_query_order_and_paging() {
+    DeviceTable table;
+    // Serials 3, 1, none, 2; last seen 400, 100, 300, 200
+    table.upsert(1, "NIOX PRO 003", -50, 400);
+    table.upsert(2, "NIOX PRO 001", -60, 100);
+    table.upsert(3, "Other", -40, 300);
+    table.upsert(4, "NIOX PRO 002", -60, 200);
+    const DeviceFilter all = { INT32_MIN, INT64_MIN, 0, 0 };
+    std::vector<uint32_t> page;
+
+    CHECK(table.query(all, DEVICE_SORT_SERIAL, 0, 0, page) == 4);
+    CHECK(page.size() == 4);
+    CHECK(table.address(page[0]) == 2 && table.address(page[1]) == 4 && table.address(page[2]) == 1);
+    CHECK(table.address(page[3]) == 3);         // No serial: last
+
+    CHECK(table.query(all, DEVICE_SORT_LAST_SEEN, 1, 2, page) == 4);
+    CHECK(page.size() == 2);
+    CHECK(table.address(page[0]) == 3 && table.address(page[1]) == 4);
+
+    CHECK(table.query(all, DEVICE_SORT_RSSI, 2, 10, page) == 4);
+    CHECK(page.size() == 2);
+    CHECK(table.address(page[0]) == 2 && table.address(page[1]) == 4);    // Ties keep slot order
+
+    CHECK(table.query(all, DEVICE_SORT_NONE, 4, 1, page) == 4);
+    CHECK(page.empty());
+
+    const DeviceFilter niox = { INT32_MIN, INT64_MIN, 0, DEVICE_FLAG_NIOX };
+    CHECK(table.query(niox, DEVICE_SORT_NONE, 0, 0, page) == 3);
+    CHECK(table.find_by_serial(table.serial(page[1])) == static_cast<int32_t>(page[1]));
+}
+
+// Offsets are int32 ms from the epoch; far-apart timestamps move it and
+// the absolute times, recency filters and ordering stay the same
+void test_rebase() {
+    const int64_t start = 5000;
+    const int64_t later = start + (int64_t(1) << 30) + 1000;
+    DeviceTable table;
+    table.upsert(1, nullptr, -50, start);
+    table.upsert(2, nullptr, -50, start + 100000);
+    table.upsert(3, nullptr, -50, later);
+    CHECK(table.last_seen_ms(0) == start);
+    CHECK(table.last_seen_ms(1) == start + 100000);
+    CHECK(table.last_seen_ms(2) == later);
+
+    std::vector<uint32_t> out;
+    DeviceFilter recent = { INT32_MIN, start + 50000, 0, 0 };
+    table.filter(recent, out);
+    CHECK(out.size() == 2 && out[0] == 1 && out[1] == 2);
+
+    table.upsert(1, nullptr, -50, later + 10);
+    std::vector<uint32_t> page;
+    const DeviceFilter all = { INT32_MIN, INT64_MIN, 0, 0 };
+    table.query(all, DEVICE_SORT_LAST_SEEN, 0, 0, page);
+    CHECK(page.size() == 3 && table.address(page[0]) == 1 && table.address(page[1]) == 3);
+    CHECK(table.last_seen_ms(0) == later + 10);
+
+    // A second rebase pushes the oldest record past the int32 range; it
+    // saturates to the oldest representable time instead of wrapping
+    const int64_t much_later = later + (int64_t(1) << 31);
+    table.upsert(4, nullptr, -50, much_later);
+    CHECK(table.last_seen_ms(3) == much_later);
+    CHECK(table.last_seen_ms(0) == later + 10);
+    CHECK(table.last_seen_ms(1) == much_later - (int64_t(1) << 29) + INT32_MIN);
+}
+
+// A resolved private address folds its advert statistics into the
+// identity's record; re-keying keeps them as they are
+void test_fold_merges_stats() {
+    const uint64_t identity = 0x001122334455ull;
+    const uint64_t rpa = 0x4A0000000001ull;
+    const uint64_t rpa2 = 0x4A0000000002ull;
+    const uint64_t fresh = 0x000000000077ull;
+    DeviceTable table;
+    for (int i = 0; i < 10; i++) table.upsert(identity, nullptr, -60 - i, 1000 + i * 100);
+    for (int i = 0; i < 6; i++) table.upsert(rpa, nullptr, -40 - i, 500 + i * 100);
+    table.upsert(rpa2, nullptr, -80, 2000);
+
+    const int32_t slot = table.fold(rpa, identity);
+    CHECK(slot != DeviceTable::NO_SLOT && table.address(slot) == identity && table.size() == 2);
+    const DeviceStats& stats = table.stats(slot);
+    CHECK(stats.adverts == 16 && stats.gaps == 14);
+    CHECK(stats.firstSeenMs == 500 && stats.lastSeenMs == 1900);
+    CHECK(stats.rssiMin == -69 && stats.rssiMax == -40);
+    double mean = 0.0;
+    for (int i = 0; i < 10; i++) mean += -60 - i;
+    for (int i = 0; i < 6; i++) mean += -40 - i;
+    mean /= 16;
+    double m2 = 0.0;
+    for (int i = 0; i < 10; i++) m2 += (-60 - i - mean) * (-60 - i - mean);
+    for (int i = 0; i < 6; i++) m2 += (-40 - i - mean) * (-40 - i - mean);
+    CHECK(std::fabs(stats.rssiMean - mean) < 1e-9 && std::fabs(stats.rssiM2 - m2) < 1e-9);
+    CHECK(stats.intervalMs == 100.0f);
+
+    const int32_t moved = table.fold(rpa2, fresh);
+    CHECK(moved != DeviceTable::NO_SLOT && table.address(moved) == fresh);
+    CHECK(table.stats(moved).adverts == 1 && table.stats(moved).rssiMean == -80.0);
+}
+
+// Change polling: adverts in the same millisecond and adverts delivered
+// late (older than the newest already seen) are all picked up once
+void test_update_sequence() {
+    DeviceTable table;
+    table.upsert(1, nullptr, -50, 1000);
+    table.upsert(2, nullptr, -50, 1000);
+    std::vector<uint32_t> changed;
+    table.updated_since(0, changed);
+    CHECK(changed.size() == 2);
+    uint64_t seen = table.sequence();
+
+    table.upsert(3, nullptr, -60, 1000);            // Same millisecond as the last poll
+    table.upsert(1, nullptr, -55, 900);             // Held advert, older than the newest
+    changed.clear();
+    table.updated_since(seen, changed);
+    CHECK(changed.size() == 2 && table.address(changed[0]) == 1 && table.address(changed[1]) == 3);
+    seen = table.sequence();
+
+    table.set_flag(1, DEVICE_FLAG_FLEET, false);    // No change, no update
+    changed.clear();
+    table.updated_since(seen, changed);
+    CHECK(changed.empty());
+    table.set_flag(1, DEVICE_FLAG_FLEET, true);
+    table.updated_since(seen, changed);
+    CHECK(changed.size() == 1 && table.address(changed[0]) == 2);
+    seen = table.sequence();
+
+    // Compaction carries the stamps with their records
+    table.fold(1, 2);
+    changed.clear();
+    table.updated_since(seen, changed);
+    CHECK(table.size() == 2 && changed.size() == 1 && table.address(changed[0]) == 2);
+
+    seen = table.sequence();
+    table.clear();
+    CHECK(table.sequence() == seen);
+    table.upsert(4, nullptr, -50, 2000);
+    changed.clear();
+    table.updated_since(seen, changed);
+    CHECK(changed.size() == 1);
+}
+
+} // namespace
+
+int main() {
+    test_filter_kernels();
+    test_sort_by_rssi_is_stable();
+    test_query_order_and_paging();
+    test_rebase();
+    test_fold_merges_stats();
+    test_update_sequence();
+    return niox_test::finish("test_device_table");
+}
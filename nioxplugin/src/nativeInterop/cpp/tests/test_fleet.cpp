@@ -0,0 +1,101 @@
+// Fleet: perfect hash build over many sizes, manifest parsing, and the
+// table niox_fleet_gen compiled in from test_fleet.txt
+
+#include "niox_fleet.h"
+#include "niox_test.h"
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+uint64_t serial_of(const char* digits) {
+    return parse_serial(digits, strlen(digits));
+}
+
+std::vector<uint64_t> random_serials(size_t count, std::mt19937_64& rng) {
+    std::vector<uint64_t> serials;
+    for (size_t i = 0; i < count; i++) serials.push_back(pack_serial(rng() % 100000000, 8));
+    return serials;
+}
+
+void test_build_sizes() {
+    std::mt19937_64 rng(71);
+    for (size_t count : { 1, 2, 3, 10, 97, 1000, 20000 }) {
+        const std::vector<uint64_t> serials = random_serials(count, rng);
+        const std::unordered_set<uint64_t> members(serials.begin(), serials.end());
+        Fleet fleet;
+        CHECK(fleet.build(serials));
+        CHECK(fleet.size() == members.size());
+        const FleetTable table = fleet.table();
+        CHECK(fleet_table_valid(table));
+        CHECK(table.buckets == (table.size + 2) / 3);
+        for (uint64_t serial : serials) CHECK(table.contains(serial));
+        size_t falsePositives = 0;
+        for (int i = 0; i < 20000; i++) {
+            const uint64_t probe = pack_serial(rng() % 100000000, 8);
+            if (table.contains(probe) != (members.count(probe) != 0)) falsePositives++;
+        }
+        CHECK(falsePositives == 0);
+    }
+}
+
+void test_build_edge_cases() {
+    Fleet fleet;
+    CHECK(fleet.build({ serial_of("07000123"), serial_of("07000123"), serial_of("7000123") }));
+    CHECK(fleet.size() == 2);       // Duplicate dropped; leading zero is a different unit
+    CHECK(fleet.table().contains(serial_of("7000123")));
+    CHECK(!fleet.table().contains(0));
+
+    CHECK(!fleet.build({ serial_of("07000123"), 0 }));
+    CHECK(fleet.size() == 2);       // Previous table kept
+
+    CHECK(fleet.build({}));
+    CHECK(fleet.size() == 0);
+    CHECK(!fleet.table().contains(serial_of("07000123")));
+}
+
+void test_manifest_parsing() {
+    std::vector<uint64_t> serials;
+    CHECK(parse_fleet_manifest("07000123\r\nNIOX PRO 07000124 , 07000125;\n# comment, 999\n\n", serials) == 3);
+    CHECK(serials.size() == 3);
+    CHECK(serials[0] == serial_of("07000123"));
+    CHECK(serials[1] == serial_of("07000124"));
+    CHECK(serials[2] == serial_of("07000125"));
+
+    serials.clear();
+    CHECK(parse_fleet_manifest("07000123\nNIOX-7000\n", serials) == -1);
+    CHECK(parse_fleet_manifest(nullptr, serials) == -1);
+    serials.clear();
+    CHECK(parse_fleet_manifest("", serials) == 0);
+}
+
+void test_compiled_fleet() {
+    static_assert(COMPILED_FLEET.size == 6, "test_fleet.txt lists 6 serials");
+    static_assert(COMPILED_FLEET.contains((9ull << 56) | 70401992), "leading zero kept");
+    static_assert(!COMPILED_FLEET.contains((8ull << 56) | 99999999), "not in the manifest");
+    for (const char* serial : { "070401992", "70401992", "07000123", "07000124", "07000125", "12345678" }) {
+        CHECK(COMPILED_FLEET.contains(serial_of(serial)));
+    }
+    CHECK(!COMPILED_FLEET.contains(serial_of("07000126")));
+
+    // The generated header matches a runtime build over the same serials
+    std::vector<uint64_t> serials;
+    for (uint32_t i = 0; i < COMPILED_FLEET.size; i++) serials.push_back(COMPILED_FLEET.keys[i]);
+    Fleet fleet;
+    CHECK(fleet.build(serials));
+    CHECK(fleet.table().seed == COMPILED_FLEET.seed);
+    for (uint32_t i = 0; i < COMPILED_FLEET.size; i++) CHECK(fleet.table().keys[i] == COMPILED_FLEET.keys[i]);
+}
+
+} // namespace
+
+int main() {
+    test_build_sizes();
+    test_build_edge_cases();
+    test_manifest_parsing();
+    test_compiled_fleet();
+    return niox_test::finish("test_fleet");
+}
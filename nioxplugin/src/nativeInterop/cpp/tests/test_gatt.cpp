@@ -0,0 +1,174 @@
+// GattClient over SimulatedGattBackend: attribute and value caching and
+// every path that invalidates them
+
+#include "niox_gatt.h"
+#include "niox_test.h"
+#include <memory>
+#include <string>
+
+using namespace niox;
+
+namespace {
+
+const uint64_t DEVICE = 0xC0FFEE000001ull;
+const Uuid NIOX_SERVICE = Uuid::parse("3e3d1158-5656-4a89-a3ea-ec58bff4d3c8", 36);
+const Uuid MODEL_NUMBER = Uuid::from16(0x2A24);
+const Uuid SETTINGS = Uuid::parse("3e3d0001-5656-4a89-a3ea-ec58bff4d3c8", 36);
+const Uuid MEASUREMENT = Uuid::parse("3e3d0002-5656-4a89-a3ea-ec58bff4d3c8", 36);
+
+CachedAdvertisement advert(uint64_t address) {
+    CachedAdvertisement a = {};
+    a.address = address;
+    a.addressType = ADDRESS_PUBLIC;
+    a.connectable = true;
+    return a;
+}
+
+struct Fixture {
+    std::shared_ptr<SimulatedGattBackend> backend = std::make_shared<SimulatedGattBackend>();
+    GattClient client{ backend };
+    uint16_t model = 0;
+    uint16_t settings = 0;
+    uint16_t measurement = 0;
+
+    Fixture() {
+        const std::string text = "NIOX PRO";
+        const uint8_t zero[] = { 0 };
+        model = backend->add_characteristic(DEVICE, DEVICE_INFORMATION_SERVICE_UUID, MODEL_NUMBER, GATT_PROP_READ,
+            reinterpret_cast<const uint8_t*>(text.data()), text.size());
+        settings = backend->add_characteristic(DEVICE, NIOX_SERVICE, SETTINGS, GATT_PROP_READ | GATT_PROP_WRITE, zero, 1);
+        measurement = backend->add_characteristic(DEVICE, NIOX_SERVICE, MEASUREMENT, GATT_PROP_NOTIFY, nullptr, 0);
+    }
+};
+
+void test_discovery_cached_across_links() {
+    Fixture f;
+    CHECK(f.client.connect(advert(DEVICE), 1000) == LINK_OK);
+    std::vector<GattCharacteristic> characteristics;
+    bool cached = true;
+    CHECK(f.client.discover(DEVICE, characteristics, &cached) == LINK_OK);
+    CHECK(!cached);
+    CHECK(characteristics.size() == 4);     // Service Changed + 3
+    const uint64_t trips = f.backend->round_trips();
+
+    f.client.disconnect(DEVICE);
+    CHECK(f.client.connect(advert(DEVICE), 1000) == LINK_OK);
+    CHECK(f.client.discover(DEVICE, characteristics, &cached) == LINK_OK);
+    CHECK(cached);
+    // Only the Service Changed re-subscription on connect went on air
+    CHECK(f.backend->round_trips() == trips + 1);
+    CHECK(f.client.stats().discoveries == 1);
+    CHECK(f.client.stats().cachedDiscoveries == 1);
+}
+
+void test_static_values_cached() {
+    Fixture f;
+    f.client.connect(advert(DEVICE), 1000);
+    std::vector<uint8_t> value;
+    bool cached = true;
+    CHECK(f.client.read(DEVICE, DEVICE_INFORMATION_SERVICE_UUID, MODEL_NUMBER, value, &cached) == LINK_OK);
+    CHECK(!cached);
+    CHECK(std::string(value.begin(), value.end()) == "NIOX PRO");
+    const uint64_t trips = f.backend->round_trips();
+    CHECK(f.client.read(DEVICE, DEVICE_INFORMATION_SERVICE_UUID, MODEL_NUMBER, value, &cached) == LINK_OK);
+    CHECK(cached);
+    CHECK(f.backend->round_trips() == trips);
+
+    // Writable characteristics always go to the device
+    const uint8_t one[] = { 1 };
+    CHECK(f.client.read(DEVICE, NIOX_SERVICE, SETTINGS, value, &cached) == LINK_OK);
+    CHECK(f.client.write(DEVICE, NIOX_SERVICE, SETTINGS, one, 1, true) == LINK_OK);
+    CHECK(f.client.read(DEVICE, NIOX_SERVICE, SETTINGS, value, &cached) == LINK_OK);
+    CHECK(!cached);
+    CHECK(value.size() == 1 && value[0] == 1);
+}
+
+void test_service_changed_indication_invalidates() {
+    Fixture f;
+    f.client.connect(advert(DEVICE), 1000);
+    std::vector<uint8_t> value;
+    f.client.read(DEVICE, DEVICE_INFORMATION_SERVICE_UUID, MODEL_NUMBER, value);
+
+    // Firmware update moves every handle; the device indicates Service Changed
+    f.backend->change_services(DEVICE);
+    CHECK(f.client.stats().invalidations == 1);
+
+    bool cached = true;
+    CHECK(f.client.read(DEVICE, DEVICE_INFORMATION_SERVICE_UUID, MODEL_NUMBER, value, &cached) == LINK_OK);
+    CHECK(!cached);
+    CHECK(std::string(value.begin(), value.end()) == "NIOX PRO");
+    CHECK(f.client.stats().discoveries == 2);
+
+    GattCharacteristic c;
+    CHECK(f.client.find(DEVICE, DEVICE_INFORMATION_SERVICE_UUID, MODEL_NUMBER, &c) == LINK_OK);
+    CHECK(c.handle != f.model);             // Rediscovered at its new handle
+}
+
+void test_service_changed_rearmed_after_reconnect() {
+    Fixture f;
+    f.client.connect(advert(DEVICE), 1000);
+    std::vector<GattCharacteristic> characteristics;
+    f.client.discover(DEVICE, characteristics);
+    f.client.disconnect(DEVICE);
+
+    // Subscriptions end with the link; connect must subscribe again or a
+    // firmware update between links would leave a stale cache
+    f.client.connect(advert(DEVICE), 1000);
+    f.backend->change_services(DEVICE);
+    CHECK(f.client.stats().invalidations == 1);
+}
+
+void test_partial_range_keeps_other_values() {
+    Fixture f;
+    f.client.connect(advert(DEVICE), 1000);
+    std::vector<uint8_t> value;
+    f.client.read(DEVICE, DEVICE_INFORMATION_SERVICE_UUID, MODEL_NUMBER, value);
+
+    // A range that does not cover the model number keeps its value cached
+    f.client.on_services_changed(DEVICE, static_cast<uint16_t>(f.model + 1), 0xFFFF);
+    const uint64_t radioReads = f.client.stats().radioReads;
+    bool cached = false;
+    CHECK(f.client.read(DEVICE, DEVICE_INFORMATION_SERVICE_UUID, MODEL_NUMBER, value, &cached) == LINK_OK);
+    CHECK(cached);
+    CHECK(f.client.stats().radioReads == radioReads);
+
+    // A range covering it drops the value
+    f.client.on_services_changed(DEVICE, f.model, f.model);
+    CHECK(f.client.read(DEVICE, DEVICE_INFORMATION_SERVICE_UUID, MODEL_NUMBER, value, &cached) == LINK_OK);
+    CHECK(!cached);
+}
+
+void test_notifications_and_errors() {
+    Fixture f;
+    std::vector<uint8_t> value;
+    CHECK(f.client.read(DEVICE, NIOX_SERVICE, SETTINGS, value) == GATT_NOT_CONNECTED);
+
+    f.client.connect(advert(DEVICE), 1000);
+    int received = 0;
+    CHECK(f.client.subscribe(DEVICE, NIOX_SERVICE, MEASUREMENT,
+        [&](uint64_t, uint16_t, const uint8_t* data, size_t length) { if (length == 2 && data[1] == 0x42) received++; }) == LINK_OK);
+    const uint8_t sample[] = { 0x00, 0x42 };
+    CHECK(f.backend->notify(DEVICE, f.measurement, sample, sizeof(sample)));
+    CHECK(received == 1);
+
+    CHECK(f.client.subscribe(DEVICE, NIOX_SERVICE, MEASUREMENT, GattValueHandler()) == LINK_OK);
+    CHECK(!f.backend->notify(DEVICE, f.measurement, sample, sizeof(sample)));
+    CHECK(received == 1);
+
+    CHECK(f.client.read(DEVICE, NIOX_SERVICE, MEASUREMENT, value) == GATT_NOT_PERMITTED);
+    CHECK(f.client.subscribe(DEVICE, NIOX_SERVICE, SETTINGS,
+        [](uint64_t, uint16_t, const uint8_t*, size_t) {}) == GATT_NOT_PERMITTED);
+    CHECK(f.client.read(DEVICE, NIOX_SERVICE, Uuid::from16(0x2A00), value) == GATT_NOT_FOUND);
+}
+
+} // namespace
+
+int main() {
+    test_discovery_cached_across_links();
+    test_static_values_cached();
+    test_service_changed_indication_invalidates();
+    test_service_changed_rearmed_after_reconnect();
+    test_partial_range_keeps_other_values();
+    test_notifications_and_errors();
+    return niox_test::finish("test_gatt");
+}
@@ -0,0 +1,138 @@
+// Direct connect from cached advertisements through MockLinkBackend
+
+#include "niox_link.h"
+#include "niox_test.h"
+#include <chrono>
+
+using namespace niox;
+
+namespace {
+
+AdvertisementEvent make_event(uint64_t address, bool connectable, bool scanResponse, const uint8_t* data, size_t length) {
+    AdvertisementEvent event;
+    event.address = address;
+    event.addressType = ADDRESS_RANDOM;
+    event.connectable = connectable;
+    event.scannable = !scanResponse;
+    event.scanResponse = scanResponse;
+    event.rssi = -55;
+    event.timestampMs = 1000;
+    event.name = nullptr;
+    event.data = data;
+    event.length = length;
+    return event;
+}
+
+void test_cache_keeps_primary_advertisement() {
+    AdvertisementCache cache;
+    const uint8_t primary[] = { 0x02, 0x01, 0x06 };
+    const uint8_t response[] = { 0x05, 0x09, 'N', 'I', 'O', 'X' };
+    cache.store(make_event(0xC01, true, false, primary, sizeof(primary)));
+    cache.store(make_event(0xC01, false, true, response, sizeof(response)));
+
+    const CachedAdvertisement* entry = cache.find(0xC01);
+    CHECK(entry != nullptr);
+    if (entry == nullptr) return;
+    CHECK(entry->connectable);                      // Not taken from the scan response
+    CHECK(entry->addressType == ADDRESS_RANDOM);
+    CHECK(entry->length == sizeof(primary));
+    CHECK(memcmp(entry->data, primary, sizeof(primary)) == 0);
+    CHECK(cache.find(0xC02) == nullptr);
+
+    // A scan response heard first is kept until the advertisement arrives
+    cache.store(make_event(0xC02, false, true, response, sizeof(response)));
+    CHECK(cache.find(0xC02)->length == sizeof(response));
+    cache.store(make_event(0xC02, true, false, primary, sizeof(primary)));
+    CHECK(cache.find(0xC02)->length == sizeof(primary));
+    CHECK(cache.find(0xC02)->connectable);
+}
+
+void test_oversized_advertisement_truncated() {
+    AdvertisementCache cache;
+    uint8_t big[400];
+    for (size_t i = 0; i < sizeof(big); i++) big[i] = static_cast<uint8_t>(i);
+    cache.store(make_event(0xC03, true, false, big, sizeof(big)));
+    CHECK(cache.find(0xC03)->length == MAX_CACHED_ADVERTISEMENT);
+}
+
+// Rotated private addresses age out; public and static ones stay
+void test_cache_evicts_private() {
+    AdvertisementCache cache;
+    const uint64_t resolvable = 0x4A0000000001ull;      // Bits 47..46 = 01
+    const uint64_t nonResolvable = 0x0A0000000002ull;   // 00
+    const uint64_t staticRandom = 0xCA0000000003ull;    // 11
+    AdvertisementEvent event = make_event(resolvable, true, false, nullptr, 0);
+    cache.store(event);
+    event.address = nonResolvable;
+    cache.store(event);
+    event.address = staticRandom;
+    cache.store(event);
+    event.address = 0x001122334455ull;
+    event.addressType = ADDRESS_PUBLIC;
+    cache.store(event);
+    event.address = 0x4A0000000005ull;
+    event.addressType = ADDRESS_RANDOM;
+    event.timestampMs = 5000;
+    cache.store(event);
+
+    CHECK(cache.evict_private(2000) == 2);
+    CHECK(cache.size() == 3);
+    CHECK(cache.find(resolvable) == nullptr);
+    CHECK(cache.find(nonResolvable) == nullptr);
+    CHECK(cache.find(staticRandom) != nullptr);
+    CHECK(cache.find(0x001122334455ull) != nullptr);
+    CHECK(cache.find(0x4A0000000005ull) != nullptr);   // Heard since the cutoff
+}
+
+void test_connect_results() {
+    AdvertisementCache cache;
+    cache.store(make_event(0xA1, true, false, nullptr, 0));
+    cache.store(make_event(0xA2, false, false, nullptr, 0));
+    cache.store(make_event(0xA3, true, false, nullptr, 0));
+
+    MockLinkBackend link;
+    CHECK(link.connect(*cache.find(0xA1), 1000) == LINK_OK);
+    CHECK(link.is_connected(0xA1));
+    CHECK(link.connect(*cache.find(0xA1), 1000) == LINK_OK);   // Already linked
+    CHECK(link.connect_count() == 1);
+
+    CHECK(link.connect(*cache.find(0xA2), 1000) == LINK_NOT_CONNECTABLE);
+
+    link.set_unreachable(0xA3, true);
+    CHECK(link.connect(*cache.find(0xA3), 1000) == LINK_ERROR);
+    CHECK(!link.is_connected(0xA3));
+    link.set_unreachable(0xA3, false);
+    CHECK(link.connect(*cache.find(0xA3), 1000) == LINK_OK);
+
+    link.disconnect(0xA1);
+    CHECK(!link.is_connected(0xA1));
+    link.disconnect_all();
+    CHECK(!link.is_connected(0xA3));
+}
+
+void test_connect_time_is_link_setup() {
+    AdvertisementCache cache;
+    cache.store(make_event(0xB1, true, false, nullptr, 0));
+
+    // Scan-to-connected is the link setup alone: no rescan in between
+    MockLinkBackend link(20);
+    const auto start = std::chrono::steady_clock::now();
+    CHECK(link.connect(*cache.find(0xB1), 1000) == LINK_OK);
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    CHECK(elapsed >= 20);
+    CHECK(elapsed < 500);
+
+    MockLinkBackend slow(50);
+    CHECK(slow.connect(*cache.find(0xB1), 10) == LINK_TIMEOUT);
+}
+
+} // namespace
+
+int main() {
+    test_cache_keeps_primary_advertisement();
+    test_oversized_advertisement_truncated();
+    test_cache_evicts_private();
+    test_connect_results();
+    test_connect_time_is_link_setup();
+    return niox_test::finish("test_link");
+}
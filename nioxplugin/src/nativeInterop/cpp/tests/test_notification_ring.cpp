@@ -0,0 +1,196 @@
+// NotificationRing: skipped ring ends (with and without a padding record),
+// drops when full, peek/release across the wrap, and several producers
+// against one consumer with byte-exact payloads
+
+#include "niox_notification_ring.h"
+#include "niox_test.h"
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+const size_t HEADER = 24;       // Ring record header
+
+// Payload of length bytes, each derived from seed and position
+std::vector<uint8_t> payload(uint32_t seed, size_t length) {
+    std::vector<uint8_t> data(length);
+    for (size_t i = 0; i < length; i++) data[i] = static_cast<uint8_t>(seed * 31 + i * 7);
+    return data;
+}
+
+bool matches(const NotificationView& view, uint32_t seed, size_t length) {
+    const std::vector<uint8_t> expected = payload(seed, length);
+    return view.length == length && (length == 0 || memcmp(view.data, expected.data(), length) == 0);
+}
+
+// Consume everything currently in the ring
+size_t drain(NotificationRing& ring) {
+    NotificationView views[64];
+    size_t total = 0;
+    while (size_t n = ring.peek(views, 64)) total += n;
+    ring.release();
+    return total;
+}
+
+// 16 bytes left at the end: less than a header, so no padding record is
+// written and the reader skips the gap by position alone
+void test_skip_smaller_than_header() {
+    NotificationRing ring(256);
+    CHECK(ring.capacity() == 256);
+    for (int i = 0; i < 10; i++) CHECK(ring.push(1, 0x10, nullptr, 0));     // 10 x 24 bytes
+    CHECK(drain(ring) == 10);
+    const std::vector<uint8_t> data = payload(1, 8);
+    CHECK(ring.push(2, 0x11, data.data(), data.size()));
+    CHECK(ring.stats().pendingBytes == 16 + 32);                        // Gap, then the record at 0
+    NotificationView view;
+    CHECK(ring.peek(&view, 1) == 1);
+    CHECK(view.address == 2 && view.handle == 0x11 && matches(view, 1, 8));
+    ring.release();
+    CHECK(ring.stats().pendingBytes == 0);
+    CHECK(ring.peek(&view, 1) == 0);
+}
+
+// 56 bytes left, a 64-byte record: the gap gets a padding header
+void test_padding_record() {
+    NotificationRing ring(256);
+    const std::vector<uint8_t> filler = payload(2, 200 - HEADER);
+    CHECK(ring.push(1, 1, filler.data(), filler.size()));               // 200 bytes
+    CHECK(drain(ring) == 1);
+    const std::vector<uint8_t> data = payload(3, 40);
+    CHECK(ring.push(2, 2, data.data(), data.size()));                   // 64 bytes, at 0
+    CHECK(ring.stats().pendingBytes == 56 + 64);
+    NotificationView views[4];
+    CHECK(ring.peek(views, 4) == 1);
+    CHECK(views[0].address == 2 && matches(views[0], 3, 40));
+    ring.release();
+    CHECK(ring.stats().pendingBytes == 0);
+}
+
+void test_drops_when_full() {
+    NotificationRing ring(256);
+    const std::vector<uint8_t> data = payload(4, 40);                   // 64-byte records
+    size_t accepted = 0;
+    for (int i = 0; i < 6; i++) accepted += ring.push(1, 1, data.data(), data.size()) ? 1 : 0;
+    CHECK(accepted == 4);
+    NotificationRingStats stats = ring.stats();
+    CHECK(stats.notifications == 4 && stats.dropped == 2 && stats.droppedBytes == 80);
+    CHECK(stats.pendingBytes == 256 && stats.peakBytes == 256);
+
+    // Oversized payloads never fit
+    std::vector<uint8_t> huge(70000, 1);
+    CHECK(!ring.push(1, 1, huge.data(), huge.size()));
+
+    // Peeked but unreleased records still hold their space
+    NotificationView views[8];
+    CHECK(ring.peek(views, 2) == 2);
+    CHECK(!ring.push(1, 1, data.data(), data.size()));
+    ring.release();
+    CHECK(ring.push(1, 1, data.data(), data.size()));
+    CHECK(ring.stats().dropped == 4);
+    CHECK(drain(ring) == 3);
+    stats = ring.stats();
+    CHECK(stats.delivered == 5);
+}
+
+// Variable-length records around a small ring many times; batches that
+// straddle the wrap come back in order with intact payloads
+void test_peek_release_across_wrap() {
+    NotificationRing ring(256);
+    uint32_t pushed = 0;
+    uint32_t consumed = 0;
+    bool ok = true;
+    NotificationView views[3];
+    for (int round = 0; round < 1000; round++) {
+        while (ring.push(pushed, static_cast<uint16_t>(pushed), payload(pushed, pushed % 61).data(), pushed % 61)) pushed++;
+        // Two peeks before one release: the second continues after the first
+        const size_t first = ring.peek(views, round % 2 + 1);
+        for (size_t i = 0; i < first; i++) ok = ok && views[i].address == consumed + i && matches(views[i], consumed + static_cast<uint32_t>(i), (consumed + i) % 61);
+        consumed += static_cast<uint32_t>(first);
+        const size_t second = ring.peek(views, 2);
+        for (size_t i = 0; i < second; i++) ok = ok && views[i].address == consumed + i && matches(views[i], consumed + static_cast<uint32_t>(i), (consumed + i) % 61);
+        consumed += static_cast<uint32_t>(second);
+        ring.release();
+    }
+    CHECK(ok);
+    CHECK(pushed > 2000);
+    CHECK(consumed + drain(ring) == pushed);
+    const NotificationRingStats stats = ring.stats();
+    CHECK(stats.notifications == pushed && stats.delivered == pushed);
+    CHECK(stats.pendingBytes == 0);
+}
+
+// Four producers against one consumer: every accepted notification arrives
+// once, per producer in push order, with its exact bytes
+void test_multiple_producers() {
+    const int PRODUCERS = 4;
+    const uint32_t PER_PRODUCER = 50000;
+    NotificationRing ring(16 * 1024);
+    std::atomic<int> running(PRODUCERS);
+    std::atomic<uint64_t> attempts(0);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&, p]() {
+            uint8_t data[64];
+            for (uint32_t i = 0; i < PER_PRODUCER; i++) {
+                const size_t length = 4 + (i * 13 + static_cast<uint32_t>(p)) % 40;
+                memcpy(data, &i, 4);
+                for (size_t b = 4; b < length; b++) data[b] = static_cast<uint8_t>(i + b + static_cast<size_t>(p));
+                ring.push(static_cast<uint64_t>(p), static_cast<uint16_t>(length), data, length);
+                attempts++;
+            }
+            running--;
+        });
+    }
+
+    std::vector<int64_t> last(PRODUCERS, -1);
+    uint64_t received = 0;
+    bool ok = true;
+    NotificationView views[32];
+    for (;;) {
+        const bool done = running.load() == 0;
+        const size_t n = ring.peek(views, 32);
+        for (size_t v = 0; v < n; v++) {
+            const NotificationView& view = views[v];
+            const int p = static_cast<int>(view.address);
+            if (p < 0 || p >= PRODUCERS || view.length < 4 || view.handle != view.length) {
+                ok = false;
+                continue;
+            }
+            uint32_t i;
+            memcpy(&i, view.data, 4);
+            ok = ok && static_cast<int64_t>(i) > last[p];
+            last[p] = i;
+            for (size_t b = 4; b < view.length; b++) ok = ok && view.data[b] == static_cast<uint8_t>(i + b + static_cast<size_t>(p));
+        }
+        received += n;
+        ring.release();
+        if (n == 0) {
+            if (done) break;
+            std::this_thread::yield();
+        }
+    }
+    for (std::thread& producer : producers) producer.join();
+    CHECK(ok);
+    const NotificationRingStats stats = ring.stats();
+    CHECK(attempts.load() == PRODUCERS * PER_PRODUCER);
+    CHECK(stats.notifications + stats.dropped == attempts.load());
+    CHECK(stats.notifications == received);
+    CHECK(stats.delivered == received);
+    CHECK(stats.pendingBytes == 0);
+    CHECK(stats.peakBytes <= ring.capacity());
+}
+
+} // namespace
+
+int main() {
+    test_skip_smaller_than_header();
+    test_padding_record();
+    test_drops_when_full();
+    test_peek_release_across_wrap();
+    test_multiple_producers();
+    return niox_test::finish("test_notification_ring");
+}
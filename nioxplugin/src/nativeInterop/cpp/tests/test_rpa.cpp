@@ -0,0 +1,179 @@
+// Identity resolution against the Core spec sample data, resolver caching
+// and key changes, and folding rotated addresses in the DeviceTable
+
+#include "niox_device_table.h"
+#include "niox_rpa.h"
+#include "niox_test.h"
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+// Core spec Vol 3 Part H D.7 (ah random address hash function)
+const uint8_t SPEC_IRK[IRK_SIZE] = {
+    0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05, 0x34, 0x10, 0x10, 0xa6, 0x0a, 0x39, 0x7d, 0x9b,
+};
+const uint32_t SPEC_PRAND = 0x708194;
+const uint32_t SPEC_HASH = 0x0dfbaa;
+const uint64_t SPEC_RPA = (static_cast<uint64_t>(SPEC_PRAND) << 24) | SPEC_HASH;
+const uint64_t IDENTITY = 0xC0FFEE000069ull;
+
+uint64_t make_rpa(const uint8_t irk[IRK_SIZE], std::mt19937_64& rng) {
+    const uint32_t prand = static_cast<uint32_t>((rng() & 0x3FFFFF) | 0x400000);
+    return (static_cast<uint64_t>(prand) << 24) | rpa_hash(irk, prand);
+}
+
+void test_aes_known_answer() {
+    // FIPS-197 Appendix C.1
+    uint8_t key[16];
+    uint8_t block[16];
+    for (int i = 0; i < 16; i++) {
+        key[i] = static_cast<uint8_t>(i);
+        block[i] = static_cast<uint8_t>(i * 0x11);
+    }
+    const uint8_t expected[16] = {
+        0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a,
+    };
+    uint8_t hardware[16];
+    uint8_t portable[16];
+    Aes128(key).encrypt(block, hardware, 1, true);
+    Aes128(key).encrypt(block, portable, 1, false);
+    CHECK(memcmp(hardware, expected, 16) == 0);
+    CHECK(memcmp(portable, expected, 16) == 0);
+}
+
+void test_spec_sample() {
+    CHECK(is_resolvable_private(SPEC_RPA));
+    CHECK(rpa_hash(SPEC_IRK, SPEC_PRAND) == SPEC_HASH);
+
+    IdentityResolver resolver;
+    resolver.add_key(IDENTITY, SPEC_IRK);
+    CHECK(resolver.resolve(SPEC_RPA) == IDENTITY);
+    CHECK(resolver.resolve(SPEC_RPA ^ 1) == (SPEC_RPA ^ 1));               // Hash mismatch
+    CHECK(resolver.resolve(0xC01122334455ull) == 0xC01122334455ull);       // Static random, not an RPA
+    CHECK(resolver.resolve(SPEC_RPA) == IDENTITY);
+
+    const IdentityResolverStats stats = resolver.stats();
+    CHECK(stats.lookups == 3);
+    CHECK(stats.cacheHits == 1);
+    CHECK(stats.resolved == 1);
+    CHECK(stats.unresolved == 1);
+}
+
+void test_batch_matches_portable() {
+    std::mt19937_64 rng(69);
+    const size_t keyCount = 12;
+    std::vector<std::vector<uint8_t>> irks(keyCount, std::vector<uint8_t>(IRK_SIZE));
+    IdentityResolver hardware;
+    IdentityResolver portable;
+    portable.set_hardware(false);
+    for (size_t k = 0; k < keyCount; k++) {
+        for (uint8_t& b : irks[k]) b = static_cast<uint8_t>(rng());
+        hardware.add_key(IDENTITY + k, irks[k].data());
+        portable.add_key(IDENTITY + k, irks[k].data());
+    }
+
+    // Mixed batch: RPAs of every key, RPAs of unknown keys, other addresses
+    std::vector<uint64_t> addresses;
+    std::vector<uint64_t> expected;
+    for (size_t i = 0; i < 300; i++) {
+        if (i % 3 == 0) {
+            addresses.push_back(make_rpa(irks[i % keyCount].data(), rng));
+            expected.push_back(IDENTITY + i % keyCount);
+        } else {
+            const uint64_t other = i % 3 == 1 ? ((rng() & 0x3FFFFFFFFFFFull) | 0x400000000000ull) : (0xC00000000000ull | i);
+            addresses.push_back(other);
+            expected.push_back(other);
+        }
+    }
+    std::vector<uint64_t> viaPortable = addresses;
+    CHECK(hardware.resolve(addresses.data(), addresses.size()) == 100);
+    CHECK(portable.resolve(viaPortable.data(), viaPortable.size()) == 100);
+    CHECK(addresses == expected);
+    CHECK(viaPortable == expected);
+}
+
+void test_key_changes_update_cache() {
+    IdentityResolver resolver;
+    resolver.add_key(IDENTITY + 1, SPEC_IRK);
+    CHECK(resolver.resolve(SPEC_RPA) == IDENTITY + 1);
+    CHECK(resolver.remove_key(IDENTITY + 1));
+    CHECK(!resolver.remove_key(IDENTITY + 1));
+    CHECK(resolver.stats().cached == 0);
+
+    // A failure cached before the key was known is retried after add_key
+    uint8_t other[IRK_SIZE] = { 1 };
+    resolver.add_key(IDENTITY + 2, other);
+    CHECK(resolver.resolve(SPEC_RPA) == SPEC_RPA);
+    resolver.add_key(IDENTITY, SPEC_IRK);
+    CHECK(resolver.resolve(SPEC_RPA) == IDENTITY);
+}
+
+void test_cache_capacity() {
+    IdentityResolver resolver(64);
+    resolver.add_key(IDENTITY, SPEC_IRK);
+    std::mt19937_64 rng(7);
+    for (int i = 0; i < 1000; i++) resolver.resolve(make_rpa(SPEC_IRK, rng));
+    CHECK(resolver.stats().cached <= 64);
+    CHECK(resolver.stats().resolved == 1000);
+}
+
+void test_table_evicts_private_rows() {
+    DeviceTable table;
+    for (int i = 0; i < 100; i++) {
+        table.upsert(0x400000000000ull + i, i % 2 ? "NIOX PRO 07000123" : nullptr, -60, 1000 + i, DEVICE_FLAG_PRIVATE);
+    }
+    table.upsert(0xC01122334455ull, "Other", -50, 500);
+    CHECK(table.size() == 101);
+    CHECK(table.evict(DEVICE_FLAG_PRIVATE, 1050) == 50);
+    CHECK(table.size() == 51);
+    CHECK(table.find_by_address(0xC01122334455ull) >= 0);     // Old, but not private
+    CHECK(table.find_by_address(0x400000000000ull + 49) == DeviceTable::NO_SLOT);
+    const int32_t slot = table.find_by_address(0x400000000000ull + 51);
+    CHECK(slot >= 0 && std::string(table.name(slot)) == "NIOX PRO 07000123");
+    CHECK(table.evict(DEVICE_FLAG_PRIVATE, 0) == 0);
+}
+
+void test_table_folds_resolved_rows() {
+    DeviceTable table;
+    const uint64_t first = 0x400000000001ull;
+    const uint64_t second = 0x400000000002ull;
+    table.upsert(first, "NIOX PRO 07000123", -70, 1000, DEVICE_FLAG_PRIVATE);
+    table.upsert(second, nullptr, -55, 2000, DEVICE_FLAG_PRIVATE);
+
+    // The first RPA becomes the identity's row
+    int32_t slot = table.fold(first, IDENTITY);
+    CHECK(slot >= 0);
+    CHECK(table.address(slot) == IDENTITY);
+    CHECK(table.radio_address(slot) == first);
+    CHECK((table.flags(slot) & DEVICE_FLAG_RESOLVED) != 0);
+    CHECK((table.flags(slot) & DEVICE_FLAG_PRIVATE) == 0);
+    CHECK(table.find_by_address(first) == DeviceTable::NO_SLOT);
+
+    // The newer second RPA merges into it: its RSSI and radio address win,
+    // the name and serial stay
+    slot = table.fold(second, IDENTITY);
+    CHECK(table.size() == 1);
+    CHECK(table.rssi(slot) == -55);
+    CHECK(table.radio_address(slot) == second);
+    CHECK(std::string(table.name(slot)) == "NIOX PRO 07000123");
+    CHECK(table.find_by_serial(table.serial(slot)) == slot);
+    CHECK(table.fold(second, IDENTITY) == DeviceTable::NO_SLOT);
+}
+
+} // namespace
+
+int main() {
+    test_aes_known_answer();
+    test_spec_sample();
+    test_batch_matches_portable();
+    test_key_changes_update_cache();
+    test_cache_capacity();
+    test_table_evicts_private_rows();
+    test_table_folds_resolved_rows();
+    return niox_test::finish("test_rpa");
+}
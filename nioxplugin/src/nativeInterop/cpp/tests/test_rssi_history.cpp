@@ -0,0 +1,163 @@
+// RssiHistory: raw / 1 s / 10 s stitching without overlap, bucket close,
+// LRU block reuse and eviction, and rebasing that keeps buckets aligned
+
+#include "niox_rssi_history.h"
+#include "niox_test.h"
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+std::vector<RssiPoint> series(const RssiHistory& history, uint64_t address, int64_t sinceMs = INT64_MIN) {
+    std::vector<RssiPoint> points(history.export_series(address, sinceMs, nullptr, 0));
+    const size_t written = history.export_series(address, sinceMs, points.data(), points.size());
+    points.resize(written);
+    return points;
+}
+
+// 60 s of samples every 100 ms into 1 s of raw samples, 20 s of 1 s
+// buckets and 300 s of 10 s buckets
+void test_stitching() {
+    const RssiHistoryConfig config = { 4, { 10, 20, 30 } };
+    RssiHistory history(config);
+    const int64_t start = 1000000;
+    for (int i = 0; i < 600; i++) history.add(7, -40 - i % 30, start + i * 100);
+
+    const std::vector<RssiPoint> points = series(history, 7);
+    CHECK(!points.empty());
+    uint32_t samples = 0;
+    int64_t end = INT64_MIN;
+    int32_t previousWidth = 10000;
+    for (const RssiPoint& p : points) {
+        CHECK(p.timeMs >= end);                     // No overlap
+        CHECK(p.widthMs <= previousWidth);          // Coarse, then finer
+        CHECK(p.min <= p.mean && p.mean <= p.max);
+        end = p.timeMs + (p.widthMs > 0 ? p.widthMs : 1);
+        previousWidth = p.widthMs;
+        samples += p.count;
+    }
+    CHECK(samples == 600);                          // Every sample exactly once
+    CHECK(points.front().timeMs == start && points.front().widthMs == 10000);
+    CHECK(points.back().timeMs == start + 59900 && points.back().widthMs == 0);
+    size_t raw = 0;
+    size_t seconds = 0;
+    for (const RssiPoint& p : points) {
+        raw += p.widthMs == 0 ? 1 : 0;
+        seconds += p.widthMs == 1000 ? 1 : 0;
+    }
+    CHECK(raw == 10);
+    CHECK(seconds == 19);       // 40..58 s; 10 s buckets end where the 1 s ring begins
+    CHECK(series(history, 8).empty());
+
+    // sinceMs starts mid-history; export truncated to capacity still counts all
+    const std::vector<RssiPoint> recent = series(history, 7, start + 55000);
+    CHECK(!recent.empty() && recent.front().timeMs >= start + 55000);
+    RssiPoint two[2];
+    CHECK(history.export_series(7, INT64_MIN, two, 2) == points.size());
+    CHECK(two[1].timeMs == points[1].timeMs);
+}
+
+void test_bucket_close() {
+    const RssiHistoryConfig config = { 1, { 2, 10, 10 } };
+    RssiHistory history(config);
+    history.add(1, -50, 0);
+    history.add(1, -60, 400);
+    history.add(1, -70, 900);
+    std::vector<RssiPoint> points = series(history, 1);
+    // No bucket is closed yet: the open 1 s bucket starts before the raw
+    // ring and covers all three samples
+    CHECK(points.size() == 1);
+    CHECK(points[0].timeMs == 0 && points[0].widthMs == 1000 && points[0].count == 3);
+
+    history.add(1, -40, 1000);
+    points = series(history, 1);
+    CHECK(points.size() == 2);
+    CHECK(points[0].timeMs == 0 && points[0].widthMs == 1000);
+    CHECK(points[0].min == -70 && points[0].max == -50 && points[0].mean == -60 && points[0].count == 3);
+    CHECK(points[1].timeMs == 1000 && points[1].widthMs == 0 && points[1].mean == -40 && points[1].count == 1);
+
+    // Rounded to nearest: (-41 - 42) / 2 = -41.5 -> -42
+    RssiHistory rounding(config);
+    rounding.add(2, -41, 0);
+    rounding.add(2, -42, 10);
+    rounding.add(2, -10, 5000);
+    rounding.add(2, -10, 5001);
+    points = series(rounding, 2);
+    CHECK(points.size() >= 1 && points[0].widthMs == 1000 && points[0].mean == -42);
+}
+
+void test_lru_reuse_and_eviction() {
+    const RssiHistoryConfig config = { 3, { 8, 4, 4 } };
+    RssiHistory history(config);
+    CHECK(history.bytes() >= 3 * 16 * 8);
+    history.add(0xA, -50, 0);
+    history.add(0xB, -51, 10);
+    history.add(0xC, -52, 20);
+    history.add(0xA, -53, 30);                      // A is now the most recent
+    CHECK(history.devices() == 3 && history.evictions() == 0);
+
+    history.add(0xD, -60, 40);                      // Takes B's block
+    CHECK(history.devices() == 3 && history.evictions() == 1);
+    CHECK(series(history, 0xB).empty());
+    std::vector<RssiPoint> d = series(history, 0xD);
+    CHECK(d.size() == 1 && d[0].mean == -60 && d[0].count == 1);   // Nothing left over from B
+    CHECK(series(history, 0xA).size() == 2);
+
+    for (uint64_t address = 0x10; address < 0x20; address++) history.add(address, -70, 100 + static_cast<int64_t>(address));
+    CHECK(history.devices() == 3);
+    CHECK(history.evictions() == 17);
+    std::vector<uint64_t> addresses;
+    history.addresses(addresses);
+    CHECK(addresses.size() == 3);
+    for (uint64_t address : addresses) CHECK(address >= 0x1D && address <= 0x1F);
+
+    history.clear();
+    CHECK(history.devices() == 0 && history.evictions() == 0);
+    RssiHistory none(RssiHistoryConfig{ 0, { 8, 4, 4 } });
+    none.add(1, -50, 0);
+    CHECK(none.devices() == 0);
+}
+
+// Time offsets are uint32 ms; past ~24 days the epoch moves by whole 10 s
+// buckets, so buckets keep their boundaries and recent times stay exact
+void test_rebase_keeps_alignment() {
+    const RssiHistoryConfig config = { 2, { 4, 8, 8 } };
+    RssiHistory history(config);
+    const int64_t start = 123457;
+    const int64_t beforeMs = start + (int64_t(1) << 31) - 1000;
+    const int64_t afterMs = start + (int64_t(1) << 31) + 5000;
+    history.add(1, -50, start);
+    history.add(2, -60, beforeMs);
+    for (int i = 0; i < 30; i++) history.add(1, -55, afterMs + i * 500);
+
+    // Device 2 was heard just before the rebase; its open 10 s bucket still
+    // starts on the original boundary and holds its one sample
+    const std::vector<RssiPoint> before = series(history, 2);
+    CHECK(before.size() == 1 && before[0].widthMs == 10000 && before[0].count == 1);
+    CHECK((before[0].timeMs - start) % 10000 == 0);
+    CHECK(before[0].timeMs <= beforeMs && beforeMs < before[0].timeMs + 10000);
+
+    // Skip device 1's pre-rebase sample, clamped to the new epoch
+    const std::vector<RssiPoint> after = series(history, 1, afterMs - 10000);
+    CHECK(!after.empty());
+    bool aligned = true;
+    for (const RssiPoint& p : after) {
+        if (p.widthMs > 0) aligned = aligned && (p.timeMs - start) % p.widthMs == 0;
+    }
+    CHECK(aligned);
+    CHECK(after.back().widthMs == 0 && after.back().timeMs == afterMs + 29 * 500);
+    size_t samples = 0;
+    for (const RssiPoint& p : after) samples += p.count;
+    CHECK(samples == 30);
+}
+
+} // namespace
+
+int main() {
+    test_stitching();
+    test_bucket_close();
+    test_lru_reuse_and_eviction();
+    test_rebase_keeps_alignment();
+    return niox_test::finish("test_rssi_history");
+}
@@ -0,0 +1,207 @@
+// Scan log: writer/reader round trip, torn last block cut on reopen,
+// time-range scans, and files that are not logs left untouched
+
+#include "niox_scan_log.h"
+#include "niox_test.h"
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+const char* LOG_PATH = "test_scan_log.nxsl";
+
+std::vector<ScanLogRecord> make_records(size_t count, int64_t startMs, uint32_t seed) {
+    std::vector<ScanLogRecord> records(count);
+    uint32_t x = seed;
+    int64_t time = startMs;
+    for (ScanLogRecord& record : records) {
+        x = x * 1664525u + 1013904223u;
+        record.address = 0xC00000000000ull + (x >> 8) % 37;
+        time += (x >> 4) % 50;
+        record.timeMs = (x & 0x1F) == 0 ? time - 30 : time;    // Now and then out of order
+        record.rssi = static_cast<int8_t>(-100 + static_cast<int>((x >> 16) % 90));
+        record.flags = static_cast<uint8_t>(x >> 24);
+    }
+    return records;
+}
+
+bool same(const ScanLogRecord& a, const ScanLogRecord& b) {
+    return a.address == b.address && a.timeMs == b.timeMs && a.rssi == b.rssi && a.flags == b.flags;
+}
+
+std::vector<ScanLogRecord> read_all(const std::string& path) {
+    std::vector<ScanLogRecord> out;
+    ScanLogReader reader;
+    if (!reader.open(path)) return out;
+    reader.scan(INT64_MIN, INT64_MAX, [&](const ScanLogRecord& record) { out.push_back(record); });
+    return out;
+}
+
+// One session: every record appended lands in one block when stop() writes it
+bool write_session(const std::vector<ScanLogRecord>& records) {
+    ScanLogWriter writer;
+    if (!writer.start(LOG_PATH, 60000, 65536, 65536)) return false;
+    for (const ScanLogRecord& record : records) {
+        if (!writer.append(record)) return false;
+    }
+    writer.stop();
+    const ScanLogStats stats = writer.stats();
+    return stats.records == records.size() && stats.dropped == 0 && stats.pending == 0;
+}
+
+void test_round_trip() {
+    std::remove(LOG_PATH);
+    const std::vector<ScanLogRecord> records = make_records(20000, 1700000000000, 1);
+    {
+        ScanLogWriter writer;
+        CHECK(writer.start(LOG_PATH, 10, 65536, 4096));
+        for (const ScanLogRecord& record : records) CHECK(writer.append(record));
+        writer.stop();
+        CHECK(!writer.append(records[0]));
+        const ScanLogStats stats = writer.stats();
+        CHECK(stats.records == records.size());
+        CHECK(stats.blocks >= 5);
+        CHECK(stats.bytes == std::filesystem::file_size(LOG_PATH));
+        CHECK(stats.bytes < records.size() * 8);       // Columnar: a few bytes per advert
+    }
+    ScanLogReader reader;
+    CHECK(reader.open(LOG_PATH));
+    CHECK(reader.records() == records.size());
+    const std::vector<ScanLogRecord> read = read_all(LOG_PATH);
+    CHECK(read.size() == records.size());
+    for (size_t i = 0; i < read.size() && i < records.size(); i++) CHECK(same(read[i], records[i]));
+    std::remove(LOG_PATH);
+}
+
+void test_full_buffer_drops() {
+    std::remove(LOG_PATH);
+    ScanLogWriter writer;
+    CHECK(writer.start(LOG_PATH, 60000, 8, 1000));
+    const std::vector<ScanLogRecord> records = make_records(20, 0, 2);
+    size_t accepted = 0;
+    for (const ScanLogRecord& record : records) accepted += writer.append(record) ? 1 : 0;
+    CHECK(accepted == 8);
+    CHECK(writer.stats().dropped == 12);
+    writer.stop();
+    CHECK(read_all(LOG_PATH).size() == 8);
+    std::remove(LOG_PATH);
+}
+
+// A crash mid-write leaves a partial block; readers stop before it and the
+// next writer cuts it off before appending
+void test_torn_tail_cut_on_reopen() {
+    std::remove(LOG_PATH);
+    const std::vector<ScanLogRecord> first = make_records(100, 1000, 3);
+    const std::vector<ScanLogRecord> second = make_records(50, 9000, 4);
+    const std::vector<ScanLogRecord> third = make_records(30, 20000, 5);
+    CHECK(write_session(first));
+    const uintmax_t oneBlock = std::filesystem::file_size(LOG_PATH);
+    CHECK(write_session(second));
+    const uintmax_t twoBlocks = std::filesystem::file_size(LOG_PATH);
+    CHECK(read_all(LOG_PATH).size() == 150);
+
+    std::filesystem::resize_file(LOG_PATH, twoBlocks - 7);
+    ScanLogReader reader;
+    CHECK(reader.open(LOG_PATH));
+    CHECK(reader.blocks() == 1 && reader.records() == 100);
+
+    CHECK(write_session(third));
+    CHECK(std::filesystem::file_size(LOG_PATH) > oneBlock);
+    const std::vector<ScanLogRecord> read = read_all(LOG_PATH);
+    CHECK(read.size() == 130);
+    for (size_t i = 0; i < read.size() && i < 130; i++) CHECK(same(read[i], i < 100 ? first[i] : third[i - 100]));
+
+    // A corrupt byte inside a block payload fails its checksum the same way
+    {
+        FILE* file = fopen(LOG_PATH, "r+b");
+        CHECK(file != nullptr);
+        if (file != nullptr) {
+            fseek(file, static_cast<long>(oneBlock) + static_cast<long>(SCAN_LOG_BLOCK_HEADER_SIZE) + 3, SEEK_SET);
+            fputc(0xFF, file);
+            fclose(file);
+        }
+    }
+    CHECK(read_all(LOG_PATH).size() == 100);
+    std::remove(LOG_PATH);
+}
+
+// Blocks written directly: [0, 1000), [1000, 2000), [2000, 3000), one
+// record per 10 ms
+void test_time_range_scan() {
+    std::remove(LOG_PATH);
+    std::vector<uint8_t> file;
+    put_le(file, SCAN_LOG_MAGIC, 4);
+    put_le(file, SCAN_LOG_VERSION, 4);
+    put_le(file, 0, 8);
+    std::vector<ScanLogRecord> all;
+    for (int block = 0; block < 3; block++) {
+        std::vector<ScanLogRecord> records;
+        for (int i = 0; i < 100; i++) {
+            const int64_t time = block * 1000 + i * 10;
+            records.push_back(ScanLogRecord{ static_cast<uint64_t>(0xA0 + i % 7), time, static_cast<int8_t>(-40 - i % 50),
+                                             static_cast<uint8_t>(block) });
+        }
+        encode_scan_log_block(records.data(), records.size(), file);
+        all.insert(all.end(), records.begin(), records.end());
+    }
+    FILE* out = fopen(LOG_PATH, "wb");
+    CHECK(out != nullptr);
+    if (out == nullptr) return;
+    fwrite(file.data(), 1, file.size(), out);
+    fclose(out);
+
+    ScanLogReader reader;
+    CHECK(reader.open(LOG_PATH));
+    CHECK(reader.blocks() == 3 && reader.records() == 300);
+    const struct { int64_t from; int64_t to; } ranges[] = {
+        { 0, 3000 }, { 995, 1005 }, { 1000, 1000 }, { 1500, 2500 }, { 2990, 5000 }, { -100, 1 }, { 3000, 9000 } };
+    for (const auto& range : ranges) {
+        std::vector<ScanLogRecord> got;
+        const uint64_t matched = reader.scan(range.from, range.to, [&](const ScanLogRecord& r) { got.push_back(r); });
+        std::vector<ScanLogRecord> expected;
+        for (const ScanLogRecord& r : all) {
+            if (r.timeMs >= range.from && r.timeMs < range.to) expected.push_back(r);
+        }
+        CHECK(matched == expected.size());
+        CHECK(got.size() == expected.size());
+        for (size_t i = 0; i < got.size() && i < expected.size(); i++) CHECK(same(got[i], expected[i]));
+    }
+    std::remove(LOG_PATH);
+}
+
+// start() refuses a file it cannot recognize or size, and leaves it as is
+void test_foreign_files_untouched() {
+    std::remove(LOG_PATH);
+    {
+        FILE* out = fopen(LOG_PATH, "wb");
+        CHECK(out != nullptr);
+        if (out == nullptr) return;
+        fputs("not a scan log, keep me", out);
+        fclose(out);
+    }
+    ScanLogWriter writer;
+    CHECK(!writer.start(LOG_PATH));
+    CHECK(std::filesystem::file_size(LOG_PATH) == 23);
+    std::remove(LOG_PATH);
+
+    const std::string directory = "test_scan_log.dir";
+    std::filesystem::create_directory(directory);
+    CHECK(!writer.start(directory));
+    CHECK(std::filesystem::is_directory(directory));
+    std::filesystem::remove(directory);
+}
+
+} // namespace
+
+int main() {
+    test_round_trip();
+    test_full_buffer_drops();
+    test_torn_tail_cut_on_reopen();
+    test_time_range_scan();
+    test_foreign_files_untouched();
+    return niox_test::finish("test_scan_log");
+}
@@ -0,0 +1,177 @@
+// ScanMerger: advertisement / scan response pairing in either order,
+// timeout, supersession, pass-through, flush and idle slot sweep
+
+#include "niox_test.h"
+#include "niox_scan_merge.h"
+#include <cstring>
+#include <string>
+
+using namespace niox;
+
+namespace {
+
+const uint8_t ADV_DATA[] = { 0x02, 0x01, 0x06 };
+const uint8_t RSP_DATA[] = { 0x05, 0x09, 'N', 'I', 'O', 'X' };
+
+AdvertisementEvent advert(uint64_t address, int64_t ms, bool scannable = true, int rssi = -60) {
+    AdvertisementEvent event = {};
+    event.address = address;
+    event.connectable = true;
+    event.scannable = scannable;
+    event.rssi = rssi;
+    event.timestampMs = ms;
+    event.data = ADV_DATA;
+    event.length = sizeof(ADV_DATA);
+    return event;
+}
+
+AdvertisementEvent response(uint64_t address, int64_t ms, const char* name = "NIOX", int rssi = -62) {
+    AdvertisementEvent event = {};
+    event.address = address;
+    event.scanResponse = true;
+    event.rssi = rssi;
+    event.timestampMs = ms;
+    event.name = name;
+    event.data = RSP_DATA;
+    event.length = sizeof(RSP_DATA);
+    return event;
+}
+
+bool is_pair(const MergedAdvertisement& merged) {
+    return merged.length == sizeof(ADV_DATA) + sizeof(RSP_DATA) &&
+        memcmp(merged.data, ADV_DATA, sizeof(ADV_DATA)) == 0 &&
+        memcmp(merged.data + sizeof(ADV_DATA), RSP_DATA, sizeof(RSP_DATA)) == 0;
+}
+
+void test_pairing_either_order() {
+    ScanMerger merger(100);
+    MergedAdvertisement out[2];
+    CHECK(merger.add(advert(1, 0), out) == 0);
+    CHECK(merger.stats().pending == 1);
+    CHECK(merger.add(response(1, 5), out) == 1);
+    CHECK(is_pair(out[0]));
+    CHECK(out[0].connectable && !out[0].scanResponse);
+    CHECK(out[0].hasName && std::string(out[0].name) == "NIOX");
+    CHECK(out[0].rssi == -62 && out[0].timestampMs == 5);
+    const AdvertisementEvent event = out[0].event();
+    CHECK(event.name == out[0].name && event.data == out[0].data && !event.scannable);
+
+    // Response first: data still in advertisement, response order
+    CHECK(merger.add(response(2, 10), out) == 0);
+    CHECK(merger.add(advert(2, 12), out) == 1);
+    CHECK(is_pair(out[0]));
+    CHECK(out[0].connectable);
+
+    const ScanMergeStats stats = merger.stats();
+    CHECK(stats.received == 4 && stats.delivered == 2 && stats.merged == 2);
+    CHECK(stats.pending == 0);
+}
+
+void test_timeout() {
+    ScanMerger merger(100);
+    MergedAdvertisement out[2];
+    MergedAdvertisement held;
+    merger.add(advert(1, 0), out);
+    merger.add(response(2, 50), out);
+    CHECK(!merger.take_expired(99, &held));
+    CHECK(merger.take_expired(100, &held));
+    CHECK(held.address == 1 && held.length == sizeof(ADV_DATA) && !held.hasName && !held.scanResponse);
+    CHECK(!merger.take_expired(149, &held));
+    CHECK(merger.take_expired(150, &held));
+    CHECK(held.address == 2 && held.scanResponse && !held.connectable && held.hasName);
+    CHECK(!merger.take_expired(1000, &held));
+
+    // A late partner starts a new pair instead of completing the old one
+    CHECK(merger.add(response(1, 120), out) == 0);
+    CHECK(merger.stats().timedOut == 2);
+    CHECK(merger.stats().pending == 1);
+}
+
+void test_supersession() {
+    ScanMerger merger(100);
+    MergedAdvertisement out[2];
+    merger.add(advert(1, 0, true, -70), out);
+    // A second advertisement before the response delivers the first alone
+    CHECK(merger.add(advert(1, 30, true, -50), out) == 1);
+    CHECK(out[0].rssi == -70 && out[0].length == sizeof(ADV_DATA));
+    CHECK(merger.add(response(1, 40), out) == 1);
+    CHECK(is_pair(out[0]));
+
+    // A device turning non-scannable: the held half goes first, then the
+    // new advertisement passes through on its own
+    merger.add(advert(1, 100), out);
+    CHECK(merger.add(advert(1, 110, false, -55), out) == 2);
+    CHECK(out[0].timestampMs == 100);
+    CHECK(out[1].timestampMs == 110 && out[1].rssi == -55 && out[1].length == sizeof(ADV_DATA));
+
+    const ScanMergeStats stats = merger.stats();
+    CHECK(stats.superseded == 2);
+    CHECK(stats.passedThrough == 1);
+    CHECK(stats.pending == 0);
+    // The expiry entries of delivered pairs are skipped
+    MergedAdvertisement held;
+    CHECK(!merger.take_any(&held));
+}
+
+void test_pass_through_needs_no_slot() {
+    ScanMerger merger(100);
+    MergedAdvertisement out[2];
+    for (uint64_t address = 0; address < 1000; address++) {
+        AdvertisementEvent event = advert(address, static_cast<int64_t>(address), false);
+        event.name = "beacon";
+        CHECK(merger.add(event, out) == 1);
+        CHECK(out[0].address == address && out[0].hasName && !out[0].scanResponse);
+    }
+    const ScanMergeStats stats = merger.stats();
+    CHECK(stats.passedThrough == 1000 && stats.delivered == 1000);
+    CHECK(stats.slots == 0);
+}
+
+void test_flush() {
+    ScanMerger merger(100);
+    MergedAdvertisement out[2];
+    for (uint64_t address = 1; address <= 5; address++) merger.add(advert(address, 0), out);
+    MergedAdvertisement held;
+    size_t flushed = 0;
+    while (merger.take_any(&held)) flushed++;
+    CHECK(flushed == 5);
+    CHECK(merger.stats().pending == 0);
+    merger.clear();
+    CHECK(merger.stats().received == 0 && merger.stats().slots == 0);
+}
+
+// Addresses heard once (rotating private addresses) give their buffers
+// back; a slot still waiting for its partner is kept
+void test_idle_slots_freed() {
+    ScanMerger merger(100);
+    MergedAdvertisement out[2];
+    MergedAdvertisement held;
+    for (uint64_t address = 0; address < 500; address++) {
+        merger.add(advert(address, 0), out);
+        merger.add(response(address, 1), out);
+    }
+    CHECK(merger.stats().slots == 500);
+    CHECK(!merger.take_expired(10, &held));
+    merger.add(advert(9999, SLOT_IDLE_MS), out);
+    merger.add(advert(42, SLOT_IDLE_MS), out);
+    merger.add(response(42, SLOT_IDLE_MS + 1), out);
+    CHECK(!merger.take_expired(SLOT_IDLE_MS + 20, &held));
+    const ScanMergeStats stats = merger.stats();
+    CHECK(stats.slots == 2);
+    CHECK(stats.slotsFreed == 499);
+    CHECK(stats.pending == 1);
+    CHECK(merger.take_expired(SLOT_IDLE_MS + 100, &held));
+    CHECK(held.address == 9999);
+}
+
+} // namespace
+
+int main() {
+    test_pairing_either_order();
+    test_timeout();
+    test_supersession();
+    test_pass_through_needs_no_slot();
+    test_flush();
+    test_idle_slots_freed();
+    return niox_test::finish("test_scan_merge");
+}
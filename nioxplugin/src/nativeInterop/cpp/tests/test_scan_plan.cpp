@@ -0,0 +1,197 @@
+// Two-phase scanning against always-active scanning on simulated
+// populations: discovery latency and event volume, plus the early exits
+
+#include "niox_scan_plan.h"
+#include "niox_test.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+const int64_t DURATION_MS = 800;
+const int64_t ADVERT_INTERVAL_MS = 40;
+const int MIN_RSSI = -85;
+
+struct SimDevice {
+    int rssi;
+    int64_t phaseMs;
+    bool nameInAdvert;      // Otherwise the name only comes in the scan response
+    bool named;
+};
+
+// Radio model driven by the scan's tick hook: each device advertises every
+// ADVERT_INTERVAL_MS; while active, every advert also draws a scan response
+struct SimRadio {
+    std::vector<SimDevice> devices;
+    bool active = false;
+    int modeSwitches = 0;
+    bool failSwitch = false;
+    uint64_t adverts = 0;
+    uint64_t responses = 0;
+    int64_t resolvedMs = -1;
+    int64_t lastMs = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    SimRadio(size_t count, double nameless, int weakEvery, unsigned seed) {
+        std::mt19937 rng(seed);
+        for (size_t i = 0; i < count; i++) {
+            SimDevice d;
+            d.rssi = weakEvery > 0 && i % weakEvery == 0 ? -95 : -50 - static_cast<int>(rng() % 30);
+            d.phaseMs = static_cast<int64_t>(rng() % ADVERT_INTERVAL_MS);
+            d.nameInAdvert = (rng() % 1000) >= nameless * 1000;
+            d.named = false;
+            devices.push_back(d);
+        }
+    }
+
+    int64_t now_ms() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Deliver every advert due since the last tick
+    void tick() {
+        const int64_t now = now_ms();
+        for (SimDevice& d : devices) {
+            for (int64_t t = first_at_or_after(d, lastMs); t < now; t += ADVERT_INTERVAL_MS) {
+                adverts++;
+                if (d.nameInAdvert) d.named = true;
+                if (active && d.rssi >= MIN_RSSI) {     // Weak devices miss the scan request
+                    responses++;
+                    d.named = true;
+                }
+            }
+        }
+        lastMs = now;
+        if (resolvedMs < 0 && discovered()) resolvedMs = now;
+    }
+
+    // Every device at or above the floor heard and named
+    bool discovered() const {
+        for (const SimDevice& d : devices) {
+            if (d.rssi >= MIN_RSSI && !d.named) return false;
+        }
+        return true;
+    }
+
+    static int64_t first_at_or_after(const SimDevice& d, int64_t t) {
+        if (t <= d.phaseMs) return d.phaseMs;
+        return d.phaseMs + ((t - d.phaseMs + ADVERT_INTERVAL_MS - 1) / ADVERT_INTERVAL_MS) * ADVERT_INTERVAL_MS;
+    }
+
+    // Nameless devices heard so far at or above the floor
+    size_t unresolved(int minRssi) const {
+        size_t count = 0;
+        for (const SimDevice& d : devices) {
+            if (!d.named && d.rssi >= minRssi && d.phaseMs < lastMs) count++;
+        }
+        return count;
+    }
+
+    ScanPhaseHooks hooks() {
+        ScanPhaseHooks h;
+        h.set_mode = [this](bool enable) {
+            if (failSwitch) return false;
+            active = enable;
+            modeSwitches++;
+            return true;
+        };
+        h.unresolved = [this](int minRssi) { return unresolved(minRssi); };
+        h.tick = [this]() { tick(); };
+        return h;
+    }
+};
+
+struct Outcome {
+    ScanPhaseStats stats;
+    uint64_t events;
+    int64_t latencyMs;
+    int modeSwitches;
+};
+
+Outcome run(int strategy, size_t count, double nameless, int weakEvery, bool failSwitch = false) {
+    SimRadio radio(count, nameless, weakEvery, 68);
+    radio.active = strategy == SCAN_ACTIVE;
+    radio.failSwitch = failSwitch;
+    const ScanPlan plan = { strategy, 150, 300, MIN_RSSI };
+    radio.start = std::chrono::steady_clock::now();
+    const ScanPhaseStats stats = run_scan_phases(plan, DURATION_MS, radio.hooks(), 5);
+    return Outcome{ stats, radio.adverts + radio.responses, radio.resolvedMs, radio.modeSwitches };
+}
+
+void report(const char* population, const Outcome& active, const Outcome& twoPhase) {
+    printf("%-22s active: %5llu events, resolved %4lld ms | two-phase: %5llu events, resolved %4lld ms, burst %lld ms\n",
+        population, static_cast<unsigned long long>(active.events), static_cast<long long>(active.latencyMs),
+        static_cast<unsigned long long>(twoPhase.events), static_cast<long long>(twoPhase.latencyMs),
+        static_cast<long long>(twoPhase.stats.activeMs));
+}
+
+void test_named_population_stays_passive() {
+    const Outcome active = run(SCAN_ACTIVE, 40, 0.0, 0);
+    const Outcome twoPhase = run(SCAN_TWO_PHASE, 40, 0.0, 0);
+    CHECK(twoPhase.modeSwitches == 0);
+    CHECK(twoPhase.stats.candidates == 0);
+    CHECK(twoPhase.stats.resolvedMs >= 0);
+    CHECK(twoPhase.stats.activeMs == 0);
+    CHECK(active.stats.unresolved == 0);
+    // The passive sweep ends the scan early and carries no scan responses
+    CHECK(twoPhase.events * 2 < active.events);
+    report("names in advert", active, twoPhase);
+}
+
+void test_nameless_candidates_get_a_burst() {
+    const Outcome active = run(SCAN_ACTIVE, 40, 0.5, 0);
+    const Outcome twoPhase = run(SCAN_TWO_PHASE, 40, 0.5, 0);
+    CHECK(twoPhase.modeSwitches == 1);
+    CHECK(twoPhase.stats.candidates > 0);
+    CHECK(twoPhase.stats.unresolved == 0);
+    CHECK(twoPhase.stats.resolvedMs >= twoPhase.stats.passiveMs);
+    CHECK(twoPhase.stats.activeMs < 300);   // Burst ends once everyone is named
+    CHECK(twoPhase.events < active.events);
+    CHECK(active.latencyMs >= 0 && active.latencyMs <= twoPhase.latencyMs);
+    report("half nameless", active, twoPhase);
+}
+
+void test_weak_devices_ignored() {
+    // Every nameless device is below the floor: no burst for them
+    SimRadio radio(20, 1.0, 1, 68);
+    const ScanPlan plan = { SCAN_TWO_PHASE, 100, 300, MIN_RSSI };
+    const ScanPhaseStats stats = run_scan_phases(plan, DURATION_MS, radio.hooks(), 5);
+    CHECK(radio.modeSwitches == 0);
+    CHECK(stats.candidates == 0);
+    CHECK(radio.responses == 0);
+
+    const Outcome active = run(SCAN_ACTIVE, 40, 0.5, 4);
+    const Outcome twoPhase = run(SCAN_TWO_PHASE, 40, 0.5, 4);
+    CHECK(twoPhase.stats.unresolved == 0);
+    report("half nameless, weak", active, twoPhase);
+}
+
+void test_failed_switch_and_stop() {
+    const Outcome failed = run(SCAN_TWO_PHASE, 20, 1.0, 0, true);
+    CHECK(failed.stats.candidates > 0);
+    CHECK(failed.stats.unresolved == failed.stats.candidates);
+    CHECK(failed.stats.activeMs == 0);
+    CHECK(failed.stats.resolvedMs == -1);
+
+    SimRadio radio(20, 1.0, 0, 68);
+    ScanPhaseHooks hooks = radio.hooks();
+    hooks.stopped = [&radio]() { return radio.now_ms() >= 50; };
+    const ScanPlan plan = { SCAN_TWO_PHASE, 150, 300, MIN_RSSI };
+    const ScanPhaseStats stats = run_scan_phases(plan, DURATION_MS, hooks, 5);
+    CHECK(stats.passiveMs < 150);
+    CHECK(radio.modeSwitches == 0);
+}
+
+} // namespace
+
+int main() {
+    test_named_population_stays_passive();
+    test_nameless_candidates_get_a_burst();
+    test_weak_devices_ignored();
+    test_failed_switch_and_stop();
+    return niox_test::finish("test_scan_plan");
+}
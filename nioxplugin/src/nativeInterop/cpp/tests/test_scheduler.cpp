@@ -0,0 +1,225 @@
+// ConnectionScheduler: concurrency bound, per-device serialization,
+// priority, fair interleaving, failed links and a simulated station load
+
+#include "niox_gatt.h"
+#include "niox_scheduler.h"
+#include "niox_test.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+// Holds the only worker busy until released, so later submissions queue up
+struct Gate {
+    std::atomic<bool> entered{ false };
+    std::atomic<bool> released{ false };
+
+    ConnectionScheduler::Operation operation() {
+        return [this](uint64_t) {
+            entered = true;
+            while (!released) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return 0;
+        };
+    }
+
+    void wait_entered() {
+        while (!entered) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+};
+
+// Order in which operations ran, as "<device>:<tag>"
+struct Trace {
+    std::mutex mutex;
+    std::vector<std::string> order;
+
+    ConnectionScheduler::Operation record(const std::string& entry) {
+        return [this, entry](uint64_t) {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(entry);
+            return 0;
+        };
+    }
+};
+
+void drain(ConnectionScheduler& scheduler) {
+    for (;;) {
+        bool idle = true;
+        for (const DeviceScheduleStats& s : scheduler.stats()) idle = idle && s.pending == 0;
+        if (idle) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    scheduler.stop();   // Joins workers, so running sessions have finished
+}
+
+void test_priority_and_fairness() {
+    ConnectionScheduler scheduler;
+    CHECK(scheduler.start(1, 1, SessionHooks()));
+    Gate gate;
+    Trace trace;
+    scheduler.submit(0x99, 0, gate.operation(), nullptr);
+    gate.wait_entered();
+
+    scheduler.submit(0xA, 0, trace.record("A:1"), nullptr);
+    scheduler.submit(0xA, 0, trace.record("A:2"), nullptr);
+    scheduler.submit(0xA, 0, trace.record("A:3"), nullptr);
+    scheduler.submit(0xB, 0, trace.record("B:1"), nullptr);
+    scheduler.submit(0xB, 0, trace.record("B:2"), nullptr);
+    scheduler.submit(0xC, 5, trace.record("C:urgent"), nullptr);
+    scheduler.submit(0xA, 1, trace.record("A:raised"), nullptr);
+    gate.released = true;
+    drain(scheduler);
+
+    // C has the highest head priority, then A's raised operation; after that
+    // devices alternate one operation per session, FIFO within a device
+    const std::vector<std::string> expected = { "C:urgent", "A:raised", "B:1", "A:1", "B:2", "A:2", "A:3" };
+    CHECK(trace.order == expected);
+}
+
+void test_quantum_batches_a_session() {
+    ConnectionScheduler scheduler;
+    std::atomic<int> opens{ 0 };
+    SessionHooks hooks;
+    hooks.open = [&](uint64_t) { opens++; return LINK_OK; };
+    CHECK(scheduler.start(1, 3, hooks));
+    Gate gate;
+    scheduler.submit(0x99, 0, gate.operation(), nullptr);
+    gate.wait_entered();
+    for (int i = 0; i < 6; i++) scheduler.submit(0xA, 0, [](uint64_t) { return 0; }, nullptr);
+    gate.released = true;
+    drain(scheduler);
+
+    CHECK(opens == 3);      // Gate session + two sessions of three
+    for (const DeviceScheduleStats& s : scheduler.stats()) {
+        if (s.address == 0xA) {
+            CHECK(s.completed == 6);
+            CHECK(s.sessions == 2);
+        }
+    }
+}
+
+void test_failed_link_fails_head_only() {
+    ConnectionScheduler scheduler;
+    std::atomic<int> attempts{ 0 };
+    SessionHooks hooks;
+    hooks.open = [&](uint64_t) { return attempts++ == 0 ? LINK_TIMEOUT : LINK_OK; };
+    std::atomic<int> closes{ 0 };
+    hooks.close = [&](uint64_t) { closes++; };
+    CHECK(scheduler.start(1, 4, hooks));
+
+    std::vector<int> results(3, 1);
+    for (int i = 0; i < 3; i++) {
+        scheduler.submit(0xA, 0, [](uint64_t) { return 0; },
+            [&results, i](const OperationResult& r) { results[i] = r.result; });
+    }
+    drain(scheduler);
+    CHECK(results[0] == LINK_TIMEOUT);
+    CHECK(results[1] == 0 && results[2] == 0);
+    CHECK(closes == 1);     // Only the session that opened is closed
+}
+
+void test_stop_cancels_pending() {
+    ConnectionScheduler scheduler;
+    CHECK(scheduler.start(1, 1, SessionHooks()));
+    Gate gate;
+    scheduler.submit(0x99, 0, gate.operation(), nullptr);
+    gate.wait_entered();
+    std::atomic<int> cancelled{ 0 };
+    for (int i = 0; i < 4; i++) {
+        scheduler.submit(0xA, 0, [](uint64_t) { return 0; },
+            [&](const OperationResult& r) { if (r.result == SCHEDULE_CANCELLED) cancelled++; });
+    }
+    std::thread releaser([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        gate.released = true;
+    });
+    scheduler.stop();
+    releaser.join();
+    CHECK(cancelled == 4);
+    CHECK(scheduler.submit(0xA, 0, nullptr, nullptr) == 0);
+}
+
+// A device-management station: 16 units, each with a configuration push
+// and log pulls, over links with simulated setup and ATT round trips
+void test_station_load() {
+    const int units = 16;
+    const int maxSessions = 4;
+    const int opsPerUnit = 6;
+    auto backend = std::make_shared<SimulatedGattBackend>(5, 1);
+    const Uuid service = Uuid::from16(0x1850);
+    const Uuid logs = Uuid::from16(0x2B50);
+    std::vector<uint16_t> handles(units);
+    const uint8_t zero[] = { 0 };
+    for (int u = 0; u < units; u++) {
+        handles[u] = backend->add_characteristic(0xC00000000000ull + u, service, logs, GATT_PROP_READ | GATT_PROP_WRITE, zero, 1);
+    }
+
+    std::atomic<int> open{ 0 };
+    std::atomic<int> peakOpen{ 0 };
+    std::vector<std::atomic<int>> inFlight(units);
+    std::atomic<int> overlaps{ 0 };
+    SessionHooks hooks;
+    hooks.open = [&](uint64_t address) {
+        CachedAdvertisement advert = {};
+        advert.address = address;
+        advert.connectable = true;
+        const int result = backend->connect(advert, 1000);
+        const int now = ++open;
+        int peak = peakOpen.load();
+        while (now > peak && !peakOpen.compare_exchange_weak(peak, now)) {}
+        return result;
+    };
+    hooks.close = [&](uint64_t address) {
+        open--;
+        backend->disconnect(address);
+    };
+
+    ConnectionScheduler scheduler;
+    CHECK(scheduler.start(maxSessions, 2, hooks));
+    std::atomic<int> failed{ 0 };
+    for (int op = 0; op < opsPerUnit; op++) {
+        for (int u = 0; u < units; u++) {
+            const int priority = op == 0 ? 1 : 0;     // Configuration push first
+            scheduler.submit(0xC00000000000ull + u, priority, [&, u](uint64_t address) {
+                if (inFlight[u]++ != 0) overlaps++;
+                std::vector<uint8_t> value;
+                int result = backend->read(address, handles[u], value);
+                if (result == LINK_OK) result = backend->write(address, handles[u], zero, 1, true);
+                inFlight[u]--;
+                return result;
+            }, [&](const OperationResult& r) { if (r.result != LINK_OK) failed++; });
+        }
+    }
+    drain(scheduler);
+
+    CHECK(failed == 0);
+    CHECK(overlaps == 0);
+    CHECK(peakOpen <= maxSessions);
+    CHECK(scheduler.peak_sessions() == maxSessions);
+    int64_t worstQueue = 0;
+    int64_t totalQueue = 0;
+    for (const DeviceScheduleStats& s : scheduler.stats()) {
+        CHECK(s.completed == static_cast<uint64_t>(opsPerUnit));
+        CHECK(s.sessions == static_cast<uint64_t>(opsPerUnit / 2));
+        totalQueue += s.totalQueueMs;
+        if (s.maxQueueMs > worstQueue) worstQueue = s.maxQueueMs;
+    }
+    printf("station load: %d units, %d sessions, mean queue %.1f ms, worst %lld ms\n", units, maxSessions,
+        static_cast<double>(totalQueue) / (units * opsPerUnit), static_cast<long long>(worstQueue));
+}
+
+} // namespace
+
+int main() {
+    test_priority_and_fairness();
+    test_quantum_batches_a_session();
+    test_failed_link_fails_head_only();
+    test_stop_cancels_pending();
+    test_station_load();
+    return niox_test::finish("test_scheduler");
+}
@@ -0,0 +1,109 @@
+// Advertised status decoding: v1 fields, scanning past other AD structures,
+// and rejection of unknown, short and malformed payloads
+
+#include "niox_status.h"
+#include "niox_test.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+using namespace niox;
+
+namespace {
+
+size_t g_allocations = 0;
+
+// Flags, complete local name, then NIOX manufacturer data (v1):
+// battery 87 %, ready + charging, 312 tests left, error code 0
+const uint8_t ADVERT[] = {
+    0x02, 0x01, 0x06,
+    0x09, 0x09, 'N', 'I', 'O', 'X', ' ', 'P', 'R', 'O',
+    0x09, 0xFF, 0xFF, 0xFF, 0x01, 87, 0x03, 0x38, 0x01, 0x00,
+};
+
+void test_v1_fields() {
+    DeviceStatus status = {};
+    CHECK(decode_status(ADVERT, sizeof(ADVERT), &status));
+    CHECK(status.version == 1);
+    CHECK(status.present == (1u << STATUS_FIELD_COUNT) - 1);
+    CHECK(status.get(STATUS_BATTERY) == 87);
+    CHECK(status.get(STATUS_READY) == 1);
+    CHECK(status.get(STATUS_CHARGING) == 1);
+    CHECK(status.get(STATUS_BUSY) == 0);
+    CHECK(status.get(STATUS_ERROR) == 0);
+    CHECK(status.get(STATUS_TESTS_REMAINING) == 312);
+    CHECK(status.get(STATUS_ERROR_CODE) == 0);
+}
+
+void test_error_state() {
+    const uint8_t advert[] = { 0x09, 0xFF, 0xFF, 0xFF, 0x01, 12, 0x0C, 0xFF, 0xFF, 0x2A, 0x55 };    // Trailing byte ignored
+    DeviceStatus status = {};
+    CHECK(decode_status(advert, sizeof(advert), &status));
+    CHECK(status.get(STATUS_BUSY) == 1);
+    CHECK(status.get(STATUS_ERROR) == 1);
+    CHECK(status.get(STATUS_READY) == 0);
+    CHECK(status.get(STATUS_TESTS_REMAINING) == 0xFFFF);
+    CHECK(status.get(STATUS_ERROR_CODE) == 0x2A);
+}
+
+void test_other_company_skipped() {
+    const uint8_t advert[] = {
+        0x05, 0xFF, 0x4C, 0x00, 0x01, 0x02,                                 // Another vendor's data
+        0x09, 0xFF, 0xFF, 0xFF, 0x01, 50, 0x01, 0x0A, 0x00, 0x00,
+    };
+    DeviceStatus status = {};
+    CHECK(decode_status(advert, sizeof(advert), &status));
+    CHECK(status.get(STATUS_BATTERY) == 50);
+    CHECK(status.get(STATUS_TESTS_REMAINING) == 10);
+}
+
+void expect_rejected(const uint8_t* advert, size_t length) {
+    DeviceStatus status;
+    memset(&status, 0xA5, sizeof(status));
+    CHECK(!decode_status(advert, length, &status));
+    CHECK(status.version == 0xA5 && status.present == 0xA5);    // Left untouched
+}
+
+void test_rejected_payloads() {
+    const uint8_t noStatus[] = { 0x02, 0x01, 0x06, 0x03, 0x03, 0x0F, 0x18 };
+    expect_rejected(noStatus, sizeof(noStatus));
+    const uint8_t unknownVersion[] = { 0x09, 0xFF, 0xFF, 0xFF, 0x07, 87, 0x01, 0x00, 0x00, 0x00 };
+    expect_rejected(unknownVersion, sizeof(unknownVersion));
+    const uint8_t shortFields[] = { 0x07, 0xFF, 0xFF, 0xFF, 0x01, 87, 0x01, 0x00 };
+    expect_rejected(shortFields, sizeof(shortFields));
+    const uint8_t tooShortForHeader[] = { 0x03, 0xFF, 0xFF, 0xFF };
+    expect_rejected(tooShortForHeader, sizeof(tooShortForHeader));
+    const uint8_t truncated[] = { 0x09, 0xFF, 0xFF, 0xFF, 0x01, 87, 0x01 };    // Length runs past the end
+    expect_rejected(truncated, sizeof(truncated));
+    const uint8_t terminated[] = { 0x02, 0x01, 0x06, 0x00, 0x09, 0xFF, 0xFF, 0xFF, 0x01, 87, 0x01, 0x00, 0x00, 0x00 };
+    expect_rejected(terminated, sizeof(terminated));
+    expect_rejected(ADVERT, 0);
+}
+
+void test_allocation_free() {
+    DeviceStatus status = {};
+    const size_t before = g_allocations;
+    for (int i = 0; i < 1000; i++) decode_status(ADVERT, sizeof(ADVERT), &status);
+    CHECK(g_allocations == before);
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    g_allocations++;
+    void* p = malloc(size ? size : 1);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+int main() {
+    test_v1_fields();
+    test_error_state();
+    test_other_company_skipped();
+    test_rejected_payloads();
+    test_allocation_free();
+    return niox_test::finish("test_status");
+}
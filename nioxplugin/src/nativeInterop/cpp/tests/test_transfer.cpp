@@ -0,0 +1,151 @@
+// LogTransfer against SimulatedLogPeripheral: byte-exact downloads with and
+// without loss, resume after a disconnect at a different MTU, stall timeout
+
+#include "niox_test.h"
+#include "niox_transfer.h"
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+const uint64_t DEVICE = 0xC0FFEE000063ull;
+
+std::vector<uint8_t> make_log(size_t size) {
+    std::vector<uint8_t> log(size);
+    uint32_t x = 0x12345678;
+    for (uint8_t& byte : log) {
+        x = x * 1664525u + 1013904223u;
+        byte = static_cast<uint8_t>(x >> 24);
+    }
+    return log;
+}
+
+bool connect(GattClient& client) {
+    CachedAdvertisement advert = {};
+    advert.address = DEVICE;
+    advert.connectable = true;
+    return client.connect(advert, 1000) == LINK_OK;
+}
+
+void test_lossless() {
+    auto backend = std::make_shared<SimulatedGattBackend>(0, 2);
+    backend->set_max_mtu(247);
+    const std::vector<uint8_t> log = make_log(32 * 1024 + 77);
+    SimulatedLogPeripheral device(backend, DEVICE, log, 2, 50, 0.0);
+    GattClient client(backend);
+    CHECK(connect(client));
+
+    LogTransfer transfer(DEVICE);
+    CHECK(transfer.run(client) == LINK_OK);
+    CHECK(transfer.complete());
+    CHECK(transfer.data() == log);
+    const TransferStats stats = transfer.stats();
+    CHECK(stats.size == log.size());
+    CHECK(stats.received == log.size());
+    CHECK(stats.acknowledged == log.size());
+    CHECK(stats.mtu == 247);
+    CHECK(stats.chunk == 247 - ATT_NOTIFY_HEADER - LOG_DATA_HEADER);
+    CHECK(stats.rerequests == 0);
+    CHECK(stats.duplicates == 0);
+    CHECK(stats.resumes == 0);
+    CHECK(device.chunks_dropped() == 0);
+    // A finished transfer does not download again
+    CHECK(transfer.run(client) == LINK_OK);
+    CHECK(transfer.stats().requests == stats.requests);
+}
+
+void test_lossy() {
+    auto backend = std::make_shared<SimulatedGattBackend>(0, 2);
+    backend->set_max_mtu(185);
+    const std::vector<uint8_t> log = make_log(24 * 1024);
+    SimulatedLogPeripheral device(backend, DEVICE, log, 2, 50, 0.05, 7);
+    GattClient client(backend);
+    CHECK(connect(client));
+
+    TransferOptions options;
+    options.requestTimeoutMs = 40;
+    LogTransfer transfer(DEVICE, options);
+    CHECK(transfer.run(client) == LINK_OK);
+    CHECK(transfer.data() == log);
+    const TransferStats stats = transfer.stats();
+    CHECK(device.chunks_dropped() > 0);
+    CHECK(stats.rerequests > 0);
+    CHECK(stats.received == log.size());
+    CHECK(stats.mtu == 185);
+}
+
+// Drop the link part way, then resume on a new link that grants a smaller
+// MTU: the chunk grid is re-laid from the acknowledged offset
+void test_resume_at_other_mtu() {
+    auto backend = std::make_shared<SimulatedGattBackend>(0, 2);
+    backend->set_max_mtu(247);
+    const std::vector<uint8_t> log = make_log(64 * 1024);
+    SimulatedLogPeripheral device(backend, DEVICE, log, 2, 400, 0.0);
+    GattClient client(backend);
+    CHECK(connect(client));
+
+    LogTransfer transfer(DEVICE);
+    int first = LINK_OK;
+    std::thread runner([&]() { first = transfer.run(client); });
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (transfer.stats().acknowledged < 16 * 1024 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    backend->disconnect(DEVICE);
+    runner.join();
+    CHECK(first != LINK_OK);
+    CHECK(!transfer.complete());
+    const TransferStats cut = transfer.stats();
+    CHECK(cut.acknowledged >= 16 * 1024);
+    CHECK(cut.acknowledged < log.size());
+    CHECK(cut.mtu == 247);
+
+    backend->set_max_mtu(185);
+    CHECK(connect(client));
+    CHECK(transfer.run(client) == LINK_OK);
+    CHECK(transfer.data() == log);
+    const TransferStats stats = transfer.stats();
+    CHECK(stats.mtu == 185);
+    CHECK(stats.chunk == 185 - ATT_NOTIFY_HEADER - LOG_DATA_HEADER);
+    CHECK(stats.resumes == 1);
+    CHECK(stats.acknowledged == log.size());
+}
+
+// Nothing arrives: the tail timeout keeps re-requesting until the stall
+// timeout gives up, and the transfer stays resumable
+void test_stall_timeout() {
+    auto backend = std::make_shared<SimulatedGattBackend>(0, 1);
+    const std::vector<uint8_t> log = make_log(4096);
+    SimulatedLogPeripheral device(backend, DEVICE, log, 1, 50, 1.0);
+    GattClient client(backend);
+    CHECK(connect(client));
+
+    TransferOptions options;
+    options.requestTimeoutMs = 20;
+    options.stallTimeoutMs = 150;
+    LogTransfer transfer(DEVICE, options);
+    const auto start = std::chrono::steady_clock::now();
+    CHECK(transfer.run(client) == LINK_TIMEOUT);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    CHECK(elapsed >= std::chrono::milliseconds(150));
+    CHECK(elapsed < std::chrono::seconds(2));
+    CHECK(!transfer.complete());
+    const TransferStats stats = transfer.stats();
+    CHECK(stats.received == 0);
+    CHECK(stats.rerequests > 0);
+    CHECK(device.chunks_sent() == 0);
+}
+
+} // namespace
+
+int main() {
+    test_lossless();
+    test_lossy();
+    test_resume_at_other_mtu();
+    test_stall_timeout();
+    return niox_test::finish("test_transfer");
+}
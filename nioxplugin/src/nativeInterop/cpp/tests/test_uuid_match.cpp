@@ -0,0 +1,113 @@
+// UuidMatcher: every code path agrees with the scalar reference
+
+#include "niox_test.h"
+#include "niox_uuid_match.h"
+#include <random>
+#include <vector>
+
+using niox::Uuid;
+using niox::UuidMatcher;
+
+namespace {
+
+const Uuid FDC_SERVICE = Uuid::parse("3e3d1158-5656-4a89-a3ea-ec58bff4d3c8", 36);
+
+// Little-endian on-air bytes of a UUID, as in a UUID list AD structure
+void append_uuid(std::vector<uint8_t>& out, const Uuid& uuid) {
+    for (int i = 0; i < 8; i++) out.push_back(static_cast<uint8_t>(uuid.lo >> (8 * i)));
+    for (int i = 0; i < 8; i++) out.push_back(static_cast<uint8_t>(uuid.hi >> (8 * i)));
+}
+
+Uuid random_uuid(std::mt19937_64& rng) {
+    return Uuid{ rng(), rng() };
+}
+
+void test_paths_agree(std::mt19937_64& rng) {
+    const UuidMatcher::Path paths[] = { UuidMatcher::PATH_SCALAR,
+#if NIOX_HAVE_SSE2
+        UuidMatcher::PATH_SSE2, UuidMatcher::PATH_AVX2,
+#endif
+    };
+    for (size_t targets = 1; targets <= niox::UUID_MATCH_MAX_TARGETS; targets++) {
+        UuidMatcher matcher;
+        std::vector<Uuid> wanted;
+        for (size_t t = 0; t < targets; t++) {
+            wanted.push_back(random_uuid(rng));
+            CHECK(matcher.add(wanted.back()) == static_cast<int>(t));
+        }
+        for (int round = 0; round < 200; round++) {
+            const size_t count = 1 + rng() % 16;
+            std::vector<uint8_t> list;
+            for (size_t e = 0; e < count; e++) append_uuid(list, random_uuid(rng));
+            int expected = -1;
+            if (round % 2 == 0) {
+                // Plant one target at a random position
+                const size_t target = rng() % targets;
+                const size_t entry = rng() % count;
+                std::vector<uint8_t> bytes;
+                append_uuid(bytes, wanted[target]);
+                std::copy(bytes.begin(), bytes.end(), list.begin() + entry * 16);
+                expected = static_cast<int>(target);
+            }
+            for (UuidMatcher::Path path : paths) {
+                if (path == UuidMatcher::PATH_AVX2 && !niox::cpu_has_avx2()) continue;
+                matcher.set_path(path);
+                CHECK(matcher.match(list.data(), count) == expected);
+            }
+        }
+    }
+}
+
+void test_unused_lanes_never_match() {
+    // Lanes past the last target are zero; an all-zero UUID must not hit them
+    UuidMatcher matcher;
+    matcher.add(FDC_SERVICE);
+    std::vector<uint8_t> zero(16, 0);
+    CHECK(matcher.match(zero.data(), 1) == -1);
+    CHECK(matcher.match_scalar(zero.data(), 1) == -1);
+}
+
+void test_payload_walk() {
+    UuidMatcher matcher;
+    matcher.add(FDC_SERVICE);
+
+    // Flags, then a complete 128-bit list with the FDC service second
+    std::vector<uint8_t> payload = { 0x02, 0x01, 0x06, 0x21, niox::AD_TYPE_UUID128_COMPLETE };
+    append_uuid(payload, Uuid{ 1, 2 });
+    append_uuid(payload, FDC_SERVICE);
+    CHECK(matcher.match_payload(payload.data(), payload.size()) == 0);
+
+    // Truncated structure: the length byte claims more than is there
+    std::vector<uint8_t> truncated(payload.begin(), payload.end() - 1);
+    CHECK(matcher.match_payload(truncated.data(), truncated.size()) == -1);
+
+    // 128-bit service data keyed by the FDC service
+    std::vector<uint8_t> service_data = { 0x13, niox::AD_TYPE_SERVICE_DATA_UUID128 };
+    append_uuid(service_data, FDC_SERVICE);
+    service_data.push_back(0x55);
+    service_data.push_back(0xAA);
+    CHECK(matcher.match_payload(service_data.data(), service_data.size()) == 0);
+
+    // A zero length byte ends the walk (padding)
+    std::vector<uint8_t> padded = { 0x00, 0x11, niox::AD_TYPE_UUID128_COMPLETE };
+    append_uuid(padded, FDC_SERVICE);
+    CHECK(matcher.match_payload(padded.data(), padded.size()) == -1);
+}
+
+void test_full_matcher() {
+    UuidMatcher matcher;
+    for (size_t t = 0; t < niox::UUID_MATCH_MAX_TARGETS; t++) CHECK(matcher.add(Uuid{ t, t }) >= 0);
+    CHECK(matcher.add(FDC_SERVICE) == -1);
+    CHECK(matcher.size() == niox::UUID_MATCH_MAX_TARGETS);
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(53);
+    test_paths_agree(rng);
+    test_unused_lanes_never_match();
+    test_payload_walk();
+    test_full_matcher();
+    return niox_test::finish("test_uuid_match");
+}
@@ -0,0 +1,189 @@
+// Wire protocol: round trip, chunked input, corruption and sequence gaps
+
+#include "niox_test.h"
+#include "niox_wire.h"
+#include <random>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+struct Stream {
+    WireFramer framer;
+    WireDecoder decoder;
+    std::vector<WireUpdate> out;
+    int rejected = 0;
+
+    void feed(const uint8_t* data, size_t length) {
+        framer.feed(data, length);
+        uint8_t type;
+        uint16_t sequence;
+        std::vector<uint8_t> payload;
+        uint64_t corrupt = framer.corrupt_frames();
+        while (framer.next_frame(&type, &sequence, payload)) {
+            if (framer.corrupt_frames() != corrupt) {
+                corrupt = framer.corrupt_frames();
+                decoder.lose_sync();
+            }
+            if (!decoder.decode(type, sequence, payload, out)) rejected++;
+        }
+        if (framer.corrupt_frames() != corrupt) decoder.lose_sync();
+    }
+};
+
+std::vector<WireUpdate> make_batch(std::mt19937_64& rng, size_t devices, int64_t nowMs) {
+    std::vector<WireUpdate> batch;
+    for (size_t d = 0; d < devices; d++) {
+        if (rng() % 3 == 0) continue;   // Not every device is heard every batch
+        WireUpdate update;
+        update.address = 0xC00000000000ull + d;
+        update.serial = d % 2 ? 7000000 + d : 0;
+        update.rssi = -40 - static_cast<int>(rng() % 50);
+        update.timestampMs = nowMs - static_cast<int64_t>(rng() % 500);
+        update.flags = static_cast<uint8_t>(d % 4);
+        update.present = 0;
+        batch.push_back(update);
+    }
+    return batch;
+}
+
+bool same(const WireUpdate& a, const WireUpdate& b) {
+    return a.address == b.address && a.serial == b.serial && a.rssi == b.rssi &&
+           a.timestampMs == b.timestampMs && a.flags == b.flags;
+}
+
+void test_crc32() {
+    // Standard check value of CRC-32/ISO-HDLC
+    const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    CHECK(crc32(check, sizeof(check)) == 0xCBF43926u);
+    // Chaining over two halves equals one pass
+    CHECK(crc32(check + 4, 5, crc32(check, 4)) == 0xCBF43926u);
+    // A Fletcher sum cannot tell these apart
+    const uint8_t zero[] = { 0x00 };
+    const uint8_t ones[] = { 0xFF };
+    CHECK(crc32(zero, 1) != crc32(ones, 1));
+}
+
+void test_round_trip_chunked(std::mt19937_64& rng) {
+    WireEncoder encoder;
+    Stream stream;
+    std::vector<WireUpdate> sent;
+    std::vector<uint8_t> bytes;
+    for (int batch = 0; batch < 50; batch++) {
+        std::vector<WireUpdate> updates = make_batch(rng, 40, 1700000000000ll + batch * 1000);
+        sent.insert(sent.end(), updates.begin(), updates.end());
+        encoder.encode(updates.data(), updates.size(), bytes);
+    }
+    // Feed in arbitrary chunks
+    for (size_t pos = 0; pos < bytes.size();) {
+        const size_t chunk = 1 + rng() % 37;
+        const size_t n = chunk < bytes.size() - pos ? chunk : bytes.size() - pos;
+        stream.feed(bytes.data() + pos, n);
+        pos += n;
+    }
+    CHECK(stream.rejected == 0);
+    CHECK(stream.decoder.synced());
+    CHECK(stream.out.size() == sent.size());
+    bool all_same = stream.out.size() == sent.size();
+    for (size_t i = 0; all_same && i < sent.size(); i++) all_same = same(stream.out[i], sent[i]);
+    CHECK(all_same);
+    CHECK(encoder.dictionary_size() == 40);
+}
+
+void test_corrupt_frame_drops_sync(std::mt19937_64& rng) {
+    WireEncoder encoder;
+    Stream stream;
+    std::vector<uint8_t> first, second, third;
+    std::vector<WireUpdate> batch = make_batch(rng, 10, 1000);
+    encoder.encode(batch.data(), batch.size(), first);
+    batch = make_batch(rng, 10, 2000);
+    encoder.encode(batch.data(), batch.size(), second);
+    batch = make_batch(rng, 10, 3000);
+    encoder.encode(batch.data(), batch.size(), third);
+
+    stream.feed(first.data(), first.size());
+    CHECK(stream.decoder.synced());
+
+    // Flip one payload bit: the CRC rejects the frame and the decoder stops
+    second[second.size() / 2] ^= 0x10;
+    stream.feed(second.data(), second.size());
+    CHECK(stream.framer.corrupt_frames() >= 1);
+    CHECK(!stream.decoder.synced());
+
+    // Later frames are ignored rather than applied to a stale dictionary
+    const size_t decoded = stream.out.size();
+    stream.feed(third.data(), third.size());
+    CHECK(stream.out.size() == decoded);
+    CHECK(!stream.decoder.synced());
+
+    // A reset from the producer brings the reader back
+    encoder.reset();
+    std::vector<uint8_t> key;
+    batch = make_batch(rng, 10, 4000);
+    encoder.encode(batch.data(), batch.size(), key);
+    stream.feed(key.data(), key.size());
+    CHECK(stream.decoder.synced());
+    CHECK(stream.out.size() == decoded + batch.size());
+}
+
+void test_lost_frame_is_a_gap(std::mt19937_64& rng) {
+    WireEncoder encoder;
+    Stream stream;
+    std::vector<uint8_t> first, lost, next;
+    std::vector<WireUpdate> batch = make_batch(rng, 10, 1000);
+    encoder.encode(batch.data(), batch.size(), first);
+    batch = make_batch(rng, 10, 2000);
+    encoder.encode(batch.data(), batch.size(), lost);
+    batch = make_batch(rng, 10, 3000);
+    encoder.encode(batch.data(), batch.size(), next);
+
+    stream.feed(first.data(), first.size());
+    stream.feed(next.data(), next.size());      // 'lost' never arrives
+    CHECK(stream.decoder.sequence_gaps() == 1);
+    CHECK(!stream.decoder.synced());
+    CHECK(stream.framer.corrupt_frames() == 0);
+}
+
+void test_updates_before_reset_rejected(std::mt19937_64& rng) {
+    WireEncoder encoder;
+    std::vector<uint8_t> bytes;
+    std::vector<WireUpdate> batch = make_batch(rng, 5, 1000);
+    encoder.encode(batch.data(), batch.size(), bytes);
+    std::vector<uint8_t> updates_only;
+    batch = make_batch(rng, 5, 2000);
+    encoder.encode(batch.data(), batch.size(), updates_only);
+
+    // A reader that joins mid-stream has no dictionary
+    Stream late;
+    late.feed(updates_only.data(), updates_only.size());
+    CHECK(late.out.empty());
+    CHECK(!late.decoder.synced());
+    CHECK(late.decoder.rejected_frames() == 1);
+}
+
+void test_garbage_resync() {
+    WireEncoder encoder;
+    Stream stream;
+    // Noise, then something that looks like a frame header but fails the CRC
+    std::vector<uint8_t> bytes = { 0x13, 0x37, WIRE_SYNC, 0x02, 0x00, 0x00, 0x03, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77 };
+    WireUpdate update = { 0xC01122334455ull, 0, -60, 5000, 1, 0 };
+    encoder.encode(&update, 1, bytes);
+    stream.feed(bytes.data(), bytes.size());
+    CHECK(stream.framer.corrupt_frames() == 1);
+    CHECK(stream.out.size() == 1);
+    CHECK(stream.decoder.synced());
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(57);
+    test_crc32();
+    test_round_trip_chunked(rng);
+    test_corrupt_frame_drops_sync(rng);
+    test_lost_frame_is_a_gap(rng);
+    test_updates_before_reset_rejected(rng);
+    test_garbage_resync();
+    return niox_test::finish("test_wire");
+}
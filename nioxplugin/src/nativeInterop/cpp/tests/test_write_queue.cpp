@@ -0,0 +1,155 @@
+// WriteQueue over SimulatedGattBackend's paced command buffer: write order,
+// barriers, fallbacks, and recovery from a command lost in the stack
+
+#include "niox_test.h"
+#include "niox_write_queue.h"
+#include <chrono>
+#include <memory>
+#include <vector>
+
+using namespace niox;
+
+namespace {
+
+const uint64_t DEVICE = 0xC0FFEE000065ull;
+const Uuid CONFIG_SERVICE = Uuid::from16(0x1850);
+const Uuid CONFIG = Uuid::from16(0x2B60);
+const Uuid READ_ONLY = Uuid::from16(0x2B61);
+
+struct Fixture {
+    std::shared_ptr<SimulatedGattBackend> backend = std::make_shared<SimulatedGattBackend>();
+    GattClient client{ backend };
+    std::vector<std::vector<uint8_t>> seen;     // Writes in the order the device applied them
+
+    Fixture() {
+        const uint8_t zero[] = { 0 };
+        const uint16_t config = backend->add_characteristic(DEVICE, CONFIG_SERVICE, CONFIG,
+            GATT_PROP_WRITE | GATT_PROP_WRITE_NO_RESPONSE, zero, 1);
+        backend->add_characteristic(DEVICE, CONFIG_SERVICE, READ_ONLY, GATT_PROP_READ, zero, 1);
+        backend->set_write_handler(DEVICE, config, [this](const uint8_t* data, size_t length) {
+            seen.emplace_back(data, data + length);
+        });
+        backend->set_command_buffer(4, 2000);      // 4 slots, 2 ms per packet
+        CachedAdvertisement advert = {};
+        advert.address = DEVICE;
+        advert.connectable = true;
+        client.connect(advert, 1000);
+    }
+};
+
+std::vector<uint8_t> value(int i, size_t length = 4) {
+    std::vector<uint8_t> v(length, static_cast<uint8_t>(i));
+    v[0] = static_cast<uint8_t>(i);
+    return v;
+}
+
+void enqueue(WriteQueue& queue, int i, bool barrier, size_t length = 4) {
+    const std::vector<uint8_t> v = value(i, length);
+    queue.enqueue(CONFIG_SERVICE, CONFIG, v.data(), v.size(), barrier);
+}
+
+void test_order_and_barriers() {
+    Fixture f;
+    WriteQueue queue(DEVICE);
+    for (int i = 0; i < 20; i++) enqueue(queue, i, i == 9 || i == 14);
+    WriteQueueStats stats;
+    CHECK(queue.flush(f.client, &stats) == LINK_OK);
+    CHECK(queue.pending() == 0);
+    CHECK(f.seen.size() == 20);
+    for (size_t i = 0; i < f.seen.size(); i++) CHECK(f.seen[i] == value(static_cast<int>(i)));
+    CHECK(stats.commands == 20);
+    CHECK(stats.acknowledged == 2);
+    CHECK(stats.unacknowledged == 18);
+    CHECK(stats.bursts == 3);
+    CHECK(stats.failed == 0);
+    CHECK(f.backend->credit_waits() > 0);     // Bursts were paced by the buffer
+}
+
+void test_trailing_commands_complete_when_sent() {
+    Fixture f;
+    f.backend->set_command_buffer(64, 5000);   // Room for all, 5 ms each on air
+    WriteQueue queue(DEVICE);
+    for (int i = 0; i < 10; i++) enqueue(queue, i, false);
+    WriteQueueStats stats;
+    CHECK(queue.flush(f.client, &stats) == LINK_OK);
+    // Accepted at once, but on air for 50 ms: flush waits for that
+    CHECK(stats.elapsedMs >= 45);
+    CHECK(stats.maxCompletionMs >= 45);
+}
+
+void test_fallbacks() {
+    Fixture f;
+    f.backend->set_max_mtu(247);
+    WriteQueue queue(DEVICE);
+    enqueue(queue, 1, false, 300);              // Longer than MTU - 3: sent as a request
+    enqueue(queue, 2, false);
+    WriteQueueStats stats;
+    CHECK(queue.flush(f.client, &stats) == LINK_OK);
+    CHECK(stats.acknowledged == 1 && stats.unacknowledged == 1);
+    CHECK(f.seen.size() == 2 && f.seen[0].size() == 300);
+
+    const uint8_t one[] = { 1 };
+    queue.enqueue(CONFIG_SERVICE, READ_ONLY, one, 1, false);
+    enqueue(queue, 3, false);
+    CHECK(queue.flush(f.client) == GATT_NOT_PERMITTED);
+    CHECK(queue.pending() == 2);                // Failed write and the rest stay queued
+    queue.clear();
+    queue.enqueue(CONFIG_SERVICE, Uuid::from16(0x2B99), one, 1, false);
+    CHECK(queue.flush(f.client) == GATT_NOT_FOUND);
+}
+
+void test_lost_command_is_resent() {
+    Fixture f;
+    WriteQueue queue(DEVICE);
+    for (int i = 0; i < 6; i++) enqueue(queue, i, false);
+    f.backend->fail_commands(1);
+    WriteQueueStats stats;
+    CHECK(queue.flush(f.client, &stats) == LINK_ERROR);
+    CHECK(stats.failed == 1);
+    CHECK(queue.pending() == 6);                // Unconfirmed commands queued again
+    CHECK(f.seen.empty());
+
+    // The failure was cleared by the flush that reported it
+    CHECK(queue.flush(f.client, &stats) == LINK_OK);
+    CHECK(queue.pending() == 0);
+    CHECK(f.seen.size() == 6);
+    for (size_t i = 0; i < f.seen.size(); i++) CHECK(f.seen[i] == value(static_cast<int>(i)));
+    CHECK(f.backend->write_command(DEVICE, 0, nullptr, 0) != LINK_ERROR);
+}
+
+void test_lost_command_before_barrier() {
+    Fixture f;
+    WriteQueue queue(DEVICE);
+    for (int i = 0; i < 4; i++) enqueue(queue, i, i == 3);
+    f.backend->fail_commands(1);
+    CHECK(queue.flush(f.client) == LINK_ERROR);
+    CHECK(queue.pending() == 4);                // The barrier was not sent either
+    CHECK(queue.flush(f.client) == LINK_OK);
+    CHECK(f.seen.size() == 4 && f.seen[3] == value(3));
+}
+
+void test_failure_left_by_another_user() {
+    Fixture f;
+    // A command lost outside the queue (e.g. a range request) must not fail it
+    f.backend->fail_commands(1);
+    GattCharacteristic c;
+    f.client.find(DEVICE, CONFIG_SERVICE, CONFIG, &c);
+    const uint8_t one[] = { 1 };
+    CHECK(f.backend->write_command(DEVICE, c.handle, one, 1) == LINK_OK);
+    WriteQueue queue(DEVICE);
+    enqueue(queue, 7, false);
+    CHECK(queue.flush(f.client) == LINK_OK);
+    CHECK(f.seen.size() == 1 && f.seen[0] == value(7));
+}
+
+} // namespace
+
+int main() {
+    test_order_and_barriers();
+    test_trailing_commands_complete_when_sent();
+    test_fallbacks();
+    test_lost_command_is_resent();
+    test_lost_command_before_barrier();
+    test_failure_left_by_another_user();
+    return niox_test::finish("test_write_queue");
+}
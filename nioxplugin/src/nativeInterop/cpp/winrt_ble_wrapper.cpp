@@ -2,32 +2,163 @@
 // This provides a C API wrapper around Windows Runtime Bluetooth APIs
 
 #include "winrt_ble_wrapper.h"
+#include "niox_address_filter.h"
+#include "niox_advertisement.h"
+#include "niox_aggregator.h"
+#include "niox_attribute_store.h"
+#include "niox_btsnoop.h"
+#include "niox_connection_pool.h"
+#include "niox_device_table.h"
+#include "niox_fleet.h"
+#include "niox_gatt.h"
+#include "niox_link.h"
+#include "niox_notification_ring.h"
+#include "niox_rpa.h"
+#include "niox_rssi_history.h"
+#include "niox_scan_merge.h"
+#include "niox_scan_log.h"
+#include "niox_scan_plan.h"
+#include "niox_scheduler.h"
+#include "niox_status.h"
+#include "niox_transfer.h"
+#include "niox_uuid.h"
+#include "niox_uuid_match.h"
+#include "niox_wire.h"
+#include "niox_write_queue.h"
 #include <windows.h>
 #include <winrt/Windows.Foundation.h>
 #include <winrt/Windows.Foundation.Collections.h>
 #include <winrt/Windows.Devices.Bluetooth.h>
 #include <winrt/Windows.Devices.Bluetooth.Advertisement.h>
+#include <winrt/Windows.Devices.Bluetooth.GenericAttributeProfile.h>
 #include <winrt/Windows.Devices.Radios.h>
+#include <winrt/Windows.Storage.Streams.h>
 #include <string>
 #include <vector>
 #include <memory>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
+#include <unordered_map>
 
 using namespace winrt;
 using namespace Windows::Devices::Bluetooth;
 using namespace Windows::Devices::Bluetooth::Advertisement;
+using namespace Windows::Devices::Bluetooth::GenericAttributeProfile;
 using namespace Windows::Devices::Radios;
 using namespace Windows::Foundation;
 
 // Global state
 static bool g_initialized = false;
 static BluetoothLEAdvertisementWatcher g_watcher{ nullptr };
-static std::vector<BLEDevice> g_discovered_devices;
+static std::vector<BLEDevice> g_discovered_devices;     // Guarded by g_discovered_mutex
+static std::mutex g_discovered_mutex;
+static const size_t MAX_DISCOVERED_DEVICES = 4096;      // Adverts, not unique devices
 static DeviceFoundCallback g_callback = nullptr;
 static void* g_user_data = nullptr;
 static bool g_niox_only = false;
-static const char* NIOX_PREFIX = "NIOX PRO";
+
+// Device table persists across scans so serial lookups see every unit heard
+// since initialization. Guarded by g_device_mutex (Received runs on the
+// WinRT thread pool).
+static niox::DeviceTable g_device_table;
+static std::mutex g_device_mutex;
+
+// Rows keyed by a private address nobody resolves stop being heard once the
+// address rotates (~15 min); they are swept out after this long. Guarded by
+// g_device_mutex.
+static int64_t g_device_sweep_ms = 0;
+static const int64_t DEVICE_SWEEP_INTERVAL_MS = 60000;
+static const int64_t PRIVATE_ADDRESS_EXPIRY_MS = 30 * 60000;
+
+// Last advertisement per address (address type, connectability, payload)
+// so winrt_connect needs no rescan. Private addresses are swept with the
+// device table rows. Guarded by g_device_mutex.
+static niox::AdvertisementCache g_advertisement_cache;
+
+// Address denylist / allowlist checked first in the Received handler.
+// Lock-free for readers; membership can change while scanning.
+static niox::AddressFilter g_address_filter;
+
+// Recent RSSI of NIOX devices in a fixed slab (winrt_export_rssi_history).
+// Guarded by g_history_mutex.
+static niox::RssiHistory g_rssi_history;
+static std::mutex g_history_mutex;
+
+// On-disk scan log (winrt_scan_log_*). The writer has its own short lock;
+// g_scan_log_active keeps the Received handler off it while not logging.
+// Records carry wall-clock time: monotonic ms + g_scan_log_clock_offset.
+static niox::ScanLogWriter g_scan_log;
+static std::atomic<bool> g_scan_log_active{ false };
+static std::atomic<int64_t> g_scan_log_clock_offset{ 0 };
+static std::mutex g_scan_log_mutex;     // Serializes start / stop
+
+// btsnoop replay (winrt_replay_*): one thread feeding a capture into the
+// scan pipeline. g_replay_stats and g_replay_stop are guarded by
+// g_replay_mutex; g_replay_thread is only touched under g_replay_control_mutex.
+// Replayed adverts reach the device table and the discovery callback but
+// are not kept in g_discovered_devices (t_replaying marks the thread).
+static BLEReplayStats g_replay_stats = {};
+static bool g_replay_stop = false;
+static std::condition_variable g_replay_wake;
+static std::mutex g_replay_mutex;
+static std::mutex g_replay_control_mutex;
+static thread_local bool t_replaying = false;
+static const uint64_t REPLAY_PUBLISH_REPORTS = 4096;   // Counters are published this often
+
+// Owns the replay thread: a replay that ended on its own is still joined,
+// at the latest on exit. Declared after the mutexes it stops through.
+struct ReplayThread {
+    std::thread thread;
+    ~ReplayThread() { winrt_replay_stop(); }
+};
+static ReplayThread g_replay_thread;
+
+// Site fleet membership: the table compiled in (NIOX_COMPILED_FLEET) until
+// winrt_load_fleet replaces it with g_fleet. Guarded by g_device_mutex.
+static niox::Fleet g_fleet;
+static niox::FleetTable g_fleet_table = niox::COMPILED_FLEET;
+
+// Identity resolving keys: private addresses of bonded devices resolve to
+// their identity address, which keys the device table. Guarded by
+// g_identity_mutex.
+static niox::IdentityResolver g_identity_resolver;
+static std::mutex g_identity_mutex;
+
+// Advertisement / scan response pairing ahead of ingest. Guarded by
+// g_merge_mutex; a timeout of 0 delivers every PDU as it arrives.
+static niox::ScanMerger g_scan_merger;
+static std::mutex g_merge_mutex;
+static const int SCAN_MERGE_TICK_MS = 25;
+
+// Scan strategy (winrt_set_scan_strategy) and the outcome of the last scan.
+// Guarded by g_scan_plan_mutex; g_scan_active tells the Received handler
+// whether scan responses can follow.
+static niox::ScanPlan g_scan_plan = { niox::SCAN_ACTIVE, 1500, 2000, -85 };
+static niox::ScanPhaseStats g_scan_phase_stats;
+static uint64_t g_scan_events[2];     // Received events while passive / active
+static std::mutex g_scan_plan_mutex;
+static std::atomic<bool> g_scan_active{ true };
+static std::atomic<uint32_t> g_scan_generation{ 0 };   // Lets a finished scan's timer tell it was superseded
+
+// Clinic-wide aggregation (node and/or collector role)
+static niox::AggregationService g_aggregator;
+
+// Delta-compressed update stream (winrt_wire_*). Guarded by g_wire_mutex.
+static niox::WireEncoder g_wire_encoder;
+static niox::WireFramer g_wire_framer;
+static niox::WireDecoder g_wire_decoder;
+static std::vector<uint8_t> g_wire_pending;
+static uint64_t g_wire_sequence = 0;     // Device table sequence() of the last batch
+static std::mutex g_wire_mutex;
+
+// Helper: Monotonic milliseconds for last-seen timestamps
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 // Helper: Convert wide string to allocated char*
 char* wstring_to_cstring(const std::wstring& wstr) {
@@ -44,24 +175,702 @@ char* hstring_to_cstring(const hstring& hstr) {
     return wstring_to_cstring(wstr);
 }
 
-// Helper: Format Bluetooth address
-char* format_bluetooth_address(uint64_t address) {
-    char* addr_str = new char[18]; // XX:XX:XX:XX:XX:XX + null
-    sprintf_s(addr_str, 18, "%02llX:%02llX:%02llX:%02llX:%02llX:%02llX",
+// Helper: Copy a UTF-8 string into an allocated char*
+char* copy_cstring(const char* str) {
+    if (str == nullptr) return nullptr;
+    size_t length = strlen(str);
+    char* copy = new char[length + 1];
+    memcpy(copy, str, length + 1);
+    return copy;
+}
+
+// Helper: Format Bluetooth address into a caller buffer (at least 18 bytes)
+void format_bluetooth_address_into(uint64_t address, char* buffer, size_t size) {
+    sprintf_s(buffer, size, "%02llX:%02llX:%02llX:%02llX:%02llX:%02llX",
         (address >> 40) & 0xFF,
         (address >> 32) & 0xFF,
         (address >> 24) & 0xFF,
         (address >> 16) & 0xFF,
         (address >> 8) & 0xFF,
         address & 0xFF);
+}
+
+// Helper: Format Bluetooth address
+char* format_bluetooth_address(uint64_t address) {
+    char* addr_str = new char[18]; // XX:XX:XX:XX:XX:XX + null
+    format_bluetooth_address_into(address, addr_str, 18);
     return addr_str;
 }
 
-// Helper: Check if device name starts with NIOX PRO
+// Helper: Check if device name starts with NIOX PRO (any case; the same
+// test that sets DEVICE_FLAG_NIOX_NAME in the device table)
 bool is_niox_device(const char* name) {
-    if (name == nullptr) return false;
-    size_t prefix_len = strlen(NIOX_PREFIX);
-    return strncmp(name, NIOX_PREFIX, prefix_len) == 0;
+    return niox::has_niox_prefix(name);
+}
+
+// Service UUIDs matched against raw advertisement payloads
+niox::UuidMatcher make_service_matcher() {
+    niox::UuidMatcher matcher;
+    matcher.add(niox::NIOX_SERVICE_UUID);
+    return matcher;
+}
+static const niox::UuidMatcher g_service_matcher = make_service_matcher();
+
+// Helper: Rebuild the raw AD payload ([len][type][data]...) from the
+// advertisement's data sections. Returns the payload length.
+size_t collect_advertisement_payload(const BluetoothLEAdvertisement& advertisement, uint8_t* buffer, size_t capacity) {
+    size_t length = 0;
+    for (auto const& section : advertisement.DataSections()) {
+        auto data = section.Data();
+        length = niox::append_ad_structure(buffer, length, capacity, section.DataType(), data.data(), data.Length());
+    }
+    return length;
+}
+
+// Helper: Free the strings of every discovered device and empty the list
+void clear_discovered_devices() {
+    std::lock_guard<std::mutex> lock(g_discovered_mutex);
+    for (auto& device : g_discovered_devices) {
+        if (device.name) delete[] device.name;
+        if (device.address) delete[] device.address;
+    }
+    g_discovered_devices.clear();
+}
+
+// Helper: Feed one advertisement into the scan pipeline
+// Shared by the WinRT watcher and winrt_inject_advertisement: device table,
+// advertisement cache, NIOX filter and discovery callback.
+void ingest_advertisement(const niox::AdvertisementEvent& event) {
+    // Match the raw 128-bit UUID list / service data sections in place
+    // instead of materializing ServiceUuids() as a vector of guids
+    bool has_niox_service = g_service_matcher.match_payload(event.data, event.length) >= 0;
+
+    // Broadcast status (battery, readiness) so dashboards need not connect.
+    // It may come in the advertisement or the scan response.
+    niox::DeviceStatus status;
+    const bool has_status = niox::decode_status(event.data, event.length, &status);
+
+    // A rotating private address is tracked under its identity; the
+    // connect cache stays keyed by the address actually heard
+    uint64_t identity = event.address;
+    if (event.addressType == niox::ADDRESS_RANDOM) {
+        std::lock_guard<std::mutex> lock(g_identity_mutex);
+        identity = g_identity_resolver.resolve(event.address);
+    }
+
+    // Track every device heard; the serial is parsed once per address
+    bool niox_device;
+    uint32_t flags;
+    const bool unresolved_private = event.addressType == niox::ADDRESS_RANDOM && identity == event.address &&
+        niox::is_resolvable_private(event.address);
+    {
+        std::lock_guard<std::mutex> lock(g_device_mutex);
+        if (event.timestampMs - g_device_sweep_ms >= DEVICE_SWEEP_INTERVAL_MS) {
+            g_device_sweep_ms = event.timestampMs;
+            g_device_table.evict(niox::DEVICE_FLAG_PRIVATE, event.timestampMs - PRIVATE_ADDRESS_EXPIRY_MS);
+            g_advertisement_cache.evict_private(event.timestampMs - PRIVATE_ADDRESS_EXPIRY_MS);
+        }
+        uint32_t slot = g_device_table.upsert(identity, event.name, event.rssi, event.timestampMs,
+            (has_niox_service ? niox::DEVICE_FLAG_NIOX_SERVICE : 0) | (unresolved_private ? niox::DEVICE_FLAG_PRIVATE : 0),
+            has_status ? &status : nullptr);
+        g_device_table.set_radio_address(slot, event.address);
+        const uint64_t serial = g_device_table.serial(slot);
+        if (serial != 0) g_device_table.set_flag(slot, niox::DEVICE_FLAG_FLEET, g_fleet_table.contains(serial));
+        g_advertisement_cache.store(event);
+        flags = g_device_table.flags(slot);
+        niox_device = (flags & niox::DEVICE_FLAG_NIOX) != 0;
+    }
+
+    if (g_scan_log_active.load(std::memory_order_relaxed)) {
+        g_scan_log.append(niox::ScanLogRecord{ identity,
+            event.timestampMs + g_scan_log_clock_offset.load(std::memory_order_relaxed),
+            niox::clamp_rssi8(event.rssi), static_cast<uint8_t>(flags) });
+    }
+
+    if (niox_device) {
+        std::lock_guard<std::mutex> lock(g_history_mutex);
+        g_rssi_history.add(identity, event.rssi, event.timestampMs);
+    }
+
+    // A device that keeps naming itself as something else is not a NIOX
+    // unit; once learning is on, its adverts end up dropped on arrival.
+    // Nameless devices are not counted, their name may still be pending.
+    // The filter drops by the address heard, so only stable addresses are
+    // learned; a private one would be denied after the device rotated away.
+    const bool stable_address = event.addressType != niox::ADDRESS_RANDOM || niox::is_static_random(event.address);
+    if (stable_address && event.name != nullptr && event.name[0] != '\0' && !is_niox_device(event.name) &&
+        !has_niox_service) {
+        g_address_filter.observe_irrelevant(event.address);
+    }
+
+    // Apply NIOX filter if needed (name prefix or FDC service UUID)
+    if (g_niox_only && !is_niox_device(event.name) && !has_niox_service) {
+        return;
+    }
+
+    // Create device structure
+    BLEDevice device;
+    device.name = copy_cstring(event.name);
+    device.address = format_bluetooth_address(event.address);
+    device.rssi = event.rssi;
+    device.hasRssi = 1;
+    device.hasNioxService = has_niox_service ? 1 : 0;
+
+    // Store in discovered devices (ingest runs on the WinRT thread pool,
+    // the merge timer and winrt_inject_advertisement callers at once).
+    // Replayed adverts and any past the cap are only handed to the
+    // callback; their strings are freed once it returns.
+    bool kept = false;
+    if (!t_replaying) {
+        std::lock_guard<std::mutex> lock(g_discovered_mutex);
+        if (g_discovered_devices.size() < MAX_DISCOVERED_DEVICES) {
+            g_discovered_devices.push_back(device);
+            kept = true;
+        }
+    }
+
+    // Call callback if provided
+    if (g_callback) {
+        g_callback(device, g_user_data);
+    }
+
+    if (!kept) {
+        delete[] device.name;
+        delete[] device.address;
+    }
+}
+
+// Helper: Pair an advertisement with its scan response before ingest
+// Events are delivered outside g_merge_mutex, so a discovery callback may
+// stop the scan.
+void merge_advertisement(const niox::AdvertisementEvent& event) {
+    niox::MergedAdvertisement merged[2];
+    size_t count = 0;
+    bool enabled;
+    {
+        std::lock_guard<std::mutex> lock(g_merge_mutex);
+        enabled = g_scan_merger.timeout() > 0;
+        if (enabled) count = g_scan_merger.add(event, merged);
+    }
+    if (!enabled) {
+        ingest_advertisement(event);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        ingest_advertisement(merged[i].event());
+    }
+}
+
+// Helper: Deliver held PDUs whose partner is overdue (all of them if flush)
+void deliver_unpaired(bool flush) {
+    niox::MergedAdvertisement merged;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(g_merge_mutex);
+            if (!(flush ? g_scan_merger.take_any(&merged) : g_scan_merger.take_expired(now_ms(), &merged))) return;
+        }
+        ingest_advertisement(merged.event());
+    }
+}
+
+// Helper: Replay a btsnoop capture through the scan pipeline
+// Adverts pass the address filter and scan response pairing like watcher
+// events. rate scales capture time (2 = twice as fast); 0 replays as fast
+// as possible, stamping adverts with the time they are fed in. loops 0
+// repeats the capture until stopped.
+void run_replay(std::shared_ptr<niox::BtsnoopReader> reader, double rate, int loops) {
+    t_replaying = true;
+    const int64_t start = now_ms();
+    int64_t firstUs = INT64_MIN;
+    int64_t loopOffsetMs = 0;           // Capture time of earlier passes
+    int64_t captureMs = 0;
+    int64_t lastTickMs = start;
+    BLEReplayStats local = {};
+    niox::BtsnoopStats previous = {};   // Parser counters of earlier passes
+
+    auto publish = [&](bool running) {
+        const niox::BtsnoopStats& parsed = reader->stats();
+        std::lock_guard<std::mutex> lock(g_replay_mutex);
+        g_replay_stats.records = previous.records + parsed.records;
+        g_replay_stats.events = previous.events + parsed.events;
+        g_replay_stats.reports = previous.reports + parsed.reports;
+        g_replay_stats.extendedReports = previous.extended + parsed.extended;
+        g_replay_stats.malformed = previous.malformed + parsed.malformed;
+        g_replay_stats.delivered = local.delivered;
+        g_replay_stats.filtered = local.filtered;
+        g_replay_stats.loops = local.loops;
+        g_replay_stats.captureMs = captureMs;
+        g_replay_stats.elapsedMs = now_ms() - start;
+        g_replay_stats.running = running ? 1 : 0;
+        return g_replay_stop;
+    };
+
+    niox::BtsnoopAdvertisement advertisement;
+    bool stopped = false;
+    while (!stopped) {
+        bool interrupted = false;
+        while (!interrupted && reader->next(&advertisement)) {
+            if (firstUs == INT64_MIN) firstUs = advertisement.captureUs;
+            captureMs = loopOffsetMs + (advertisement.captureUs - firstUs) / 1000;
+
+            int64_t timestampMs = now_ms();
+            if (rate > 0.0) {
+                const int64_t dueMs = start + static_cast<int64_t>(static_cast<double>(captureMs) / rate);
+                if (dueMs > timestampMs) {
+                    std::unique_lock<std::mutex> lock(g_replay_mutex);
+                    interrupted = g_replay_wake.wait_until(lock,
+                        std::chrono::steady_clock::time_point(std::chrono::milliseconds(dueMs)),
+                        []() { return g_replay_stop; });
+                    if (interrupted) break;
+                }
+                timestampMs = dueMs;
+            }
+
+            const uint64_t reports = local.delivered + local.filtered;
+            if (!g_address_filter.admit(advertisement.address)) {
+                local.filtered++;
+            }
+            else {
+                merge_advertisement(advertisement.event(timestampMs));
+                local.delivered++;
+            }
+
+            const int64_t now = now_ms();
+            if (now - lastTickMs >= SCAN_MERGE_TICK_MS) {
+                lastTickMs = now;
+                deliver_unpaired(false);
+            }
+            if ((reports + 1) % REPLAY_PUBLISH_REPORTS == 0) interrupted = publish(true);
+        }
+
+        if (!interrupted) local.loops++;
+        stopped = interrupted || publish(true) || (loops > 0 && local.loops >= static_cast<uint64_t>(loops)) || reader->stats().reports == 0;
+        if (!stopped) {
+            // Next pass continues the timeline one millisecond after this one
+            const niox::BtsnoopStats& parsed = reader->stats();
+            previous.records += parsed.records;
+            previous.events += parsed.events;
+            previous.reports += parsed.reports;
+            previous.extended += parsed.extended;
+            previous.malformed += parsed.malformed;
+            loopOffsetMs = captureMs + 1;
+            firstUs = INT64_MIN;
+            reader->rewind();
+        }
+    }
+
+    deliver_unpaired(true);
+    publish(false);
+}
+
+// Helper: Convert a WinRT guid to a niox::Uuid
+niox::Uuid guid_to_uuid(const guid& value) {
+    uint64_t lo = 0;
+    for (int i = 0; i < 8; i++) lo = (lo << 8) | value.Data4[i];
+    return niox::Uuid{
+        (static_cast<uint64_t>(value.Data1) << 32) | (static_cast<uint64_t>(value.Data2) << 16) | value.Data3,
+        lo };
+}
+
+// IBufferByteAccess from robuffer.h, declared here because that header's
+// ::Windows namespace is ambiguous with the winrt::Windows using-directives
+struct __declspec(uuid("905a0fef-bc53-11df-8c49-001e4fc686da")) IBufferByteAccess : ::IUnknown {
+    virtual HRESULT __stdcall Buffer(uint8_t** value) = 0;
+};
+
+// Helper: Bytes of an IBuffer in place, without copying
+const uint8_t* buffer_bytes(Windows::Storage::Streams::IBuffer const& buffer) {
+    uint8_t* bytes = nullptr;
+    check_hresult(buffer.as<IBufferByteAccess>()->Buffer(&bytes));
+    return bytes;
+}
+
+// GATT over WinRT, connecting from cached advertisement metadata
+// FromBluetoothAddressAsync with the advertised address type resolves the
+// device without a watcher; a GattSession with MaintainConnection keeps the
+// link up until winrt_disconnect. Windows consumes Service Changed itself and
+// raises GattServicesChanged, which is forwarded as a full-range change.
+class WinRtGattBackend : public niox::GattBackend {
+public:
+    int connect(const niox::CachedAdvertisement& advertisement, int timeoutMs) override {
+        if (is_connected(advertisement.address)) return niox::LINK_OK;
+        if (!advertisement.connectable) return niox::LINK_NOT_CONNECTABLE;
+
+        const TimeSpan timeout = std::chrono::milliseconds(timeoutMs);
+        const auto start = std::chrono::steady_clock::now();
+
+        auto addressType = advertisement.addressType == niox::ADDRESS_RANDOM
+            ? BluetoothAddressType::Random
+            : BluetoothAddressType::Public;
+        auto deviceOp = BluetoothLEDevice::FromBluetoothAddressAsync(advertisement.address, addressType);
+        if (deviceOp.wait_for(timeout) != AsyncStatus::Completed) {
+            deviceOp.Cancel();
+            return niox::LINK_TIMEOUT;
+        }
+        BluetoothLEDevice device = deviceOp.GetResults();
+        if (device == nullptr) return niox::LINK_ERROR;
+
+        const TimeSpan remaining = timeout -
+            std::chrono::duration_cast<TimeSpan>(std::chrono::steady_clock::now() - start);
+        auto sessionOp = GattSession::FromDeviceIdAsync(device.BluetoothDeviceId());
+        if (remaining.count() <= 0 || sessionOp.wait_for(remaining) != AsyncStatus::Completed) {
+            sessionOp.Cancel();
+            device.Close();
+            return niox::LINK_TIMEOUT;
+        }
+        GattSession session = sessionOp.GetResults();
+        if (session == nullptr) {
+            device.Close();
+            return niox::LINK_ERROR;
+        }
+        session.MaintainConnection(true);
+
+        const uint64_t address = advertisement.address;
+        auto servicesChanged = device.GattServicesChanged(auto_revoke,
+            [this, address](BluetoothLEDevice const&, IInspectable const&) {
+                deliver_services_changed(address, 0x0001, 0xFFFF);
+            });
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        Link& link = links_[address];
+        link.device = device;
+        link.session = session;
+        link.servicesChanged = std::move(servicesChanged);
+        return niox::LINK_OK;
+    }
+
+    void disconnect(uint64_t address) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = links_.find(address);
+        if (it == links_.end()) return;
+        close(it->second);
+        links_.erase(it);
+    }
+
+    bool is_connected(uint64_t address) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = links_.find(address);
+        return it != links_.end() &&
+            it->second.device.ConnectionStatus() == BluetoothConnectionStatus::Connected;
+    }
+
+    void disconnect_all() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : links_) close(entry.second);
+        links_.clear();
+    }
+
+    int discover(uint64_t address, std::vector<niox::GattCharacteristic>& out) override {
+        return enumerate(address, BluetoothCacheMode::Uncached, &out);
+    }
+
+    int read(uint64_t address, uint16_t handle, std::vector<uint8_t>& out) override {
+        GattCharacteristic characteristic{ nullptr };
+        int result = resolve(address, handle, &characteristic);
+        if (result != niox::LINK_OK) return result;
+
+        auto value = characteristic.ReadValueAsync(BluetoothCacheMode::Uncached).get();
+        if (value.Status() != GattCommunicationStatus::Success) return niox::LINK_ERROR;
+        auto buffer = value.Value();
+        out.assign(buffer.data(), buffer.data() + buffer.Length());
+        return niox::LINK_OK;
+    }
+
+    int write(uint64_t address, uint16_t handle, const uint8_t* data, size_t length, bool withResponse) override {
+        GattCharacteristic characteristic{ nullptr };
+        int result = resolve(address, handle, &characteristic);
+        if (result != niox::LINK_OK) return result;
+        // A request acknowledges the commands before it, so they must have left first
+        if (withResponse) {
+            result = drain_commands(address);
+            if (result != niox::LINK_OK) return result;
+        }
+
+        Windows::Storage::Streams::Buffer buffer(static_cast<uint32_t>(length));
+        if (length > 0) memcpy(buffer.data(), data, length);
+        buffer.Length(static_cast<uint32_t>(length));
+        auto status = characteristic.WriteValueWithResultAsync(buffer,
+            withResponse ? GattWriteOption::WriteWithResponse : GattWriteOption::WriteWithoutResponse).get();
+        return status.Status() == GattCommunicationStatus::Success ? niox::LINK_OK : niox::LINK_ERROR;
+    }
+
+    int subscribe(uint64_t address, uint16_t handle, bool enable) override {
+        GattCharacteristic characteristic{ nullptr };
+        int result = resolve(address, handle, &characteristic);
+        if (result != niox::LINK_OK) return result;
+
+        auto descriptor = GattClientCharacteristicConfigurationDescriptorValue::None;
+        if (enable) {
+            descriptor = (characteristic.CharacteristicProperties() & GattCharacteristicProperties::Notify) != GattCharacteristicProperties::None
+                ? GattClientCharacteristicConfigurationDescriptorValue::Notify
+                : GattClientCharacteristicConfigurationDescriptorValue::Indicate;
+        }
+
+        GattCharacteristic::ValueChanged_revoker revoker;
+        if (enable) {
+            revoker = characteristic.ValueChanged(auto_revoke,
+                [this, address, handle](GattCharacteristic const&, GattValueChangedEventArgs const& args) {
+                    // Handed on in place: a streaming subscriber copies it straight into its ring
+                    auto buffer = args.CharacteristicValue();
+                    deliver_value(address, handle, buffer_bytes(buffer), buffer.Length());
+                });
+        }
+        auto status = characteristic.WriteClientCharacteristicConfigurationDescriptorAsync(descriptor).get();
+        if (status != GattCommunicationStatus::Success) return niox::LINK_ERROR;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = links_.find(address);
+        if (it == links_.end()) return niox::GATT_NOT_CONNECTED;
+        if (enable) it->second.subscriptions[handle] = std::move(revoker);
+        else it->second.subscriptions.erase(handle);
+        return niox::LINK_OK;
+    }
+
+    // Write commands are issued without waiting for completion. At most
+    // COMMAND_WINDOW are outstanding in the stack; each completion (the
+    // packet left the stack's buffer) frees a slot. A failed completion fails
+    // later commands until drain_commands reports and clears it.
+    int write_command(uint64_t address, uint16_t handle, const uint8_t* data, size_t length) override {
+        GattCharacteristic characteristic{ nullptr };
+        int result = resolve(address, handle, &characteristic);
+        if (result != niox::LINK_OK) return result;
+        std::shared_ptr<CommandWindow> window = command_window(address);
+        if (!window) return niox::GATT_NOT_CONNECTED;
+        {
+            std::unique_lock<std::mutex> lock(window->mutex);
+            if (!window->cv.wait_for(lock, std::chrono::milliseconds(COMMAND_TIMEOUT_MS),
+                    [&window]() { return window->inFlight < COMMAND_WINDOW || window->failed; })) {
+                return niox::LINK_TIMEOUT;
+            }
+            if (window->failed) return niox::LINK_ERROR;
+            window->inFlight++;
+        }
+
+        Windows::Storage::Streams::Buffer buffer(static_cast<uint32_t>(length));
+        if (length > 0) memcpy(buffer.data(), data, length);
+        buffer.Length(static_cast<uint32_t>(length));
+        auto operation = characteristic.WriteValueWithResultAsync(buffer, GattWriteOption::WriteWithoutResponse);
+        operation.Completed([window](IAsyncOperation<GattWriteResult> const& completed, AsyncStatus status) {
+            bool sent = false;
+            try {
+                sent = status == AsyncStatus::Completed &&
+                    completed.GetResults().Status() == GattCommunicationStatus::Success;
+            }
+            catch (...) {}
+            std::lock_guard<std::mutex> lock(window->mutex);
+            window->inFlight--;
+            if (!sent) window->failed = true;
+            window->cv.notify_all();
+        });
+        return niox::LINK_OK;
+    }
+
+    // Wait until every write command has left; reports (and clears) a failed one
+    int drain_commands(uint64_t address) override {
+        std::shared_ptr<CommandWindow> window = command_window(address);
+        if (!window) return niox::GATT_NOT_CONNECTED;
+        std::unique_lock<std::mutex> lock(window->mutex);
+        if (!window->cv.wait_for(lock, std::chrono::milliseconds(COMMAND_TIMEOUT_MS),
+                [&window]() { return window->inFlight == 0; })) {
+            return niox::LINK_TIMEOUT;
+        }
+        const bool failed = window->failed;
+        window->failed = false;
+        return failed ? niox::LINK_ERROR : niox::LINK_OK;
+    }
+
+    // Windows exchanges the largest MTU it supports when the session opens;
+    // the result can only be read
+    int exchange_mtu(uint64_t address, uint16_t desired, uint16_t* mtu) override {
+        GattSession session{ nullptr };
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = links_.find(address);
+            if (it == links_.end()) return niox::GATT_NOT_CONNECTED;
+            session = it->second.session;
+        }
+        const uint16_t granted = session.MaxPduSize();
+        *mtu = granted < desired ? granted : desired;
+        return niox::LINK_OK;
+    }
+
+private:
+    // Outstanding write commands of one link
+    struct CommandWindow {
+        std::mutex mutex;
+        std::condition_variable cv;
+        int inFlight = 0;
+        bool failed = false;
+    };
+
+    static const int COMMAND_WINDOW = 8;
+    static const int COMMAND_TIMEOUT_MS = 5000;
+
+    struct Link {
+        BluetoothLEDevice device{ nullptr };
+        GattSession session{ nullptr };
+        BluetoothLEDevice::GattServicesChanged_revoker servicesChanged;
+        std::unordered_map<uint16_t, GattCharacteristic> characteristics;
+        std::unordered_map<uint16_t, GattCharacteristic::ValueChanged_revoker> subscriptions;
+        std::shared_ptr<CommandWindow> commands = std::make_shared<CommandWindow>();
+    };
+
+    // Helper: Command window of a link, or nullptr when not connected
+    std::shared_ptr<CommandWindow> command_window(uint64_t address) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = links_.find(address);
+        return it == links_.end() ? nullptr : it->second.commands;
+    }
+
+    static void close(Link& link) {
+        try {
+            link.subscriptions.clear();
+            link.servicesChanged.revoke();
+            link.characteristics.clear();
+            link.session.MaintainConnection(false);
+            link.session.Close();
+            link.device.Close();
+        }
+        catch (...) {}
+    }
+
+    // Walk services and characteristics, refreshing the handle -> object map
+    int enumerate(uint64_t address, BluetoothCacheMode mode, std::vector<niox::GattCharacteristic>* out) {
+        BluetoothLEDevice device{ nullptr };
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = links_.find(address);
+            if (it == links_.end()) return niox::GATT_NOT_CONNECTED;
+            device = it->second.device;
+        }
+
+        auto services = device.GetGattServicesAsync(mode).get();
+        if (services.Status() != GattCommunicationStatus::Success) return niox::LINK_ERROR;
+
+        std::unordered_map<uint16_t, GattCharacteristic> objects;
+        for (auto const& service : services.Services()) {
+            auto characteristics = service.GetCharacteristicsAsync(mode).get();
+            if (characteristics.Status() != GattCommunicationStatus::Success) return niox::LINK_ERROR;
+            const niox::Uuid serviceUuid = guid_to_uuid(service.Uuid());
+            for (auto const& characteristic : characteristics.Characteristics()) {
+                const uint16_t handle = characteristic.AttributeHandle();
+                objects.emplace(handle, characteristic);
+                if (out) {
+                    out->push_back(niox::GattCharacteristic{
+                        serviceUuid,
+                        guid_to_uuid(characteristic.Uuid()),
+                        handle,
+                        static_cast<uint8_t>(characteristic.CharacteristicProperties()) });
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = links_.find(address);
+        if (it == links_.end()) return niox::GATT_NOT_CONNECTED;
+        it->second.characteristics.swap(objects);
+        return niox::LINK_OK;
+    }
+
+    // Characteristic object for a value handle. After a reconnect the client
+    // may use handles from its cache; those resolve from the OS attribute cache.
+    int resolve(uint64_t address, uint16_t handle, GattCharacteristic* out) {
+        for (int attempt = 0; attempt < 2; attempt++) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = links_.find(address);
+                if (it == links_.end()) return niox::GATT_NOT_CONNECTED;
+                auto found = it->second.characteristics.find(handle);
+                if (found != it->second.characteristics.end()) {
+                    *out = found->second;
+                    return niox::LINK_OK;
+                }
+            }
+            if (attempt == 0) {
+                int result = enumerate(address, BluetoothCacheMode::Cached, nullptr);
+                if (result != niox::LINK_OK) return result;
+            }
+        }
+        return niox::GATT_NOT_FOUND;
+    }
+
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, Link> links_;
+};
+
+// Active GATT client (WinRT backend by default, simulated peripherals for
+// tests). Callers copy the pointer under g_gatt_mutex and use it without
+// holding the lock. g_simulated_backend is set while the simulation is active.
+static std::shared_ptr<niox::GattClient> g_gatt_client;
+static std::shared_ptr<niox::SimulatedGattBackend> g_simulated_backend;
+static std::mutex g_gatt_mutex;
+
+// Persistent attribute layouts (winrt_gatt_set_cache_file). Guarded by g_gatt_mutex.
+static std::shared_ptr<niox::AttributeStore> g_attribute_store;
+
+// Simulated log devices (winrt_mock_add_log), tied to g_simulated_backend. Guarded by g_gatt_mutex.
+static std::vector<std::unique_ptr<niox::SimulatedLogPeripheral>> g_simulated_logs;
+
+// Notification streaming (winrt_stream_*). g_stream_polled keeps the ring
+// alive while the consumer holds views from winrt_stream_poll.
+static std::shared_ptr<niox::NotificationRing> g_stream_ring;
+static std::shared_ptr<niox::NotificationRing> g_stream_polled;
+static std::mutex g_stream_mutex;
+
+// Batched configuration writes by address (winrt_write_queue_*)
+static std::unordered_map<uint64_t, std::shared_ptr<niox::WriteQueue>> g_write_queues;
+static std::mutex g_write_queue_mutex;
+
+// Log downloads by address: unfinished ones resume on the next call;
+// statistics of the last finished download stay queryable
+static std::unordered_map<uint64_t, std::shared_ptr<niox::LogTransfer>> g_transfers;
+static std::unordered_map<uint64_t, niox::TransferStats> g_finished_transfers;
+static std::mutex g_transfer_mutex;
+
+// Helper: Packed NIOX serial of a tracked device, 0 if unknown
+uint64_t serial_of(uint64_t address) {
+    std::lock_guard<std::mutex> lock(g_device_mutex);
+    int32_t slot = g_device_table.find_by_address(address);
+    return slot == niox::DeviceTable::NO_SLOT ? 0 : g_device_table.serial(static_cast<uint32_t>(slot));
+}
+
+// Helper: New GATT client over a backend (caller holds g_gatt_mutex)
+std::shared_ptr<niox::GattClient> make_gatt_client(std::shared_ptr<niox::GattBackend> backend) {
+    auto client = std::make_shared<niox::GattClient>(backend);
+    if (g_attribute_store) client->set_persistence(g_attribute_store, serial_of);
+    return client;
+}
+
+// Helper: Current GATT client, created on first use
+std::shared_ptr<niox::GattClient> gatt_client() {
+    std::lock_guard<std::mutex> lock(g_gatt_mutex);
+    if (!g_gatt_client) g_gatt_client = make_gatt_client(std::make_shared<WinRtGattBackend>());
+    return g_gatt_client;
+}
+
+// Helper: Connect from the advertisement cache (LINK_NOT_CACHED if never heard)
+int connect_cached(uint64_t address, int timeoutMs) {
+    niox::CachedAdvertisement advertisement;
+    {
+        std::lock_guard<std::mutex> lock(g_device_mutex);
+        const niox::CachedAdvertisement* cached = g_advertisement_cache.find(address);
+        if (cached == nullptr) return niox::LINK_NOT_CACHED;
+        advertisement = *cached;
+    }
+    return gatt_client()->connect(advertisement, timeoutMs);
+}
+
+// Scheduled GATT work for many devices (winrt_schedule_*)
+static niox::ConnectionScheduler g_scheduler;
+
+// Reusable device sessions (winrt_pool_*); scheduler sessions lease from it while running
+static niox::ConnectionPool g_pool;
+
+// Helper: Parse service and characteristic UUID strings
+bool parse_characteristic(const char* service, const char* characteristic, niox::Uuid* serviceUuid, niox::Uuid* characteristicUuid) {
+    if (service == nullptr || characteristic == nullptr) return false;
+    return niox::Uuid::try_parse(service, strlen(service), serviceUuid) &&
+        niox::Uuid::try_parse(characteristic, strlen(characteristic), characteristicUuid);
 }
 
 // Initialize WinRT
@@ -88,12 +897,59 @@ void winrt_cleanup() {
         g_watcher = nullptr;
     }
 
+    winrt_replay_stop();
+    g_scheduler.stop();
+    g_pool.shutdown();
+
     // Free discovered devices
-    for (auto& device : g_discovered_devices) {
-        if (device.name) delete[] device.name;
-        if (device.address) delete[] device.address;
+    clear_discovered_devices();
+
+    {
+        std::lock_guard<std::mutex> lock(g_stream_mutex);
+        g_stream_ring = nullptr;
+        g_stream_polled = nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_write_queue_mutex);
+        g_write_queues.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_transfer_mutex);
+        g_transfers.clear();
+        g_finished_transfers.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_gatt_mutex);
+        if (g_gatt_client) g_gatt_client->backend().disconnect_all();
+        g_simulated_logs.clear();
+        g_gatt_client = nullptr;
+        g_simulated_backend = nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_merge_mutex);
+        g_scan_merger.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_device_mutex);
+        g_device_table.clear();
+        g_advertisement_cache.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_history_mutex);
+        g_rssi_history.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_scan_log_mutex);
+        g_scan_log_active = false;
+        g_scan_log.stop();
     }
-    g_discovered_devices.clear();
 
     g_callback = nullptr;
     g_user_data = nullptr;
@@ -144,6 +1000,44 @@ int winrt_check_bluetooth_state() {
     }
 }
 
+// Helper: Nameless devices heard since sinceMs at or above minRssi
+size_t count_unresolved(int minRssi, int64_t sinceMs) {
+    niox::DeviceFilter filter;
+    filter.minRssi = minRssi;
+    filter.seenSinceMs = sinceMs;
+    filter.requireFlags = 0;
+    filter.anyFlags = 0;
+
+    std::lock_guard<std::mutex> lock(g_device_mutex);
+    static std::vector<uint32_t> matches;   // Reused across calls; guarded by g_device_mutex
+    matches.clear();
+    g_device_table.filter(filter, matches);
+    size_t unresolved = 0;
+    for (uint32_t slot : matches) {
+        if ((g_device_table.flags(slot) & niox::DEVICE_FLAG_HAS_NAME) == 0) unresolved++;
+    }
+    return unresolved;
+}
+
+// Helper: Restart the watcher in active mode (the mode is fixed while it runs)
+bool switch_to_active_scan() {
+    BluetoothLEAdvertisementWatcher watcher = g_watcher;
+    if (!watcher) return false;
+    try {
+        watcher.Stop();
+        for (int i = 0; i < 20 && watcher.Status() == BluetoothLEAdvertisementWatcherStatus::Stopping; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        g_scan_active = true;
+        watcher.ScanningMode(BluetoothLEScanningMode::Active);
+        watcher.Start();
+        return true;
+    }
+    catch (...) {
+        return false;
+    }
+}
+
 // Start BLE scan
 int winrt_start_scan(int durationMs, int nioxOnly, DeviceFoundCallback callback, void* userData) {
     if (!g_initialized) {
@@ -160,56 +1054,65 @@ int winrt_start_scan(int durationMs, int nioxOnly, DeviceFoundCallback callback,
         g_callback = callback;
         g_user_data = userData;
         g_niox_only = (nioxOnly != 0);
-        g_discovered_devices.clear();
+        clear_discovered_devices();
+
+        niox::ScanPlan plan;
+        {
+            std::lock_guard<std::mutex> lock(g_scan_plan_mutex);
+            plan = g_scan_plan;
+            g_scan_events[0] = 0;
+            g_scan_events[1] = 0;
+        }
+        const bool twoPhase = plan.strategy == niox::SCAN_TWO_PHASE;
+        g_scan_active = !twoPhase;
 
         // Create watcher
         g_watcher = BluetoothLEAdvertisementWatcher();
 
-        // Configure watcher
-        g_watcher.ScanningMode(BluetoothLEScanningMode::Active);
+        // Configure watcher (two-phase scans start passive)
+        g_watcher.ScanningMode(twoPhase ? BluetoothLEScanningMode::Passive : BluetoothLEScanningMode::Active);
 
         // Set up advertisement received handler
         g_watcher.Received([](BluetoothLEAdvertisementWatcher const& watcher,
                               BluetoothLEAdvertisementReceivedEventArgs const& args) {
             try {
-                // Get device info
-                uint64_t address = args.BluetoothAddress();
-                int16_t rssi = args.RawSignalStrengthInDBm();
+                // Known-irrelevant addresses are dropped before anything is decoded
+                if (!g_address_filter.admit(args.BluetoothAddress())) return;
+
                 auto advertisement = args.Advertisement();
+                auto type = args.AdvertisementType();
 
                 // Get local name
-                char* name = nullptr;
+                std::string name;
                 auto localName = advertisement.LocalName();
                 if (!localName.empty()) {
-                    name = hstring_to_cstring(localName);
+                    name = to_string(localName);
                 }
 
-                // Apply NIOX filter if needed
-                bool should_report = true;
-                if (g_niox_only && !is_niox_device(name)) {
-                    should_report = false;
-                }
+                uint8_t payload[niox::MAX_CACHED_ADVERTISEMENT];
+                niox::AdvertisementEvent event;
+                event.address = args.BluetoothAddress();
+                event.addressType = args.BluetoothAddressType() == BluetoothAddressType::Random
+                    ? niox::ADDRESS_RANDOM
+                    : niox::ADDRESS_PUBLIC;
+                event.connectable = type == BluetoothLEAdvertisementType::ConnectableUndirected ||
+                    type == BluetoothLEAdvertisementType::ConnectableDirected;
+                // No scan request is sent in passive mode, so no response will follow
+                const bool active = g_scan_active.load();
+                event.scannable = active && (type == BluetoothLEAdvertisementType::ConnectableUndirected ||
+                    type == BluetoothLEAdvertisementType::ScannableUndirected);
+                event.scanResponse = type == BluetoothLEAdvertisementType::ScanResponse;
+                event.rssi = args.RawSignalStrengthInDBm();
+                event.timestampMs = now_ms();
+                event.name = name.empty() ? nullptr : name.c_str();
+                event.data = payload;
+                event.length = collect_advertisement_payload(advertisement, payload, sizeof(payload));
 
-                if (should_report) {
-                    // Create device structure
-                    BLEDevice device;
-                    device.name = name;
-                    device.address = format_bluetooth_address(address);
-                    device.rssi = rssi;
-                    device.hasRssi = 1;
-
-                    // Store in discovered devices
-                    g_discovered_devices.push_back(device);
-
-                    // Call callback if provided
-                    if (g_callback) {
-                        g_callback(device, g_user_data);
-                    }
-                }
-                else {
-                    // Free name if not reporting
-                    if (name) delete[] name;
+                {
+                    std::lock_guard<std::mutex> lock(g_scan_plan_mutex);
+                    g_scan_events[active ? 1 : 0]++;
                 }
+                merge_advertisement(event);
             }
             catch (...) {
                 // Ignore errors in handler
@@ -219,10 +1122,22 @@ int winrt_start_scan(int durationMs, int nioxOnly, DeviceFoundCallback callback,
         // Start watching
         g_watcher.Start();
 
-        // Wait for scan duration in a separate thread
-        std::thread([durationMs]() {
-            std::this_thread::sleep_for(std::chrono::milliseconds(durationMs));
+        // Run the scan phases in a separate thread, delivering
+        // advertisements whose scan response did not arrive in time
+        const int64_t scanStart = now_ms();
+        const uint32_t generation = ++g_scan_generation;
+        std::thread([durationMs, plan, scanStart, generation]() {
+            auto current = [generation]() { return g_scan_generation.load() == generation; };
+            niox::ScanPhaseHooks hooks;
+            hooks.set_mode = [](bool) { return switch_to_active_scan(); };
+            hooks.unresolved = [scanStart](int minRssi) { return count_unresolved(minRssi, scanStart); };
+            hooks.tick = []() { deliver_unpaired(false); };
+            hooks.stopped = [current]() { return !current() || !g_watcher; };
+            niox::ScanPhaseStats stats = niox::run_scan_phases(plan, durationMs, hooks, SCAN_MERGE_TICK_MS);
+            if (!current()) return;
             winrt_stop_scan();
+            std::lock_guard<std::mutex> lock(g_scan_plan_mutex);
+            g_scan_phase_stats = stats;
         }).detach();
 
         return 0;
@@ -242,6 +1157,1579 @@ void winrt_stop_scan() {
         catch (...) {}
         g_watcher = nullptr;
     }
+    deliver_unpaired(true);
+}
+
+// Find device by NIOX serial
+int winrt_find_device_by_serial(const char* serial, unsigned long long* address, int* rssi, long long* ageMs) {
+    if (serial == nullptr) return -1;
+
+    uint64_t packed = niox::parse_serial(serial, strlen(serial));
+    if (packed == 0) return -1;
+
+    std::lock_guard<std::mutex> lock(g_device_mutex);
+    int32_t slot = g_device_table.find_by_serial(packed);
+    if (slot == niox::DeviceTable::NO_SLOT) return 0;
+
+    if (address) *address = g_device_table.address(slot);
+    if (rssi) *rssi = g_device_table.rssi(slot);
+    if (ageMs) *ageMs = now_ms() - g_device_table.last_seen_ms(slot);
+    return 1;
+}
+
+// Helper: Copy advertised status to a device record (-1 for absent fields)
+void fill_status(const niox::DeviceTable& table, uint32_t slot, BLEDeviceRecord* record) {
+    const niox::DeviceStatus& status = table.status(slot);
+    const bool known = (table.flags(slot) & niox::DEVICE_FLAG_HAS_STATUS) != 0;
+    auto field = [&](niox::StatusField f) { return known && status.has(f) ? static_cast<int>(status.get(f)) : -1; };
+    record->hasStatus = known ? 1 : 0;
+    record->batteryPercent = field(niox::STATUS_BATTERY);
+    record->ready = field(niox::STATUS_READY);
+    record->charging = field(niox::STATUS_CHARGING);
+    record->busy = field(niox::STATUS_BUSY);
+    record->error = field(niox::STATUS_ERROR);
+    record->errorCode = field(niox::STATUS_ERROR_CODE);
+    record->testsRemaining = field(niox::STATUS_TESTS_REMAINING);
+}
+
+// Helper: Device table filter for a query
+niox::DeviceFilter device_filter(const BLEDeviceQuery* query) {
+    niox::DeviceFilter filter;
+    filter.minRssi = query->minRssi;
+    filter.seenSinceMs = query->seenWithinMs > 0 ? now_ms() - query->seenWithinMs : INT64_MIN;
+    filter.requireFlags = query->nioxOnly == 2 ? niox::DEVICE_FLAG_FLEET : 0;
+    filter.anyFlags = query->nioxOnly == 1 ? niox::DEVICE_FLAG_NIOX : 0;
+    return filter;
+}
+
+// Helper: Whether a query names a DeviceSortKey; the cast to the enum is
+// only defined for those
+bool valid_sort_key(const BLEDeviceQuery* query) {
+    return query->sortKey >= niox::DEVICE_SORT_NONE && query->sortKey <= niox::DEVICE_SORT_SERIAL;
+}
+
+// Query device table
+int winrt_query_devices(const BLEDeviceQuery* query, BLEDeviceRecord* records, int capacity, int* totalMatches) {
+    if (query == nullptr || (records == nullptr && capacity > 0) || capacity < 0) return -1;
+    if (!valid_sort_key(query)) return -1;
+
+    try {
+        const niox::DeviceFilter filter = device_filter(query);
+
+        size_t limit = query->limit > 0 ? static_cast<size_t>(query->limit) : 0;
+        if (limit == 0 || limit > static_cast<size_t>(capacity)) limit = static_cast<size_t>(capacity);
+        if (limit == 0) {
+            // Count-only query
+            std::lock_guard<std::mutex> lock(g_device_mutex);
+            std::vector<uint32_t> matches;
+            g_device_table.filter(filter, matches);
+            if (totalMatches) *totalMatches = static_cast<int>(matches.size());
+            return 0;
+        }
+
+        std::lock_guard<std::mutex> lock(g_device_mutex);
+        static std::vector<uint32_t> page;  // Reused across queries; guarded by g_device_mutex
+        size_t total = g_device_table.query(filter,
+            static_cast<niox::DeviceSortKey>(query->sortKey),
+            query->offset > 0 ? static_cast<size_t>(query->offset) : 0,
+            limit, page);
+        if (totalMatches) *totalMatches = static_cast<int>(total);
+
+        const int64_t now = now_ms();
+        for (size_t i = 0; i < page.size(); i++) {
+            const uint32_t slot = page[i];
+            BLEDeviceRecord& record = records[i];
+            record.rawAddress = g_device_table.address(slot);
+            record.radioAddress = g_device_table.radio_address(slot);
+            format_bluetooth_address_into(record.rawAddress, record.address, sizeof(record.address));
+
+            record.name[0] = '\0';
+            if (const char* name = g_device_table.name(slot)) {
+                size_t len = g_device_table.name_length(slot);
+                if (len >= sizeof(record.name)) len = sizeof(record.name) - 1;
+                memcpy(record.name, name, len);
+                record.name[len] = '\0';
+            }
+
+            record.serialNumber[0] = '\0';
+            niox::format_serial(g_device_table.serial(slot), record.serialNumber, sizeof(record.serialNumber));
+
+            record.rssi = g_device_table.rssi(slot);
+            record.ageMs = static_cast<int>(now - g_device_table.last_seen_ms(slot));
+            record.isNioxDevice = (g_device_table.flags(slot) & niox::DEVICE_FLAG_NIOX) ? 1 : 0;
+            record.inFleet = (g_device_table.flags(slot) & niox::DEVICE_FLAG_FLEET) ? 1 : 0;
+            fill_status(g_device_table, slot, &record);
+        }
+        return static_cast<int>(page.size());
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Connect to a device from its cached advertisement
+int winrt_connect(unsigned long long address, int timeoutMs, int* elapsedMs) {
+    if (timeoutMs <= 0) return niox::LINK_ERROR;
+
+    try {
+        const int64_t start = now_ms();
+        int result = connect_cached(address, timeoutMs);
+        if (elapsedMs) *elapsedMs = static_cast<int>(now_ms() - start);
+        return result;
+    }
+    catch (...) {
+        return niox::LINK_ERROR;
+    }
+}
+
+// Disconnect a device
+void winrt_disconnect(unsigned long long address) {
+    try {
+        g_pool.forget(address);
+        gatt_client()->disconnect(address);
+    }
+    catch (...) {}
+}
+
+// Check link state
+int winrt_is_connected(unsigned long long address) {
+    try {
+        return gatt_client()->is_connected(address) ? 1 : 0;
+    }
+    catch (...) {
+        return 0;
+    }
+}
+
+// Switch between the WinRT backend and simulated peripherals
+void winrt_use_mock_backend(int enabled, int connectLatencyMs) {
+    std::lock_guard<std::mutex> lock(g_gatt_mutex);
+    if (g_gatt_client) g_gatt_client->backend().disconnect_all();
+    g_simulated_logs.clear();
+    if (enabled) {
+        g_simulated_backend = std::make_shared<niox::SimulatedGattBackend>(connectLatencyMs);
+        g_gatt_client = make_gatt_client(g_simulated_backend);
+    }
+    else {
+        g_simulated_backend = nullptr;
+        g_gatt_client = nullptr;
+    }
+}
+
+// Helper: Parse a 32-digit hex IRK, most significant byte first
+bool parse_irk(const char* text, uint8_t irk[niox::IRK_SIZE]) {
+    if (text == nullptr || strlen(text) != niox::IRK_SIZE * 2) return false;
+    for (size_t i = 0; i < niox::IRK_SIZE * 2; i++) {
+        const char c = text[i];
+        int nibble;
+        if (c >= '0' && c <= '9') nibble = c - '0';
+        else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+        else return false;
+        irk[i / 2] = static_cast<uint8_t>((i % 2) ? (irk[i / 2] | nibble) : (nibble << 4));
+    }
+    return true;
+}
+
+// Helper: Move device table rows of private addresses that a key now
+// resolves under their identity address
+void fold_resolved_devices() {
+    std::vector<uint64_t> addresses;
+    {
+        std::lock_guard<std::mutex> lock(g_device_mutex);
+        niox::DeviceFilter filter;
+        filter.minRssi = INT32_MIN;
+        filter.seenSinceMs = INT64_MIN;
+        filter.requireFlags = niox::DEVICE_FLAG_PRIVATE;
+        filter.anyFlags = 0;
+        std::vector<uint32_t> slots;
+        g_device_table.filter(filter, slots);
+        for (uint32_t slot : slots) addresses.push_back(g_device_table.address(slot));
+    }
+    if (addresses.empty()) return;
+
+    std::vector<uint64_t> identities(addresses);
+    {
+        std::lock_guard<std::mutex> lock(g_identity_mutex);
+        g_identity_resolver.resolve(identities.data(), identities.size());
+    }
+
+    std::lock_guard<std::mutex> lock(g_device_mutex);
+    for (size_t i = 0; i < addresses.size(); i++) {
+        if (identities[i] != addresses[i]) g_device_table.fold(addresses[i], identities[i]);
+    }
+}
+
+// Add or replace the identity resolving key of a bonded device
+int winrt_add_identity_key(unsigned long long identityAddress, const char* irk) {
+    uint8_t key[niox::IRK_SIZE];
+    if (!parse_irk(irk, key)) return -1;
+
+    try {
+        {
+            std::lock_guard<std::mutex> lock(g_identity_mutex);
+            g_identity_resolver.add_key(identityAddress, key);
+        }
+        fold_resolved_devices();
+        return 0;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Forget an identity resolving key
+int winrt_remove_identity_key(unsigned long long identityAddress) {
+    std::lock_guard<std::mutex> lock(g_identity_mutex);
+    return g_identity_resolver.remove_key(identityAddress) ? 0 : -1;
+}
+
+// Resolve addresses in place to identity addresses
+int winrt_resolve_addresses(unsigned long long* addresses, int count) {
+    if (count < 0 || (count > 0 && addresses == nullptr)) return -1;
+
+    try {
+        static_assert(sizeof(unsigned long long) == sizeof(uint64_t), "address width");
+        std::lock_guard<std::mutex> lock(g_identity_mutex);
+        return static_cast<int>(g_identity_resolver.resolve(reinterpret_cast<uint64_t*>(addresses), static_cast<size_t>(count)));
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Get identity resolution counters
+void winrt_identity_stats(BLEIdentityStats* stats) {
+    if (stats == nullptr) return;
+    std::lock_guard<std::mutex> lock(g_identity_mutex);
+    niox::IdentityResolverStats resolver = g_identity_resolver.stats();
+    stats->keys = static_cast<int>(resolver.keys);
+    stats->cached = static_cast<int>(resolver.cached);
+    stats->lookups = resolver.lookups;
+    stats->cacheHits = resolver.cacheHits;
+    stats->resolved = resolver.resolved;
+    stats->unresolved = resolver.unresolved;
+    stats->aesBlocks = resolver.aesBlocks;
+    stats->hardwareAes = resolver.hardware ? 1 : 0;
+}
+
+// Query per-device advert statistics (same filter, order and paging as winrt_query_devices)
+int winrt_query_device_stats(const BLEDeviceQuery* query, BLEDeviceStats* stats, int capacity, int* totalMatches) {
+    if (query == nullptr || (stats == nullptr && capacity > 0) || capacity < 0) return -1;
+    if (!valid_sort_key(query)) return -1;
+
+    try {
+        const niox::DeviceFilter filter = device_filter(query);
+        size_t limit = query->limit > 0 ? static_cast<size_t>(query->limit) : 0;
+        if (limit == 0 || limit > static_cast<size_t>(capacity)) limit = static_cast<size_t>(capacity);
+
+        std::lock_guard<std::mutex> lock(g_device_mutex);
+        std::vector<uint32_t> page;
+        if (limit == 0) {
+            // Count-only query
+            g_device_table.filter(filter, page);
+            if (totalMatches) *totalMatches = static_cast<int>(page.size());
+            return 0;
+        }
+        size_t total = g_device_table.query(filter,
+            static_cast<niox::DeviceSortKey>(query->sortKey),
+            query->offset > 0 ? static_cast<size_t>(query->offset) : 0,
+            limit, page);
+        if (totalMatches) *totalMatches = static_cast<int>(total);
+
+        const int64_t now = now_ms();
+        for (size_t i = 0; i < page.size(); i++) {
+            const uint32_t slot = page[i];
+            const niox::DeviceStats& device = g_device_table.stats(slot);
+            BLEDeviceStats& out = stats[i];
+            out.rawAddress = g_device_table.address(slot);
+            format_bluetooth_address_into(out.rawAddress, out.address, sizeof(out.address));
+            out.serialNumber[0] = '\0';
+            niox::format_serial(g_device_table.serial(slot), out.serialNumber, sizeof(out.serialNumber));
+            out.adverts = device.adverts;
+            out.firstSeenAgeMs = now - device.firstSeenMs;
+            out.lastSeenAgeMs = now - device.lastSeenMs;
+            out.rssiMin = device.rssiMin;
+            out.rssiMax = device.rssiMax;
+            out.rssiMean = device.rssiMean;
+            out.rssiStdDev = std::sqrt(device.rssi_variance());
+            out.intervalMs = device.gaps > 0 ? device.intervalMs : -1.0;
+            out.receiveRatio = device.receive_ratio();
+            out.scanWindowMs = static_cast<int>(niox::scan_window_ms(device, 0.95));
+        }
+        return static_cast<int>(page.size());
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Scan length needed to hear every matching device with the given confidence
+int winrt_suggest_scan_window(const BLEDeviceQuery* query, double confidence, int* devices) {
+    if (query == nullptr || confidence < 0.0 || confidence > 1.0) return -1;
+
+    try {
+        const niox::DeviceFilter filter = device_filter(query);
+        std::lock_guard<std::mutex> lock(g_device_mutex);
+        std::vector<uint32_t> matches;
+        g_device_table.filter(filter, matches);
+
+        int64_t window = -1;
+        int counted = 0;
+        for (uint32_t slot : matches) {
+            const int64_t needed = niox::scan_window_ms(g_device_table.stats(slot), confidence);
+            if (needed < 0) continue;
+            counted++;
+            if (needed > window) window = needed;
+        }
+        if (devices) *devices = counted;
+        return window > INT32_MAX ? INT32_MAX : static_cast<int>(window);
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Size the RSSI history slab; drops the history kept so far
+int winrt_configure_rssi_history(int maxDevices, int rawSamples, int secondBuckets, int tenSecondBuckets) {
+    const int limit = 65535;
+    if (maxDevices < 0 || maxDevices > 4096 || rawSamples < 0 || rawSamples > limit ||
+        secondBuckets < 0 || secondBuckets > limit || tenSecondBuckets < 0 || tenSecondBuckets > limit) return -1;
+
+    try {
+        niox::RssiHistoryConfig config = { static_cast<uint32_t>(maxDevices),
+            { static_cast<uint32_t>(rawSamples), static_cast<uint32_t>(secondBuckets), static_cast<uint32_t>(tenSecondBuckets) } };
+        std::lock_guard<std::mutex> lock(g_history_mutex);
+        g_rssi_history.configure(config);
+        return 0;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Export RSSI history for charts: one device, or all (address 0)
+int winrt_export_rssi_history(unsigned long long address, int windowMs, BLERssiPoint* points, int capacity, int* total) {
+    if (windowMs < 0 || capacity < 0 || (capacity > 0 && points == nullptr)) return -1;
+
+    try {
+        const int64_t now = now_ms();
+        const int64_t since = windowMs > 0 ? now - windowMs : INT64_MIN;
+        std::lock_guard<std::mutex> lock(g_history_mutex);
+
+        std::vector<uint64_t> addresses;
+        if (address != 0) addresses.push_back(address);
+        else g_rssi_history.addresses(addresses);
+        std::sort(addresses.begin(), addresses.end());
+
+        static std::vector<niox::RssiPoint> series;     // Reused; guarded by g_history_mutex
+        const niox::RssiHistoryConfig& config = g_rssi_history.config();
+        series.resize(static_cast<size_t>(config.capacity[0]) + config.capacity[1] + config.capacity[2] + niox::RSSI_TIERS);
+
+        int written = 0;
+        int available = 0;
+        for (uint64_t device : addresses) {
+            const size_t count = g_rssi_history.export_series(device, since, series.data(), series.size());
+            for (size_t i = 0; i < count && i < series.size(); i++, available++) {
+                if (written >= capacity) continue;
+                const niox::RssiPoint& point = series[i];
+                BLERssiPoint& out = points[written++];
+                out.rawAddress = device;
+                out.ageMs = static_cast<int>(now - point.timeMs);
+                out.widthMs = point.widthMs;
+                out.rssiMin = point.min;
+                out.rssiMax = point.max;
+                out.rssiMean = point.mean;
+                out.count = point.count;
+            }
+        }
+        if (total) *total = available;
+        return written;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Start appending every advert to an on-disk scan log
+int winrt_scan_log_start(const char* path, int flushIntervalMs, int maxBufferedRecords) {
+    if (path == nullptr || path[0] == '\0' || flushIntervalMs < 0 || maxBufferedRecords < 0) return -1;
+
+    try {
+        std::lock_guard<std::mutex> lock(g_scan_log_mutex);
+        g_scan_log_active = false;
+        const int64_t wallMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        g_scan_log_clock_offset = wallMs - now_ms();
+        if (!g_scan_log.start(path, flushIntervalMs > 0 ? flushIntervalMs : 1000,
+                              maxBufferedRecords > 0 ? static_cast<size_t>(maxBufferedRecords) : 65536)) return -1;
+        g_scan_log_active = true;
+        return 0;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Flush and close the scan log
+void winrt_scan_log_stop() {
+    try {
+        std::lock_guard<std::mutex> lock(g_scan_log_mutex);
+        g_scan_log_active = false;
+        g_scan_log.stop();
+    }
+    catch (...) {
+    }
+}
+
+// Get scan log counters
+void winrt_scan_log_stats(BLEScanLogStats* stats) {
+    if (stats == nullptr) return;
+    const niox::ScanLogStats current = g_scan_log.stats();
+    stats->records = current.records;
+    stats->blocks = current.blocks;
+    stats->bytes = current.bytes;
+    stats->dropped = current.dropped;
+    stats->pending = static_cast<int>(current.pending);
+    stats->active = g_scan_log_active ? 1 : 0;
+}
+
+// Range scan over a scan log by time
+int winrt_scan_log_query(const char* path, long long fromMs, long long toMs,
+                         BLEScanLogRecord* records, int capacity, int* total) {
+    if (path == nullptr || capacity < 0 || (capacity > 0 && records == nullptr)) return -1;
+
+    try {
+        niox::ScanLogReader reader;
+        if (!reader.open(path)) return -1;
+        int written = 0;
+        const uint64_t matched = reader.scan(fromMs, toMs, [&](const niox::ScanLogRecord& record) {
+            if (written >= capacity) return;
+            BLEScanLogRecord& out = records[written++];
+            out.rawAddress = record.address;
+            out.timeMs = record.timeMs;
+            out.rssi = record.rssi;
+            out.isNioxDevice = (record.flags & niox::DEVICE_FLAG_NIOX) != 0 ? 1 : 0;
+            out.inFleet = (record.flags & niox::DEVICE_FLAG_FLEET) != 0 ? 1 : 0;
+            out.hasStatus = (record.flags & niox::DEVICE_FLAG_HAS_STATUS) != 0 ? 1 : 0;
+        });
+        if (total) *total = matched > INT32_MAX ? INT32_MAX : static_cast<int>(matched);
+        return written;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Replace the site fleet (NULL or empty restores the compiled-in table)
+int winrt_load_fleet(const char* manifest) {
+    try {
+        std::vector<uint64_t> serials;
+        if (manifest != nullptr && niox::parse_fleet_manifest(manifest, serials) < 0) return -1;
+
+        std::lock_guard<std::mutex> lock(g_device_mutex);
+        if (serials.empty()) {
+            g_fleet_table = niox::COMPILED_FLEET;
+        }
+        else {
+            if (!g_fleet.build(serials)) return -1;
+            g_fleet_table = g_fleet.table();
+        }
+
+        // Re-flag devices already tracked
+        for (uint32_t slot = 0; slot < g_device_table.size(); slot++) {
+            const uint64_t serial = g_device_table.serial(slot);
+            if (serial != 0) g_device_table.set_flag(slot, niox::DEVICE_FLAG_FLEET, g_fleet_table.contains(serial));
+        }
+        return static_cast<int>(g_fleet_table.size);
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Check whether a serial belongs to the site fleet
+int winrt_fleet_contains(const char* serial) {
+    if (serial == nullptr) return -1;
+    const uint64_t packed = niox::parse_serial(serial, strlen(serial));
+    if (packed == 0) return -1;
+    std::lock_guard<std::mutex> lock(g_device_mutex);
+    return g_fleet_table.contains(packed) ? 1 : 0;
+}
+
+// Number of serials in the active fleet table
+int winrt_fleet_size(int* compiled) {
+    std::lock_guard<std::mutex> lock(g_device_mutex);
+    if (compiled) *compiled = g_fleet_table.keys == niox::COMPILED_FLEET.keys ? 1 : 0;
+    return static_cast<int>(g_fleet_table.size);
+}
+
+// Add an address to the denylist (0) or allowlist (1)
+int winrt_address_filter_add(int list, unsigned long long address) {
+    if (list != niox::ADDRESS_DENY && list != niox::ADDRESS_ALLOW) return -1;
+
+    try {
+        g_address_filter.add(static_cast<niox::AddressList>(list), address);
+        return 0;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Remove an address from the denylist (0) or allowlist (1)
+int winrt_address_filter_remove(int list, unsigned long long address) {
+    if (list != niox::ADDRESS_DENY && list != niox::ADDRESS_ALLOW) return -1;
+
+    try {
+        return g_address_filter.remove(static_cast<niox::AddressList>(list), address) ? 0 : -1;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Empty the denylist (0) or allowlist (1)
+int winrt_address_filter_clear(int list) {
+    if (list != niox::ADDRESS_DENY && list != niox::ADDRESS_ALLOW) return -1;
+
+    try {
+        g_address_filter.set(static_cast<niox::AddressList>(list), std::vector<uint64_t>());
+        return 0;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Deny devices heard with a non-NIOX name threshold times (0 stops learning)
+int winrt_address_filter_learn(int threshold, int capacity) {
+    if (threshold < 0 || capacity < 0) return -1;
+    g_address_filter.set_learning(static_cast<uint32_t>(threshold), static_cast<size_t>(capacity));
+    return 0;
+}
+
+// Get address filter counters
+void winrt_address_filter_stats(BLEAddressFilterStats* stats) {
+    if (stats == nullptr) return;
+    niox::AddressFilterStats filter = g_address_filter.stats();
+    stats->checked = filter.checked;
+    stats->denied = filter.denied;
+    stats->notAllowed = filter.notAllowed;
+    stats->bloomFalsePositives = filter.bloomFalsePositives;
+    stats->learned = filter.learned;
+    stats->denySize = static_cast<int>(filter.denySize);
+    stats->allowSize = static_cast<int>(filter.allowSize);
+}
+
+// Choose between always-active and two-phase scanning
+int winrt_set_scan_strategy(int strategy, int passiveMs, int activeMs, int minRssi) {
+    if ((strategy != niox::SCAN_ACTIVE && strategy != niox::SCAN_TWO_PHASE) || passiveMs < 0 || activeMs < 0) return -1;
+    std::lock_guard<std::mutex> lock(g_scan_plan_mutex);
+    g_scan_plan.strategy = strategy;
+    g_scan_plan.passiveMs = passiveMs;
+    g_scan_plan.activeMs = activeMs;
+    g_scan_plan.minRssi = minRssi;
+    return 0;
+}
+
+// Get the phase breakdown of the last completed scan
+void winrt_scan_phase_stats(BLEScanPhaseStats* stats) {
+    if (stats == nullptr) return;
+    std::lock_guard<std::mutex> lock(g_scan_plan_mutex);
+    stats->strategy = g_scan_phase_stats.strategy;
+    stats->passiveMs = static_cast<int>(g_scan_phase_stats.passiveMs);
+    stats->activeMs = static_cast<int>(g_scan_phase_stats.activeMs);
+    stats->candidates = static_cast<int>(g_scan_phase_stats.candidates);
+    stats->unresolved = static_cast<int>(g_scan_phase_stats.unresolved);
+    stats->resolvedMs = static_cast<int>(g_scan_phase_stats.resolvedMs);
+    stats->passiveEvents = g_scan_events[0];
+    stats->activeEvents = g_scan_events[1];
+}
+
+// Set how long an advertisement waits for its scan response
+int winrt_set_scan_merge_timeout(int timeoutMs) {
+    if (timeoutMs < 0) return -1;
+    {
+        std::lock_guard<std::mutex> lock(g_merge_mutex);
+        g_scan_merger.set_timeout(timeoutMs);
+    }
+    if (timeoutMs == 0) deliver_unpaired(true);
+    return 0;
+}
+
+// Get scan merge counters
+void winrt_scan_merge_stats(BLEScanMergeStats* stats) {
+    if (stats == nullptr) return;
+    std::lock_guard<std::mutex> lock(g_merge_mutex);
+    niox::ScanMergeStats merge = g_scan_merger.stats();
+    stats->received = merge.received;
+    stats->delivered = merge.delivered;
+    stats->merged = merge.merged;
+    stats->passedThrough = merge.passedThrough;
+    stats->timedOut = merge.timedOut;
+    stats->superseded = merge.superseded;
+    stats->pending = static_cast<int>(merge.pending);
+    stats->timeoutMs = static_cast<int>(g_scan_merger.timeout());
+}
+
+// Inject an advertisement into the scan pipeline
+int winrt_inject_advertisement(unsigned long long address, int addressType, int connectable, int rssi,
+                               const char* name, const unsigned char* data, int length) {
+    if (length < 0 || (length > 0 && data == nullptr)) return -1;
+
+    try {
+        if (!g_address_filter.admit(address)) return 0;
+
+        niox::AdvertisementEvent event;
+        event.address = address;
+        event.addressType = static_cast<uint8_t>(addressType);
+        event.connectable = connectable != 0;
+        event.scannable = false;
+        event.scanResponse = false;
+        event.rssi = rssi;
+        event.timestampMs = now_ms();
+        event.name = name;
+        event.data = data;
+        event.length = static_cast<size_t>(length);
+        ingest_advertisement(event);
+        return 0;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Replay a btsnoop capture through the scan pipeline on a background thread
+int winrt_replay_start(const char* path, double rate, int loops) {
+    if (path == nullptr || rate < 0.0 || loops < 0) return -1;
+
+    try {
+        auto reader = std::make_shared<niox::BtsnoopReader>();
+        if (!reader->open(path)) return -1;
+
+        winrt_replay_stop();
+        std::lock_guard<std::mutex> control(g_replay_control_mutex);
+        {
+            std::lock_guard<std::mutex> lock(g_replay_mutex);
+            g_replay_stats = BLEReplayStats();
+            g_replay_stats.running = 1;
+            g_replay_stop = false;
+        }
+        g_replay_thread.thread = std::thread(run_replay, reader, rate, loops);
+        return 0;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Stop a running replay (adverts held for pairing are delivered)
+void winrt_replay_stop() {
+    try {
+        std::lock_guard<std::mutex> control(g_replay_control_mutex);
+        {
+            std::lock_guard<std::mutex> lock(g_replay_mutex);
+            g_replay_stop = true;
+        }
+        g_replay_wake.notify_all();
+        if (!g_replay_thread.thread.joinable()) return;
+        // Called from a discovery callback the thread cannot wait for itself
+        if (g_replay_thread.thread.get_id() == std::this_thread::get_id()) g_replay_thread.thread.detach();
+        else g_replay_thread.thread.join();
+    }
+    catch (...) {
+    }
+}
+
+// Get replay progress
+void winrt_replay_stats(BLEReplayStats* stats) {
+    if (stats == nullptr) return;
+    std::lock_guard<std::mutex> lock(g_replay_mutex);
+    *stats = g_replay_stats;
+}
+
+// Discover GATT characteristics
+int winrt_gatt_discover(unsigned long long address, BLEGattCharacteristic* characteristics, int capacity, int* total) {
+    if (capacity < 0 || (capacity > 0 && characteristics == nullptr)) return niox::LINK_ERROR;
+
+    try {
+        std::vector<niox::GattCharacteristic> found;
+        int result = gatt_client()->discover(address, found);
+        if (result != niox::LINK_OK) return result;
+
+        if (total) *total = static_cast<int>(found.size());
+        int count = static_cast<int>(found.size()) < capacity ? static_cast<int>(found.size()) : capacity;
+        for (int i = 0; i < count; i++) {
+            BLEGattCharacteristic& record = characteristics[i];
+            niox::format_uuid(found[i].service, record.serviceUuid, sizeof(record.serviceUuid));
+            niox::format_uuid(found[i].characteristic, record.characteristicUuid, sizeof(record.characteristicUuid));
+            record.handle = found[i].handle;
+            record.properties = found[i].properties;
+        }
+        return count;
+    }
+    catch (...) {
+        return niox::LINK_ERROR;
+    }
+}
+
+// Read a GATT characteristic
+int winrt_gatt_read(unsigned long long address, const char* service, const char* characteristic,
+                    unsigned char* buffer, int capacity, int* fromCache) {
+    niox::Uuid serviceUuid;
+    niox::Uuid characteristicUuid;
+    if (!parse_characteristic(service, characteristic, &serviceUuid, &characteristicUuid)) return niox::LINK_ERROR;
+    if (capacity < 0 || (capacity > 0 && buffer == nullptr)) return niox::LINK_ERROR;
+
+    try {
+        std::vector<uint8_t> value;
+        bool cached = false;
+        int result = gatt_client()->read(address, serviceUuid, characteristicUuid, value, &cached);
+        if (result != niox::LINK_OK) return result;
+        if (value.size() > static_cast<size_t>(capacity)) return niox::GATT_NO_SPACE;
+
+        if (!value.empty()) memcpy(buffer, value.data(), value.size());
+        if (fromCache) *fromCache = cached ? 1 : 0;
+        return static_cast<int>(value.size());
+    }
+    catch (...) {
+        return niox::LINK_ERROR;
+    }
+}
+
+// Write a GATT characteristic
+int winrt_gatt_write(unsigned long long address, const char* service, const char* characteristic,
+                     const unsigned char* data, int length, int withResponse) {
+    niox::Uuid serviceUuid;
+    niox::Uuid characteristicUuid;
+    if (!parse_characteristic(service, characteristic, &serviceUuid, &characteristicUuid)) return niox::LINK_ERROR;
+    if (length < 0 || (length > 0 && data == nullptr)) return niox::LINK_ERROR;
+
+    try {
+        return gatt_client()->write(address, serviceUuid, characteristicUuid, data, static_cast<size_t>(length), withResponse != 0);
+    }
+    catch (...) {
+        return niox::LINK_ERROR;
+    }
+}
+
+// Subscribe to GATT notifications or indications
+int winrt_gatt_subscribe(unsigned long long address, const char* service, const char* characteristic,
+                         GattValueCallback callback, void* userData) {
+    niox::Uuid serviceUuid;
+    niox::Uuid characteristicUuid;
+    if (!parse_characteristic(service, characteristic, &serviceUuid, &characteristicUuid)) return niox::LINK_ERROR;
+
+    try {
+        niox::GattValueHandler handler;
+        if (callback) {
+            handler = [callback, userData](uint64_t device, uint16_t handle, const uint8_t* data, size_t length) {
+                callback(device, handle, data, static_cast<int>(length), userData);
+            };
+        }
+        return gatt_client()->subscribe(address, serviceUuid, characteristicUuid, handler);
+    }
+    catch (...) {
+        return niox::LINK_ERROR;
+    }
+}
+
+// Get GATT cache statistics
+void winrt_gatt_stats(BLEGattStats* stats) {
+    if (stats == nullptr) return;
+    niox::GattStats current = gatt_client()->stats();
+    stats->discoveries = current.discoveries;
+    stats->cachedDiscoveries = current.cachedDiscoveries;
+    stats->persistedDiscoveries = current.persistedDiscoveries;
+    stats->radioReads = current.radioReads;
+    stats->cachedReads = current.cachedReads;
+    stats->invalidations = current.invalidations;
+}
+
+// Persist discovered attribute layouts in a file
+int winrt_gatt_set_cache_file(const char* path) {
+    try {
+        std::shared_ptr<niox::AttributeStore> store;
+        if (path != nullptr && path[0] != '\0') {
+            store = std::make_shared<niox::AttributeStore>();
+            if (!store->open(path)) return -1;
+        }
+
+        std::lock_guard<std::mutex> lock(g_gatt_mutex);
+        g_attribute_store = store;
+        if (g_gatt_client) g_gatt_client->set_persistence(store, serial_of);
+        return 0;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Get persistent attribute cache statistics
+void winrt_gatt_cache_stats(BLEAttributeCacheStats* stats) {
+    if (stats == nullptr) return;
+    std::shared_ptr<niox::AttributeStore> store;
+    {
+        std::lock_guard<std::mutex> lock(g_gatt_mutex);
+        store = g_attribute_store;
+    }
+    niox::AttributeStoreStats current = store ? store->stats() : niox::AttributeStoreStats();
+    stats->lookups = current.lookups;
+    stats->hits = current.hits;
+    stats->misses = current.misses;
+    stats->stale = current.stale;
+    stats->writes = current.writes;
+    stats->entries = current.entries;
+}
+
+// Start the connection scheduler
+int winrt_scheduler_start(int maxSessions, int quantum, int connectTimeoutMs) {
+    if (maxSessions <= 0 || connectTimeoutMs <= 0) return -1;
+
+    niox::SessionHooks hooks;
+    hooks.open = [connectTimeoutMs](uint64_t address) {
+        try {
+            if (g_pool.running()) return g_pool.acquire(address);
+            return connect_cached(address, connectTimeoutMs);
+        }
+        catch (...) {
+            return niox::LINK_ERROR;
+        }
+    };
+    hooks.close = [](uint64_t address) {
+        try {
+            if (g_pool.running()) g_pool.release(address);
+            else gatt_client()->disconnect(address);
+        }
+        catch (...) {}
+    };
+    return g_scheduler.start(maxSessions, quantum, hooks) ? 0 : -1;
+}
+
+// Stop the connection scheduler
+void winrt_scheduler_stop() {
+    g_scheduler.stop();
+}
+
+// Queue a characteristic read
+long long winrt_schedule_read(unsigned long long address, const char* service, const char* characteristic,
+                              int priority, ScheduledOperationCallback callback, void* userData) {
+    niox::Uuid serviceUuid;
+    niox::Uuid characteristicUuid;
+    if (!parse_characteristic(service, characteristic, &serviceUuid, &characteristicUuid)) return -1;
+
+    try {
+        auto value = std::make_shared<std::vector<uint8_t>>();
+        uint64_t id = g_scheduler.submit(address, priority,
+            [serviceUuid, characteristicUuid, value](uint64_t device) {
+                return gatt_client()->read(device, serviceUuid, characteristicUuid, *value);
+            },
+            [callback, userData, value](const niox::OperationResult& result) {
+                if (callback) {
+                    callback(result.id, result.address, result.result, value->data(), static_cast<int>(value->size()),
+                        static_cast<int>(result.queueMs), static_cast<int>(result.serviceMs), userData);
+                }
+            });
+        return id == 0 ? -1 : static_cast<long long>(id);
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Queue a characteristic write
+long long winrt_schedule_write(unsigned long long address, const char* service, const char* characteristic,
+                               const unsigned char* data, int length, int withResponse,
+                               int priority, ScheduledOperationCallback callback, void* userData) {
+    niox::Uuid serviceUuid;
+    niox::Uuid characteristicUuid;
+    if (!parse_characteristic(service, characteristic, &serviceUuid, &characteristicUuid)) return -1;
+    if (length < 0 || (length > 0 && data == nullptr)) return -1;
+
+    try {
+        auto value = std::make_shared<std::vector<uint8_t>>(data, data + length);
+        const bool response = withResponse != 0;
+        uint64_t id = g_scheduler.submit(address, priority,
+            [serviceUuid, characteristicUuid, value, response](uint64_t device) {
+                return gatt_client()->write(device, serviceUuid, characteristicUuid, value->data(), value->size(), response);
+            },
+            [callback, userData](const niox::OperationResult& result) {
+                if (callback) {
+                    callback(result.id, result.address, result.result, nullptr, 0,
+                        static_cast<int>(result.queueMs), static_cast<int>(result.serviceMs), userData);
+                }
+            });
+        return id == 0 ? -1 : static_cast<long long>(id);
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Get per-device scheduling statistics
+int winrt_scheduler_stats(BLEScheduleStats* stats, int capacity, int* total) {
+    if (capacity < 0 || (capacity > 0 && stats == nullptr)) return -1;
+
+    try {
+        std::vector<niox::DeviceScheduleStats> devices = g_scheduler.stats();
+        if (total) *total = static_cast<int>(devices.size());
+        int count = static_cast<int>(devices.size()) < capacity ? static_cast<int>(devices.size()) : capacity;
+        for (int i = 0; i < count; i++) {
+            const niox::DeviceScheduleStats& device = devices[i];
+            const uint64_t operations = device.completed + device.failed;
+            BLEScheduleStats& record = stats[i];
+            record.rawAddress = device.address;
+            format_bluetooth_address_into(device.address, record.address, sizeof(record.address));
+            record.completed = device.completed;
+            record.failed = device.failed;
+            record.pending = static_cast<int>(device.pending);
+            record.avgQueueMs = operations ? static_cast<int>(device.totalQueueMs / operations) : 0;
+            record.maxQueueMs = static_cast<int>(device.maxQueueMs);
+            record.avgServiceMs = operations ? static_cast<int>(device.totalServiceMs / operations) : 0;
+            record.maxServiceMs = static_cast<int>(device.maxServiceMs);
+            record.sessions = device.sessions;
+        }
+        return count;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Start (or reconfigure) the connection pool
+int winrt_pool_start(int capacity, int idleMs, int connectTimeoutMs) {
+    if (capacity <= 0 || idleMs < 0 || connectTimeoutMs <= 0) return -1;
+
+    try {
+        niox::PoolHooks hooks;
+        hooks.connect = [connectTimeoutMs](uint64_t address) {
+            try {
+                return connect_cached(address, connectTimeoutMs);
+            }
+            catch (...) {
+                return niox::LINK_ERROR;
+            }
+        };
+        hooks.disconnect = [](uint64_t address) {
+            try {
+                gatt_client()->disconnect(address);
+            }
+            catch (...) {}
+        };
+        hooks.alive = [](uint64_t address) {
+            try {
+                return gatt_client()->is_connected(address);
+            }
+            catch (...) {
+                return false;
+            }
+        };
+        g_pool.start(static_cast<size_t>(capacity), idleMs, hooks);
+        return 0;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Stop the pool and close its sessions
+void winrt_pool_stop() {
+    g_pool.shutdown();
+}
+
+// Lease a session from the pool
+int winrt_pool_acquire(unsigned long long address, int* reused) {
+    if (!g_pool.running()) return niox::LINK_ERROR;
+
+    try {
+        bool hit = false;
+        int result = g_pool.acquire(address, &hit);
+        if (reused) *reused = hit ? 1 : 0;
+        return result;
+    }
+    catch (...) {
+        return niox::LINK_ERROR;
+    }
+}
+
+// Return a leased session to the pool
+void winrt_pool_release(unsigned long long address) {
+    try {
+        g_pool.release(address);
+    }
+    catch (...) {}
+}
+
+// Get connection pool statistics
+void winrt_pool_stats(BLEPoolStats* stats) {
+    if (stats == nullptr) return;
+
+    niox::PoolStats pool = g_pool.stats();
+    stats->acquires = pool.acquires;
+    stats->hits = pool.hits;
+    stats->misses = pool.misses;
+    stats->reconnects = pool.reconnects;
+    stats->failures = pool.failures;
+    stats->evictedIdle = pool.evictedIdle;
+    stats->evictedLru = pool.evictedLru;
+    stats->open = static_cast<int>(pool.open);
+    stats->leased = static_cast<int>(pool.leased);
+    stats->avgSetupMs = pool.setups ? static_cast<int>(pool.totalSetupMs / static_cast<int64_t>(pool.setups)) : 0;
+    stats->savedSetupMs = pool.savedSetupMs;
+}
+
+// Start notification streaming into a ring of capacityBytes
+int winrt_stream_start(int capacityBytes) {
+    if (capacityBytes <= 0) return -1;
+
+    try {
+        std::lock_guard<std::mutex> lock(g_stream_mutex);
+        if (g_stream_ring) return -1;
+        g_stream_ring = std::make_shared<niox::NotificationRing>(static_cast<size_t>(capacityBytes));
+        return 0;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Stop streaming; the ring is freed once views are released and streams unsubscribed
+void winrt_stream_stop() {
+    std::lock_guard<std::mutex> lock(g_stream_mutex);
+    g_stream_ring = nullptr;
+}
+
+// Route a characteristic's notifications into the ring (enable = 0 stops them)
+int winrt_stream_subscribe(unsigned long long address, const char* service, const char* characteristic, int enable) {
+    niox::Uuid serviceUuid;
+    niox::Uuid characteristicUuid;
+    if (!parse_characteristic(service, characteristic, &serviceUuid, &characteristicUuid)) return niox::LINK_ERROR;
+
+    try {
+        niox::GattValueHandler handler;
+        if (enable) {
+            std::shared_ptr<niox::NotificationRing> ring;
+            {
+                std::lock_guard<std::mutex> lock(g_stream_mutex);
+                ring = g_stream_ring;
+            }
+            if (!ring) return niox::LINK_ERROR;
+            handler = [ring](uint64_t device, uint16_t handle, const uint8_t* data, size_t length) {
+                ring->push(device, handle, data, length);
+            };
+        }
+        return gatt_client()->subscribe(address, serviceUuid, characteristicUuid, handler);
+    }
+    catch (...) {
+        return niox::LINK_ERROR;
+    }
+}
+
+// Views of buffered notifications, oldest first; valid until winrt_stream_release
+int winrt_stream_poll(BLENotification* records, int maxRecords) {
+    if (maxRecords < 0 || (maxRecords > 0 && records == nullptr)) return -1;
+
+    std::shared_ptr<niox::NotificationRing> ring;
+    {
+        std::lock_guard<std::mutex> lock(g_stream_mutex);
+        if (!g_stream_polled) g_stream_polled = g_stream_ring;
+        ring = g_stream_polled;
+    }
+    if (!ring) return -1;
+
+    const size_t BATCH = 64;
+    niox::NotificationView views[BATCH];
+    int count = 0;
+    while (count < maxRecords) {
+        const size_t wanted = static_cast<size_t>(maxRecords - count);
+        const size_t found = ring->peek(views, wanted < BATCH ? wanted : BATCH);
+        for (size_t i = 0; i < found; i++) {
+            BLENotification& record = records[count + static_cast<int>(i)];
+            record.address = views[i].address;
+            record.handle = views[i].handle;
+            record.length = views[i].length;
+            record.timestampUs = views[i].timestampUs;
+            record.data = views[i].data;
+        }
+        count += static_cast<int>(found);
+        if (found < BATCH) break;
+    }
+    return count;
+}
+
+// Free the notifications returned by winrt_stream_poll
+void winrt_stream_release() {
+    std::shared_ptr<niox::NotificationRing> ring;
+    {
+        std::lock_guard<std::mutex> lock(g_stream_mutex);
+        ring.swap(g_stream_polled);
+    }
+    if (ring) ring->release();
+}
+
+// Get streaming throughput and drop counters
+int winrt_stream_stats(BLEStreamStats* stats) {
+    if (stats == nullptr) return -1;
+
+    std::shared_ptr<niox::NotificationRing> ring;
+    {
+        std::lock_guard<std::mutex> lock(g_stream_mutex);
+        ring = g_stream_ring ? g_stream_ring : g_stream_polled;
+    }
+    if (!ring) return -1;
+
+    niox::NotificationRingStats ringStats = ring->stats();
+    stats->notifications = ringStats.notifications;
+    stats->bytes = ringStats.bytes;
+    stats->dropped = ringStats.dropped;
+    stats->droppedBytes = ringStats.droppedBytes;
+    stats->delivered = ringStats.delivered;
+    stats->batches = ringStats.batches;
+    stats->pendingBytes = ringStats.pendingBytes;
+    stats->peakBytes = ringStats.peakBytes;
+    stats->capacity = ringStats.capacity;
+    return 0;
+}
+
+// Helper: Write queue of a device, created on first use
+std::shared_ptr<niox::WriteQueue> write_queue(uint64_t address, bool create) {
+    std::lock_guard<std::mutex> lock(g_write_queue_mutex);
+    auto it = g_write_queues.find(address);
+    if (it != g_write_queues.end()) return it->second;
+    if (!create) return nullptr;
+    auto queue = std::make_shared<niox::WriteQueue>(address);
+    g_write_queues.emplace(address, queue);
+    return queue;
+}
+
+// Queue a characteristic write for the next flush
+int winrt_write_queue_add(unsigned long long address, const char* service, const char* characteristic,
+                          const unsigned char* data, int length, int barrier) {
+    niox::Uuid serviceUuid;
+    niox::Uuid characteristicUuid;
+    if (!parse_characteristic(service, characteristic, &serviceUuid, &characteristicUuid)) return -1;
+    if (length < 0 || (length > 0 && data == nullptr)) return -1;
+
+    try {
+        write_queue(address, true)->enqueue(serviceUuid, characteristicUuid, data, static_cast<size_t>(length), barrier != 0);
+        return 0;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Send queued writes in order
+int winrt_write_queue_flush(unsigned long long address, BLEWriteQueueStats* stats) {
+    try {
+        std::shared_ptr<niox::WriteQueue> queue = write_queue(address, false);
+        niox::WriteQueueStats run = niox::WriteQueueStats();
+        int result = queue ? queue->flush(*gatt_client(), &run) : niox::LINK_OK;
+        if (stats) {
+            stats->writes = run.commands;
+            stats->commands = run.unacknowledged;
+            stats->requests = run.acknowledged;
+            stats->bursts = run.bursts;
+            stats->pending = queue ? static_cast<int>(queue->pending()) : 0;
+            stats->elapsedMs = run.elapsedMs;
+            stats->writesPerSecond = run.elapsedMs > 0 ? run.commands * 1000.0 / static_cast<double>(run.elapsedMs) : 0.0;
+            stats->avgCompletionMs = run.commands ? static_cast<int>(run.totalCompletionMs / static_cast<int64_t>(run.commands)) : 0;
+            stats->maxCompletionMs = static_cast<int>(run.maxCompletionMs);
+        }
+        return result;
+    }
+    catch (...) {
+        return niox::LINK_ERROR;
+    }
+}
+
+// Drop queued writes
+void winrt_write_queue_clear(unsigned long long address) {
+    std::shared_ptr<niox::WriteQueue> queue = write_queue(address, false);
+    if (queue) queue->clear();
+}
+
+// Helper: Copy transfer counters to the C struct
+void fill_transfer_stats(const niox::TransferStats& transfer, BLETransferStats* stats) {
+    stats->size = transfer.size;
+    stats->received = transfer.received;
+    stats->acknowledged = transfer.acknowledged;
+    stats->mtu = transfer.mtu;
+    stats->chunk = transfer.chunk;
+    stats->requests = transfer.requests;
+    stats->rerequests = transfer.rerequests;
+    stats->notifications = transfer.notifications;
+    stats->duplicates = transfer.duplicates;
+    stats->resumes = static_cast<int>(transfer.resumes);
+    stats->elapsedMs = transfer.elapsedMs;
+    stats->bytesPerSecond = transfer.bytesPerSecond;
+}
+
+// Download a device's measurement log, resuming an interrupted download
+int winrt_log_download(unsigned long long address, int mtu, int depth, int requestTimeoutMs,
+                       unsigned char* buffer, int capacity) {
+    if (capacity < 0 || (capacity > 0 && buffer == nullptr)) return niox::LINK_ERROR;
+
+    try {
+        std::shared_ptr<niox::LogTransfer> transfer;
+        {
+            std::lock_guard<std::mutex> lock(g_transfer_mutex);
+            std::shared_ptr<niox::LogTransfer>& entry = g_transfers[address];
+            if (!entry) {
+                niox::TransferOptions options;
+                if (mtu > 0) options.mtu = static_cast<uint16_t>(mtu < niox::ATT_MAX_MTU ? mtu : niox::ATT_MAX_MTU);
+                if (depth > 0) options.depth = depth;
+                if (requestTimeoutMs > 0) options.requestTimeoutMs = requestTimeoutMs;
+                entry = std::make_shared<niox::LogTransfer>(address, options);
+            }
+            transfer = entry;
+        }
+
+        int result = transfer->run(*gatt_client());
+        if (result != niox::LINK_OK) return result;
+
+        // Kept until the caller's buffer is large enough
+        const std::vector<uint8_t>& log = transfer->data();
+        if (log.size() > static_cast<size_t>(capacity)) return niox::GATT_NO_SPACE;
+        if (!log.empty()) memcpy(buffer, log.data(), log.size());
+
+        std::lock_guard<std::mutex> lock(g_transfer_mutex);
+        g_finished_transfers[address] = transfer->stats();
+        auto it = g_transfers.find(address);
+        if (it != g_transfers.end() && it->second == transfer) g_transfers.erase(it);
+        return static_cast<int>(log.size());
+    }
+    catch (...) {
+        return niox::LINK_ERROR;
+    }
+}
+
+// Get progress of the current (or last finished) log download
+int winrt_log_stats(unsigned long long address, BLETransferStats* stats) {
+    if (stats == nullptr) return -1;
+
+    std::shared_ptr<niox::LogTransfer> transfer;
+    {
+        std::lock_guard<std::mutex> lock(g_transfer_mutex);
+        auto active = g_transfers.find(address);
+        if (active != g_transfers.end()) {
+            transfer = active->second;
+        }
+        else {
+            auto finished = g_finished_transfers.find(address);
+            if (finished == g_finished_transfers.end()) return -1;
+            fill_transfer_stats(finished->second, stats);
+            return 0;
+        }
+    }
+    fill_transfer_stats(transfer->stats(), stats);
+    return 0;
+}
+
+// Drop a partial download so the next one starts from offset 0
+void winrt_log_discard(unsigned long long address) {
+    std::lock_guard<std::mutex> lock(g_transfer_mutex);
+    g_transfers.erase(address);
+    g_finished_transfers.erase(address);
+}
+
+// Helper: Simulated backend, or nullptr when WinRT is active
+std::shared_ptr<niox::SimulatedGattBackend> simulated_backend() {
+    std::lock_guard<std::mutex> lock(g_gatt_mutex);
+    return g_simulated_backend;
+}
+
+// Add a characteristic to a simulated peripheral
+int winrt_mock_add_characteristic(unsigned long long address, const char* service, const char* characteristic,
+                                  int properties, const unsigned char* data, int length) {
+    niox::Uuid serviceUuid;
+    niox::Uuid characteristicUuid;
+    if (!parse_characteristic(service, characteristic, &serviceUuid, &characteristicUuid)) return -1;
+    if (length < 0 || (length > 0 && data == nullptr)) return -1;
+
+    auto backend = simulated_backend();
+    if (!backend) return -1;
+    return backend->add_characteristic(address, serviceUuid, characteristicUuid,
+        static_cast<uint8_t>(properties), data, static_cast<size_t>(length));
+}
+
+// Change a simulated characteristic value
+int winrt_mock_set_value(unsigned long long address, int handle, const unsigned char* data, int length) {
+    if (handle <= 0 || handle > 0xFFFF || length < 0 || (length > 0 && data == nullptr)) return -1;
+
+    auto backend = simulated_backend();
+    if (!backend) return -1;
+    return backend->set_value(address, static_cast<uint16_t>(handle), data, static_cast<size_t>(length)) ? 0 : -1;
+}
+
+// Move a simulated peripheral's attributes and indicate Service Changed
+int winrt_mock_services_changed(unsigned long long address) {
+    auto backend = simulated_backend();
+    if (!backend) return -1;
+    backend->change_services(address);
+    return 0;
+}
+
+// Make a simulated peripheral refuse or accept links
+int winrt_mock_set_unreachable(unsigned long long address, int unreachable) {
+    auto backend = simulated_backend();
+    if (!backend) return -1;
+    backend->link().set_unreachable(address, unreachable != 0);
+    return 0;
+}
+
+// Set simulated radio timing: round trip per request and the write command buffer
+int winrt_mock_set_timing(int roundTripMs, int commandSlots, int packetIntervalUs) {
+    if (roundTripMs < 0 || commandSlots < 0 || packetIntervalUs < 0) return -1;
+
+    auto backend = simulated_backend();
+    if (!backend) return -1;
+    backend->set_round_trip(roundTripMs);
+    backend->set_command_buffer(static_cast<size_t>(commandSlots), packetIntervalUs);
+    return 0;
+}
+
+// Give a simulated peripheral a measurement log served over the log protocol
+int winrt_mock_add_log(unsigned long long address, int size, int roundTripMs, int packetIntervalUs,
+                       int lossPercent, int maxMtu) {
+    if (size < 0 || roundTripMs < 0 || packetIntervalUs < 0 || lossPercent < 0 || lossPercent > 100) return -1;
+
+    try {
+        std::lock_guard<std::mutex> lock(g_gatt_mutex);
+        if (!g_simulated_backend) return -1;
+        if (maxMtu > 0) g_simulated_backend->set_max_mtu(static_cast<uint16_t>(maxMtu < niox::ATT_MAX_MTU ? maxMtu : niox::ATT_MAX_MTU));
+
+        // Byte i of the log is (i * 7 + i / 256) & 0xFF, so downloads can be verified
+        std::vector<uint8_t> log(static_cast<size_t>(size));
+        for (size_t i = 0; i < log.size(); i++) log[i] = static_cast<uint8_t>(i * 7 + (i >> 8));
+        g_simulated_logs.emplace_back(new niox::SimulatedLogPeripheral(g_simulated_backend, address, std::move(log),
+            roundTripMs, packetIntervalUs, lossPercent / 100.0, static_cast<uint32_t>(address)));
+        return 0;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Start aggregation collector
+int winrt_aggregator_start_collector(const char* endpoint) {
+    niox::Endpoint parsed;
+    if (!niox::Endpoint::parse(endpoint, &parsed)) return -1;
+    try {
+        return g_aggregator.start_collector(parsed) ? 0 : -1;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Start aggregation node
+int winrt_aggregator_start_node(int nodeId, const char* collectorEndpoint, int intervalMs) {
+    niox::Endpoint parsed;
+    if (!niox::Endpoint::parse(collectorEndpoint, &parsed)) return -1;
+    if (nodeId < 0 || nodeId > 0xFFFF || intervalMs <= 0) return -1;
+
+    try {
+        // Snapshot devices heard recently enough for their age to fit the wire field
+        auto snapshot = [](std::vector<niox::DeviceDelta>& out, int64_t) {
+            std::lock_guard<std::mutex> lock(g_device_mutex);
+            const int64_t now = now_ms();
+            for (uint32_t slot = 0; slot < g_device_table.size(); slot++) {
+                const int64_t age = now - g_device_table.last_seen_ms(slot);
+                if (age > 0xFFFF) continue;
+                int rssi = g_device_table.rssi(slot);
+                niox::DeviceDelta delta;
+                delta.address = g_device_table.address(slot);
+                delta.serial = g_device_table.serial(slot);
+                delta.rssi = static_cast<int8_t>(rssi < -128 ? -128 : (rssi > 127 ? 127 : rssi));
+                delta.flags = static_cast<uint8_t>(g_device_table.flags(slot));
+                delta.ageMs = static_cast<uint16_t>(age);
+                out.push_back(delta);
+            }
+        };
+        return g_aggregator.start_node(static_cast<uint16_t>(nodeId), parsed, intervalMs, snapshot) ? 0 : -1;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Stop aggregation
+void winrt_aggregator_stop() {
+    try {
+        g_aggregator.stop();
+        g_aggregator.collector().clear();
+    }
+    catch (...) {}
+}
+
+// Get merged devices from the collector
+int winrt_aggregator_devices(BLEAggregatedDevice* devices, int capacity, int* total) {
+    if (capacity < 0 || (devices == nullptr && capacity > 0)) return -1;
+    try {
+        std::vector<niox::AggregatedDevice> merged;
+        g_aggregator.collector().snapshot_devices(merged);
+        if (total) *total = static_cast<int>(merged.size());
+
+        const int64_t now = niox::AggregationService::clock_ms();
+        int count = 0;
+        for (const auto& device : merged) {
+            if (count >= capacity) break;
+            BLEAggregatedDevice& out = devices[count++];
+            out.rawAddress = device.address;
+            format_bluetooth_address_into(device.address, out.address, sizeof(out.address));
+            out.serialNumber[0] = '\0';
+            niox::format_serial(device.serial, out.serialNumber, sizeof(out.serialNumber));
+            out.bestRssi = device.bestRssi;
+            out.bestNode = device.bestNode;
+            out.bestAgeMs = static_cast<int>(now - device.bestSeenMs);
+            out.ageMs = static_cast<int>(now - device.lastSeenMs);
+        }
+        return count;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Get per-node freshness from the collector
+int winrt_aggregator_nodes(BLEAggregatorNode* nodes, int capacity, int* total) {
+    if (capacity < 0 || (nodes == nullptr && capacity > 0)) return -1;
+    try {
+        std::vector<niox::NodeStatus> status;
+        g_aggregator.collector().snapshot_nodes(status);
+        if (total) *total = static_cast<int>(status.size());
+
+        const int64_t now = niox::AggregationService::clock_ms();
+        int count = 0;
+        for (const auto& node : status) {
+            if (count >= capacity) break;
+            BLEAggregatorNode& out = nodes[count++];
+            out.nodeId = node.nodeId;
+            out.ageMs = static_cast<int>(now - node.lastHeardMs);
+            out.datagrams = node.datagrams;
+            out.lost = node.lost;
+            out.deltas = node.deltas;
+        }
+        return count;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Encode device updates into the wire stream
+int winrt_wire_encode_updates(unsigned char* buffer, int capacity) {
+    if (buffer == nullptr || capacity <= 0) return -1;
+
+    try {
+        std::lock_guard<std::mutex> wire_lock(g_wire_mutex);
+
+        // Drain what is still pending before encoding a new batch
+        if (g_wire_pending.empty()) {
+            std::vector<niox::WireUpdate> updates;
+            // The stream carries Unix ms; our monotonic clock means nothing to the reader
+            const int64_t wallOffset = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count() - now_ms();
+            {
+                std::lock_guard<std::mutex> lock(g_device_mutex);
+                // Select by change sequence, not last-seen time: several adverts
+                // share a millisecond, and held adverts arrive with older times
+                std::vector<uint32_t> slots;
+                g_device_table.updated_since(g_wire_sequence, slots);
+                g_wire_sequence = g_device_table.sequence();
+
+                updates.reserve(slots.size());
+                for (uint32_t slot : slots) {
+                    niox::WireUpdate update;
+                    update.address = g_device_table.address(slot);
+                    update.serial = g_device_table.serial(slot);
+                    update.rssi = g_device_table.rssi(slot);
+                    update.timestampMs = g_device_table.last_seen_ms(slot) + wallOffset;
+                    update.flags = static_cast<uint8_t>(g_device_table.flags(slot));
+                    update.present = 0;
+                    updates.push_back(update);
+                }
+            }
+            g_wire_encoder.encode(updates.data(), updates.size(), g_wire_pending);
+        }
+
+        size_t count = g_wire_pending.size() < static_cast<size_t>(capacity)
+            ? g_wire_pending.size() : static_cast<size_t>(capacity);
+        memcpy(buffer, g_wire_pending.data(), count);
+        g_wire_pending.erase(g_wire_pending.begin(), g_wire_pending.begin() + count);
+        return static_cast<int>(count);
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Restart the wire stream with a key frame
+void winrt_wire_reset_encoder() {
+    std::lock_guard<std::mutex> lock(g_wire_mutex);
+    g_wire_encoder.reset();
+    g_wire_pending.clear();
+    g_wire_sequence = 0;
+}
+
+// Decode wire stream bytes
+int winrt_wire_decode(const unsigned char* data, int length, BLEWireUpdate* updates, int capacity) {
+    if ((data == nullptr && length > 0) || length < 0 || capacity < 0 || (updates == nullptr && capacity > 0)) return -1;
+
+    try {
+        std::lock_guard<std::mutex> lock(g_wire_mutex);
+        g_wire_framer.feed(data, static_cast<size_t>(length));
+
+        static std::vector<niox::WireUpdate> decoded;  // Reused; guarded by g_wire_mutex
+        static size_t decoded_read = 0;
+        uint8_t type;
+        uint16_t sequence;
+        std::vector<uint8_t> payload;
+        uint64_t corrupt = g_wire_framer.corrupt_frames();
+        while (decoded.size() - decoded_read < static_cast<size_t>(capacity) && g_wire_framer.next_frame(&type, &sequence, payload)) {
+            // A frame lost to corruption invalidates the dictionary even if
+            // the next good frame happens to be a reset
+            if (g_wire_framer.corrupt_frames() != corrupt) {
+                corrupt = g_wire_framer.corrupt_frames();
+                g_wire_decoder.lose_sync();
+            }
+            g_wire_decoder.decode(type, sequence, payload, decoded);
+        }
+        if (g_wire_framer.corrupt_frames() != corrupt) g_wire_decoder.lose_sync();
+
+        int count = 0;
+        while (count < capacity && decoded_read < decoded.size()) {
+            const niox::WireUpdate& update = decoded[decoded_read++];
+            BLEWireUpdate& out = updates[count++];
+            out.rawAddress = update.address;
+            format_bluetooth_address_into(update.address, out.address, sizeof(out.address));
+            out.serialNumber[0] = '\0';
+            niox::format_serial(update.serial, out.serialNumber, sizeof(out.serialNumber));
+            out.rssi = update.rssi;
+            out.timestampMs = update.timestampMs;
+            out.isNioxDevice = (update.flags & niox::DEVICE_FLAG_NIOX) ? 1 : 0;
+        }
+        if (decoded_read == decoded.size()) {
+            decoded.clear();
+            decoded_read = 0;
+        }
+        return count;
+    }
+    catch (...) {
+        return -1;
+    }
+}
+
+// Get wire decoder sync state and error counters
+void winrt_wire_decode_stats(BLEWireDecodeStats* stats) {
+    if (stats == nullptr) return;
+    std::lock_guard<std::mutex> lock(g_wire_mutex);
+    stats->synced = g_wire_decoder.synced() ? 1 : 0;
+    stats->corruptFrames = g_wire_framer.corrupt_frames();
+    stats->sequenceGaps = g_wire_decoder.sequence_gaps();
+    stats->rejectedFrames = g_wire_decoder.rejected_frames();
 }
 
 // Free string
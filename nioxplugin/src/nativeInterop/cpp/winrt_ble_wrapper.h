@@ -11,11 +11,308 @@ typedef struct {
     char* address;
     int rssi;
     int hasRssi;
+    int hasNioxService;  // 1 if the advert lists the NIOX FDC service UUID
 } BLEDevice;
 
+// Query over the native device table (see winrt_query_devices)
+typedef struct {
+    int nioxOnly;       // 1 = NIOX name prefix or FDC service only, 2 = site fleet only (see winrt_load_fleet)
+    int minRssi;        // RSSI floor in dBm (e.g. -128 for no floor)
+    int seenWithinMs;   // Only devices heard in the last N ms (0 = any)
+    int sortKey;        // 0=RSSI (strongest first), 1=last seen (newest first), 2=serial, -1=none; others fail with -1
+    int offset;         // Page start within the sorted matches
+    int limit;          // Page size (0 = all remaining)
+} BLEDeviceQuery;
+
+// Fixed-size device record; a page of these involves no per-device allocation
+typedef struct {
+    unsigned long long rawAddress;      // Identity address if resolved (see winrt_add_identity_key)
+    unsigned long long radioAddress;    // Address last heard over the air; use it to connect
+    char address[18];       // XX:XX:XX:XX:XX:XX
+    char name[32];          // UTF-8, truncated, empty if unknown
+    char serialNumber[20];  // NIOX serial digits, empty if none
+    int rssi;
+    int ageMs;              // Milliseconds since last heard
+    int isNioxDevice;
+    int inFleet;            // Serial is in the site fleet
+    // Status from manufacturer advert data; fields are -1 if not advertised
+    int hasStatus;
+    int batteryPercent;
+    int ready;              // 1 if ready to measure
+    int charging;
+    int busy;               // Measurement in progress
+    int error;
+    int errorCode;
+    int testsRemaining;
+} BLEDeviceRecord;
+
+// Advertisement / scan response pairing counters (see winrt_scan_merge_stats)
+typedef struct {
+    unsigned long long received;        // PDUs from the watcher
+    unsigned long long delivered;       // Updates passed on (table, callback)
+    unsigned long long merged;          // Advertisement + scan response pairs
+    unsigned long long passedThrough;   // Non-scannable advertisements
+    unsigned long long timedOut;        // Delivered without the other half
+    unsigned long long superseded;      // Delivered alone because the same PDU type repeated
+    int pending;                        // Waiting for the other half
+    int timeoutMs;
+} BLEScanMergeStats;
+
+// Identity resolution counters (see winrt_identity_stats)
+typedef struct {
+    int keys;                           // Known IRKs
+    int cached;                         // Addresses with a cached result
+    unsigned long long lookups;         // Private addresses looked up
+    unsigned long long cacheHits;
+    unsigned long long resolved;        // Resolved to an identity on a cache miss
+    unsigned long long unresolved;      // No known IRK matched
+    unsigned long long aesBlocks;       // AES-128 operations
+    int hardwareAes;                    // 1 if AES-NI is used
+} BLEIdentityStats;
+
+// Per-device advert statistics (see winrt_query_device_stats)
+typedef struct {
+    unsigned long long rawAddress;
+    char address[18];       // XX:XX:XX:XX:XX:XX
+    char serialNumber[20];  // NIOX serial digits, empty if none
+    unsigned int adverts;               // Adverts received since first seen
+    long long firstSeenAgeMs;           // Milliseconds since first / last heard
+    long long lastSeenAgeMs;
+    int rssiMin;
+    int rssiMax;
+    double rssiMean;
+    double rssiStdDev;
+    double intervalMs;                  // Estimated advertising interval, -1 if unknown
+    double receiveRatio;                // Share of the device's adverts received (0..1, 0 if unknown)
+    int scanWindowMs;                   // Scan time to hear it with 95% confidence, -1 if unknown
+} BLEDeviceStats;
+
+// One point of a device's RSSI history (see winrt_export_rssi_history)
+typedef struct {
+    unsigned long long rawAddress;
+    int ageMs;                          // Milliseconds since the sample / bucket start
+    int widthMs;                        // 0 for a raw sample, else the bucket length
+    int rssiMin;
+    int rssiMax;
+    int rssiMean;
+    int count;                          // Adverts in the point (saturates at 255)
+} BLERssiPoint;
+
+// btsnoop replay progress (see winrt_replay_stats)
+typedef struct {
+    unsigned long long records;         // btsnoop records read
+    unsigned long long events;          // LE advertising report events
+    unsigned long long reports;         // Advertisements in them
+    unsigned long long extendedReports; // ... from extended reports (fragments joined)
+    unsigned long long malformed;       // Events that did not parse
+    unsigned long long delivered;       // Fed into the scan pipeline
+    unsigned long long filtered;        // Dropped by the address filter
+    unsigned long long loops;           // Completed passes over the capture
+    long long captureMs;                // Capture time replayed
+    long long elapsedMs;                // Wall time since the replay started
+    int running;
+} BLEReplayStats;
+
+// Scan log counters (see winrt_scan_log_stats)
+typedef struct {
+    unsigned long long records;         // Written to the log
+    unsigned long long blocks;
+    unsigned long long bytes;           // File bytes written this session
+    unsigned long long dropped;         // Buffer full or write failed
+    int pending;                        // Buffered, not yet written
+    int active;                         // 1 while logging
+} BLEScanLogStats;
+
+// One advert read back from a scan log (see winrt_scan_log_query)
+typedef struct {
+    unsigned long long rawAddress;      // Identity address if resolved
+    long long timeMs;                   // Unix milliseconds
+    int rssi;
+    int isNioxDevice;
+    int inFleet;
+    int hasStatus;
+} BLEScanLogRecord;
+
+// Address filter counters (see winrt_address_filter_stats)
+typedef struct {
+    unsigned long long checked;         // Adverts looked up
+    unsigned long long denied;          // Dropped by the denylist
+    unsigned long long notAllowed;      // Dropped because not on the allowlist
+    unsigned long long bloomFalsePositives;
+    unsigned long long learned;         // Denylist entries added by learning
+    int denySize;
+    int allowSize;
+} BLEAddressFilterStats;
+
+// Phase breakdown of the last scan (see winrt_scan_phase_stats)
+typedef struct {
+    int strategy;                       // 0=always active, 1=two-phase
+    int passiveMs;                      // Time spent passive / active
+    int activeMs;
+    int candidates;                     // Nameless devices above the RSSI floor after the passive sweep
+    int unresolved;                     // Still nameless at the end
+    int resolvedMs;                     // Two-phase: scan start until every candidate had a name, -1 if never
+    unsigned long long passiveEvents;   // Received events in each phase
+    unsigned long long activeEvents;
+} BLEScanPhaseStats;
+
+// Device merged across aggregation nodes (see winrt_aggregator_devices)
+typedef struct {
+    unsigned long long rawAddress;
+    char address[18];
+    char serialNumber[20];  // Empty if not a NIOX unit
+    int bestRssi;           // Strongest fresh RSSI across nodes
+    int bestNode;           // Node that reported bestRssi
+    int bestAgeMs;          // Age of the best report
+    int ageMs;              // Age of the newest report from any node
+} BLEAggregatedDevice;
+
+// Aggregation node freshness (see winrt_aggregator_nodes)
+typedef struct {
+    int nodeId;
+    int ageMs;                      // Since the last datagram from this node
+    unsigned long long datagrams;
+    unsigned long long lost;        // Datagrams missing from the sequence
+    unsigned long long deltas;
+} BLEAggregatorNode;
+
+// Device update decoded from a wire stream (see winrt_wire_decode)
+typedef struct {
+    unsigned long long rawAddress;
+    char address[18];
+    char serialNumber[20];  // Empty if not a NIOX unit
+    int rssi;
+    long long timestampMs;  // Unix milliseconds (sender's wall clock)
+    int isNioxDevice;
+} BLEWireUpdate;
+
+// Wire decoder state (see winrt_wire_decode_stats)
+typedef struct {
+    int synced;                         // 0 until a reset frame arrives, and again after any error
+    unsigned long long corruptFrames;   // Failed the checksum
+    unsigned long long sequenceGaps;    // Frames missing from the sequence
+    unsigned long long rejectedFrames;  // Malformed, out of sequence, or received while not synced
+} BLEWireDecodeStats;
+
+// GATT characteristic (see winrt_gatt_discover)
+typedef struct {
+    char serviceUuid[37];           // Canonical lowercase UUID text
+    char characteristicUuid[37];
+    int handle;                     // Attribute value handle
+    int properties;                 // 0x02=read, 0x04=write without response, 0x08=write, 0x10=notify, 0x20=indicate
+} BLEGattCharacteristic;
+
+// GATT cache counters (see winrt_gatt_stats)
+typedef struct {
+    unsigned long long discoveries;         // Service discoveries sent to a device
+    unsigned long long cachedDiscoveries;   // Discoveries answered from the in-memory cache
+    unsigned long long persistedDiscoveries;// Discoveries answered from the cache file
+    unsigned long long radioReads;
+    unsigned long long cachedReads;
+    unsigned long long invalidations;       // Service Changed events applied
+} BLEGattStats;
+
+// Persistent attribute cache counters (see winrt_gatt_cache_stats)
+typedef struct {
+    unsigned long long lookups;
+    unsigned long long hits;        // Stored layout reused (firmware revision unchanged)
+    unsigned long long misses;      // Device not stored, or stored for another serial
+    unsigned long long stale;       // Stored layout dropped after a firmware change
+    unsigned long long writes;      // Cache file rewrites
+    unsigned long long entries;
+} BLEAttributeCacheStats;
+
+// Per-device scheduling counters (see winrt_scheduler_stats)
+typedef struct {
+    unsigned long long rawAddress;
+    char address[18];
+    unsigned long long completed;
+    unsigned long long failed;
+    int pending;                // Operations still queued
+    int avgQueueMs;             // Submit to start of execution
+    int maxQueueMs;
+    int avgServiceMs;           // Execution time, excluding link setup
+    int maxServiceMs;
+    unsigned long long sessions;// Links opened for this device
+} BLEScheduleStats;
+
+// Connection pool counters (see winrt_pool_stats)
+typedef struct {
+    unsigned long long acquires;
+    unsigned long long hits;        // Live pooled session reused
+    unsigned long long misses;      // New link opened
+    unsigned long long reconnects;  // Pooled link had dropped and was re-established
+    unsigned long long failures;
+    unsigned long long evictedIdle; // Closed after the idle period
+    unsigned long long evictedLru;  // Closed to stay within capacity
+    int open;
+    int leased;
+    int avgSetupMs;                 // Average link setup time
+    long long savedSetupMs;         // Estimated setup time avoided by hits
+} BLEPoolStats;
+
+// Result of a write queue flush (see winrt_write_queue_flush)
+typedef struct {
+    unsigned long long writes;      // Writes completed
+    unsigned long long commands;    // Sent without response
+    unsigned long long requests;    // Sent with response (barriers, long values)
+    unsigned long long bursts;      // Runs of write commands
+    int pending;                    // Writes left queued (after an error)
+    long long elapsedMs;
+    double writesPerSecond;
+    int avgCompletionMs;            // Enqueue to acknowledgement (or acceptance by the stack)
+    int maxCompletionMs;
+} BLEWriteQueueStats;
+
+// Streamed notification (see winrt_stream_poll); data points into the ring
+typedef struct {
+    unsigned long long address;
+    int handle;                     // Attribute value handle
+    int length;
+    long long timestampUs;          // Arrival time, monotonic clock
+    const unsigned char* data;      // Valid until winrt_stream_release
+} BLENotification;
+
+// Notification streaming counters (see winrt_stream_stats)
+typedef struct {
+    unsigned long long notifications;   // Written to the ring
+    unsigned long long bytes;           // Payload bytes written
+    unsigned long long dropped;         // Lost because the ring was full
+    unsigned long long droppedBytes;
+    unsigned long long delivered;       // Released by the consumer
+    unsigned long long batches;
+    unsigned long long pendingBytes;    // Ring bytes in use
+    unsigned long long peakBytes;
+    unsigned long long capacity;
+} BLEStreamStats;
+
+// Log download progress (see winrt_log_stats)
+typedef struct {
+    unsigned int size;              // Log size reported by the device
+    unsigned int received;          // Bytes held
+    unsigned int acknowledged;      // Contiguous bytes from offset 0; a resume continues here
+    int mtu;                        // Negotiated ATT MTU
+    int chunk;                      // Payload bytes per notification
+    unsigned long long requests;
+    unsigned long long rerequests;  // Requests repeating lost chunks
+    unsigned long long notifications;
+    unsigned long long duplicates;
+    int resumes;
+    long long elapsedMs;
+    double bytesPerSecond;
+} BLETransferStats;
+
 // Callback function type for device discovery
 typedef void (*DeviceFoundCallback)(BLEDevice device, void* userData);
 
+// Callback function type for GATT notifications and indications
+typedef void (*GattValueCallback)(unsigned long long address, int handle, const unsigned char* data, int length, void* userData);
+
+// Callback function type for scheduled operations (data/length: value read, NULL/0 for writes)
+typedef void (*ScheduledOperationCallback)(unsigned long long id, unsigned long long address, int result,
+                                           const unsigned char* data, int length, int queueMs, int serviceMs,
+                                           void* userData);
+
 // Initialize WinRT
 int winrt_initialize();
 
@@ -38,6 +335,466 @@ int winrt_start_scan(int durationMs, int nioxOnly, DeviceFoundCallback callback,
 // Stop ongoing scan
 void winrt_stop_scan();
 
+// Scan strategy for later scans
+//   strategy 0: active for the whole duration (default)
+//   strategy 1: passive sweep of passiveMs collecting addresses, RSSI and
+//     in-advert names; then, only if devices at or above minRssi are still
+//     nameless, an active burst of up to activeMs that ends once they all
+//     have names. durationMs of winrt_start_scan caps the total.
+// Returns: 0 on success, -1 on error
+int winrt_set_scan_strategy(int strategy, int passiveMs, int activeMs, int minRssi);
+
+// Get the phase breakdown of the last completed scan
+void winrt_scan_phase_stats(BLEScanPhaseStats* stats);
+
+// Active scans pair each scannable advertisement with its scan response and
+// report them as one update (name and both payloads), or the advertisement
+// alone once timeoutMs passes without a response. 0 reports every PDU
+// separately. Default 100 ms.
+// Returns: 0 on success, -1 on error
+int winrt_set_scan_merge_timeout(int timeoutMs);
+
+// Get pairing counters since winrt_initialize
+void winrt_scan_merge_stats(BLEScanMergeStats* stats);
+
+// RSSI history
+// The recent RSSI of every NIOX device is kept in one fixed slab: the last
+// raw samples, then 1 s buckets, then 10 s buckets, so older data survives
+// at lower resolution. Default: 64 devices x (256 raw, 120 x 1 s, 90 x 10 s),
+// about 15 minutes in 238 KB. The device heard least recently is dropped
+// when the slab is full.
+
+// Size the slab (entries are 8 bytes). Drops all history.
+// Returns: 0 on success, -1 on error
+int winrt_configure_rssi_history(int maxDevices, int rawSamples, int secondBuckets, int tenSecondBuckets);
+
+// Export history, oldest first per device, devices in address order
+// Parameters:
+//   address: one device (BLEDeviceRecord.rawAddress), or 0 for all
+//   windowMs: only the last N milliseconds (0 = everything kept)
+//   points: output array of at least `capacity` points
+//   total: receives the number of points available (may be NULL)
+// Returns: number of points written, or -1 on error
+int winrt_export_rssi_history(unsigned long long address, int windowMs, BLERssiPoint* points, int capacity, int* total);
+
+// Scan log
+// Every advert can be appended to an on-disk log for long-term analytics
+// (weeks of history per site). The log is columnar and delta-encoded, about
+// 5 bytes per advert, written in blocks by a background thread; the
+// Received handler only copies the record into a bounded buffer. A full
+// buffer drops records (counted) rather than blocking. Logs survive a crash
+// up to the last complete block.
+
+// Start logging to path; an existing log is appended to
+//   flushIntervalMs: buffered records are written at least this often (0 = 1000)
+//   maxBufferedRecords: buffer limit (0 = 65536)
+// Returns: 0 on success, -1 on error (e.g. path is not a scan log)
+int winrt_scan_log_start(const char* path, int flushIntervalMs, int maxBufferedRecords);
+
+// Write buffered records and close the log
+void winrt_scan_log_stop();
+
+// Get counters of the current (or last) log
+void winrt_scan_log_stats(BLEScanLogStats* stats);
+
+// Read adverts with fromMs <= timeMs < toMs (Unix ms) from a log, which may
+// be the one being written (records still buffered are not seen). Blocks
+// outside the range are skipped without decoding.
+//   records: output array of at least `capacity` records, in log order
+//   total: receives the number of matching records (may be NULL)
+// Returns: number of records written, or -1 on error
+int winrt_scan_log_query(const char* path, long long fromMs, long long toMs,
+                         BLEScanLogRecord* records, int capacity, int* total);
+
+// Site fleet
+// A site's known NIOX PRO serials, held as a minimal perfect hash so
+// membership costs one hash and one compare per advert. The table can be
+// compiled in (build-winrt-native-dll.ps1 -FleetManifest <file>) or loaded
+// at runtime; devices in it carry BLEDeviceRecord.inFleet and match
+// BLEDeviceQuery.nioxOnly = 2.
+// Manifest: one serial per line (or ',' / ';' separated), bare digits or
+// "NIOX PRO <serial>"; '#' starts a comment.
+
+// Replace the fleet. NULL or an empty manifest restores the compiled-in
+// table (empty if none was compiled in).
+// Returns: number of serials in the active table, or -1 on error
+int winrt_load_fleet(const char* manifest);
+
+// Returns: 1 if the serial is in the fleet, 0 if not, -1 if not a serial
+int winrt_fleet_contains(const char* serial);
+
+// Returns: number of serials in the active table
+//   compiled: receives 1 if the compiled-in table is active (may be NULL)
+int winrt_fleet_size(int* compiled);
+
+// Address filtering
+// Adverts from denylisted addresses are dropped on arrival, before any
+// decoding; when the allowlist is non-empty, only its addresses are
+// processed. Lists are matched on the address as heard over the air and can
+// be changed while a scan is running. Lists persist until changed.
+//   list: 0=denylist, 1=allowlist
+
+// Returns: 0 on success, -1 on error
+int winrt_address_filter_add(int list, unsigned long long address);
+
+// Returns: 0 if the address was removed, -1 if not listed or on error
+int winrt_address_filter_remove(int list, unsigned long long address);
+
+// Returns: 0 on success, -1 on error
+int winrt_address_filter_clear(int list);
+
+// Learn the denylist: a device heard threshold times with a name that is
+// not a NIOX name (and no NIOX service) is denied. Nameless devices are
+// never learned. At most capacity addresses are learned; threshold 0 stops
+// learning (learned entries stay until removed or cleared).
+// Returns: 0 on success, -1 on error
+int winrt_address_filter_learn(int threshold, int capacity);
+
+// Get address filter counters since startup
+void winrt_address_filter_stats(BLEAddressFilterStats* stats);
+
+// Look up a tracked device by NIOX serial number (e.g. "070401992")
+// Devices stay tracked across scans until winrt_cleanup().
+// Parameters:
+//   serial: serial number digits, as printed after "NIOX PRO"
+//   address: receives the 48-bit Bluetooth address (may be NULL)
+//   rssi: receives the last RSSI in dBm (may be NULL)
+//   ageMs: receives milliseconds since the device was last heard (may be NULL)
+// Returns: 1 if found, 0 if not tracked, -1 if serial is not a valid serial
+int winrt_find_device_by_serial(const char* serial, unsigned long long* address, int* rssi, long long* ageMs);
+
+// Query the native device table without rescanning
+// Filtering, sorting and paging happen natively; only the requested page is copied out.
+// Parameters:
+//   query: filter, sort key and page
+//   records: output array of at least `capacity` records
+//   capacity: size of the records array
+//   totalMatches: receives the number of devices matching the filter (may be NULL)
+// Returns: number of records written, or -1 on error (including an unknown sortKey)
+int winrt_query_devices(const BLEDeviceQuery* query, BLEDeviceRecord* records, int capacity, int* totalMatches);
+
+// Per-device statistics
+// Every advert updates a fixed 64-byte block per device: counts, first and
+// last seen, RSSI min/max/mean/variance and the estimated advertising
+// interval (lost adverts are divided out). The receive ratio follows from
+// the interval and the observed gaps, so scan windows can be sized from data.
+
+// Query statistics for the devices matching query, in the same order and
+// pages as winrt_query_devices
+// Returns: number of entries written, or -1 on error
+int winrt_query_device_stats(const BLEDeviceQuery* query, BLEDeviceStats* stats, int capacity, int* totalMatches);
+
+// Shortest scan that hears every matching device (with an interval
+// estimate) at least once with the given confidence (0..1)
+//   devices: receives the number of devices the estimate covers (may be NULL)
+// Returns: milliseconds, -1 if no matching device has an estimate or on error
+int winrt_suggest_scan_window(const BLEDeviceQuery* query, double confidence, int* devices);
+
+// Identity resolution
+// Resolvable private addresses of bonded devices rotate every few minutes.
+// With the device's IRK known, adverts from any of its private addresses
+// update one device table record keyed by the identity address
+// (BLEDeviceRecord.rawAddress); radioAddress is the address it was last
+// heard from. Results are cached per address. Adding a key folds the
+// records of private addresses it resolves into the identity's record;
+// records of private addresses no key resolves are dropped 30 minutes
+// after they were last heard.
+
+// Add or replace an IRK
+// Parameters:
+//   identityAddress: the device's identity address (public or static random)
+//   irk: 32 hex digits, most significant byte first
+// Returns: 0 on success, -1 on error
+int winrt_add_identity_key(unsigned long long identityAddress, const char* irk);
+
+// Returns: 0 if the key was removed, -1 if unknown
+int winrt_remove_identity_key(unsigned long long identityAddress);
+
+// Replace each resolvable private address in the array with its identity
+// address, in one batch. Returns: number replaced, or -1 on error
+int winrt_resolve_addresses(unsigned long long* addresses, int count);
+
+// Get identity resolution counters
+void winrt_identity_stats(BLEIdentityStats* stats);
+
+// Direct connect
+// Every advertisement heard since init is cached with its address type and
+// connectability, so a device can be connected by address without rescanning.
+
+// Connect to a previously heard device
+// Parameters:
+//   address: 48-bit Bluetooth address (as in BLEDeviceRecord.rawAddress)
+//   timeoutMs: overall link setup timeout
+//   elapsedMs: receives the link setup time in milliseconds (may be NULL)
+// Returns: 0 on success, -1 on error, -2 if the device was never heard,
+//          -3 if it only sent non-connectable adverts, -4 on timeout
+int winrt_connect(unsigned long long address, int timeoutMs, int* elapsedMs);
+
+// Drop the link to a device (no-op if not connected)
+void winrt_disconnect(unsigned long long address);
+
+// Returns: 1 if the device is connected, 0 otherwise
+int winrt_is_connected(unsigned long long address);
+
+// Route connects and GATT through simulated peripherals (enabled=1) that
+// link every connectable device after connectLatencyMs, or back to WinRT
+// (enabled=0). Switching drops all links and the GATT cache.
+void winrt_use_mock_backend(int enabled, int connectLatencyMs);
+
+// Feed an advertisement into the scan pipeline as if the watcher received it
+// (device table, connect cache, active scan callback). Works without a scan.
+// Parameters:
+//   addressType: 0=public, 1=random
+//   connectable: 1 if the advert was connectable
+//   name: UTF-8 local name (may be NULL)
+//   data, length: raw AD structures, [len][type][data]... (may be NULL/0)
+// Returns: 0 on success, -1 on error
+int winrt_inject_advertisement(unsigned long long address, int addressType, int connectable, int rssi,
+                               const char* name, const unsigned char* data, int length);
+
+// Replay the LE advertising reports (legacy and extended) of a btsnoop
+// capture through the scan pipeline on a background thread, as if the
+// watcher received them: address filter, scan response pairing, device
+// table, callback. Works without a radio or a scan. Captures from btmon,
+// hcidump, Android and btvs (Windows HCI traces) are supported.
+// Replayed devices are not retained: the BLEDevice strings passed to the
+// callback are only valid during the call.
+// Parameters:
+//   rate: replay speed relative to capture time (1 = real time, 10 = ten
+//         times faster); 0 = as fast as possible
+//   loops: passes over the capture, 0 = until winrt_replay_stop
+// Returns: 0 on success, -1 if the file is not a supported btsnoop capture
+int winrt_replay_start(const char* path, double rate, int loops);
+
+// Stop a running replay
+void winrt_replay_stop();
+
+// Get progress of the current (or last) replay; delivered / elapsedMs is
+// the pipeline throughput when rate is 0
+void winrt_replay_stats(BLEReplayStats* stats);
+
+// GATT client
+// Services and characteristics are discovered once per device and cached
+// across connections, together with the values of static (read-only)
+// characteristics. A Service Changed indication drops the affected range.
+// UUIDs are given as text, e.g. "0000180a-0000-1000-8000-00805f9b34fb" or "180a".
+// Return codes as for winrt_connect, plus -5 not connected, -6 no such
+// characteristic, -7 operation not supported by the characteristic,
+// -8 buffer too small.
+
+// Copy the device's characteristics (cached after the first call)
+// Returns: records written, or a negative code
+int winrt_gatt_discover(unsigned long long address, BLEGattCharacteristic* characteristics, int capacity, int* total);
+
+// Read a characteristic; fromCache receives 1 if no radio round trip was needed (may be NULL)
+// Returns: value length, or a negative code
+int winrt_gatt_read(unsigned long long address, const char* service, const char* characteristic,
+                    unsigned char* buffer, int capacity, int* fromCache);
+
+// Write a characteristic (withResponse: 1 = write request, 0 = write command)
+// Returns: 0 on success, or a negative code
+int winrt_gatt_write(unsigned long long address, const char* service, const char* characteristic,
+                     const unsigned char* data, int length, int withResponse);
+
+// Enable notifications/indications delivered to callback; NULL callback disables
+// Returns: 0 on success, or a negative code
+int winrt_gatt_subscribe(unsigned long long address, const char* service, const char* characteristic,
+                         GattValueCallback callback, void* userData);
+
+// Copy GATT cache counters
+void winrt_gatt_stats(BLEGattStats* stats);
+
+// Keep discovered attribute layouts in a memory-mapped file, keyed by
+// address, NIOX serial and firmware revision, so discovery is skipped on
+// later connects and later runs. On connect the stored layout is confirmed
+// with one read of the Firmware Revision String (0x2A26); devices without it
+// are not stored. NULL or "" turns persistence off.
+// Returns: 0 on success, -1 on error
+int winrt_gatt_set_cache_file(const char* path);
+
+// Copy persistent attribute cache counters (all zero while persistence is off)
+void winrt_gatt_cache_stats(BLEAttributeCacheStats* stats);
+
+// Connection scheduler
+// Queues GATT work for many devices and serves it with at most maxSessions
+// links open at once. Operations on one device never overlap; the device
+// whose next operation has the highest priority goes first, and a session
+// runs at most `quantum` operations before other ready devices get a turn.
+// Callbacks run on scheduler threads.
+
+// Start the scheduler. Returns: 0 on success, -1 on error or if already running
+int winrt_scheduler_start(int maxSessions, int quantum, int connectTimeoutMs);
+
+// Stop the scheduler; queued operations complete with result -9 (cancelled)
+void winrt_scheduler_stop();
+
+// Queue a read / write (priority: higher runs first)
+// Returns: operation id passed to the callback, or -1 on error
+long long winrt_schedule_read(unsigned long long address, const char* service, const char* characteristic,
+                              int priority, ScheduledOperationCallback callback, void* userData);
+long long winrt_schedule_write(unsigned long long address, const char* service, const char* characteristic,
+                               const unsigned char* data, int length, int withResponse,
+                               int priority, ScheduledOperationCallback callback, void* userData);
+
+// Copy per-device queueing and service times. Returns: records written, or -1 on error
+int winrt_scheduler_stats(BLEScheduleStats* stats, int capacity, int* total);
+
+// Connection pool: released sessions stay open for idleMs and are reused by
+// later acquires (including scheduler sessions); beyond capacity the least
+// recently used idle session is closed. Dropped links are re-established.
+// Returns: 0 on success, -1 on error
+int winrt_pool_start(int capacity, int idleMs, int connectTimeoutMs);
+
+// Stop the pool and close its sessions
+void winrt_pool_stop();
+
+// Lease a session (reused: 1 if a pooled link was handed out)
+// Returns: 0 on success, or a negative link error
+int winrt_pool_acquire(unsigned long long address, int* reused);
+
+// Return a leased session to the pool
+void winrt_pool_release(unsigned long long address);
+
+// Get pool hit rate, evictions and saved setup time
+void winrt_pool_stats(BLEPoolStats* stats);
+
+// Batched writes
+// Queued writes are sent in order as write commands (without response),
+// paced by the stack's transmit buffer. A barrier is sent as a write request:
+// its response acknowledges it and every write before it, and later writes
+// wait for it. Use barriers only where the device protocol needs an
+// acknowledgement. Values longer than MTU - 3 go as requests.
+
+// Queue a write. Returns: 0 on success, -1 on error
+int winrt_write_queue_add(unsigned long long address, const char* service, const char* characteristic,
+                          const unsigned char* data, int length, int barrier);
+
+// Send queued writes (stats may be NULL). On error the failed write and those
+// after it stay queued. Returns: 0 on success, or a negative code
+int winrt_write_queue_flush(unsigned long long address, BLEWriteQueueStats* stats);
+
+// Drop queued writes
+void winrt_write_queue_clear(unsigned long long address);
+
+// Notification streaming
+// Notifications of streamed characteristics are copied once, from the WinRT
+// buffer into a preallocated ring; the consumer reads them in place. No
+// allocation happens per notification. When the ring is full, new
+// notifications are dropped and counted.
+
+// Create the ring. Returns: 0 on success, -1 on error or if already started
+int winrt_stream_start(int capacityBytes);
+
+// Stop streaming. The ring is freed once polled views are released and
+// streamed characteristics are unsubscribed.
+void winrt_stream_stop();
+
+// Stream a characteristic's notifications into the ring (enable = 0 stops)
+// Returns: 0 on success, or a negative code
+int winrt_stream_subscribe(unsigned long long address, const char* service, const char* characteristic, int enable);
+
+// Views of up to maxRecords buffered notifications, oldest first. Repeated
+// polls continue after the previous ones until winrt_stream_release.
+// Returns: records written, or -1 if streaming is not started
+int winrt_stream_poll(BLENotification* records, int maxRecords);
+
+// Free every notification returned by winrt_stream_poll
+void winrt_stream_release();
+
+// Returns: 0 on success, -1 if streaming is not started
+int winrt_stream_stats(BLEStreamStats* stats);
+
+// Measurement log download
+// Negotiates the largest MTU and keeps `depth` range requests outstanding
+// while the device streams the log as notifications (values <= 0 pick
+// defaults; options apply when a download starts). If the link drops, the
+// call fails with the link error and keeps the data received so far; calling
+// again after reconnecting resumes from the last acknowledged offset.
+// Returns: log size on success, GATT_NO_SPACE (-8) if capacity is too small
+// (call again with a larger buffer), or another negative code
+int winrt_log_download(unsigned long long address, int mtu, int depth, int requestTimeoutMs,
+                       unsigned char* buffer, int capacity);
+
+// Progress and throughput of the current or last finished download
+// Returns: 0 on success, -1 if the device has no download
+int winrt_log_stats(unsigned long long address, BLETransferStats* stats);
+
+// Drop a partial download; the next one starts from offset 0
+void winrt_log_discard(unsigned long long address);
+
+// Simulated peripherals (only while winrt_use_mock_backend(1, ...) is active)
+// Each peripheral exposes the Generic Attribute service with Service Changed.
+
+// Add a characteristic. Returns: its value handle, or -1 on error
+int winrt_mock_add_characteristic(unsigned long long address, const char* service, const char* characteristic,
+                                  int properties, const unsigned char* data, int length);
+
+// Change a value, notifying a subscribed client. Returns: 0 on success, -1 on error
+int winrt_mock_set_value(unsigned long long address, int handle, const unsigned char* data, int length);
+
+// Move all non-GATT attributes to new handles and indicate Service Changed
+// Returns: 0 on success, -1 on error
+int winrt_mock_services_changed(unsigned long long address);
+
+// Make a simulated peripheral refuse links (unreachable=1) as a device that
+// advertises but is out of range would, or accept them again (0)
+// Returns: 0 on success, -1 if the simulation is not active
+int winrt_mock_set_unreachable(unsigned long long address, int unreachable);
+
+// Simulated radio timing: roundTripMs per request; write commands take
+// packetIntervalUs each on air with at most commandSlots buffered (0: no limit)
+// Returns: 0 on success, -1 on error
+int winrt_mock_set_timing(int roundTripMs, int commandSlots, int packetIntervalUs);
+
+// Add a measurement log of `size` bytes (byte i = (i * 7 + i / 256) & 0xFF).
+// The first chunk of each request arrives after roundTripMs, later ones every
+// packetIntervalUs; lossPercent of the chunks are dropped. maxMtu > 0 sets the
+// largest MTU simulated peripherals accept. Returns: 0 on success, -1 on error
+int winrt_mock_add_log(unsigned long long address, int size, int roundTripMs, int packetIntervalUs,
+                       int lossPercent, int maxMtu);
+
+// Multi-host aggregation
+// Endpoints are "udp://host:port" (e.g. "udp://127.0.0.1:47000") or, on POSIX
+// hosts, "unix:///path/to/socket". A process may run a node, a collector, or both.
+
+// Start receiving device deltas from nodes. Returns: 0 on success, -1 on error
+int winrt_aggregator_start_collector(const char* endpoint);
+
+// Start streaming this host's device table to a collector every intervalMs
+// Returns: 0 on success, -1 on error
+int winrt_aggregator_start_node(int nodeId, const char* collectorEndpoint, int intervalMs);
+
+// Stop node and collector threads and clear the merged table
+void winrt_aggregator_stop();
+
+// Copy merged devices (collector role). Returns: records written, or -1 on error
+int winrt_aggregator_devices(BLEAggregatedDevice* devices, int capacity, int* total);
+
+// Copy per-node status (collector role). Returns: records written, or -1 on error
+int winrt_aggregator_nodes(BLEAggregatorNode* nodes, int capacity, int* total);
+
+// Delta-compressed update stream for forwarding scan results
+// Frames are stateful (address dictionary), so the bytes must reach the
+// decoder in order, e.g. over a pipe, TCP connection or file. After a
+// corrupt or missing frame the decoder reports synced = 0 and ignores
+// updates until the producer calls winrt_wire_reset_encoder.
+
+// Encode devices heard since the previous call and copy up to `capacity`
+// bytes of stream into buffer. Bytes that did not fit are returned first by
+// the next call. Returns: bytes written (0 if nothing new), or -1 on error
+int winrt_wire_encode_updates(unsigned char* buffer, int capacity);
+
+// Start a new stream: the next encode begins with a reset frame and the full dictionary
+void winrt_wire_reset_encoder();
+
+// Feed stream bytes (any chunking) and copy out up to `capacity` decoded updates.
+// Call again with length 0 to drain remaining updates.
+// Returns: updates written, or -1 on error
+int winrt_wire_decode(const unsigned char* data, int length, BLEWireUpdate* updates, int capacity);
+
+// Get the decoder's sync state and error counters
+void winrt_wire_decode_stats(BLEWireDecodeStats* stats);
+
 // Free string allocated by this library
 void winrt_free_string(char* str);
 
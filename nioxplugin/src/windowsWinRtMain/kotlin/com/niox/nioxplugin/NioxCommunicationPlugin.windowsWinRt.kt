@@ -50,6 +50,9 @@ class WindowsWinRtNioxCommunicationPlugin : NioxCommunicationPlugin {
         scanDurationMs: Long,
         serviceUuidFilter: String?
     ): List<BluetoothDevice> {
+        // A malformed filter must not silently widen the scan to every device
+        serviceUuidFilter?.let { BluetoothUuid.parse(it) }
+
         if (!isScanning.compareAndSet(false, true)) {
             // Already scanning
             return emptyList()
@@ -100,6 +103,9 @@ class WindowsWinRtNioxCommunicationPlugin : NioxCommunicationPlugin {
                     return@withContext
                 }
 
+                // Parse the filter once; adverts are compared as integers
+                val filterUuid = serviceUuidFilter?.let { BluetoothUuid.parseOrNull(it) }
+
                 // Set up advertisement received callback
                 val callback = object : AdvertisementCallback {
                     override fun onAdvertisementReceived(advertisement: Advertisement) {
@@ -112,7 +118,7 @@ class WindowsWinRtNioxCommunicationPlugin : NioxCommunicationPlugin {
                         // Apply filtering
                         val shouldInclude = if (serviceUuidFilter != null) {
                             // Check if advertisement contains the service UUID
-                            advertisement.serviceUuids.contains(serviceUuidFilter.lowercase()) ||
+                            (filterUuid != null && advertisement.serviceUuids.any { BluetoothUuid.parseOrNull(it) == filterUuid }) ||
                             // Also filter by NIOX name prefix
                             (name?.startsWith(NioxConstants.NIOX_DEVICE_NAME_PREFIX, ignoreCase = true) == true)
                         } else {
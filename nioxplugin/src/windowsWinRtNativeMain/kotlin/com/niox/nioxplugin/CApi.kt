@@ -2,6 +2,7 @@ package com.niox.nioxplugin
 
 import kotlinx.cinterop.*
 import kotlinx.coroutines.runBlocking
+import platform.winrt.ble.*
 import kotlin.experimental.ExperimentalNativeApi
 
 /**
@@ -57,7 +58,7 @@ fun checkBluetooth(): Int {
  * Scan for devices
  * Parameters:
  *   durationMs: scan duration in milliseconds
- *   nioxOnly: 1 for NIOX devices only, 0 for all devices
+ *   nioxOnly: 1 for NIOX devices only, 2 for the site fleet only (see niox_load_fleet), 0 for all devices
  * Returns: JSON string with device list (must be freed with niox_free_string)
  */
 @OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
@@ -82,7 +83,7 @@ fun scanDevices(durationMs: Long, nioxOnly: Int): CPointer<ByteVar>? {
             devices.forEachIndexed { index, device ->
                 if (index > 0) append(",")
                 append("{")
-                append("\"name\":\"${device.name?.replace("\"", "\\\"") ?: "Unknown"}\",")
+                append("\"name\":\"${jsonEscape(device.name ?: "Unknown")}\",")
                 append("\"address\":\"${device.address}\",")
                 append("\"rssi\":${device.rssi ?: "null"},") // NOW HAS RSSI!
                 append("\"isNioxDevice\":${device.isNioxDevice()},")
@@ -95,14 +96,66 @@ fun scanDevices(durationMs: Long, nioxOnly: Int): CPointer<ByteVar>? {
         }
 
         // Allocate string in native memory and return pointer
-        return memScoped {
-            val bytes = json.encodeToByteArray()
-            val ptr = nativeHeap.allocArray<ByteVar>(bytes.size + 1)
-            bytes.forEachIndexed { index, byte ->
-                ptr[index] = byte
+        return allocNativeString(json)
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Add or replace the identity resolving key (IRK) of a bonded device
+ * Adverts from the device's rotating private addresses then update one record under its identity address.
+ * Parameters:
+ *   identityAddress: identity address "XX:XX:XX:XX:XX:XX"
+ *   irk: 32 hex digits, most significant byte first
+ * Returns: 0 on success, -1 on error
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_add_identity_key")
+fun addIdentityKey(identityAddress: CPointer<ByteVar>?, irk: CPointer<ByteVar>?): Int {
+    return try {
+        val rawAddress = parseBluetoothAddress(identityAddress?.toKString()) ?: return -1
+        winrt_add_identity_key(rawAddress, irk?.toKString())
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Forget the IRK of an identity address
+ * Returns: 0 if removed, -1 if unknown or invalid
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_remove_identity_key")
+fun removeIdentityKey(identityAddress: CPointer<ByteVar>?): Int {
+    val rawAddress = parseBluetoothAddress(identityAddress?.toKString()) ?: return -1
+    return winrt_remove_identity_key(rawAddress)
+}
+
+/**
+ * Get identity resolution counters
+ * Returns: JSON object (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_identity_stats")
+fun identityStats(): CPointer<ByteVar>? {
+    return try {
+        memScoped {
+            val stats = alloc<BLEIdentityStats>()
+            winrt_identity_stats(stats.ptr)
+            val json = buildString {
+                append("{")
+                append("\"keys\":${stats.keys},")
+                append("\"cached\":${stats.cached},")
+                append("\"lookups\":${stats.lookups},")
+                append("\"cacheHits\":${stats.cacheHits},")
+                append("\"resolved\":${stats.resolved},")
+                append("\"unresolved\":${stats.unresolved},")
+                append("\"aesBlocks\":${stats.aesBlocks},")
+                append("\"hardwareAes\":${stats.hardwareAes != 0}")
+                append("}")
             }
-            ptr[bytes.size] = 0 // Null terminator
-            ptr
+            allocNativeString(json)
         }
     } catch (e: Exception) {
         null
@@ -110,24 +163,1686 @@ fun scanDevices(durationMs: Long, nioxOnly: Int): CPointer<ByteVar>? {
 }
 
 /**
- * Free string memory allocated by niox_scan_devices
+ * Size the RSSI history kept for NIOX devices (drops the history kept so far)
+ * Parameters:
+ *   maxDevices: devices with history; the one heard least recently is dropped when full
+ *   rawSamples: last adverts kept at full resolution
+ *   secondBuckets: 1 s buckets kept after that
+ *   tenSecondBuckets: 10 s buckets kept after that
+ * Returns: 0 on success, -1 on error
  */
 @OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
-@CName("niox_free_string")
-fun freeString(ptr: CPointer<ByteVar>?) {
-    ptr?.let {
-        nativeHeap.free(it)
+@CName("niox_configure_rssi_history")
+fun configureRssiHistory(maxDevices: Int, rawSamples: Int, secondBuckets: Int, tenSecondBuckets: Int): Int {
+    return winrt_configure_rssi_history(maxDevices, rawSamples, secondBuckets, tenSecondBuckets)
+}
+
+/**
+ * Export the RSSI history of one NIOX device, or of all of them, for charts
+ * Older samples come back as 1 s / 10 s buckets with min, max and mean.
+ * Parameters:
+ *   address: "XX:XX:XX:XX:XX:XX", or null for every device
+ *   windowMs: only the last N milliseconds (0 = everything kept)
+ * Returns: JSON object {"devices":[{"address":"...","points":[[ageMs,widthMs,min,max,mean,count],...]}]},
+ *          oldest point first (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_rssi_history")
+fun rssiHistory(address: CPointer<ByteVar>?, windowMs: Int): CPointer<ByteVar>? {
+    return try {
+        val rawAddress = if (address == null) 0uL else (parseBluetoothAddress(address.toKString()) ?: return null)
+        memScoped {
+            val total = alloc<IntVar>()
+            if (winrt_export_rssi_history(rawAddress, windowMs, null, 0, total.ptr) < 0) return null
+            val capacity = total.value
+            val points = allocArray<BLERssiPoint>(maxOf(capacity, 1))
+            val count = winrt_export_rssi_history(rawAddress, windowMs, points, capacity, null)
+            if (count < 0) return null
+
+            val json = buildString {
+                append("{\"devices\":[")
+                var current: ULong? = null
+                for (index in 0 until count) {
+                    val point = points[index]
+                    if (point.rawAddress != current) {
+                        if (current != null) append("]},")
+                        append("{\"address\":\"${formatBluetoothAddress(point.rawAddress)}\",\"points\":[")
+                        current = point.rawAddress
+                    } else {
+                        append(",")
+                    }
+                    append("[${point.ageMs},${point.widthMs},${point.rssiMin},${point.rssiMax},${point.rssiMean},${point.count}]")
+                }
+                if (current != null) append("]}")
+                append("]}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Start appending every advert to an on-disk scan log (about 5 bytes per advert)
+ * Writing happens on a background thread; adverts are dropped (and counted) if its buffer fills.
+ * Parameters:
+ *   path: log file; an existing scan log is appended to
+ *   flushIntervalMs: buffered adverts are written at least this often (0 = 1000)
+ *   maxBufferedRecords: buffer limit (0 = 65536)
+ * Returns: 0 on success, -1 on error
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_scan_log_start")
+fun scanLogStart(path: CPointer<ByteVar>?, flushIntervalMs: Int, maxBufferedRecords: Int): Int {
+    return try {
+        winrt_scan_log_start(path?.toKString(), flushIntervalMs, maxBufferedRecords)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Write buffered adverts and close the scan log
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_scan_log_stop")
+fun scanLogStop() {
+    winrt_scan_log_stop()
+}
+
+/**
+ * Get scan log counters
+ * Returns: JSON object (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_scan_log_stats")
+fun scanLogStats(): CPointer<ByteVar>? {
+    return try {
+        memScoped {
+            val stats = alloc<BLEScanLogStats>()
+            winrt_scan_log_stats(stats.ptr)
+            val json = buildString {
+                append("{")
+                append("\"records\":${stats.records},")
+                append("\"blocks\":${stats.blocks},")
+                append("\"bytes\":${stats.bytes},")
+                append("\"dropped\":${stats.dropped},")
+                append("\"pending\":${stats.pending},")
+                append("\"active\":${stats.active != 0}")
+                append("}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Read adverts from a scan log by time range
+ * Parameters:
+ *   path: log file (may be the one being written)
+ *   fromMs, toMs: Unix milliseconds, fromMs inclusive, toMs exclusive
+ *   maxRecords: most records returned
+ * Returns: JSON object {"total":N,"records":[{"address":"...","timeMs":T,"rssi":R,"isNioxDevice":B,"inFleet":B,"hasStatus":B},...]}
+ *          in log order (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_scan_log_query")
+fun scanLogQuery(path: CPointer<ByteVar>?, fromMs: Long, toMs: Long, maxRecords: Int): CPointer<ByteVar>? {
+    return try {
+        memScoped {
+            val capacity = maxOf(maxRecords, 0)
+            val total = alloc<IntVar>()
+            val records = allocArray<BLEScanLogRecord>(maxOf(capacity, 1))
+            val count = winrt_scan_log_query(path?.toKString(), fromMs, toMs, records, capacity, total.ptr)
+            if (count < 0) return null
+
+            val json = buildString {
+                append("{\"total\":${total.value},\"records\":[")
+                for (index in 0 until count) {
+                    val record = records[index]
+                    if (index > 0) append(",")
+                    append("{\"address\":\"${formatBluetoothAddress(record.rawAddress)}\",")
+                    append("\"timeMs\":${record.timeMs},")
+                    append("\"rssi\":${record.rssi},")
+                    append("\"isNioxDevice\":${record.isNioxDevice != 0},")
+                    append("\"inFleet\":${record.inFleet != 0},")
+                    append("\"hasStatus\":${record.hasStatus != 0}}")
+                }
+                append("]}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Replace the site fleet: the known NIOX PRO serials of this site
+ * Devices in the fleet report "inFleet": true and match queryDevices with nioxOnly = 2.
+ * Parameters:
+ *   manifest: serials one per line (or ',' / ';' separated), bare or as "NIOX PRO <serial>", '#' comments;
+ *             null or empty restores the table compiled into the DLL
+ * Returns: number of serials in the active fleet, or -1 on error
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_load_fleet")
+fun loadFleet(manifest: CPointer<ByteVar>?): Int {
+    return try {
+        winrt_load_fleet(manifest?.toKString())
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Check whether a serial number belongs to the site fleet
+ * Returns: 1 if it does, 0 if not, -1 if the serial is invalid
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_fleet_contains")
+fun fleetContains(serial: CPointer<ByteVar>?): Int {
+    return try {
+        winrt_fleet_contains(serial?.toKString())
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Get the number of serials in the active fleet
+ * Returns: JSON object {"size":N,"compiled":true|false} (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_fleet_info")
+fun fleetInfo(): CPointer<ByteVar>? {
+    return try {
+        memScoped {
+            val compiled = alloc<IntVar>()
+            val size = winrt_fleet_size(compiled.ptr)
+            allocNativeString("{\"size\":$size,\"compiled\":${compiled.value != 0}}")
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Add an address to the denylist or allowlist
+ * Adverts from denylisted addresses are dropped on arrival; a non-empty allowlist admits only its addresses.
+ * Lists can change while a scan is running.
+ * Parameters:
+ *   list: 0 = denylist, 1 = allowlist
+ *   address: "XX:XX:XX:XX:XX:XX"
+ * Returns: 0 on success, -1 on error
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_address_filter_add")
+fun addressFilterAdd(list: Int, address: CPointer<ByteVar>?): Int {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+        winrt_address_filter_add(list, rawAddress)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Remove an address from the denylist (0) or allowlist (1)
+ * Returns: 0 if removed, -1 if not listed or invalid
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_address_filter_remove")
+fun addressFilterRemove(list: Int, address: CPointer<ByteVar>?): Int {
+    val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+    return winrt_address_filter_remove(list, rawAddress)
+}
+
+/**
+ * Empty the denylist (0) or allowlist (1)
+ * Returns: 0 on success, -1 on error
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_address_filter_clear")
+fun addressFilterClear(list: Int): Int {
+    return winrt_address_filter_clear(list)
+}
+
+/**
+ * Learn the denylist from devices heard threshold times with a non-NIOX name
+ * Parameters:
+ *   threshold: sightings before an address is denied, 0 stops learning
+ *   capacity: most addresses to learn
+ * Returns: 0 on success, -1 on error
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_address_filter_learn")
+fun addressFilterLearn(threshold: Int, capacity: Int): Int {
+    return winrt_address_filter_learn(threshold, capacity)
+}
+
+/**
+ * Get address filter counters
+ * Returns: JSON object (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_address_filter_stats")
+fun addressFilterStats(): CPointer<ByteVar>? {
+    return try {
+        memScoped {
+            val stats = alloc<BLEAddressFilterStats>()
+            winrt_address_filter_stats(stats.ptr)
+            val json = buildString {
+                append("{")
+                append("\"checked\":${stats.checked},")
+                append("\"denied\":${stats.denied},")
+                append("\"notAllowed\":${stats.notAllowed},")
+                append("\"bloomFalsePositives\":${stats.bloomFalsePositives},")
+                append("\"learned\":${stats.learned},")
+                append("\"denySize\":${stats.denySize},")
+                append("\"allowSize\":${stats.allowSize}")
+                append("}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Choose the scan strategy for later scans
+ * Parameters:
+ *   strategy: 0 = active for the whole scan, 1 = passive sweep then an active burst only if needed
+ *   passiveMs: passive sweep length (strategy 1)
+ *   activeMs: longest active burst (strategy 1)
+ *   minRssi: nameless devices weaker than this (dBm) do not trigger the active burst
+ * Returns: 0 on success, -1 on error
+ */
+@OptIn(ExperimentalNativeApi::class)
+@CName("niox_set_scan_strategy")
+fun setScanStrategy(strategy: Int, passiveMs: Int, activeMs: Int, minRssi: Int): Int {
+    return winrt_set_scan_strategy(strategy, passiveMs, activeMs, minRssi)
+}
+
+/**
+ * Get the phase breakdown of the last completed scan
+ * Returns: JSON object (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_scan_phase_stats")
+fun scanPhaseStats(): CPointer<ByteVar>? {
+    return try {
+        memScoped {
+            val stats = alloc<BLEScanPhaseStats>()
+            winrt_scan_phase_stats(stats.ptr)
+            val json = buildString {
+                append("{")
+                append("\"strategy\":${stats.strategy},")
+                append("\"passiveMs\":${stats.passiveMs},")
+                append("\"activeMs\":${stats.activeMs},")
+                append("\"candidates\":${stats.candidates},")
+                append("\"unresolved\":${stats.unresolved},")
+                append("\"resolvedMs\":${stats.resolvedMs},")
+                append("\"passiveEvents\":${stats.passiveEvents},")
+                append("\"activeEvents\":${stats.activeEvents}")
+                append("}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Set how long an active scan waits to pair an advertisement with its scan response
+ * Parameters:
+ *   timeoutMs: wait in milliseconds; 0 reports every advertisement and scan response separately
+ * Returns: 0 on success, -1 on error
+ */
+@OptIn(ExperimentalNativeApi::class)
+@CName("niox_set_scan_merge_timeout")
+fun setScanMergeTimeout(timeoutMs: Int): Int {
+    return winrt_set_scan_merge_timeout(timeoutMs)
+}
+
+/**
+ * Get advertisement / scan response pairing counters
+ * Returns: JSON object (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_scan_merge_stats")
+fun scanMergeStats(): CPointer<ByteVar>? {
+    return try {
+        memScoped {
+            val stats = alloc<BLEScanMergeStats>()
+            winrt_scan_merge_stats(stats.ptr)
+            val json = buildString {
+                append("{")
+                append("\"received\":${stats.received},")
+                append("\"delivered\":${stats.delivered},")
+                append("\"merged\":${stats.merged},")
+                append("\"passedThrough\":${stats.passedThrough},")
+                append("\"timedOut\":${stats.timedOut},")
+                append("\"superseded\":${stats.superseded},")
+                append("\"pending\":${stats.pending},")
+                append("\"timeoutMs\":${stats.timeoutMs}")
+                append("}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Query devices tracked by previous scans without rescanning
+ * Filtering, sorting and paging run natively, so only the requested page is serialized.
+ * Parameters:
+ *   nioxOnly: 1 for NIOX devices only, 0 for all devices
+ *   minRssi: RSSI floor in dBm (-128 for no floor)
+ *   seenWithinMs: only devices heard in the last N milliseconds (0 = any)
+ *   sortKey: 0=RSSI (strongest first), 1=last seen (newest first), 2=serial number, -1=none
+ *   offset: index of the first device of the page
+ *   limit: page size (1..1000)
+ * Returns: JSON object {"total":N,"devices":[...]} (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_query_devices")
+fun queryDevices(nioxOnly: Int, minRssi: Int, seenWithinMs: Int, sortKey: Int, offset: Int, limit: Int): CPointer<ByteVar>? {
+    return try {
+        val pageSize = limit.coerceIn(1, MAX_QUERY_PAGE)
+        memScoped {
+            val query = alloc<BLEDeviceQuery>().apply {
+                this.nioxOnly = nioxOnly
+                this.minRssi = minRssi
+                this.seenWithinMs = seenWithinMs
+                this.sortKey = sortKey
+                this.offset = offset
+                this.limit = pageSize
+            }
+            val records = allocArray<BLEDeviceRecord>(pageSize)
+            val total = alloc<IntVar>()
+
+            val count = winrt_query_devices(query.ptr, records, pageSize, total.ptr)
+            if (count < 0) return null
+
+            val json = buildString {
+                append("{\"total\":${total.value},\"devices\":[")
+                for (index in 0 until count) {
+                    val record = records[index]
+                    val name = record.name.toKString()
+                    val serial = record.serialNumber.toKString()
+                    if (index > 0) append(",")
+                    append("{")
+                    append("\"name\":\"${jsonEscape(name.ifEmpty { "Unknown" })}\",")
+                    append("\"address\":\"${record.address.toKString()}\",")
+                    if (record.radioAddress != record.rawAddress) {
+                        append("\"radioAddress\":\"${formatBluetoothAddress(record.radioAddress)}\",")
+                    }
+                    append("\"rssi\":${record.rssi},")
+                    append("\"ageMs\":${record.ageMs},")
+                    append("\"isNioxDevice\":${record.isNioxDevice != 0},")
+                    append("\"inFleet\":${record.inFleet != 0},")
+                    if (record.hasStatus != 0) {
+                        append("\"status\":{")
+                        append("\"batteryPercent\":${statusField(record.batteryPercent)},")
+                        append("\"ready\":${statusFlag(record.ready)},")
+                        append("\"charging\":${statusFlag(record.charging)},")
+                        append("\"busy\":${statusFlag(record.busy)},")
+                        append("\"error\":${statusFlag(record.error)},")
+                        append("\"errorCode\":${statusField(record.errorCode)},")
+                        append("\"testsRemaining\":${statusField(record.testsRemaining)}")
+                        append("},")
+                    } else {
+                        append("\"status\":null,")
+                    }
+                    if (serial.isNotEmpty()) {
+                        append("\"serialNumber\":\"$serial\"")
+                    } else {
+                        append("\"serialNumber\":null")
+                    }
+                    append("}")
+                }
+                append("]}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Query per-device advert statistics: count, first/last seen, RSSI spread and advertising interval
+ * Parameters are those of niox_query_devices; devices come back in the same order and pages.
+ * Returns: JSON object {"total":N,"devices":[...]} (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_query_device_stats")
+fun queryDeviceStats(nioxOnly: Int, minRssi: Int, seenWithinMs: Int, sortKey: Int, offset: Int, limit: Int): CPointer<ByteVar>? {
+    return try {
+        val pageSize = limit.coerceIn(1, MAX_QUERY_PAGE)
+        memScoped {
+            val query = alloc<BLEDeviceQuery>().apply {
+                this.nioxOnly = nioxOnly
+                this.minRssi = minRssi
+                this.seenWithinMs = seenWithinMs
+                this.sortKey = sortKey
+                this.offset = offset
+                this.limit = pageSize
+            }
+            val stats = allocArray<BLEDeviceStats>(pageSize)
+            val total = alloc<IntVar>()
+
+            val count = winrt_query_device_stats(query.ptr, stats, pageSize, total.ptr)
+            if (count < 0) return null
+
+            val json = buildString {
+                append("{\"total\":${total.value},\"devices\":[")
+                for (index in 0 until count) {
+                    val device = stats[index]
+                    val serial = device.serialNumber.toKString()
+                    if (index > 0) append(",")
+                    append("{")
+                    append("\"address\":\"${device.address.toKString()}\",")
+                    append("\"serialNumber\":${if (serial.isNotEmpty()) "\"$serial\"" else "null"},")
+                    append("\"adverts\":${device.adverts},")
+                    append("\"firstSeenAgeMs\":${device.firstSeenAgeMs},")
+                    append("\"lastSeenAgeMs\":${device.lastSeenAgeMs},")
+                    append("\"rssiMin\":${device.rssiMin},")
+                    append("\"rssiMax\":${device.rssiMax},")
+                    append("\"rssiMean\":${device.rssiMean},")
+                    append("\"rssiStdDev\":${device.rssiStdDev},")
+                    append("\"intervalMs\":${if (device.intervalMs < 0) "null" else device.intervalMs.toString()},")
+                    append("\"receiveRatio\":${device.receiveRatio},")
+                    append("\"scanWindowMs\":${if (device.scanWindowMs < 0) "null" else device.scanWindowMs.toString()}")
+                    append("}")
+                }
+                append("]}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Suggest a scan duration from measured advertising intervals and receive ratios
+ * Parameters:
+ *   nioxOnly, minRssi, seenWithinMs: which devices must be heard, as in niox_query_devices
+ *   confidence: probability of hearing every one of them at least once (0..1, e.g. 0.95)
+ * Returns: scan duration in milliseconds, or -1 if no matching device has been measured yet
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_suggest_scan_window")
+fun suggestScanWindow(nioxOnly: Int, minRssi: Int, seenWithinMs: Int, confidence: Double): Int {
+    return try {
+        memScoped {
+            val query = alloc<BLEDeviceQuery>().apply {
+                this.nioxOnly = nioxOnly
+                this.minRssi = minRssi
+                this.seenWithinMs = seenWithinMs
+                this.sortKey = -1
+                this.offset = 0
+                this.limit = 0
+            }
+            winrt_suggest_scan_window(query.ptr, confidence, null)
+        }
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Connect to a device heard by any previous scan, without rescanning
+ * Parameters:
+ *   address: Bluetooth address "XX:XX:XX:XX:XX:XX" as returned by scans and queries
+ *   timeoutMs: link setup timeout in milliseconds
+ *   elapsedMsOut: receives the link setup time in milliseconds (may be null)
+ * Returns: 0 on success, -1 on error, -2 if never heard, -3 if not connectable, -4 on timeout
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_connect")
+fun connectDevice(address: CPointer<ByteVar>?, timeoutMs: Int, elapsedMsOut: CPointer<IntVar>?): Int {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+        winrt_connect(rawAddress, timeoutMs, elapsedMsOut)
+    } catch (e: Exception) {
+        -1
     }
 }
 
 /**
- * Cleanup and release resources
+ * Disconnect a device connected with niox_connect
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_disconnect")
+fun disconnectDevice(address: CPointer<ByteVar>?) {
+    val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return
+    winrt_disconnect(rawAddress)
+}
+
+/**
+ * Check whether a device is connected
+ * Returns: 1 if connected, 0 otherwise
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_is_connected")
+fun isDeviceConnected(address: CPointer<ByteVar>?): Int {
+    val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return 0
+    return winrt_is_connected(rawAddress)
+}
+
+/**
+ * Use an in-memory connection backend instead of the Bluetooth radio (for tests)
+ * Parameters:
+ *   enabled: 1 for the mock backend, 0 for WinRT
+ *   connectLatencyMs: simulated link setup time
  */
 @OptIn(ExperimentalNativeApi::class)
+@CName("niox_use_mock_backend")
+fun useMockBackend(enabled: Int, connectLatencyMs: Int) {
+    winrt_use_mock_backend(enabled, connectLatencyMs)
+}
+
+/**
+ * Inject an advertisement as if it had been received by a scan (for tests)
+ * Parameters:
+ *   address: Bluetooth address "XX:XX:XX:XX:XX:XX"
+ *   addressType: 0=public, 1=random
+ *   connectable: 1 if the advertisement was connectable
+ *   rssi: signal strength in dBm
+ *   name: local name (may be null)
+ *   data, length: raw advertising data structures (may be null/0)
+ * Returns: 0 on success, -1 on failure
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_inject_advertisement")
+fun injectAdvertisement(
+    address: CPointer<ByteVar>?,
+    addressType: Int,
+    connectable: Int,
+    rssi: Int,
+    name: CPointer<ByteVar>?,
+    data: CPointer<UByteVar>?,
+    length: Int
+): Int {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+        winrt_inject_advertisement(rawAddress, addressType, connectable, rssi, name?.toKString(), data, length)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Replay the advertising reports of a btsnoop capture through the scan pipeline, without a radio
+ * Runs in the background; discovered devices reach the scan callback as in a live scan.
+ * Parameters:
+ *   path: btsnoop file (btmon, hcidump, Android, or a Windows HCI trace converted with btvs)
+ *   rate: speed relative to capture time (1 = real time); 0 = as fast as possible
+ *   loops: passes over the capture, 0 = until niox_replay_stop
+ * Returns: 0 on success, -1 if the file is not a supported capture
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_replay_start")
+fun replayStart(path: CPointer<ByteVar>?, rate: Double, loops: Int): Int {
+    return try {
+        winrt_replay_start(path?.toKString(), rate, loops)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Stop a running replay
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_replay_stop")
+fun replayStop() {
+    winrt_replay_stop()
+}
+
+/**
+ * Get replay progress; "reportsPerSecond" is the pipeline throughput of a rate 0 replay
+ * Returns: JSON object (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_replay_stats")
+fun replayStats(): CPointer<ByteVar>? {
+    return try {
+        memScoped {
+            val stats = alloc<BLEReplayStats>()
+            winrt_replay_stats(stats.ptr)
+            val handled = stats.delivered + stats.filtered
+            val perSecond = if (stats.elapsedMs > 0) (handled.toDouble() * 1000.0 / stats.elapsedMs).toLong() else 0L
+            val json = buildString {
+                append("{")
+                append("\"records\":${stats.records},")
+                append("\"events\":${stats.events},")
+                append("\"reports\":${stats.reports},")
+                append("\"extendedReports\":${stats.extendedReports},")
+                append("\"malformed\":${stats.malformed},")
+                append("\"delivered\":${stats.delivered},")
+                append("\"filtered\":${stats.filtered},")
+                append("\"loops\":${stats.loops},")
+                append("\"captureMs\":${stats.captureMs},")
+                append("\"elapsedMs\":${stats.elapsedMs},")
+                append("\"reportsPerSecond\":$perSecond,")
+                append("\"running\":${stats.running != 0}")
+                append("}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * List a connected device's GATT characteristics (discovered once, then served from the cache)
+ * Returns: JSON object {"characteristics":[...]} (must be freed with niox_free_string), or null on error
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_gatt_discover")
+fun gattDiscover(address: CPointer<ByteVar>?): CPointer<ByteVar>? {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return null
+        memScoped {
+            val total = alloc<IntVar>()
+            if (winrt_gatt_discover(rawAddress, null, 0, total.ptr) < 0) return null
+            val capacity = total.value.coerceAtLeast(1)
+            val records = allocArray<BLEGattCharacteristic>(capacity)
+            val count = winrt_gatt_discover(rawAddress, records, capacity, total.ptr)
+            if (count < 0) return null
+
+            val json = buildString {
+                append("{\"characteristics\":[")
+                for (index in 0 until count) {
+                    val record = records[index]
+                    if (index > 0) append(",")
+                    append("{")
+                    append("\"service\":\"${record.serviceUuid.toKString()}\",")
+                    append("\"characteristic\":\"${record.characteristicUuid.toKString()}\",")
+                    append("\"handle\":${record.handle},")
+                    append("\"properties\":${record.properties}")
+                    append("}")
+                }
+                append("]}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Read a GATT characteristic
+ * Parameters:
+ *   address: Bluetooth address "XX:XX:XX:XX:XX:XX" of a connected device
+ *   service, characteristic: UUIDs, full or 16-bit ("180a")
+ *   buffer, capacity: destination for the value
+ *   fromCacheOut: receives 1 if the value came from the cache (may be null)
+ * Returns: value length, or a negative code (see winrt_ble_wrapper.h)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_gatt_read")
+fun gattRead(
+    address: CPointer<ByteVar>?,
+    service: CPointer<ByteVar>?,
+    characteristic: CPointer<ByteVar>?,
+    buffer: CPointer<UByteVar>?,
+    capacity: Int,
+    fromCacheOut: CPointer<IntVar>?
+): Int {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+        winrt_gatt_read(rawAddress, service?.toKString(), characteristic?.toKString(), buffer, capacity, fromCacheOut)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Write a GATT characteristic
+ * Parameters:
+ *   withResponse: 1 for a write request, 0 for a write command
+ * Returns: 0 on success, or a negative code (see winrt_ble_wrapper.h)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_gatt_write")
+fun gattWrite(
+    address: CPointer<ByteVar>?,
+    service: CPointer<ByteVar>?,
+    characteristic: CPointer<ByteVar>?,
+    data: CPointer<UByteVar>?,
+    length: Int,
+    withResponse: Int
+): Int {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+        winrt_gatt_write(rawAddress, service?.toKString(), characteristic?.toKString(), data, length, withResponse)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Subscribe to notifications/indications of a characteristic
+ * Parameters:
+ *   callback: called with (address, handle, data, length, userData) on a background thread; null unsubscribes
+ * Returns: 0 on success, or a negative code (see winrt_ble_wrapper.h)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_gatt_subscribe")
+fun gattSubscribe(
+    address: CPointer<ByteVar>?,
+    service: CPointer<ByteVar>?,
+    characteristic: CPointer<ByteVar>?,
+    callback: GattValueCallback?,
+    userData: COpaquePointer?
+): Int {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+        winrt_gatt_subscribe(rawAddress, service?.toKString(), characteristic?.toKString(), callback, userData)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Persist discovered GATT attribute layouts in a file so reconnects skip service discovery
+ * Parameters:
+ *   path: cache file path; null or empty turns persistence off
+ * Returns: 0 on success, -1 on failure
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_gatt_set_cache_file")
+fun gattSetCacheFile(path: CPointer<ByteVar>?): Int {
+    return try {
+        winrt_gatt_set_cache_file(path?.toKString())
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Get GATT cache counters, including the persistent cache file
+ * Returns: JSON object (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_gatt_stats")
+fun gattStats(): CPointer<ByteVar>? {
+    return try {
+        memScoped {
+            val stats = alloc<BLEGattStats>()
+            winrt_gatt_stats(stats.ptr)
+            val file = alloc<BLEAttributeCacheStats>()
+            winrt_gatt_cache_stats(file.ptr)
+            val json = buildString {
+                append("{")
+                append("\"discoveries\":${stats.discoveries},")
+                append("\"cachedDiscoveries\":${stats.cachedDiscoveries},")
+                append("\"persistedDiscoveries\":${stats.persistedDiscoveries},")
+                append("\"radioReads\":${stats.radioReads},")
+                append("\"cachedReads\":${stats.cachedReads},")
+                append("\"invalidations\":${stats.invalidations},")
+                append("\"cacheFile\":{")
+                append("\"lookups\":${file.lookups},")
+                append("\"hits\":${file.hits},")
+                append("\"misses\":${file.misses},")
+                append("\"stale\":${file.stale},")
+                append("\"writes\":${file.writes},")
+                append("\"entries\":${file.entries}")
+                append("}}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Start the connection scheduler for servicing many devices at once
+ * Parameters:
+ *   maxSessions: maximum number of simultaneously open links
+ *   quantum: operations per session before other devices get a turn
+ *   connectTimeoutMs: link setup timeout per session
+ * Returns: 0 on success, -1 on failure
+ */
+@OptIn(ExperimentalNativeApi::class)
+@CName("niox_scheduler_start")
+fun schedulerStart(maxSessions: Int, quantum: Int, connectTimeoutMs: Int): Int {
+    return try {
+        winrt_scheduler_start(maxSessions, quantum, connectTimeoutMs)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Stop the scheduler; queued operations complete with result -9
+ */
+@OptIn(ExperimentalNativeApi::class)
+@CName("niox_scheduler_stop")
+fun schedulerStop() {
+    winrt_scheduler_stop()
+}
+
+/**
+ * Queue a characteristic read
+ * Parameters:
+ *   priority: higher runs first
+ *   callback: (id, address, result, data, length, queueMs, serviceMs, userData), called on a scheduler thread
+ * Returns: operation id, or -1 on error
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_schedule_read")
+fun scheduleRead(
+    address: CPointer<ByteVar>?,
+    service: CPointer<ByteVar>?,
+    characteristic: CPointer<ByteVar>?,
+    priority: Int,
+    callback: ScheduledOperationCallback?,
+    userData: COpaquePointer?
+): Long {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+        winrt_schedule_read(rawAddress, service?.toKString(), characteristic?.toKString(), priority, callback, userData)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Queue a characteristic write
+ * Parameters:
+ *   withResponse: 1 for a write request, 0 for a write command
+ *   priority: higher runs first
+ * Returns: operation id, or -1 on error
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_schedule_write")
+fun scheduleWrite(
+    address: CPointer<ByteVar>?,
+    service: CPointer<ByteVar>?,
+    characteristic: CPointer<ByteVar>?,
+    data: CPointer<UByteVar>?,
+    length: Int,
+    withResponse: Int,
+    priority: Int,
+    callback: ScheduledOperationCallback?,
+    userData: COpaquePointer?
+): Long {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+        winrt_schedule_write(
+            rawAddress, service?.toKString(), characteristic?.toKString(),
+            data, length, withResponse, priority, callback, userData
+        )
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Get per-device queueing and service times
+ * Returns: JSON object {"devices":[...]} (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_scheduler_stats")
+fun schedulerStats(): CPointer<ByteVar>? {
+    return try {
+        memScoped {
+            val total = alloc<IntVar>()
+            winrt_scheduler_stats(null, 0, total.ptr)
+            val capacity = total.value.coerceAtLeast(1)
+            val records = allocArray<BLEScheduleStats>(capacity)
+            val count = winrt_scheduler_stats(records, capacity, total.ptr)
+            if (count < 0) return null
+
+            val json = buildString {
+                append("{\"devices\":[")
+                for (index in 0 until count) {
+                    val record = records[index]
+                    if (index > 0) append(",")
+                    append("{")
+                    append("\"address\":\"${record.address.toKString()}\",")
+                    append("\"completed\":${record.completed},")
+                    append("\"failed\":${record.failed},")
+                    append("\"pending\":${record.pending},")
+                    append("\"avgQueueMs\":${record.avgQueueMs},")
+                    append("\"maxQueueMs\":${record.maxQueueMs},")
+                    append("\"avgServiceMs\":${record.avgServiceMs},")
+                    append("\"maxServiceMs\":${record.maxServiceMs},")
+                    append("\"sessions\":${record.sessions}")
+                    append("}")
+                }
+                append("]}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Start (or reconfigure) the connection pool; scheduler sessions lease from it while it runs
+ * Parameters:
+ *   capacity: maximum number of open pooled links
+ *   idleMs: released links close after this idle period
+ *   connectTimeoutMs: link setup timeout
+ * Returns: 0 on success, -1 on failure
+ */
+@OptIn(ExperimentalNativeApi::class)
+@CName("niox_pool_start")
+fun poolStart(capacity: Int, idleMs: Int, connectTimeoutMs: Int): Int {
+    return try {
+        winrt_pool_start(capacity, idleMs, connectTimeoutMs)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Stop the connection pool and close its links
+ */
+@OptIn(ExperimentalNativeApi::class)
+@CName("niox_pool_stop")
+fun poolStop() {
+    winrt_pool_stop()
+}
+
+/**
+ * Lease a link from the pool, connecting if none is open
+ * Parameters:
+ *   reusedOut: receives 1 if a pooled link was reused (may be null)
+ * Returns: 0 on success, -1 on error, -2 if never heard, -3 if not connectable, -4 on timeout
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_pool_acquire")
+fun poolAcquire(address: CPointer<ByteVar>?, reusedOut: CPointer<IntVar>?): Int {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+        winrt_pool_acquire(rawAddress, reusedOut)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Return a leased link to the pool
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_pool_release")
+fun poolRelease(address: CPointer<ByteVar>?) {
+    val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return
+    winrt_pool_release(rawAddress)
+}
+
+/**
+ * Get connection pool statistics
+ * Returns: JSON object (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_pool_stats")
+fun poolStats(): CPointer<ByteVar>? {
+    return try {
+        memScoped {
+            val stats = alloc<BLEPoolStats>()
+            winrt_pool_stats(stats.ptr)
+            val hitRate = if (stats.acquires > 0uL) stats.hits.toDouble() / stats.acquires.toDouble() else 0.0
+            val json = buildString {
+                append("{")
+                append("\"acquires\":${stats.acquires},")
+                append("\"hits\":${stats.hits},")
+                append("\"misses\":${stats.misses},")
+                append("\"reconnects\":${stats.reconnects},")
+                append("\"failures\":${stats.failures},")
+                append("\"hitRate\":$hitRate,")
+                append("\"evictedIdle\":${stats.evictedIdle},")
+                append("\"evictedLru\":${stats.evictedLru},")
+                append("\"open\":${stats.open},")
+                append("\"leased\":${stats.leased},")
+                append("\"avgSetupMs\":${stats.avgSetupMs},")
+                append("\"savedSetupMs\":${stats.savedSetupMs}")
+                append("}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Queue a characteristic write; queued writes go out as write commands in bursts
+ * Parameters:
+ *   barrier: 1 if the device must acknowledge this write (and all before it) before later writes
+ * Returns: 0 on success, -1 on error
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_write_queue_add")
+fun writeQueueAdd(
+    address: CPointer<ByteVar>?,
+    service: CPointer<ByteVar>?,
+    characteristic: CPointer<ByteVar>?,
+    data: CPointer<UByteVar>?,
+    length: Int,
+    barrier: Int
+): Int {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+        winrt_write_queue_add(rawAddress, service?.toKString(), characteristic?.toKString(), data, length, barrier)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Send a device's queued writes
+ * Returns: JSON object with "result" (0 or a negative code) and throughput/latency figures,
+ * or null on error (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_write_queue_flush")
+fun writeQueueFlush(address: CPointer<ByteVar>?): CPointer<ByteVar>? {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return null
+        memScoped {
+            val stats = alloc<BLEWriteQueueStats>()
+            val result = winrt_write_queue_flush(rawAddress, stats.ptr)
+            val json = buildString {
+                append("{")
+                append("\"result\":$result,")
+                append("\"writes\":${stats.writes},")
+                append("\"commands\":${stats.commands},")
+                append("\"requests\":${stats.requests},")
+                append("\"bursts\":${stats.bursts},")
+                append("\"pending\":${stats.pending},")
+                append("\"elapsedMs\":${stats.elapsedMs},")
+                append("\"writesPerSecond\":${stats.writesPerSecond},")
+                append("\"avgCompletionMs\":${stats.avgCompletionMs},")
+                append("\"maxCompletionMs\":${stats.maxCompletionMs}")
+                append("}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Drop a device's queued writes
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_write_queue_clear")
+fun writeQueueClear(address: CPointer<ByteVar>?) {
+    val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return
+    winrt_write_queue_clear(rawAddress)
+}
+
+/**
+ * Start streaming notifications into a preallocated ring
+ * Parameters:
+ *   capacityBytes: ring size; each notification takes 24 bytes plus its payload (8-byte aligned)
+ * Returns: 0 on success, -1 on failure
+ */
+@OptIn(ExperimentalNativeApi::class)
+@CName("niox_stream_start")
+fun streamStart(capacityBytes: Int): Int {
+    return try {
+        winrt_stream_start(capacityBytes)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Stop notification streaming
+ */
+@OptIn(ExperimentalNativeApi::class)
+@CName("niox_stream_stop")
+fun streamStop() {
+    winrt_stream_stop()
+}
+
+/**
+ * Stream a characteristic's notifications into the ring
+ * Parameters:
+ *   enable: 1 to start, 0 to stop
+ * Returns: 0 on success, or a negative code (see winrt_ble_wrapper.h)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_stream_subscribe")
+fun streamSubscribe(
+    address: CPointer<ByteVar>?,
+    service: CPointer<ByteVar>?,
+    characteristic: CPointer<ByteVar>?,
+    enable: Int
+): Int {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+        winrt_stream_subscribe(rawAddress, service?.toKString(), characteristic?.toKString(), enable)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Fetch a batch of streamed notifications without copying their payloads
+ * Parameters:
+ *   records: array of BLENotification records (layout in winrt_ble_wrapper.h);
+ *            data pointers stay valid until niox_stream_release
+ *   maxRecords: number of records in the array
+ * Returns: records written, or -1 if streaming is not started
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_stream_poll")
+fun streamPoll(records: CPointer<BLENotification>?, maxRecords: Int): Int {
+    return try {
+        winrt_stream_poll(records, maxRecords)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Free the notifications returned by niox_stream_poll
+ */
+@OptIn(ExperimentalNativeApi::class)
+@CName("niox_stream_release")
+fun streamRelease() {
+    winrt_stream_release()
+}
+
+/**
+ * Get streaming throughput and drop counters
+ * Returns: JSON object, or null if streaming is not started (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_stream_stats")
+fun streamStats(): CPointer<ByteVar>? {
+    return try {
+        memScoped {
+            val stats = alloc<BLEStreamStats>()
+            if (winrt_stream_stats(stats.ptr) != 0) return null
+            val json = buildString {
+                append("{")
+                append("\"notifications\":${stats.notifications},")
+                append("\"bytes\":${stats.bytes},")
+                append("\"dropped\":${stats.dropped},")
+                append("\"droppedBytes\":${stats.droppedBytes},")
+                append("\"delivered\":${stats.delivered},")
+                append("\"batches\":${stats.batches},")
+                append("\"pendingBytes\":${stats.pendingBytes},")
+                append("\"peakBytes\":${stats.peakBytes},")
+                append("\"capacity\":${stats.capacity}")
+                append("}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Download a connected device's measurement log
+ * Parameters:
+ *   buffer, capacity: destination for the log
+ *   mtu, depth, requestTimeoutMs: requested MTU, outstanding requests, re-request timeout (0 = default)
+ * Returns: log size, -8 if the buffer is too small, or another negative code.
+ * After a link error, reconnect and call again to resume.
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_log_download")
+fun logDownload(
+    address: CPointer<ByteVar>?,
+    buffer: CPointer<UByteVar>?,
+    capacity: Int,
+    mtu: Int,
+    depth: Int,
+    requestTimeoutMs: Int
+): Int {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+        winrt_log_download(rawAddress, mtu, depth, requestTimeoutMs, buffer, capacity)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Get progress and throughput of the current or last log download
+ * Returns: JSON object, or null if the device has no download (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_log_stats")
+fun logStats(address: CPointer<ByteVar>?): CPointer<ByteVar>? {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return null
+        memScoped {
+            val stats = alloc<BLETransferStats>()
+            if (winrt_log_stats(rawAddress, stats.ptr) != 0) return null
+            val json = buildString {
+                append("{")
+                append("\"size\":${stats.size},")
+                append("\"received\":${stats.received},")
+                append("\"acknowledged\":${stats.acknowledged},")
+                append("\"mtu\":${stats.mtu},")
+                append("\"chunk\":${stats.chunk},")
+                append("\"requests\":${stats.requests},")
+                append("\"rerequests\":${stats.rerequests},")
+                append("\"notifications\":${stats.notifications},")
+                append("\"duplicates\":${stats.duplicates},")
+                append("\"resumes\":${stats.resumes},")
+                append("\"elapsedMs\":${stats.elapsedMs},")
+                append("\"bytesPerSecond\":${stats.bytesPerSecond}")
+                append("}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Drop a partial log download so the next one starts from the beginning
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_log_discard")
+fun logDiscard(address: CPointer<ByteVar>?) {
+    val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return
+    winrt_log_discard(rawAddress)
+}
+
+/**
+ * Add a characteristic to a simulated peripheral (requires niox_use_mock_backend(1, ...))
+ * Returns: the characteristic's value handle, or -1 on error
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_mock_add_characteristic")
+fun mockAddCharacteristic(
+    address: CPointer<ByteVar>?,
+    service: CPointer<ByteVar>?,
+    characteristic: CPointer<ByteVar>?,
+    properties: Int,
+    data: CPointer<UByteVar>?,
+    length: Int
+): Int {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+        winrt_mock_add_characteristic(rawAddress, service?.toKString(), characteristic?.toKString(), properties, data, length)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Change a simulated characteristic value, notifying subscribers
+ * Returns: 0 on success, -1 on error
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_mock_set_value")
+fun mockSetValue(address: CPointer<ByteVar>?, handle: Int, data: CPointer<UByteVar>?, length: Int): Int {
+    return try {
+        val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+        winrt_mock_set_value(rawAddress, handle, data, length)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Simulate a firmware update: move the peripheral's attributes and indicate Service Changed
+ * Returns: 0 on success, -1 on error
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_mock_services_changed")
+fun mockServicesChanged(address: CPointer<ByteVar>?): Int {
+    val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+    return winrt_mock_services_changed(rawAddress)
+}
+
+/**
+ * Make a simulated peripheral refuse connections (unreachable=1), e.g. to exercise
+ * connect retries and the scheduler's failure path, or accept them again (0)
+ * Returns: 0 on success, -1 on error or if the mock backend is not active
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_mock_set_unreachable")
+fun mockSetUnreachable(address: CPointer<ByteVar>?, unreachable: Int): Int {
+    val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+    return winrt_mock_set_unreachable(rawAddress, unreachable)
+}
+
+/**
+ * Set simulated radio timing (requires niox_use_mock_backend(1, ...))
+ * Parameters:
+ *   roundTripMs: cost of each request
+ *   commandSlots: write commands the simulated stack buffers (0 = unlimited)
+ *   packetIntervalUs: air time per write command
+ * Returns: 0 on success, -1 on error
+ */
+@OptIn(ExperimentalNativeApi::class)
+@CName("niox_mock_set_timing")
+fun mockSetTiming(roundTripMs: Int, commandSlots: Int, packetIntervalUs: Int): Int {
+    return winrt_mock_set_timing(roundTripMs, commandSlots, packetIntervalUs)
+}
+
+/**
+ * Give a simulated peripheral a measurement log (byte i = (i * 7 + i / 256) & 0xFF)
+ * Parameters:
+ *   roundTripMs: delay before the first chunk of each request
+ *   packetIntervalUs: spacing of the following chunks
+ *   lossPercent: share of chunks dropped
+ *   maxMtu: largest MTU the simulated peripherals accept (0 keeps the current limit)
+ * Returns: 0 on success, -1 on error
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_mock_add_log")
+fun mockAddLog(
+    address: CPointer<ByteVar>?,
+    size: Int,
+    roundTripMs: Int,
+    packetIntervalUs: Int,
+    lossPercent: Int,
+    maxMtu: Int
+): Int {
+    val rawAddress = parseBluetoothAddress(address?.toKString()) ?: return -1
+    return winrt_mock_add_log(rawAddress, size, roundTripMs, packetIntervalUs, lossPercent, maxMtu)
+}
+
+/**
+ * Start collecting device deltas from other plugin hosts
+ * Parameters:
+ *   endpoint: "udp://host:port" to listen on (e.g. "udp://0.0.0.0:47000")
+ * Returns: 0 on success, -1 on failure
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_aggregator_start_collector")
+fun aggregatorStartCollector(endpoint: CPointer<ByteVar>?): Int {
+    return try {
+        winrt_aggregator_start_collector(endpoint?.toKString())
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Stream this host's device table to a collector
+ * Parameters:
+ *   nodeId: identifier of this host (0..65535), reported back as bestNode
+ *   collectorEndpoint: "udp://host:port" of the collector
+ *   intervalMs: send interval in milliseconds
+ * Returns: 0 on success, -1 on failure
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_aggregator_start_node")
+fun aggregatorStartNode(nodeId: Int, collectorEndpoint: CPointer<ByteVar>?, intervalMs: Int): Int {
+    return try {
+        winrt_aggregator_start_node(nodeId, collectorEndpoint?.toKString(), intervalMs)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Stop node and collector roles
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_aggregator_stop")
+fun aggregatorStop() {
+    winrt_aggregator_stop()
+}
+
+/**
+ * Get the clinic-wide merged device table and per-node freshness (collector role)
+ * Returns: JSON object {"devices":[...],"nodes":[...]} (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_aggregator_devices")
+fun aggregatorDevices(): CPointer<ByteVar>? {
+    return try {
+        memScoped {
+            val total = alloc<IntVar>()
+            winrt_aggregator_devices(null, 0, total.ptr)
+            val deviceCapacity = total.value.coerceAtLeast(1)
+            val devices = allocArray<BLEAggregatedDevice>(deviceCapacity)
+            val deviceCount = winrt_aggregator_devices(devices, deviceCapacity, total.ptr)
+            if (deviceCount < 0) return null
+
+            winrt_aggregator_nodes(null, 0, total.ptr)
+            val nodeCapacity = total.value.coerceAtLeast(1)
+            val nodes = allocArray<BLEAggregatorNode>(nodeCapacity)
+            val nodeCount = winrt_aggregator_nodes(nodes, nodeCapacity, total.ptr)
+            if (nodeCount < 0) return null
+
+            val json = buildString {
+                append("{\"devices\":[")
+                for (index in 0 until deviceCount) {
+                    val device = devices[index]
+                    val serial = device.serialNumber.toKString()
+                    if (index > 0) append(",")
+                    append("{")
+                    append("\"address\":\"${device.address.toKString()}\",")
+                    if (serial.isNotEmpty()) {
+                        append("\"serialNumber\":\"$serial\",")
+                    } else {
+                        append("\"serialNumber\":null,")
+                    }
+                    append("\"bestRssi\":${device.bestRssi},")
+                    append("\"bestNode\":${device.bestNode},")
+                    append("\"bestAgeMs\":${device.bestAgeMs},")
+                    append("\"ageMs\":${device.ageMs}")
+                    append("}")
+                }
+                append("],\"nodes\":[")
+                for (index in 0 until nodeCount) {
+                    val node = nodes[index]
+                    if (index > 0) append(",")
+                    append("{")
+                    append("\"nodeId\":${node.nodeId},")
+                    append("\"ageMs\":${node.ageMs},")
+                    append("\"datagrams\":${node.datagrams},")
+                    append("\"lost\":${node.lost},")
+                    append("\"deltas\":${node.deltas}")
+                    append("}")
+                }
+                append("]}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/**
+ * Encode devices heard since the previous call as a delta-compressed stream
+ * Parameters:
+ *   buffer: destination for stream bytes
+ *   capacity: size of buffer in bytes
+ * Returns: bytes written (0 if nothing new), -1 on error; leftovers are returned by the next call
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_wire_encode_updates")
+fun wireEncodeUpdates(buffer: CPointer<UByteVar>?, capacity: Int): Int {
+    return try {
+        winrt_wire_encode_updates(buffer, capacity)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Restart the encoded stream with a reset frame (e.g. for a new reader)
+ */
+@OptIn(ExperimentalNativeApi::class)
+@CName("niox_wire_reset_encoder")
+fun wireResetEncoder() {
+    winrt_wire_reset_encoder()
+}
+
+/**
+ * Decode stream bytes produced by niox_wire_encode_updates on another host or process
+ * Parameters:
+ *   data, length: received bytes (any chunking; length 0 drains pending updates)
+ *   updates: array of BLEWireUpdate records (layout in winrt_ble_wrapper.h)
+ *   capacity: number of records in updates
+ * Returns: records written, or -1 on error
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_wire_decode")
+fun wireDecode(data: CPointer<UByteVar>?, length: Int, updates: CPointer<BLEWireUpdate>?, capacity: Int): Int {
+    return try {
+        winrt_wire_decode(data, length, updates, capacity)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Get the stream decoder's state; when "synced" is false, updates are ignored
+ * until the producer calls niox_wire_reset_encoder
+ * Returns: JSON object (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_wire_decode_stats")
+fun wireDecodeStats(): CPointer<ByteVar>? {
+    return try {
+        memScoped {
+            val stats = alloc<BLEWireDecodeStats>()
+            winrt_wire_decode_stats(stats.ptr)
+            val json = buildString {
+                append("{")
+                append("\"synced\":${stats.synced != 0},")
+                append("\"corruptFrames\":${stats.corruptFrames},")
+                append("\"sequenceGaps\":${stats.sequenceGaps},")
+                append("\"rejectedFrames\":${stats.rejectedFrames}")
+                append("}")
+            }
+            allocNativeString(json)
+        }
+    } catch (e: Exception) {
+        null
+    }
+}
+
+/** Upper bound on niox_query_devices page size */
+private const val MAX_QUERY_PAGE = 1000
+
+/**
+ * Escape text for a JSON string literal (quotes, backslashes, control characters);
+ * advertised names are arbitrary device-supplied bytes
+ */
+private fun jsonEscape(value: String): String = buildString(value.length) {
+    for (c in value) {
+        when {
+            c == '"' -> append("\\\"")
+            c == '\\' -> append("\\\\")
+            c == '\n' -> append("\\n")
+            c == '\r' -> append("\\r")
+            c == '\t' -> append("\\t")
+            c < ' ' -> append("\\u").append(c.code.toString(16).padStart(4, '0'))
+            else -> append(c)
+        }
+    }
+}
+
+/** Advertised status field as JSON (-1 = not advertised) */
+private fun statusField(value: Int): String = if (value < 0) "null" else value.toString()
+
+private fun statusFlag(value: Int): String = if (value < 0) "null" else (value != 0).toString()
+
+/**
+ * Parse "XX:XX:XX:XX:XX:XX" into a 48-bit address, or null if malformed
+ */
+private fun parseBluetoothAddress(text: String?): ULong? {
+    val parts = text?.split(":") ?: return null
+    if (parts.size != 6 || parts.any { it.length != 2 }) return null
+    var address = 0UL
+    for (part in parts) {
+        val byte = part.toULongOrNull(16) ?: return null
+        address = (address shl 8) or byte
+    }
+    return address
+}
+
+/**
+ * Format a 48-bit address as "XX:XX:XX:XX:XX:XX"
+ */
+private fun formatBluetoothAddress(address: ULong): String {
+    return (5 downTo 0).joinToString(":") { shift ->
+        ((address shr (shift * 8)) and 0xFFUL).toString(16).uppercase().padStart(2, '0')
+    }
+}
+
+/**
+ * Copy a string into native memory (must be freed with niox_free_string)
+ */
+@OptIn(ExperimentalForeignApi::class)
+private fun allocNativeString(value: String): CPointer<ByteVar> {
+    val bytes = value.encodeToByteArray()
+    val ptr = nativeHeap.allocArray<ByteVar>(bytes.size + 1)
+    bytes.forEachIndexed { index, byte ->
+        ptr[index] = byte
+    }
+    ptr[bytes.size] = 0 // Null terminator
+    return ptr
+}
+
+/**
+ * Look up a device seen by any previous scan by its NIOX serial number
+ * Parameters:
+ *   serial: serial number string (e.g. "070401992")
+ *   rssiOut: receives the last RSSI in dBm (may be null)
+ *   ageMsOut: receives milliseconds since the device was last heard (may be null)
+ * Returns: 1 if found, 0 if not tracked, -1 on invalid serial
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_find_device_by_serial")
+fun findDeviceBySerial(serial: CPointer<ByteVar>?, rssiOut: CPointer<IntVar>?, ageMsOut: CPointer<LongVar>?): Int {
+    return try {
+        winrt_find_device_by_serial(serial?.toKString(), null, rssiOut, ageMsOut)
+    } catch (e: Exception) {
+        -1
+    }
+}
+
+/**
+ * Free string memory allocated by niox_scan_devices
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
+@CName("niox_free_string")
+fun freeString(ptr: CPointer<ByteVar>?) {
+    ptr?.let {
+        nativeHeap.free(it)
+    }
+}
+
+/**
+ * Cleanup and release resources (stops replay, aggregation, scan log and connections)
+ */
+@OptIn(ExperimentalForeignApi::class, ExperimentalNativeApi::class)
 @CName("niox_cleanup")
 fun cleanup() {
     globalPlugin?.stopScan()
     globalPlugin = null
+    winrt_cleanup()
 }
 
 // Static string pointers for version and implementation (allocated once, never freed)
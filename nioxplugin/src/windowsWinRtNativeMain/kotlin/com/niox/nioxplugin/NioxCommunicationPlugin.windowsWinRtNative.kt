@@ -39,6 +39,9 @@ class WindowsWinRtNativeNioxCommunicationPlugin : NioxCommunicationPlugin {
         scanDurationMs: Long,
         serviceUuidFilter: String?
     ): List<BluetoothDevice> {
+        // A malformed filter must not silently widen the scan to every device
+        serviceUuidFilter?.let { BluetoothUuid.parse(it) }
+
         if (isScanning) {
             return emptyList()
         }
@@ -82,7 +85,8 @@ class WindowsWinRtNativeNioxCommunicationPlugin : NioxCommunicationPlugin {
             memScoped {
                 try {
                     // Determine if we should filter for NIOX devices only
-                    val nioxOnly = if (serviceUuidFilter == NioxConstants.NIOX_SERVICE_UUID) 1 else 0
+                    val filterUuid = serviceUuidFilter?.let { BluetoothUuid.parseOrNull(it) }
+                    val nioxOnly = if (filterUuid == NioxConstants.NIOX_SERVICE) 1 else 0
 
                     // Define callback for device discovery (must match C signature)
                     val callback = staticCFunction<CValue<BLEDevice>, COpaquePointer?, Unit> { deviceValue, userData ->
@@ -100,7 +104,8 @@ class WindowsWinRtNativeNioxCommunicationPlugin : NioxCommunicationPlugin {
                                         name = name,
                                         address = address,
                                         rssi = rssi,
-                                        serviceUuids = null, // Not available from C API
+                                        // The wrapper reports only whether the NIOX service was advertised
+                                        serviceUuids = if (this.hasNioxService != 0) listOf(NioxConstants.NIOX_SERVICE_UUID) else null,
                                         advertisingData = mapOf(
                                             "isConnectable" to true
                                         )